@@ -0,0 +1,1030 @@
+#include "AllocationCounter.h"
+#include "Bounds.h"
+#include "DrawBatcher.h"
+#include "DynamicAabbTree.h"
+#include "FramePipeline.h"
+#include "FramePrep.h"
+#include "HierarchyView.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "LightClusters.h"
+#include "LinearArena.h"
+#include "MeshBvh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+#include "ObjLoader.h"
+#include "OcclusionBuffer.h"
+#include "Renderer.h"
+#include "SceneFile.h"
+#include "TransformStore.h"
+#include "UploadRing.h"
+#include "VertexCodec.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef GGINE_BENCH_DEFAULT_OUT
+#define GGINE_BENCH_DEFAULT_OUT "ggine_bench.json"
+#endif
+
+// Headless benchmarks for the CPU-side hot paths. Results are written as JSON; with --baseline the run is
+// compared against an earlier result file and exits non-zero when a benchmark slowed down past the threshold.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    bool quick{false};
+    int repeats{0};
+    double threshold{0.10};
+    std::string filter;
+    std::filesystem::path out{GGINE_BENCH_DEFAULT_OUT};
+    std::filesystem::path baseline;
+};
+
+struct BenchResult {
+    std::string name;
+    int samples{0};
+    uint32_t batch{1};
+    double medianMs{0.0}, minMs{0.0}, meanMs{0.0};
+    std::vector<std::pair<std::string, double>> metrics;
+    double baselineMs{-1.0};
+    bool regressed{false};
+};
+
+struct BenchContext {
+    BenchOptions options;
+    JobSystem jobs;
+    std::filesystem::path scratchDir;
+    std::vector<BenchResult> results;
+    bool failed{false};   // a check that gates the exit status failed
+    bool wants(const std::string& name) const { return options.filter.empty() || name.find(options.filter) != std::string::npos; }
+};
+
+// Reports a failed correctness check; any one of them makes the run exit with status 1.
+void Fail(BenchContext& ctx, const char* format, ...) {
+    va_list args; va_start(args, format); vfprintf(stderr, format, args); va_end(args);
+    ctx.failed = true;
+}
+
+double ElapsedMs(Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); }
+
+// Short bodies are run several times per sample so each sample spans at least a couple of milliseconds; reset
+// runs untimed before every call so benchmarks that consume their input (dirty transforms, reordered indices) stay comparable.
+BenchResult& Measure(BenchContext& ctx, const std::string& name, const std::function<void()>& body, const std::function<void()>& reset = nullptr) {
+    const double minSampleMs = ctx.options.quick ? 1.0 : 4.0;
+    double warmupMs = 0.0;
+    for (int i = 0; i < 2; ++i) { if (reset) reset(); const auto start = Clock::now(); body(); warmupMs = ElapsedMs(start); }
+    BenchResult r; r.name = name; r.samples = ctx.options.repeats;
+    r.batch = warmupMs >= minSampleMs ? 1u : uint32_t(std::min(1000.0, std::ceil(minSampleMs / std::max(warmupMs, 1e-4))));
+    std::vector<double> samples;
+    for (int s = 0; s < r.samples; ++s) {
+        double total = 0.0;
+        for (uint32_t b = 0; b < r.batch; ++b) { if (reset) reset(); const auto start = Clock::now(); body(); total += ElapsedMs(start); }
+        samples.push_back(total / r.batch);
+    }
+    std::sort(samples.begin(), samples.end());
+    r.medianMs = samples.size() % 2 ? samples[samples.size() / 2] : 0.5 * (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]);
+    r.minMs = samples.front();
+    for (double v : samples) r.meanMs += v / double(samples.size());
+    printf("%-40s %10.3f ms  (min %.3f, %d x %u)\n", name.c_str(), r.medianMs, r.minMs, r.samples, r.batch);
+    fflush(stdout);
+    ctx.results.push_back(std::move(r));
+    return ctx.results.back();
+}
+
+std::string SizeLabel(size_t n) { return n >= 1000000 ? std::to_string(n / 1000000) + "m" : n >= 1000 ? std::to_string(n / 1000) + "k" : std::to_string(n); }
+
+// UV sphere with single pole vertices; roughly 4 * rings^2 triangles.
+void BuildSphereMesh(uint32_t rings, ObjMeshData& out) {
+    const uint32_t segments = rings * 2;
+    out.positions.clear(); out.indices.clear();
+    out.positions.push_back({ 0, 1, 0 });
+    for (uint32_t r = 1; r < rings; ++r) {
+        const float phi = 3.14159265f * float(r) / float(rings);
+        for (uint32_t s = 0; s < segments; ++s) { const float theta = 6.2831853f * float(s) / float(segments); out.positions.push_back({ std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta) }); }
+    }
+    out.positions.push_back({ 0, -1, 0 });
+    const uint32_t south = uint32_t(out.positions.size() - 1);
+    auto ring = [&](uint32_t r, uint32_t s) { return 1 + (r - 1) * segments + s % segments; };
+    for (uint32_t s = 0; s < segments; ++s) out.indices.insert(out.indices.end(), { 0, ring(1, s + 1), ring(1, s) });
+    for (uint32_t r = 1; r + 1 < rings; ++r) for (uint32_t s = 0; s < segments; ++s) out.indices.insert(out.indices.end(), { ring(r, s), ring(r, s + 1), ring(r + 1, s), ring(r + 1, s), ring(r, s + 1), ring(r + 1, s + 1) });
+    for (uint32_t s = 0; s < segments; ++s) out.indices.insert(out.indices.end(), { south, ring(rings - 1, s), ring(rings - 1, s + 1) });
+}
+
+uint32_t RingsForTriangles(size_t triangles) { return std::max(4u, uint32_t(std::sqrt(double(triangles) / 4.0) + 0.5)); }
+
+bool WriteObj(const std::filesystem::path& path, const ObjMeshData& mesh) {
+    std::string text; text.reserve(mesh.positions.size() * 32 + mesh.indices.size() * 8);
+    char line[96];
+    for (const Float3& p : mesh.positions) { const int n = snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", p.x, p.y, p.z); text.append(line, size_t(n)); }
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) { const int n = snprintf(line, sizeof(line), "f %u %u %u\n", mesh.indices[i] + 1, mesh.indices[i + 1] + 1, mesh.indices[i + 2] + 1); text.append(line, size_t(n)); }
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    return f && f.write(text.data(), std::streamsize(text.size()));
+}
+
+Float3 Sub(const Float3& a, const Float3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+Float3 Cross(const Float3& a, const Float3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+Float3 Normalize(const Float3& v) { const float l = std::sqrt(Dot(v, v)); return { v.x / l, v.y / l, v.z / l }; }
+
+// Row-vector matrices, matching DirectXMath and the engine's Float4x4 layout.
+Float4x4 Multiply(const Float4x4& a, const Float4x4& b) {
+    Float4x4 r;
+    for (int i = 0; i < 4; ++i) for (int j = 0; j < 4; ++j) r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+    return r;
+}
+
+Float4x4 LookAtLH(const Float3& eye, const Float3& at, const Float3& up) {
+    const Float3 z = Normalize(Sub(at, eye)), x = Normalize(Cross(up, z)), y = Cross(z, x);
+    Float4x4 m;
+    m.m[0][0] = x.x; m.m[0][1] = y.x; m.m[0][2] = z.x;
+    m.m[1][0] = x.y; m.m[1][1] = y.y; m.m[1][2] = z.y;
+    m.m[2][0] = x.z; m.m[2][1] = y.z; m.m[2][2] = z.z;
+    m.m[3][0] = -Dot(x, eye); m.m[3][1] = -Dot(y, eye); m.m[3][2] = -Dot(z, eye); m.m[3][3] = 1.0f;
+    return m;
+}
+
+Float4x4 PerspectiveFovLH(float fovY, float aspect, float zn, float zf) {
+    const float h = 1.0f / std::tan(fovY * 0.5f);
+    Float4x4 m;
+    m.m[0][0] = h / aspect; m.m[1][1] = h; m.m[2][2] = zf / (zf - zn); m.m[2][3] = 1.0f; m.m[3][2] = -zn * zf / (zf - zn);
+    return m;
+}
+
+void BenchObjLoad(BenchContext& ctx) {
+    const std::vector<size_t> sizes = ctx.options.quick ? std::vector<size_t>{ 20000, 200000 } : std::vector<size_t>{ 20000, 200000, 2000000 };
+    for (size_t tris : sizes) {
+        const std::string name = "obj_load/" + SizeLabel(tris);
+        if (!ctx.wants(name)) continue;
+        ObjMeshData source; BuildSphereMesh(RingsForTriangles(tris), source);
+        const std::filesystem::path path = ctx.scratchDir / ("sphere_" + SizeLabel(tris) + ".obj");
+        if (!WriteObj(path, source)) { Fail(ctx, "failed to write %s\n", path.string().c_str()); continue; }
+        const double megabytes = double(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+        bool ok = true;
+        BenchResult& r = Measure(ctx, name, [&] { ObjMeshData mesh; ok = LoadObjPositionsAndIndices(path.wstring(), mesh, nullptr, &ctx.jobs) && ok && mesh.indices.size() == source.indices.size(); });
+        if (!ok) Fail(ctx, "%s: loaded mesh does not match the generated one\n", name.c_str());
+        r.metrics = { { "triangles", double(source.indices.size() / 3) }, { "megabytes", megabytes }, { "mb_per_s", megabytes / (r.medianMs / 1000.0) } };
+        std::filesystem::remove(path);
+    }
+}
+
+void BenchMeshCook(BenchContext& ctx) {
+    const size_t tris = ctx.options.quick ? 50000 : 200000;
+    const std::string label = SizeLabel(tris);
+    ObjMeshData source; BuildSphereMesh(RingsForTriangles(tris), source);
+    const double triangleCount = double(source.indices.size() / 3);
+    std::vector<Float3> positions; std::vector<uint32_t> indices;
+    if (ctx.wants("cook/optimize/" + label)) {
+        BenchResult& r = Measure(ctx, "cook/optimize/" + label, [&] { OptimizeMesh(positions, indices); }, [&] { positions = source.positions; indices = source.indices; });
+        r.metrics = { { "triangles", triangleCount }, { "mtris_per_s", triangleCount / 1e6 / (r.medianMs / 1000.0) } };
+    }
+    std::vector<Float3> optimizedPositions = source.positions; std::vector<uint32_t> optimizedIndices = source.indices;
+    OptimizeMesh(optimizedPositions, optimizedIndices);
+    if (ctx.wants("cook/meshlets/" + label)) {
+        std::vector<Meshlet> meshlets;
+        BenchResult& r = Measure(ctx, "cook/meshlets/" + label, [&] { BuildMeshlets(optimizedPositions.data(), optimizedPositions.size(), indices.data(), indices.size(), meshlets); }, [&] { indices = optimizedIndices; });
+        r.metrics = { { "triangles", triangleCount }, { "meshlets", double(meshlets.size()) }, { "triangles_per_meshlet", triangleCount / double(std::max<size_t>(meshlets.size(), 1)) } };
+    }
+    if (ctx.wants("cook/lod_chain/" + label)) {
+        std::vector<MeshLod> lods;
+        BenchResult& r = Measure(ctx, "cook/lod_chain/" + label, [&] { BuildLodChain(optimizedPositions, indices, lods); }, [&] { indices = optimizedIndices; });
+        r.metrics = { { "triangles", triangleCount }, { "levels", double(lods.size()) }, { "last_level_triangles", lods.empty() ? 0.0 : double(lods.back().indexCount / 3) } };
+    }
+
+    Aabb bounds = ComputeAabb(optimizedPositions.data(), optimizedPositions.size());
+    std::vector<QuantizedPosition> quantized(optimizedPositions.size());
+    QuantizePositions(optimizedPositions.data(), optimizedPositions.size(), PositionDequantizeFor(bounds), quantized.data());
+    const double vertexMegabytes = double(quantized.size() * sizeof(QuantizedPosition)) / (1024.0 * 1024.0), indexMegabytes = double(optimizedIndices.size() * sizeof(uint32_t)) / (1024.0 * 1024.0);
+    std::vector<uint8_t> encodedVertices, encodedIndices;
+    EncodeVertexStream(quantized.data(), quantized.size(), sizeof(QuantizedPosition), encodedVertices);
+    EncodeIndexStream(optimizedIndices.data(), optimizedIndices.size(), encodedIndices);
+    if (ctx.wants("codec/encode_vertices/" + label)) {
+        BenchResult& r = Measure(ctx, "codec/encode_vertices/" + label, [&] { EncodeVertexStream(quantized.data(), quantized.size(), sizeof(QuantizedPosition), encodedVertices); });
+        r.metrics = { { "mb_per_s", vertexMegabytes / (r.medianMs / 1000.0) }, { "ratio", double(encodedVertices.size()) / double(quantized.size() * sizeof(QuantizedPosition)) } };
+    }
+    if (ctx.wants("codec/decode_vertices/" + label)) {
+        std::vector<QuantizedPosition> decoded(quantized.size()); bool ok = true;
+        BenchResult& r = Measure(ctx, "codec/decode_vertices/" + label, [&] { ok = DecodeVertexStream(encodedVertices.data(), encodedVertices.size(), decoded.data(), decoded.size(), sizeof(QuantizedPosition)) && ok; });
+        if (!ok || memcmp(decoded.data(), quantized.data(), quantized.size() * sizeof(QuantizedPosition)) != 0) Fail(ctx, "codec/decode_vertices: round trip mismatch\n");
+        r.metrics = { { "mb_per_s", vertexMegabytes / (r.medianMs / 1000.0) } };
+    }
+    if (ctx.wants("codec/encode_indices/" + label)) {
+        BenchResult& r = Measure(ctx, "codec/encode_indices/" + label, [&] { EncodeIndexStream(optimizedIndices.data(), optimizedIndices.size(), encodedIndices); });
+        r.metrics = { { "mb_per_s", indexMegabytes / (r.medianMs / 1000.0) }, { "ratio", double(encodedIndices.size()) / double(optimizedIndices.size() * sizeof(uint32_t)) } };
+    }
+    if (ctx.wants("codec/decode_indices/" + label)) {
+        std::vector<uint32_t> decoded(optimizedIndices.size()); bool ok = true;
+        BenchResult& r = Measure(ctx, "codec/decode_indices/" + label, [&] { ok = DecodeIndexStream(encodedIndices.data(), encodedIndices.size(), decoded.data(), decoded.size()) && ok; });
+        if (!ok || decoded != optimizedIndices) Fail(ctx, "codec/decode_indices: round trip mismatch\n");
+        r.metrics = { { "mb_per_s", indexMegabytes / (r.medianMs / 1000.0) } };
+    }
+}
+
+void BenchTransforms(BenchContext& ctx) {
+    const std::vector<size_t> sizes = ctx.options.quick ? std::vector<size_t>{ 10000, 100000 } : std::vector<size_t>{ 10000, 100000, 1000000 };
+    for (size_t n : sizes) {
+        const std::string parallelName = "transforms/update/" + SizeLabel(n), serialName = "transforms/update_serial/" + SizeLabel(n);
+        if (!ctx.wants(parallelName) && !ctx.wants(serialName)) continue;
+        TransformStore store; std::vector<TransformHandle> handles(n);
+        for (size_t i = 0; i < n; ++i) handles[i] = store.create({ float(i % 100), float(i / 100 % 100), float(i / 10000) }, { float(i % 360), 15.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+        uint32_t frame = 0;
+        auto dirtyAll = [&] { ++frame; for (size_t i = 0; i < n; ++i) store.setEulerDegrees(handles[i], { float((i + frame) % 360), 15.0f, 0.0f }); };
+        for (JobSystem* jobs : { &ctx.jobs, static_cast<JobSystem*>(nullptr) }) {
+            const std::string& name = jobs ? parallelName : serialName;
+            if (!ctx.wants(name)) continue;
+            size_t updated = 0;
+            BenchResult& r = Measure(ctx, name, [&] { updated = store.updateWorldMatrices(jobs); }, dirtyAll);
+            r.metrics = { { "transforms", double(updated) }, { "ns_per_transform", r.medianMs * 1e6 / double(std::max<size_t>(updated, 1)) } };
+        }
+    }
+}
+
+// Recomposes every live node from its unparented twin in flat (which holds the same local values) through the store's
+// parent links, and returns the largest difference from the world matrices the store cached.
+float HierarchyError(const TransformStore& store, const std::vector<TransformHandle>& nodes, const TransformStore& flat, const std::vector<TransformHandle>& flatNodes) {
+    std::vector<uint32_t> nodeOf; for (uint32_t k = 0; k < nodes.size(); ++k) { if (nodeOf.size() <= nodes[k].index) nodeOf.resize(nodes[k].index + 1); nodeOf[nodes[k].index] = k; }
+    std::vector<Float4x4> reference(nodes.size()); std::vector<uint8_t> done(nodes.size(), 0); std::vector<uint32_t> path;
+    float error = 0.0f;
+    for (uint32_t k = 0; k < nodes.size(); ++k) {
+        if (!store.isAlive(nodes[k])) continue;
+        path.clear();
+        for (uint32_t j = k;;) { path.push_back(j); const TransformHandle p = store.parent(nodes[j]); if (p == TransformHandle{} || done[j = nodeOf[p.index]]) break; }
+        for (size_t n = path.size(); n-- > 0;) {
+            const uint32_t j = path[n]; const TransformHandle p = store.parent(nodes[j]);
+            reference[j] = p == TransformHandle{} ? flat.world(flatNodes[j]) : Multiply(flat.world(flatNodes[j]), reference[nodeOf[p.index]]); done[j] = 1;
+        }
+        const Float4x4& cached = store.world(nodes[k]);
+        for (int r = 0; r < 4; ++r) for (int c = 0; c < 4; ++c) error = std::max(error, std::fabs(cached.m[r][c] - reference[k].m[r][c]));
+    }
+    return error;
+}
+
+// Deep: 64 chains of 2k nodes each. Wide: one root with every other node as a direct child. "root" moves the roots
+// so every world matrix is recomputed; "branch" moves one mid-chain node (deep) or 1% of the leaves (wide).
+void BenchHierarchy(BenchContext& ctx) {
+    const std::vector<size_t> sizes = ctx.options.quick ? std::vector<size_t>{ 131072 } : std::vector<size_t>{ 131072, 1048576 };
+    constexpr uint32_t kChains = 64;
+    for (size_t n : sizes) {
+        for (const bool deep : { true, false }) {
+            const std::string shape = deep ? "deep" : "wide", rootName = "hierarchy/" + shape + "/root/" + SizeLabel(n), branchName = "hierarchy/" + shape + "/branch/" + SizeLabel(n);
+            if (!ctx.wants(rootName) && !ctx.wants(branchName)) continue;
+            TransformStore store, flat; std::vector<TransformHandle> nodes(n), flatNodes(n);
+            const size_t depth = n / kChains;
+            for (size_t i = 0; i < n; ++i) {
+                const bool root = deep ? i % depth == 0 : i == 0;
+                const Float3 p = root ? Float3{ float(i / depth) * 4.0f, 0.0f, 0.0f } : deep ? Float3{ 0.0f, 0.01f, 0.0f } : Float3{ float(i % 512) * 0.5f, 0.0f, float(i / 512) * 0.5f };
+                const Float3 e{ 0.0f, root ? 0.0f : 0.5f, 0.0f };
+                nodes[i] = store.create(p, e, { 1.0f, 1.0f, 1.0f }, root ? TransformHandle{} : nodes[deep ? i - 1 : 0]);
+                flatNodes[i] = flat.create(p, e, { 1.0f, 1.0f, 1.0f });
+            }
+            store.updateWorldMatrices(&ctx.jobs);
+            std::vector<size_t> roots, branch;
+            for (size_t i = 0; i < n; ++i) if (store.parent(nodes[i]) == TransformHandle{}) roots.push_back(i);
+            if (deep) branch.push_back(depth / 2); else for (size_t i = 1; i < n; i += 100) branch.push_back(i);
+            uint32_t frame = 0;
+            auto nudge = [&](const std::vector<size_t>& which) { return [&] { ++frame; const float offset = (frame & 1) ? 0.25f : -0.25f; for (size_t i : which) { const Float3 p = store.position(nodes[i]); store.setPosition(nodes[i], { p.x, p.y + offset, p.z }); } }; };
+            for (const bool moveRoots : { true, false }) {
+                const std::string& name = moveRoots ? rootName : branchName;
+                if (!ctx.wants(name)) continue;
+                size_t updated = 0;
+                BenchResult& r = Measure(ctx, name, [&] { updated = store.updateWorldMatrices(&ctx.jobs); }, nudge(moveRoots ? roots : branch));
+                r.metrics = { { "nodes", double(n) }, { "transforms", double(updated) }, { "ns_per_transform", r.medianMs * 1e6 / double(std::max<size_t>(updated, 1)) } };
+            }
+
+            // Reparenting against the slot order, and destroying a node with children, both have to keep the cache exact.
+            store.setParent(nodes[deep ? 0 : 1], nodes[n - 1]); store.destroy(nodes[deep ? depth / 4 : 2]);
+            store.updateWorldMatrices(&ctx.jobs);
+            for (size_t i = 0; i < n; ++i) flat.setPosition(flatNodes[i], store.isAlive(nodes[i]) ? store.position(nodes[i]) : flat.position(flatNodes[i]));
+            flat.updateWorldMatrices(&ctx.jobs);
+            if (const float error = HierarchyError(store, nodes, flat, flatNodes); error > 1e-3f) Fail(ctx, "hierarchy/%s/%s: cached world matrices are off by %g\n", shape.c_str(), SizeLabel(n).c_str(), double(error));
+        }
+    }
+}
+
+// The engine's Scene without the D3D12 parts, for FramePrep; every mesh shares the cooked data of one sphere.
+struct BenchMesh {
+    TransformHandle transform;
+    Aabb localBounds{};
+    Sphere localSphere{};
+    std::array<MeshLod, kMaxMeshLods> lods{};
+    uint32_t lodCount{0};
+    uint32_t lod{0};
+    uint32_t geometryId{0};
+    uint32_t materialId{0};
+    int32_t cullProxy{-1};
+    const OccluderMesh* occluderMesh{nullptr};
+    uint32_t pipeline() const { return 0; }
+    bool drawable() const { return true; }
+    const OccluderMesh* occluder() const { return occluderMesh; }
+};
+
+struct BenchLight {
+    TransformHandle transform;
+    Float3 color{ 1.0f, 1.0f, 1.0f };
+    float intensity{1.0f};
+};
+
+struct BenchScene {
+    TransformStore transforms;
+    DynamicAabbTree meshTree;
+    DynamicAabbTree lightTree;
+    std::vector<BenchMesh> meshes;
+    std::vector<BenchLight> lights;
+};
+
+// Gives every mesh and light its cull proxy the way Engine::addMesh/addLight do, once the transforms are in place.
+void CreateCullProxies(BenchScene& scene, JobSystem& jobs) {
+    scene.transforms.updateWorldMatrices(&jobs);
+    for (size_t i = 0; i < scene.meshes.size(); ++i) { BenchMesh& m = scene.meshes[i]; m.cullProxy = scene.meshTree.createProxy(TransformAabb(m.localBounds, scene.transforms.world(m.transform)), uint32_t(i)); scene.transforms.setUserData(m.transform, uint32_t(m.cullProxy)); }
+    for (size_t i = 0; i < scene.lights.size(); ++i) { const BenchLight& l = scene.lights[i]; const int32_t proxy = scene.lightTree.createProxy(LightBounds(scene.transforms.world(l.transform), l.intensity), uint32_t(i)); scene.transforms.setUserData(l.transform, kLightProxyFlag | uint32_t(proxy)); }
+}
+
+// A grid of n spheres around the middle of which the camera sits, looking along +z and a little to the side.
+struct BenchGrid {
+    float spacing{4.0f};
+    uint32_t side{0};
+    float middle{0.0f};
+    Float3 position(size_t i) const { return { float(i % side) * spacing, float(i / side % side) * spacing, float(i / (size_t(side) * side)) * spacing }; }
+    FrameView view(float farZ) const {
+        FrameView v; v.eye = { middle, middle, middle };
+        const Float4x4 proj = PerspectiveFovLH(0.9f, 16.0f / 9.0f, 0.1f, farZ);
+        v.view = LookAtLH(v.eye, { middle + 1.0f, middle, middle + 3.0f }, { 0, 1, 0 }); v.viewProj = Multiply(v.view, proj);
+        v.projX = proj.m[0][0]; v.projY = proj.m[1][1]; v.nearZ = 0.1f; v.farZ = farZ; v.width = 1920; v.height = 1080;
+        return v;
+    }
+};
+
+BenchGrid MakeBenchGrid(size_t n, float spacing) { BenchGrid g; g.spacing = spacing; g.side = uint32_t(std::ceil(std::cbrt(double(n)))); g.middle = float(g.side / 2) * spacing + spacing * 0.5f; return g; }
+
+// Engine::render's main-thread work through FramePrep, followed by the render thread's cluster culling of the instances
+// that drew at LOD 0: dirty transform update, bounds refit, parallel frustum query, LOD selection, the draw batch sort.
+void BenchDrawList(BenchContext& ctx) {
+    const std::vector<size_t> sizes = ctx.options.quick ? std::vector<size_t>{ 10000 } : std::vector<size_t>{ 10000, 100000 };
+    ObjMeshData mesh; BuildSphereMesh(RingsForTriangles(20000), mesh);
+    OptimizeMesh(mesh.positions, mesh.indices);
+    std::vector<Meshlet> meshlets; BuildMeshlets(mesh.positions.data(), mesh.positions.size(), mesh.indices.data(), mesh.indices.size(), meshlets);
+    std::vector<MeshLod> lods; BuildLodChain(mesh.positions, mesh.indices, lods);
+    BenchMesh prototype; prototype.localBounds = ComputeAabb(mesh.positions.data(), mesh.positions.size()); prototype.localSphere = ComputeBoundingSphere(mesh.positions.data(), mesh.positions.size());
+    prototype.lodCount = uint32_t(std::min<size_t>(lods.size(), kMaxMeshLods)); std::copy_n(lods.begin(), prototype.lodCount, prototype.lods.begin());
+    constexpr uint32_t kGeometries = 64, kMaterials = 8;
+    FramePrepSettings settings; settings.occlusionCulling = false; settings.clusteredLighting = false;
+
+    for (size_t n : sizes) {
+        const std::string name = "draw_list/" + SizeLabel(n);
+        if (!ctx.wants(name)) continue;
+        const BenchGrid grid = MakeBenchGrid(n, 4.0f);
+        BenchScene scene; scene.meshes.resize(n, prototype);
+        for (size_t i = 0; i < n; ++i) { BenchMesh& m = scene.meshes[i]; m.transform = scene.transforms.create(grid.position(i), { 0.0f, float(i % 360), 0.0f }); m.geometryId = uint32_t(i * 7919 % kGeometries) + 1; m.materialId = uint32_t(i % kMaterials); }
+        CreateCullProxies(scene, ctx.jobs);
+        // Near instances stay at LOD 0 and get cluster culled.
+        const FrameView view = grid.view(float(grid.side) * grid.spacing * 0.5f);
+
+        FramePrep prep; ClusterCullPass clusterCull; std::vector<Float4x4> worlds;
+        uint32_t frame = 0;
+        auto moveSome = [&] { ++frame; const float offset = (frame & 1) ? 0.5f : -0.5f; for (size_t i = frame % 10; i < n; i += 10) { const Float3 p = scene.transforms.position(scene.meshes[i].transform); scene.transforms.setPosition(scene.meshes[i].transform, { p.x + offset, p.y, p.z }); } };
+        auto body = [&] {
+            prep.prepareDrawList(scene, view, settings, ctx.jobs);
+            worlds.resize(prep.drawBatcher().instanceOrder().size()); prep.copyInstanceWorlds(scene, worlds.data(), ctx.jobs);
+            clusterCull.begin(worlds.size());
+            for (const DrawBatch& batch : prep.drawBatcher().batches()) if ((batch.sortKey & 7) == 0) for (uint32_t i = 0; i < batch.instanceCount; ++i) clusterCull.add(batch.firstInstance + i, meshlets);
+            clusterCull.cull(worlds.data(), view.viewProj, view.eye, false, ctx.jobs);
+        };
+        BenchResult& r = Measure(ctx, name, body, moveSome);
+        r.metrics = { { "objects", double(n) }, { "visible", double(prep.visibleMeshes().size()) }, { "batches", double(prep.drawBatcher().batches().size()) }, { "clustered_instances", double(clusterCull.instanceCount()) }, { "clusters_tested", double(clusterCull.stats().clusters) }, { "tree_height", double(scene.meshTree.height()) } };
+    }
+}
+
+// Saves and reloads a scene the way Engine::saveScene/loadScene do: transforms go out in slot order and come back
+// through one TransformStore::append, meshes get cull proxies and one stream request per distinct asset.
+void BenchSceneFile(BenchContext& ctx) {
+    const std::vector<size_t> sizes = ctx.options.quick ? std::vector<size_t>{ 20000 } : std::vector<size_t>{ 20000, 100000 };
+    constexpr uint32_t kAssets = 32;
+    const Aabb localBounds{ { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+    for (size_t n : sizes) {
+        const std::string saveName = "scene_file/save/" + SizeLabel(n), loadName = "scene_file/load/" + SizeLabel(n);
+        if (!ctx.wants(saveName) && !ctx.wants(loadName)) continue;
+        struct Object { std::wstring name; TransformHandle transform; std::wstring source; bool light; };
+        TransformStore store; std::vector<Object> objects(n);
+        for (size_t i = 0; i < n; ++i) {
+            const TransformHandle parent = i % 8 ? objects[i - i % 8].transform : TransformHandle{};
+            objects[i] = { (i % 16 == 15 ? L"Light " : L"Mesh ") + std::to_wstring(i), store.create({ float(i % 100), float(i / 100 % 100), float(i / 10000) }, { 0.0f, float(i % 360), 0.0f }, { 1.0f, 1.0f, 1.0f }, parent), i % 17 == 0 || i % 16 == 15 ? std::wstring() : L"props/prop" + std::to_wstring(i % kAssets) + L".obj", i % 16 == 15 };
+        }
+        const std::filesystem::path path = ctx.scratchDir / ("scene_" + SizeLabel(n) + ".ggscene");
+        auto save = [&] {
+            SceneFileData data; data.camera = { { 1.0f, 2.0f, -3.5f }, 0.25f, -0.1f };
+            data.resizeNodes(store.size()); store.exportSlots(data.positions.data(), data.eulerDegrees.data(), data.scales.data(), data.parents.data());
+            for (const Object& o : objects) {
+                const std::string name(o.name.begin(), o.name.end());
+                if (o.light) data.lights.push_back({ store.slotOf(o.transform), { 1.0f, 0.9f, 0.8f }, 2.0f, data.addString(name) });
+                else { const std::string key(o.source.begin(), o.source.end()); data.meshes.push_back({ store.slotOf(o.transform), o.source.empty() ? kSceneBuiltinCube : data.addAsset(key), 0, data.addString(name) }); }
+            }
+            return WriteSceneFile(path, data);
+        };
+        bool saved = true;
+        if (ctx.wants(saveName)) { BenchResult& r = Measure(ctx, saveName, [&] { saved = save() && saved; }); r.metrics = { { "objects", double(n) }, { "bytes", double(std::filesystem::file_size(path)) } }; }
+        else saved = save();
+        if (!saved) { Fail(ctx, "%s: could not write %s\n", saveName.c_str(), path.string().c_str()); continue; }
+
+        struct Loaded { TransformStore transforms; DynamicAabbTree tree; std::vector<Object> objects; std::vector<int32_t> requests; };
+        std::unique_ptr<Loaded> loaded; bool opened = true;
+        auto load = [&] {
+            SceneFile file; if (!file.open(path)) { opened = false; return; }
+            const GgsceneHeader& h = file.info(); Loaded& l = *loaded;
+            std::vector<TransformHandle> nodes(h.nodeCount); l.transforms.append(h.nodeCount, file.positions(), file.eulerDegrees(), file.scales(), file.parents(), nodes.data());
+            l.requests.assign(h.assetCount, -1); l.objects.reserve(h.meshCount + h.lightCount);
+            for (uint32_t i = 0; i < h.meshCount; ++i) {
+                const SceneMeshRecord& m = file.meshes()[i]; const std::string_view name = file.string(m.name); Object o{ std::wstring(name.begin(), name.end()), nodes[m.node], {}, false };
+                if (m.asset != kSceneBuiltinCube) { const std::string_view key = file.string(file.assets()[m.asset].key); o.source.assign(key.begin(), key.end()); if (l.requests[m.asset] < 0) l.requests[m.asset] = int32_t(m.asset); }
+                l.transforms.setUserData(o.transform, uint32_t(l.tree.createProxy(localBounds, uint32_t(l.objects.size())))); l.objects.push_back(std::move(o));
+            }
+            for (uint32_t i = 0; i < h.lightCount; ++i) { const SceneLightRecord& lr = file.lights()[i]; const std::string_view name = file.string(lr.name); l.objects.push_back({ std::wstring(name.begin(), name.end()), nodes[lr.node], {}, true }); }
+        };
+        if (ctx.wants(loadName)) { BenchResult& r = Measure(ctx, loadName, load, [&] { loaded = std::make_unique<Loaded>(); }); r.metrics = { { "objects", double(n) }, { "ms_per_10k_objects", r.medianMs * 1e4 / double(n) } }; }
+        else { loaded = std::make_unique<Loaded>(); load(); }
+
+        // Round trip: same transforms slot for slot, and the same objects once meshes and lights are regrouped.
+        const size_t count = store.size(); bool same = opened && loaded->transforms.size() == count && loaded->objects.size() == n;
+        if (same) {
+            SceneFileData a, b; a.resizeNodes(count); b.resizeNodes(count);
+            store.exportSlots(a.positions.data(), a.eulerDegrees.data(), a.scales.data(), a.parents.data()); loaded->transforms.exportSlots(b.positions.data(), b.eulerDegrees.data(), b.scales.data(), b.parents.data());
+            same = memcmp(a.positions.data(), b.positions.data(), count * sizeof(Float3)) == 0 && memcmp(a.eulerDegrees.data(), b.eulerDegrees.data(), count * sizeof(Float3)) == 0 && memcmp(a.scales.data(), b.scales.data(), count * sizeof(Float3)) == 0 && a.parents == b.parents;
+            std::vector<const Object*> original; for (const Object& o : objects) if (!o.light) original.push_back(&o);
+            for (const Object& o : objects) if (o.light) original.push_back(&o);
+            for (size_t i = 0; same && i < n; ++i) { const Object& x = *original[i]; const Object& y = loaded->objects[i]; same = x.name == y.name && x.source == y.source && x.light == y.light && store.slotOf(x.transform) == loaded->transforms.slotOf(y.transform); }
+        }
+        if (!same) Fail(ctx, "%s: reloaded scene does not match the saved one\n", loadName.c_str());
+    }
+}
+
+// What the Hierarchy panel costs per frame on a large scene: fetching rows when nothing changed plus reading one
+// screen of names, against a full row rebuild (reparent, expand, add/remove) and a filter change.
+void BenchHierarchyView(BenchContext& ctx) {
+    const size_t n = ctx.options.quick ? 100000 : 250000;
+    const std::string frameName = "hierarchy_view/frame/" + SizeLabel(n), rebuildName = "hierarchy_view/rebuild/" + SizeLabel(n), filterName = "hierarchy_view/filter/" + SizeLabel(n);
+    if (!ctx.wants(frameName) && !ctx.wants(rebuildName) && !ctx.wants(filterName)) return;
+    constexpr size_t kVisibleRows = 48;
+    TransformStore store; HierarchyView view; std::vector<TransformHandle> nodes(n); size_t cubes = 0;
+    store.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        // Groups of 64: a root, 7 children, each with 8 grandchildren.
+        const size_t g = i % 64; const TransformHandle parent = g == 0 ? TransformHandle{} : g < 8 ? nodes[i - g] : nodes[i - g + 1 + (g - 8) / 8];
+        nodes[i] = store.create({ float(i % 100), 0.0f, float(i / 100) }, {}, { 1.0f, 1.0f, 1.0f }, parent);
+        const bool cube = i % 10 == 0; cubes += cube;
+        view.add(nodes[i], cube ? std::string("Cube") : "Mesh " + std::to_string(i), int32_t(i));
+    }
+    size_t touched = 0;
+    auto frame = [&] { const std::vector<HierarchyRow>& rows = view.rows(store); for (size_t r = 0; r < std::min(kVisibleRows, rows.size()); ++r) touched += view.name(rows[r].node).size() + size_t(view.object(rows[r].node) & 1); };
+    bool ok = view.rows(store).size() == n;
+    if (ctx.wants(frameName)) { BenchResult& r = Measure(ctx, frameName, frame); r.metrics = { { "nodes", double(n) }, { "rows", double(view.rows(store).size()) }, { "distinct_names", double(view.distinctNames()) } }; }
+    if (ctx.wants(rebuildName)) { BenchResult& r = Measure(ctx, rebuildName, frame, [&] { view.invalidate(); }); r.metrics = { { "nodes", double(n) }, { "ns_per_node", r.medianMs * 1e6 / double(n) } }; }
+    uint32_t flips = 0;
+    if (ctx.wants(filterName)) { BenchResult& r = Measure(ctx, filterName, frame, [&] { view.setFilter(++flips & 1 ? "cube" : "mesh 1"); }); r.metrics = { { "nodes", double(n) }, { "distinct_names", double(view.distinctNames()) } }; }
+    view.setFilter("CUBE"); ok = ok && std::count_if(view.rows(store).begin(), view.rows(store).end(), [&](const HierarchyRow& row) { return view.name(row.node) == "Cube"; }) == ptrdiff_t(cubes);
+    view.setFilter(""); view.setExpanded(nodes[0], false); ok = ok && view.rows(store).size() == n - 63;
+    if (!ok) Fail(ctx, "hierarchy_view/%s: rows do not match the tree\n", SizeLabel(n).c_str());
+    if (touched == 0) Fail(ctx, "hierarchy_view/%s: no rows were read\n", SizeLabel(n).c_str());
+}
+
+// Reference for the occlusion benches: exact per-pixel-centre depth of every occluder triangle, in double precision
+// and with edges widened slightly so ties on an edge count as covered. The masked buffer must never be nearer.
+std::vector<double> ReferenceOcclusionDepth(const std::vector<std::pair<const ObjMeshData*, Float4x4>>& occluders, const Float4x4& viewProj, uint32_t width, uint32_t height) {
+    std::vector<double> depth(size_t(width) * height, 1.0);
+    for (const auto& [mesh, world] : occluders) {
+        const Float4x4 m = Multiply(world, viewProj);
+        for (size_t i = 0; i + 2 < mesh->indices.size(); i += 3) {
+            // Only the near plane is clipped; everything else is left to the per-pixel loop.
+            std::vector<std::array<double, 4>> in, poly;
+            for (int k = 0; k < 3; ++k) { const Float3& p = mesh->positions[mesh->indices[i + size_t(k)]]; std::array<double, 4> c; for (int j = 0; j < 4; ++j) c[size_t(j)] = double(p.x) * m.m[0][j] + double(p.y) * m.m[1][j] + double(p.z) * m.m[2][j] + m.m[3][j]; in.push_back(c); }
+            for (size_t k = 0; k < 3; ++k) {
+                const auto& a = in[k]; const auto& b = in[(k + 1) % 3];
+                if (a[2] >= 0.0) poly.push_back(a);
+                if ((a[2] >= 0.0) != (b[2] >= 0.0)) { const double t = a[2] / (a[2] - b[2]); poly.push_back({ a[0] + (b[0] - a[0]) * t, a[1] + (b[1] - a[1]) * t, 0.0, a[3] + (b[3] - a[3]) * t }); }
+            }
+            for (size_t f = 1; f + 1 < poly.size(); ++f) {
+                double x[3], y[3], z[3];
+                for (int k = 0; k < 3; ++k) { const auto& c = poly[k == 0 ? 0 : f + size_t(k) - 1]; x[k] = (c[0] / c[3] * 0.5 + 0.5) * width; y[k] = (0.5 - c[1] / c[3] * 0.5) * height; z[k] = c[2] / c[3]; }
+                const double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                if (std::fabs(area) < 1e-9) continue;
+                const int x0 = int(std::clamp(std::floor(std::min({ x[0], x[1], x[2] })), 0.0, double(width))), x1 = int(std::clamp(std::ceil(std::max({ x[0], x[1], x[2] })), -1.0, width - 1.0));
+                const int y0 = int(std::clamp(std::floor(std::min({ y[0], y[1], y[2] })), 0.0, double(height))), y1 = int(std::clamp(std::ceil(std::max({ y[0], y[1], y[2] })), -1.0, height - 1.0));
+                for (int py = y0; py <= y1; ++py) for (int px = x0; px <= x1; ++px) {
+                    const double cx = px + 0.5, cy = py + 0.5;
+                    const double w0 = ((x[1] - cx) * (y[2] - cy) - (x[2] - cx) * (y[1] - cy)) / area, w1 = ((x[2] - cx) * (y[0] - cy) - (x[0] - cx) * (y[2] - cy)) / area, w2 = 1.0 - w0 - w1;
+                    if (w0 < -1e-4 || w1 < -1e-4 || w2 < -1e-4) continue;
+                    double& d = depth[size_t(py) * width + size_t(px)]; d = std::min(d, w0 * z[0] + w1 * z[1] + w2 * z[2]);
+                }
+            }
+        }
+    }
+    return depth;
+}
+
+// An interior-like view: rows of walls with doorway gaps, high-poly pillars, and a floor and side wall that reach behind
+// the camera, in front of 100k small boxes. "raster"
+// clears and rasterizes every occluder, "test" checks every box. Each box the buffer hides is checked against the
+// reference, and so is every pixel of the buffer.
+void BenchOcclusion(BenchContext& ctx) {
+    const size_t n = 100000;
+    const uint32_t pillarRings = RingsForTriangles(ctx.options.quick ? 2048 : 8192);
+    ObjMeshData cube, pillar;
+    cube.positions = { { -0.5f, -0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f }, { -0.5f, -0.5f, 0.5f }, { 0.5f, -0.5f, 0.5f }, { 0.5f, 0.5f, 0.5f }, { -0.5f, 0.5f, 0.5f } };
+    cube.indices = { 0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4, 3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5 };
+    BuildSphereMesh(pillarRings, pillar);
+    auto placed = [](const Float3& scale, const Float3& at) { Float4x4 m; m.m[0][0] = scale.x; m.m[1][1] = scale.y; m.m[2][2] = scale.z; m.m[3][0] = at.x; m.m[3][1] = at.y; m.m[3][2] = at.z; m.m[3][3] = 1.0f; return m; };
+    std::vector<std::pair<const ObjMeshData*, Float4x4>> occluders;
+    for (int row = 0; row < 4; ++row) for (int w = -4; w <= 4; ++w) occluders.push_back({ &cube, placed({ 6.0f, 4.0f, 0.3f }, { float(w) * 8.0f + (row & 1 ? 4.0f : 0.0f), 2.0f, 8.0f + float(row) * 9.0f }) });
+    occluders.push_back({ &cube, placed({ 200.0f, 0.1f, 200.0f }, { 0.0f, -0.6f, 50.0f }) });
+    occluders.push_back({ &cube, placed({ 0.3f, 6.0f, 120.0f }, { -20.0f, 2.0f, 40.0f }) });
+    for (int p = 0; p < 16; ++p) occluders.push_back({ &pillar, placed({ 1.2f, 3.0f, 1.2f }, { float(p % 8) * 5.0f - 17.5f, 2.0f, p < 8 ? 12.5f : 30.5f }) });
+    size_t triangleCount = 0; for (const auto& o : occluders) triangleCount += o.first->indices.size() / 3;
+
+    const Float4x4 viewProj = Multiply(LookAtLH({ 0.0f, 1.7f, 0.0f }, { 0.0f, 1.7f, 1.0f }, { 0, 1, 0 }), PerspectiveFovLH(0.9f, 16.0f / 9.0f, 0.1f, 100.0f));
+    std::vector<Float4x4> worldViewProj; for (const auto& o : occluders) worldViewProj.push_back(Multiply(o.second, viewProj));
+    std::vector<Aabb> boxes(n); uint32_t seed = 12345u;
+    auto random = [&seed] { seed = seed * 1664525u + 1013904223u; return float(seed >> 8) / float(1u << 24); };
+    for (Aabb& b : boxes) { const float z = 3.0f + random() * 67.0f; const Float3 c{ (random() * 2.0f - 1.0f) * z * 0.8f, random() * 4.0f, z }; const float h = 0.1f + random() * 0.4f; b = { { c.x - h, c.y - h, c.z - h }, { c.x + h, c.y + h, c.z + h } }; }
+
+    OcclusionBuffer buffer; buffer.resize(320, 180);
+    auto rasterize = [&] { buffer.clear(); for (size_t i = 0; i < occluders.size(); ++i) buffer.addOccluder(occluders[i].first->positions.data(), occluders[i].first->positions.size(), occluders[i].first->indices.data(), occluders[i].first->indices.size(), worldViewProj[i]); buffer.rasterize(&ctx.jobs); };
+    std::vector<uint8_t> visible(n);
+    auto test = [&] { ctx.jobs.parallelFor(uint32_t(n), 4096, [&](uint32_t begin, uint32_t end) { for (uint32_t i = begin; i < end; ++i) visible[i] = buffer.testAabb(boxes[i], viewProj); }); };
+    const std::string rasterName = "occlusion/raster/" + SizeLabel(triangleCount), testName = "occlusion/test/" + SizeLabel(n);
+    if (ctx.wants(rasterName)) { BenchResult& r = Measure(ctx, rasterName, rasterize); r.metrics = { { "triangles", double(triangleCount) }, { "rasterized", double(buffer.stats().rasterizedTriangles) }, { "tiles_updated", double(buffer.stats().tilesUpdated) } }; }
+    rasterize();
+    size_t hidden = 0;
+    if (ctx.wants(testName)) { BenchResult& r = Measure(ctx, testName, test); hidden = size_t(std::count(visible.begin(), visible.end(), uint8_t(0))); r.metrics = { { "boxes", double(n) }, { "hidden", double(hidden) }, { "ns_per_box", r.medianMs * 1e6 / double(n) } }; }
+    if (!ctx.wants(rasterName) && !ctx.wants(testName)) return;
+
+    test();
+    const std::vector<double> reference = ReferenceOcclusionDepth(occluders, viewProj, buffer.width(), buffer.height());
+    size_t nearerPixels = 0, wronglyHidden = 0, referenceHidden = 0;
+    for (uint32_t y = 0; y < buffer.height(); ++y) for (uint32_t x = 0; x < buffer.width(); ++x) nearerPixels += buffer.pixelDepth(x, y) < reference[size_t(y) * buffer.width() + x] - 1e-5;
+    for (size_t i = 0; i < n; ++i) {
+        double minX = 1e30, minY = 1e30, maxX = -1e30, maxY = -1e30, nearest = 1e30; bool crossesNear = false;
+        for (int k = 0; k < 8; ++k) {
+            const double p[3] = { k & 1 ? boxes[i].max.x : boxes[i].min.x, k & 2 ? boxes[i].max.y : boxes[i].min.y, k & 4 ? boxes[i].max.z : boxes[i].min.z }; double c[4];
+            for (int j = 0; j < 4; ++j) c[j] = p[0] * viewProj.m[0][j] + p[1] * viewProj.m[1][j] + p[2] * viewProj.m[2][j] + viewProj.m[3][j];
+            crossesNear |= c[2] < 0.0; const double sx = (c[0] / c[3] * 0.5 + 0.5) * buffer.width(), sy = (0.5 - c[1] / c[3] * 0.5) * buffer.height();
+            minX = std::min(minX, sx); maxX = std::max(maxX, sx); minY = std::min(minY, sy); maxY = std::max(maxY, sy); nearest = std::min(nearest, c[2] / c[3]);
+        }
+        const int x0 = std::max(0, int(std::floor(minX))), x1 = std::min(int(buffer.width()) - 1, int(std::ceil(maxX)) - 1), y0 = std::max(0, int(std::floor(minY))), y1 = std::min(int(buffer.height()) - 1, int(std::ceil(maxY)) - 1);
+        bool covered = !crossesNear, clearlyVisible = crossesNear;
+        for (int y = y0; y <= y1; ++y) for (int x = x0; x <= x1; ++x) { const double d = reference[size_t(y) * buffer.width() + size_t(x)]; covered &= d < nearest; clearlyVisible |= d > nearest + 1e-5; }
+        referenceHidden += covered && x0 <= x1 && y0 <= y1;
+        wronglyHidden += !visible[i] && clearlyVisible;
+    }
+    if (BenchResult* r = ctx.wants(testName) ? &ctx.results.back() : nullptr) r->metrics.push_back({ "reference_hidden", double(referenceHidden) });
+    if (nearerPixels) Fail(ctx, "occlusion: %zu buffer pixels are nearer than the occluders\n", nearerPixels);
+    if (wronglyHidden) Fail(ctx, "occlusion: %zu visible boxes tested hidden\n", wronglyHidden);
+    printf("occlusion: %zu of %zu boxes hidden, %zu hidden at the reference's pixel centres\n", size_t(std::count(visible.begin(), visible.end(), uint8_t(0))), n, referenceHidden);
+}
+
+// Reference for the BVH: every triangle, scalar, same conventions as IntersectMeshBvh.
+RayHit IntersectAllTriangles(const ObjMeshData& mesh, const Ray& ray) {
+    RayHit hit; const Float3& o = ray.origin; const Float3& d = ray.direction;
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        const Float3& a = mesh.positions[mesh.indices[i]];
+        const Float3 e1 = Sub(mesh.positions[mesh.indices[i + 1]], a), e2 = Sub(mesh.positions[mesh.indices[i + 2]], a), p = Cross(d, e2), s = Sub(o, a), q = Cross(s, e1);
+        const float det = Dot(e1, p); if (det == 0.0f) continue;
+        const float u = Dot(s, p) / det, v = Dot(d, q) / det, t = Dot(e2, q) / det;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < hit.t) hit = { t, uint32_t(i / 3), u, v };
+    }
+    return hit;
+}
+
+// Rays from all around a large mesh through its bounds, checked against a test of every triangle; then viewport picks
+// from an editor camera over a field of instances, through the mesh tree and each instance's BVH the way the editor
+// picks, checked against testing every instance.
+void BenchPicking(BenchContext& ctx) {
+    const size_t tris = ctx.options.quick ? 250000 : 2000000;
+    const std::string buildName = "bvh/build/" + SizeLabel(tris), rayName = "bvh/ray/" + SizeLabel(tris);
+    uint32_t seed = 4242u;
+    auto random = [&seed] { seed = seed * 1664525u + 1013904223u; return float(seed >> 8) / float(1u << 24); };
+    if (ctx.wants(buildName) || ctx.wants(rayName)) {
+        ObjMeshData mesh; BuildSphereMesh(RingsForTriangles(tris), mesh);
+        const double triangleCount = double(mesh.indices.size() / 3);
+        MeshBvh bvh; BvhBuildStats stats;
+        if (ctx.wants(buildName)) {
+            BenchResult& r = Measure(ctx, buildName, [&] { BuildMeshBvh(mesh.positions.data(), mesh.indices.data(), mesh.indices.size(), bvh, &stats); });
+            r.metrics = { { "triangles", triangleCount }, { "nodes", double(stats.nodes) }, { "leaves", double(stats.leaves) }, { "max_depth", double(stats.maxDepth) }, { "sah_cost", stats.sahCost }, { "mtris_per_s", triangleCount / 1e6 / (r.medianMs / 1000.0) } };
+        } else BuildMeshBvh(mesh.positions.data(), mesh.indices.data(), mesh.indices.size(), bvh, &stats);
+        if (!ValidateMeshBvh(bvh.nodes.data(), bvh.nodes.size(), bvh.triangles.data(), bvh.triangles.size(), uint32_t(triangleCount))) Fail(ctx, "%s: built BVH does not validate\n", buildName.c_str());
+
+        std::vector<Ray> rays(4096);
+        for (Ray& ray : rays) {
+            const Float3 from = Normalize({ random() * 2.0f - 1.0f, random() * 2.0f - 1.0f, random() * 2.0f - 1.0f }), to{ random() * 2.4f - 1.2f, random() * 2.4f - 1.2f, random() * 2.4f - 1.2f };
+            ray.origin = { from.x * 3.0f, from.y * 3.0f, from.z * 3.0f }; ray.direction = Sub(to, ray.origin);
+        }
+        std::vector<RayHit> hits(rays.size());
+        if (ctx.wants(rayName)) {
+            BenchResult& r = Measure(ctx, rayName, [&] { for (size_t i = 0; i < rays.size(); ++i) { hits[i] = RayHit{}; IntersectMeshBvh(bvh, mesh.positions.data(), mesh.indices.data(), rays[i], hits[i]); } });
+            const size_t hitCount = size_t(std::count_if(hits.begin(), hits.end(), [](const RayHit& h) { return h.triangle != ~0u; }));
+            r.metrics = { { "triangles", triangleCount }, { "rays", double(rays.size()) }, { "hits", double(hitCount) }, { "ns_per_ray", r.medianMs * 1e6 / double(rays.size()) } };
+            size_t mismatches = 0; const size_t checked = ctx.options.quick ? 32 : 64;
+            for (size_t i = 0; i < checked; ++i) {
+                const RayHit reference = IntersectAllTriangles(mesh, rays[i]);
+                mismatches += (reference.triangle == ~0u) != (hits[i].triangle == ~0u) || std::fabs(reference.t - hits[i].t) > 1e-4f * std::max(1.0f, reference.t);
+            }
+            if (mismatches) Fail(ctx, "%s: %zu of %zu rays disagree with testing every triangle\n", rayName.c_str(), mismatches, checked);
+        }
+    }
+
+    const size_t n = ctx.options.quick ? 1024 : 4096, picks = 1024;
+    const std::string pickName = "pick/scene/" + SizeLabel(n);
+    if (!ctx.wants(pickName)) return;
+    ObjMeshData mesh; BuildSphereMesh(RingsForTriangles(65536), mesh);
+    MeshBvh bvh; BuildMeshBvh(mesh.positions.data(), mesh.indices.data(), mesh.indices.size(), bvh);
+    const Aabb localBounds = ComputeAabb(mesh.positions.data(), mesh.positions.size());
+    std::vector<Float4x4> worlds(n); DynamicAabbTree tree;
+    const uint32_t side = uint32_t(std::ceil(std::sqrt(double(n))));
+    for (size_t i = 0; i < n; ++i) {
+        const float scale = 0.4f + random() * 0.8f, yaw = random() * 6.2831853f, c = std::cos(yaw) * scale, s = std::sin(yaw) * scale;
+        Float4x4& m = worlds[i];
+        m.m[0][0] = c; m.m[0][2] = -s; m.m[1][1] = scale * (0.5f + random()); m.m[2][0] = s; m.m[2][2] = c;
+        m.m[3][0] = (float(i % side) - float(side) * 0.5f) * 3.0f; m.m[3][1] = random() * 2.0f; m.m[3][2] = float(i / side) * 3.0f; m.m[3][3] = 1.0f;
+        tree.createProxy(TransformAabb(localBounds, m), uint32_t(i));
+    }
+    auto localRay = [&](size_t i, const Ray& ray) { const Float3 o = InverseTransformPoint(worlds[i], ray.origin), e = InverseTransformPoint(worlds[i], { ray.origin.x + ray.direction.x, ray.origin.y + ray.direction.y, ray.origin.z + ray.direction.z }); return Ray{ o, Sub(e, o) }; };
+    uint64_t candidates = 0;
+    auto pick = [&](const Ray& ray, float maxT) {
+        int picked = -1; RayHit hit; hit.t = maxT;
+        tree.queryRay(ray.origin, ray.direction, maxT, [&](uint32_t i) { ++candidates; if (IntersectMeshBvh(bvh, mesh.positions.data(), mesh.indices.data(), localRay(i, ray), hit)) picked = int(i); return hit.t; });
+        return picked;
+    };
+
+    // Cursor rays as the editor builds them: a unit forward component, so t is view depth and the far plane bounds it.
+    const Float3 eye{ 0.0f, 12.0f, -12.0f }, forward = Normalize({ 0.0f, -0.45f, 1.0f }), right = Normalize(Cross({ 0, 1, 0 }, forward)), up = Cross(forward, right);
+    const float farPlane = 1000.0f, tanHalf = std::tan(0.45f), aspect = 16.0f / 9.0f;
+    std::vector<Ray> rays(picks);
+    for (Ray& ray : rays) {
+        const float sx = (random() * 2.0f - 1.0f) * tanHalf * aspect, sy = (random() * 2.0f - 1.0f) * tanHalf;
+        ray = { eye, { forward.x + right.x * sx + up.x * sy, forward.y + right.y * sx + up.y * sy, forward.z + right.z * sx + up.z * sy } };
+    }
+    std::vector<int> picked(picks);
+    BenchResult& r = Measure(ctx, pickName, [&] { candidates = 0; for (size_t i = 0; i < picks; ++i) picked[i] = pick(rays[i], farPlane); });
+    double slowestMs = 0.0;
+    for (const Ray& ray : rays) { const auto start = Clock::now(); pick(ray, farPlane); slowestMs = std::max(slowestMs, ElapsedMs(start)); }
+    r.metrics = { { "instances", double(n) }, { "triangles", double(n * mesh.indices.size() / 3) }, { "hits", double(std::count_if(picked.begin(), picked.end(), [](int p) { return p >= 0; })) },
+                  { "candidates_per_pick", double(candidates) / double(picks) }, { "us_per_pick", r.medianMs * 1e3 / double(picks) }, { "slowest_pick_ms", slowestMs } };
+    size_t mismatches = 0;
+    for (size_t k = 0; k < 64; ++k) {
+        int expected = -1; RayHit hit; hit.t = farPlane;
+        for (size_t i = 0; i < n; ++i) if (IntersectMeshBvh(bvh, mesh.positions.data(), mesh.indices.data(), localRay(i, rays[k]), hit)) expected = int(i);
+        mismatches += expected != picked[k];
+    }
+    if (mismatches) Fail(ctx, "%s: %zu of 64 picks disagree with testing every instance\n", pickName.c_str(), mismatches);
+}
+
+// Point lights scattered over a level around the camera, most of them out of view, plus a set that all sit inside the
+// frustum. Validation samples points across the view volume: every light that reaches a point must be listed by the
+// point's cluster, found the way the pixel shader finds it.
+void BenchLightClusters(BenchContext& ctx) {
+    const Float4x4 view = LookAtLH({ 0.0f, 2.0f, 0.0f }, { 0.0f, 2.0f, 1.0f }, { 0, 1, 0 }), proj = PerspectiveFovLH(0.9f, 16.0f / 9.0f, 0.1f, 100.0f);
+    LightClusterGrid grid; grid.setView(view, proj.m[0][0], proj.m[1][1], 0.1f, 100.0f);
+    uint32_t seed = 777u;
+    auto random = [&seed] { seed = seed * 1664525u + 1013904223u; return float(seed >> 8) / float(1u << 24); };
+    auto makeLight = [&](const Float3& p) { const float intensity = 0.25f + random() * 3.75f; return ClusterLight{ p, LightRange(intensity), { random() * intensity, random() * intensity, random() * intensity }, 0.0f }; };
+    auto run = [&](const std::string& name, const std::vector<ClusterLight>& lights) {
+        if (!ctx.wants(name)) return;
+        BenchResult& r = Measure(ctx, name, [&] { grid.build(lights.data(), lights.size(), &ctx.jobs); });
+        const LightClusterStats& st = grid.stats();
+        r.metrics = { { "lights", double(lights.size()) }, { "visible", double(st.visibleLights) }, { "indices", double(st.indices) }, { "occupied_clusters", double(st.occupiedClusters) }, { "max_per_cluster", double(st.maxPerCluster) }, { "ns_per_visible_light", r.medianMs * 1e6 / double(std::max(st.visibleLights, 1u)) } };
+        std::vector<std::array<double, 4>> viewLights(lights.size());
+        for (size_t i = 0; i < lights.size(); ++i) { const Float3& p = lights[i].position; for (int j = 0; j < 3; ++j) viewLights[i][size_t(j)] = p.x * double(view.m[0][j]) + p.y * double(view.m[1][j]) + p.z * double(view.m[2][j]) + view.m[3][j]; viewLights[i][3] = lights[i].range; }
+        size_t missing = 0, reached = 0;
+        for (int sample = 0; sample < 8192; ++sample) {
+            const float u = random(), v = random(), z = 0.1f * std::pow(1000.0f, random());
+            const double x = (u * 2.0 - 1.0) * z / proj.m[0][0], y = (1.0 - v * 2.0) * z / proj.m[1][1];
+            const LightClusterRange& range = grid.ranges()[LightClusterGrid::clusterIndex(std::min(uint32_t(u * kLightClustersX), kLightClustersX - 1), std::min(uint32_t(v * kLightClustersY), kLightClustersY - 1), grid.sliceOf(z))];
+            const uint32_t* listed = grid.indices().data() + range.offset;
+            for (size_t i = 0; i < lights.size(); ++i) {
+                const double dx = viewLights[i][0] - x, dy = viewLights[i][1] - y, dz = viewLights[i][2] - z, reach = viewLights[i][3] * 0.999;
+                if (dx * dx + dy * dy + dz * dz >= reach * reach) continue;
+                ++reached; missing += !std::binary_search(listed, listed + range.count, uint32_t(i));
+            }
+        }
+        if (missing) Fail(ctx, "%s: %zu of %zu light hits at sampled points are missing from their cluster\n", name.c_str(), missing, reached);
+    };
+    for (size_t n : { size_t(1024), size_t(4096), size_t(16384) }) {
+        std::vector<ClusterLight> lights(n);
+        for (ClusterLight& l : lights) l = makeLight({ (random() * 2.0f - 1.0f) * 120.0f, random() * 8.0f, (random() * 2.0f - 1.0f) * 120.0f });
+        run("light_clusters/bin/" + SizeLabel(n), lights);
+    }
+    std::vector<ClusterLight> inView(4096);
+    for (ClusterLight& l : inView) { const float z = 1.0f + random() * 90.0f; l = makeLight({ (random() * 2.0f - 1.0f) * 0.85f * z, 2.0f + (random() * 2.0f - 1.0f) * 0.45f * z, z }); }
+    run("light_clusters/bin_in_view/" + SizeLabel(inView.size()), inView);
+}
+
+// Simulation publishes world matrices through FramePipeline to a null renderer that transforms them the way the
+// instance upload would; the threaded run should approach max(sim, render) per frame instead of their sum.
+void BenchFramePipeline(BenchContext& ctx) {
+    const size_t n = ctx.options.quick ? 20000 : 100000;
+    constexpr uint32_t kFrames = 32;
+    struct Snapshot { uint64_t frame{0}; Float4x4 viewProj{}; std::vector<Float4x4> worlds; double checksum{0.0}; };
+    TransformStore store; std::vector<TransformHandle> handles(n);
+    for (size_t i = 0; i < n; ++i) handles[i] = store.create({ float(i % 100), float(i / 100 % 100), float(i / 10000) }, { float(i % 360), 15.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+    const Float4x4 proj = PerspectiveFovLH(0.9f, 16.0f / 9.0f, 0.1f, 200.0f);
+    std::vector<Float4x4> clip(n);
+    for (bool threaded : { false, true }) {
+        const std::string name = std::string("frame_pipeline/") + (threaded ? "threaded/" : "serial/") + SizeLabel(n);
+        if (!ctx.wants(name)) continue;
+        uint64_t expected = 0, outOfOrder = 0;
+        FramePipeline<Snapshot> pipeline([&](Snapshot& s) {
+            if (s.frame != expected++ || s.worlds.size() != n || s.worlds[0].m[3][0] != float(s.frame % 7)) ++outOfOrder;
+            double sum = 0.0; for (size_t i = 0; i < n; ++i) { clip[i] = Multiply(s.worlds[i], s.viewProj); sum += clip[i].m[3][3]; }
+            s.checksum = sum;
+        }, threaded, "Null renderer");
+        CameraPose previous{}, current{};
+        auto body = [&] {
+            for (uint32_t f = 0; f < kFrames; ++f) {
+                const uint64_t frame = pipeline.publishedFrames();
+                previous = current; current.position.z += 0.1f; current.yaw += 0.01f;
+                store.setPosition(handles[0], { float(frame % 7), 0.0f, 0.0f });
+                for (size_t i = 1 + frame % 4; i < n; i += 4) store.setEulerDegrees(handles[i], { float((i + frame) % 360), 15.0f, 0.0f });
+                store.updateWorldMatrices(&ctx.jobs);
+                const CameraPose pose = LerpCameraPose(previous, current, 0.5f);
+                Snapshot& s = pipeline.beginFrame();
+                s.frame = frame; s.viewProj = Multiply(LookAtLH(pose.position, { pose.position.x + std::sin(pose.yaw), pose.position.y, pose.position.z + std::cos(pose.yaw) }, { 0, 1, 0 }), proj);
+                s.worlds.resize(n); for (size_t i = 0; i < n; ++i) s.worlds[i] = store.world(handles[i]);
+                pipeline.publish();
+            }
+            pipeline.waitIdle();
+        };
+        BenchResult& r = Measure(ctx, name, body);
+        if (outOfOrder) Fail(ctx, "%s: %llu snapshots arrived out of order or torn\n", name.c_str(), (unsigned long long)outOfOrder);
+        r.metrics = { { "objects", double(n) }, { "frames", double(kFrames) }, { "ms_per_frame", r.medianMs / kFrames } };
+    }
+}
+
+// The first allocation a checked frame makes, for the failure message; the hook runs inside operator new.
+std::atomic<size_t> firstFrameAllocationBytes{0};
+
+// One engine frame over the portable pieces: FramePrep's transforms, cull, occlusion, batching and light binning on the
+// main thread, then a snapshot in the slot's frame arena handed through FramePipeline to a render thread that culls
+// clusters and compiles the command stream. Once warm, a steady frame must not touch the general heap on any thread.
+// The job system has its own workers so the queues are exercised even on a single core.
+void BenchFrameAllocations(BenchContext& ctx) {
+    const size_t n = ctx.options.quick ? 4096 : 16384;
+    const std::string name = "frame_allocations/" + SizeLabel(n);
+    if (!ctx.wants(name)) return;
+    JobSystem jobs(3);
+    ObjMeshData mesh; BuildSphereMesh(RingsForTriangles(1024), mesh); OptimizeMesh(mesh.positions, mesh.indices);
+    std::vector<Meshlet> meshlets; BuildMeshlets(mesh.positions.data(), mesh.positions.size(), mesh.indices.data(), mesh.indices.size(), meshlets);
+    const OccluderMesh occluder{ mesh.positions.data(), uint32_t(mesh.positions.size()), mesh.indices.data(), uint32_t(mesh.indices.size()) };
+    BenchMesh prototype; prototype.localBounds = ComputeAabb(mesh.positions.data(), mesh.positions.size()); prototype.localSphere = ComputeBoundingSphere(mesh.positions.data(), mesh.positions.size());
+    prototype.lods[0] = { 0, uint32_t(mesh.indices.size()), 0.0f }; prototype.lodCount = 1; prototype.occluderMesh = &occluder;
+
+    const BenchGrid grid = MakeBenchGrid(n, 4.0f);
+    BenchScene scene; scene.meshes.resize(n, prototype);
+    for (size_t i = 0; i < n; ++i) { BenchMesh& m = scene.meshes[i]; m.transform = scene.transforms.create(grid.position(i)); m.geometryId = uint32_t(i * 7919 % 64) + 1; m.materialId = uint32_t(i % 8); }
+    uint32_t seed = 99u;
+    auto random = [&seed] { seed = seed * 1664525u + 1013904223u; return float(seed >> 8) / float(1u << 24); };
+    scene.lights.resize(4096);
+    for (BenchLight& l : scene.lights) { l.transform = scene.transforms.create({ grid.middle + (random() * 2.0f - 1.0f) * 60.0f, grid.middle + (random() * 2.0f - 1.0f) * 20.0f, grid.middle + (random() * 2.0f - 1.0f) * 60.0f }); l.intensity = 2.0f; }
+    CreateCullProxies(scene, jobs);
+    const FrameView view = grid.view(100.0f);
+    const FramePrepSettings settings;
+
+    // Laid out like Engine::FrameSnapshot without the D3D12 views: the lists live in the slot's arena, which is rewound
+    // when beginFrame hands the slot back.
+    struct Snapshot {
+        LinearArena arena{ 256u << 10 };
+        Float4x4 viewProj{}; Float3 eye{};
+        std::pmr::vector<Float4x4> worlds{ &arena }; std::pmr::vector<DrawBatch> batches{ &arena };
+        std::pmr::vector<ClusterLight> lights{ &arena }; std::pmr::vector<LightClusterRange> lightRanges{ &arena }; std::pmr::vector<uint32_t> lightIndices{ &arena };
+        uint32_t drawCount{0};
+        void recycle() { worlds = decltype(worlds)(&arena); batches = decltype(batches)(&arena); lights = decltype(lights)(&arena); lightRanges = decltype(lightRanges)(&arena); lightIndices = decltype(lightIndices)(&arena); arena.reset(); }
+    };
+    ClusterCullPass clusterCull; RenderCommandStream commands; NullRenderer backend;
+    // Per-batch constants come from a fenced upload ring like Engine::constantRing; the null GPU completes each frame
+    // two frames late, so the ring keeps kMaxFramesInFlight - 1 frames pending.
+    UploadRing constantRing(4u << 20); uint64_t renderSerial = 0; uint64_t constantFailures = 0;
+    FramePipeline<Snapshot> pipeline([&](Snapshot& s) {
+        PROFILE_ZONE("Render");
+        clusterCull.begin(s.worlds.size());
+        for (const DrawBatch& b : s.batches) if ((b.sortKey & 7) == 0) for (uint32_t i = 0; i < b.instanceCount; ++i) clusterCull.add(b.firstInstance + i, meshlets);
+        clusterCull.cull(s.worlds.data(), s.viewProj, s.eye, false, jobs);
+        commands.clear();
+        for (const DrawBatch& b : s.batches) { RenderDraw d; d.vertexBuffer = { 0x1000, 1u << 20, 16 }; d.indexBuffer = { 0x200000, 1u << 20, 4 }; d.instanceCount = 1;
+            const uint64_t constants = constantRing.allocate(256, 256); constantFailures += constants == UploadRing::kInvalidOffset; d.constants[0] = uint32_t(constants);
+            for (uint32_t i = 0; i < b.instanceCount; ++i) { d.instanceOffset = b.firstInstance + i; for (const MeshletRange& r : clusterCull.ranges(b.firstInstance + i)) { d.count = r.indexCount; d.firstIndex = r.firstIndex; commands.submit(b.sortKey, d); } } }
+        commands.compile(); backend.execute(commands); s.drawCount = commands.stats().draws;
+        constantRing.endFrame(++renderSerial); constantRing.retire(renderSerial - std::min<uint64_t>(renderSerial, UploadRing::kMaxFramesInFlight - 1));
+    }, true, "Null renderer");
+
+    FramePrep prep;
+    uint32_t frame = 0;
+    auto runFrame = [&] {
+        PROFILE_FRAME();
+        ++frame; const float offset = (frame & 1) ? 0.5f : -0.5f;
+        for (size_t i = frame % 10; i < n; i += 10) { const Float3 p = scene.transforms.position(scene.meshes[i].transform); scene.transforms.setPosition(scene.meshes[i].transform, { p.x + offset, p.y, p.z }); }
+        prep.prepareDrawList(scene, view, settings, jobs);
+        prep.binVisibleLights(scene, view, settings, jobs);
+
+        Snapshot& s = pipeline.beginFrame(); s.recycle();
+        s.viewProj = view.viewProj; s.eye = view.eye;
+        s.worlds.resize(prep.drawBatcher().instanceOrder().size()); prep.copyInstanceWorlds(scene, s.worlds.data(), jobs);
+        s.batches.assign(prep.drawBatcher().batches().begin(), prep.drawBatcher().batches().end());
+        const LightClusterGrid& lightGrid = prep.lightGrid();
+        s.lights.assign(prep.clusterLights().begin(), prep.clusterLights().end()); s.lightRanges.assign(lightGrid.ranges().begin(), lightGrid.ranges().end()); s.lightIndices.assign(lightGrid.indices().begin(), lightGrid.indices().end());
+        pipeline.publish();
+    };
+    constexpr uint32_t kFrames = 16;
+    BenchResult& r = Measure(ctx, name, [&] { for (uint32_t f = 0; f < kFrames; ++f) runFrame(); pipeline.waitIdle(); });
+
+    // Scratch lists settle at this scene's peak within a few frames, but each profiler history slot keeps the zone storage
+    // of the frame it last held, so the history has to turn over once before the checked frames run from retained memory.
+#if GGINE_ENABLE_PROFILER
+    for (size_t f = 0; f < kProfilerHistoryFrames; ++f) runFrame();
+#endif
+    pipeline.waitIdle(); firstFrameAllocationBytes = 0;
+    SetHeapAllocationHook([](size_t bytes) { size_t none = 0; firstFrameAllocationBytes.compare_exchange_strong(none, bytes, std::memory_order_relaxed); });
+    HeapAllocationScope heap;
+    for (uint32_t f = 0; f < kFrames; ++f) runFrame();
+    pipeline.waitIdle();
+    const HeapAllocationStats made = heap.elapsed();
+    SetHeapAllocationHook(nullptr);
+    r.metrics = { { "objects", double(n) }, { "frames", double(kFrames) }, { "ms_per_frame", r.medianMs / kFrames }, { "visible", double(prep.visibleMeshes().size()) }, { "occluded", double(prep.occludedMeshes()) }, { "lights_in_view", double(prep.clusterLights().size()) }, { "heap_allocations_per_frame", double(made.allocations) / kFrames } };
+    if (constantFailures) Fail(ctx, "%s: %llu constant ring allocations failed\n", name.c_str(), (unsigned long long)constantFailures);
+    if (!prep.occludedMeshes()) Fail(ctx, "%s: no mesh was occluded, the occlusion pass is not exercised\n", name.c_str());
+    if (!kHeapAllocationCounting) printf("%s: allocation counter compiled out, not checked\n", name.c_str());
+    else if (made.allocations) { Fail(ctx, "%s: %llu heap allocations (%llu bytes) over %u steady frames, the first of %zu bytes\n", name.c_str(), (unsigned long long)made.allocations, (unsigned long long)made.bytes, kFrames, firstFrameAllocationBytes.load()); }
+}
+
+// Replays the recorded ops with a bound-state model and checks every draw sees exactly the state its packet asked for.
+bool ValidateRenderStream(const RenderCommandStream& stream) {
+    const std::vector<RenderDraw>& draws = stream.draws();
+    RenderDraw bound{};
+    for (const RenderOp& op : stream.ops()) {
+        const RenderDraw& d = draws[op.draw];
+        switch (op.type) {
+        case RenderOpType::SetPipeline: bound.pipeline = d.pipeline; break;
+        case RenderOpType::SetVertexBuffer: bound.vertexBuffer = d.vertexBuffer; break;
+        case RenderOpType::SetIndexBuffer: bound.indexBuffer = d.indexBuffer; break;
+        case RenderOpType::SetConstants: memcpy(bound.constants, d.constants, sizeof(d.constants)); break;
+        case RenderOpType::SetInstanceOffset: bound.instanceOffset = d.instanceOffset; break;
+        case RenderOpType::DrawIndexed:
+        case RenderOpType::Draw:
+            if (bound.pipeline != d.pipeline || !(bound.vertexBuffer == d.vertexBuffer) || memcmp(bound.constants, d.constants, sizeof(d.constants)) != 0 || bound.instanceOffset != d.instanceOffset) return false;
+            if (op.type == RenderOpType::DrawIndexed && !(bound.indexBuffer == d.indexBuffer)) return false;
+            break;
+        }
+    }
+    return true;
+}
+
+// Builds the packets the engine would for a large scene: instanced batches, plus LOD 0 instances split into per-cluster
+// index ranges, submitted in scene order. Sorting, redundancy removal and the null backend are timed together.
+void BenchRenderStream(BenchContext& ctx) {
+    const std::vector<size_t> sizes = ctx.options.quick ? std::vector<size_t>{ 10000 } : std::vector<size_t>{ 10000, 100000 };
+    constexpr uint32_t kGeometries = 64, kRangesPerCluster = 12;
+    for (size_t n : sizes) {
+        const std::string name = "render_stream/" + SizeLabel(n);
+        if (!ctx.wants(name)) continue;
+        struct Object { uint32_t geometry, lod, pipeline; };
+        std::vector<Object> objects(n);
+        for (size_t i = 0; i < n; ++i) objects[i] = { uint32_t(i * 7919 % kGeometries), uint32_t(i * 31 % 7 < 2 ? 0 : 1 + i % 3), uint32_t(i * 7919 % kGeometries) & 1 };
+        DrawBatcher batcher; batcher.resize(n);
+        for (size_t i = 0; i < n; ++i) batcher.set(i, MakeDrawSortKey(objects[i].pipeline, 0, (uint64_t(objects[i].geometry + 1) << 3) | objects[i].lod), uint32_t(i));
+        batcher.build();
+        RenderCommandStream stream; NullRenderer backend;
+        auto body = [&] {
+            stream.clear();
+            for (const DrawBatch& batch : batcher.batches()) {
+                const Object& obj = objects[batch.objectIndex];
+                RenderDraw d; d.pipeline = obj.pipeline; d.vertexBuffer = { 0x10000000ull * (obj.geometry + 1), 1u << 20, obj.pipeline ? 8u : 12u }; d.indexBuffer = { d.vertexBuffer.address + (1u << 20), 1u << 19, 2 };
+                const float scale = 1.0f / float(obj.geometry + 1); memcpy(&d.constants[0], &scale, sizeof(scale)); d.instanceOffset = batch.firstInstance; d.instanceCount = batch.instanceCount;
+                if (obj.lod == 0) { d.instanceCount = 1; for (uint32_t i = 0; i < batch.instanceCount; ++i) { d.instanceOffset = batch.firstInstance + i; for (uint32_t r = 0; r < kRangesPerCluster; ++r) { d.firstIndex = r * 372; d.count = 186; stream.submit(batch.sortKey, d); } } }
+                else { d.firstIndex = 0; d.count = 3000u >> obj.lod; stream.submit(batch.sortKey, d); }
+            }
+            stream.compile();
+            backend.execute(stream);
+        };
+        BenchResult& r = Measure(ctx, name, body, [&] { backend.reset(); });
+        const RenderStreamStats& st = stream.stats();
+        if (!ValidateRenderStream(stream) || backend.primitives() != st.primitives || backend.opCount(RenderOpType::DrawIndexed) != st.draws) Fail(ctx, "%s: compiled stream does not reproduce the submitted draws\n", name.c_str());
+        const double stateCalls = double(st.pipelineChanges + st.vertexBufferChanges + st.indexBufferChanges + st.constantChanges + st.instanceOffsetChanges);
+        r.metrics = { { "draws", double(st.draws) }, { "ns_per_draw", r.medianMs * 1e6 / double(std::max<uint32_t>(st.draws, 1)) }, { "state_calls", stateCalls }, { "redundant_skipped", double(st.redundantStateSkipped) },
+                      { "pipeline_changes", double(st.pipelineChanges) }, { "vertex_buffer_changes", double(st.vertexBufferChanges) }, { "instance_offset_changes", double(st.instanceOffsetChanges) } };
+    }
+}
+
+void WriteJsonNumber(std::ostream& f, double v) { char buf[32]; snprintf(buf, sizeof(buf), "%.6g", std::isfinite(v) ? v : 0.0); f << buf; }
+
+bool WriteResults(const BenchContext& ctx) {
+    std::ofstream f(ctx.options.out, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    f << "{\n  \"schema\": 1,\n  \"quick\": " << (ctx.options.quick ? "true" : "false") << ",\n  \"workers\": " << ctx.jobs.workerCount() << ",\n  \"results\": [";
+    for (size_t i = 0; i < ctx.results.size(); ++i) {
+        const BenchResult& r = ctx.results[i];
+        f << (i ? ",\n" : "\n") << "    { \"name\": \"" << r.name << "\", \"samples\": " << r.samples << ", \"batch\": " << r.batch;
+        f << ", \"median_ms\": "; WriteJsonNumber(f, r.medianMs); f << ", \"min_ms\": "; WriteJsonNumber(f, r.minMs); f << ", \"mean_ms\": "; WriteJsonNumber(f, r.meanMs);
+        if (r.baselineMs >= 0.0) { f << ", \"baseline_median_ms\": "; WriteJsonNumber(f, r.baselineMs); f << ", \"regressed\": " << (r.regressed ? "true" : "false"); }
+        f << ", \"metrics\": {";
+        for (size_t m = 0; m < r.metrics.size(); ++m) { f << (m ? ", " : " ") << '"' << r.metrics[m].first << "\": "; WriteJsonNumber(f, r.metrics[m].second); }
+        f << (r.metrics.empty() ? "} }" : " } }");
+    }
+    f << "\n  ]\n}\n";
+    return bool(f);
+}
+
+// Reads back the files WriteResults produces: each result object starts with its name and carries median_ms.
+bool ReadBaseline(const std::filesystem::path& path, std::vector<std::pair<std::string, double>>& out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    std::stringstream ss; ss << f.rdbuf(); const std::string text = ss.str();
+    const std::string nameKey = "\"name\": \"", medianKey = "\"median_ms\": ";
+    for (size_t pos = text.find(nameKey); pos != std::string::npos; pos = text.find(nameKey, pos)) {
+        const size_t start = pos + nameKey.size(), end = text.find('"', start);
+        const size_t next = text.find(nameKey, end), median = text.find(medianKey, end);
+        if (end == std::string::npos || median == std::string::npos || median > next) return false;
+        out.push_back({ text.substr(start, end - start), std::strtod(text.c_str() + median + medianKey.size(), nullptr) });
+        pos = end;
+    }
+    return true;
+}
+
+bool CompareWithBaseline(BenchContext& ctx) {
+    std::vector<std::pair<std::string, double>> baseline;
+    if (!ReadBaseline(ctx.options.baseline, baseline)) { fprintf(stderr, "could not read baseline %s\n", ctx.options.baseline.string().c_str()); return false; }
+    bool regressed = false;
+    printf("\n%-40s %12s %12s %9s\n", "benchmark", "baseline ms", "current ms", "change");
+    for (BenchResult& r : ctx.results) {
+        const auto it = std::find_if(baseline.begin(), baseline.end(), [&](const auto& b) { return b.first == r.name; });
+        if (it == baseline.end() || it->second <= 0.0) { printf("%-40s %12s %12.3f %9s\n", r.name.c_str(), "-", r.medianMs, "new"); continue; }
+        r.baselineMs = it->second;
+        const double change = r.medianMs / r.baselineMs - 1.0;
+        r.regressed = change > ctx.options.threshold; regressed = regressed || r.regressed;
+        printf("%-40s %12.3f %12.3f %+8.1f%%%s\n", r.name.c_str(), r.baselineMs, r.medianMs, change * 100.0, r.regressed ? "  REGRESSION" : change < -ctx.options.threshold ? "  faster" : "");
+    }
+    return !regressed;
+}
+
+void PrintUsage() {
+    printf("usage: ggine_bench [--quick] [--filter <substring>] [--repeat <n>] [--out <results.json>] [--baseline <results.json>] [--threshold <fraction>]\n"
+           "  --baseline compares medians against an earlier run and exits with status 1 when any benchmark is\n"
+           "  slower by more than --threshold (default 0.10). A failed correctness check, including a steady frame that\n"
+           "  allocates from the general heap, also fails the run.\n"
+           "  --out defaults to %s.\n", GGINE_BENCH_DEFAULT_OUT);
+}
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> const char* { if (i + 1 >= argc) { fprintf(stderr, "%s needs a value\n", arg.c_str()); exit(2); } return argv[++i]; };
+        if (arg == "--quick") options.quick = true;
+        else if (arg == "--filter") options.filter = value();
+        else if (arg == "--repeat") options.repeats = std::max(1, atoi(value()));
+        else if (arg == "--out") options.out = value();
+        else if (arg == "--baseline") options.baseline = value();
+        else if (arg == "--threshold") options.threshold = std::max(0.0, atof(value()));
+        else if (arg == "--help" || arg == "-h") { PrintUsage(); return 0; }
+        else { fprintf(stderr, "unknown argument %s\n", arg.c_str()); PrintUsage(); return 2; }
+    }
+    if (options.repeats == 0) options.repeats = options.quick ? 3 : 7;
+
+    auto ctx = std::make_unique<BenchContext>();
+    ctx->options = options;
+    ctx->scratchDir = std::filesystem::temp_directory_path() / "ggine_bench";
+    std::error_code ec; std::filesystem::create_directories(ctx->scratchDir, ec);
+    printf("ggine_bench: %u worker threads%s\n", ctx->jobs.workerCount(), options.quick ? ", quick" : "");
+
+    BenchObjLoad(*ctx);
+    BenchMeshCook(*ctx);
+    BenchTransforms(*ctx);
+    BenchHierarchy(*ctx);
+    BenchHierarchyView(*ctx);
+    BenchOcclusion(*ctx);
+    BenchPicking(*ctx);
+    BenchLightClusters(*ctx);
+    BenchDrawList(*ctx);
+    BenchRenderStream(*ctx);
+    BenchFramePipeline(*ctx);
+    BenchFrameAllocations(*ctx);
+    BenchSceneFile(*ctx);
+    std::filesystem::remove_all(ctx->scratchDir, ec);
+
+    const bool passed = options.baseline.empty() || CompareWithBaseline(*ctx);
+    if (!WriteResults(*ctx)) { fprintf(stderr, "failed to write %s\n", options.out.string().c_str()); return 2; }
+    printf("\nwrote %zu results to %s\n", ctx->results.size(), options.out.string().c_str());
+    return passed && !ctx->failed ? 0 : 1;
+}
@@ -1,18 +1,92 @@
-cbuffer Camera : register(b0)
+cbuffer Frame : register(b0)
 {
-    row_major float4x4 mvp;
+    row_major float4x4 viewProj;
+    row_major float4x4 view;
+    float3 eye;
+    // LightGridParams: the pixel's cluster is floor(SV_Position.xy * clustersPerPixel) and floor(log(viewZ) * sliceScale + sliceBias).
+    float2 clustersPerPixel;
+    float sliceScale;
+    float sliceBias;
+    uint3 clusterDims;
+    uint lightCount;
 };
+cbuffer Draw : register(b1)
+{
+    uint instanceOffset;
+    float3 dequantizeScale;
+    float3 dequantizeOffset;
+};
+struct InstanceData {
+    row_major float4x4 world;
+};
+struct PointLight {
+    float3 position;
+    float range;
+    float3 radiance;
+    float padding;
+};
+StructuredBuffer<InstanceData> instances : register(t0);
+StructuredBuffer<PointLight> lights : register(t1);
+StructuredBuffer<uint2> clusterRanges : register(t2);   // offset, count into lightIndices
+StructuredBuffer<uint> lightIndices : register(t3);
+
+static const float kAmbient = 0.08f;
+
 struct VSIn {
+#ifdef QUANTIZED_POSITIONS
+    float4 pos : POSITION; // R16G16B16A16_UNORM relative to the mesh bounds; w holds the octahedral normal as two SNORM8
+#else
     float3 pos : POSITION;
+    float2 normal : NORMAL; // octahedral, R16G16_SNORM
+#endif
 };
 struct VSOut {
     float4 pos : SV_Position;
+    float3 worldPos : TEXCOORD0;
+    float3 normal : TEXCOORD1;
+    float viewZ : TEXCOORD2;
 };
-VSOut VSMain(VSIn i) {
+
+float3 DecodeOctahedral(float2 e) {
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    if (n.z < 0.0f) n.xy = (1.0f - abs(n.yx)) * float2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+    return normalize(n);
+}
+
+VSOut VSMain(VSIn i, uint instanceId : SV_InstanceID) {
     VSOut o;
-    o.pos = mul(float4(i.pos, 1.0f), mvp);
+#ifdef QUANTIZED_POSITIONS
+    float3 localPos = dequantizeOffset + i.pos.xyz * 65535.0f * dequantizeScale;
+    uint packed = uint(i.pos.w * 65535.0f + 0.5f);
+    float2 octahedral = max(float2(int(packed << 24) >> 24, int(packed << 16) >> 24) / 127.0f, -1.0f);
+#else
+    float3 localPos = i.pos;
+    float2 octahedral = i.normal;
+#endif
+    float4x4 world = instances[instanceOffset + instanceId].world;
+    float4 worldPos = mul(float4(localPos, 1.0f), world);
+    o.pos = mul(worldPos, viewProj);
+    o.worldPos = worldPos.xyz;
+    o.normal = mul(float4(DecodeOctahedral(octahedral), 0.0f), world).xyz;
+    o.viewZ = mul(worldPos, view).z;
     return o;
 }
+
+// Point lights use the same windowed inverse-square falloff the CPU binning derives each light's range from.
 float4 PSMain(VSOut i) : SV_Target {
-    return float4(1,1,1,1);
+    float3 n = normalize(i.normal);
+    if (dot(n, eye - i.worldPos) < 0.0f) n = -n;   // geometry is drawn without culling, so both sides are lit
+    float3 color = kAmbient.xxx;
+    if (lightCount > 0) {
+        uint3 cluster = uint3(min(uint2(i.pos.xy * clustersPerPixel), clusterDims.xy - 1), uint(clamp(floor(log(max(i.viewZ, 1e-4f)) * sliceScale + sliceBias), 0.0f, float(clusterDims.z - 1))));
+        uint2 range = clusterRanges[(cluster.z * clusterDims.y + cluster.y) * clusterDims.x + cluster.x];
+        for (uint k = 0; k < range.y; ++k) {
+            PointLight light = lights[lightIndices[range.x + k]];
+            float3 toLight = light.position - i.worldPos;
+            float distanceSq = dot(toLight, toLight);
+            float window = saturate(1.0f - distanceSq * distanceSq / (light.range * light.range * light.range * light.range));
+            color += light.radiance * (saturate(dot(n, toLight * rsqrt(max(distanceSq, 1e-8f)))) * window * window / (distanceSq + 1.0f));
+        }
+    }
+    return float4(color, 1.0f);
 }
@@ -0,0 +1,61 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if GGINE_ENABLE_ALLOCATION_COUNTER
+namespace {
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocationBytes{0};
+std::atomic<HeapAllocationHook> allocationHook{nullptr};
+
+// Over-aligned blocks come from the aligned allocator of the platform and must go back to its matching free.
+void* Allocate(size_t bytes, size_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed); allocationBytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (HeapAllocationHook hook = allocationHook.load(std::memory_order_relaxed)) hook(bytes);
+    if (bytes == 0) bytes = 1;
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) return std::malloc(bytes);
+#if defined(_MSC_VER)
+    return _aligned_malloc(bytes, alignment);
+#else
+    return std::aligned_alloc(alignment, (bytes + alignment - 1) & ~(alignment - 1));
+#endif
+}
+
+void Free(void* p, size_t alignment) {
+#if defined(_MSC_VER)
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) { _aligned_free(p); return; }
+#endif
+    (void)alignment; std::free(p);
+}
+
+void* AllocateOrThrow(size_t bytes, size_t alignment) { if (void* p = Allocate(bytes, alignment)) return p; throw std::bad_alloc(); }
+}
+
+HeapAllocationStats HeapAllocations() { return { allocationCount.load(std::memory_order_relaxed), allocationBytes.load(std::memory_order_relaxed) }; }
+void SetHeapAllocationHook(HeapAllocationHook hook) { allocationHook.store(hook, std::memory_order_relaxed); }
+
+void* operator new(size_t bytes) { return AllocateOrThrow(bytes, 0); }
+void* operator new[](size_t bytes) { return AllocateOrThrow(bytes, 0); }
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept { return Allocate(bytes, 0); }
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept { return Allocate(bytes, 0); }
+void* operator new(size_t bytes, std::align_val_t alignment) { return AllocateOrThrow(bytes, size_t(alignment)); }
+void* operator new[](size_t bytes, std::align_val_t alignment) { return AllocateOrThrow(bytes, size_t(alignment)); }
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept { return Allocate(bytes, size_t(alignment)); }
+void* operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept { return Allocate(bytes, size_t(alignment)); }
+void operator delete(void* p) noexcept { Free(p, 0); }
+void operator delete[](void* p) noexcept { Free(p, 0); }
+void operator delete(void* p, size_t) noexcept { Free(p, 0); }
+void operator delete[](void* p, size_t) noexcept { Free(p, 0); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { Free(p, 0); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { Free(p, 0); }
+void operator delete(void* p, std::align_val_t alignment) noexcept { Free(p, size_t(alignment)); }
+void operator delete[](void* p, std::align_val_t alignment) noexcept { Free(p, size_t(alignment)); }
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept { Free(p, size_t(alignment)); }
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept { Free(p, size_t(alignment)); }
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { Free(p, size_t(alignment)); }
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { Free(p, size_t(alignment)); }
+#else
+HeapAllocationStats HeapAllocations() { return {}; }
+void SetHeapAllocationHook(HeapAllocationHook) {}
+#endif
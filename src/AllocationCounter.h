@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#ifndef GGINE_ENABLE_ALLOCATION_COUNTER
+#define GGINE_ENABLE_ALLOCATION_COUNTER 1
+#endif
+
+struct HeapAllocationStats {
+    uint64_t allocations{0};
+    uint64_t bytes{0};
+};
+
+// With the counter compiled in, this library replaces the global operator new and delete, so every general-heap
+// allocation in the process is counted, from any thread. Arenas count only when they take a new block. Without it the
+// totals stay zero.
+constexpr bool kHeapAllocationCounting = GGINE_ENABLE_ALLOCATION_COUNTER != 0;
+HeapAllocationStats HeapAllocations();
+
+// Called on every counted allocation, on the allocating thread, before the memory is taken; e.g. to break on the first
+// allocation of a frame that should make none. The hook must not allocate. nullptr removes it.
+using HeapAllocationHook = void (*)(size_t bytes);
+void SetHeapAllocationHook(HeapAllocationHook hook);
+
+// Allocations made, by every thread, since construction.
+class HeapAllocationScope {
+public:
+    HeapAllocationScope() : start(HeapAllocations()) {}
+    HeapAllocationStats elapsed() const { const HeapAllocationStats now = HeapAllocations(); return { now.allocations - start.allocations, now.bytes - start.bytes }; }
+
+private:
+    HeapAllocationStats start;
+};
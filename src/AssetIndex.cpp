@@ -0,0 +1,176 @@
+#include "AssetIndex.h"
+#include "MeshCache.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace {
+template <typename T> void WritePod(std::ofstream& f, const T& v) { f.write(reinterpret_cast<const char*>(&v), sizeof(T)); }
+template <typename T> bool ReadPod(std::ifstream& f, T& v) { f.read(reinterpret_cast<char*>(&v), sizeof(T)); return bool(f); }
+
+std::string ToLower(std::string s) { for (char& c : s) c = char(tolower(static_cast<unsigned char>(c))); return s; }
+
+bool IsUnder(const std::string& key, const std::string& dir) { return dir.empty() || (key.size() > dir.size() && key.compare(0, dir.size(), dir) == 0 && key[dir.size()] == '/'); }
+}
+
+std::string AssetIndex::KeyFor(const std::filesystem::path& root, const std::filesystem::path& path) {
+    const std::u8string rel = path.lexically_normal().lexically_relative(root.lexically_normal()).generic_u8string();
+    if (rel == u8".") return {};
+    return std::string(reinterpret_cast<const char*>(rel.data()), rel.size());
+}
+
+std::filesystem::path AssetIndex::PathFor(const std::filesystem::path& root, const std::string& key) {
+    return root / std::filesystem::path(std::u8string(reinterpret_cast<const char8_t*>(key.data()), key.size()));
+}
+
+bool AssetIndex::accepts(const std::filesystem::path& path) const {
+    const std::string ext = ToLower(path.extension().string());
+    return std::find(extensions.begin(), extensions.end(), ext) != extensions.end();
+}
+
+bool AssetIndex::load(const std::filesystem::path& file) {
+    std::ifstream f(file, std::ios::binary);
+    uint32_t magic = 0, version = 0, count = 0;
+    if (!f || !ReadPod(f, magic) || !ReadPod(f, version) || !ReadPod(f, count) || magic != kAssetIndexMagic || version != kAssetIndexVersion) return false;
+    std::map<std::string, AssetRecord> loaded;
+    for (uint32_t i = 0; i < count; ++i) {
+        AssetRecord r; uint32_t length = 0; uint8_t cooked = 0;
+        if (!ReadPod(f, length) || length > 4096) return false;
+        r.path.resize(length); f.read(r.path.data(), length);
+        if (!ReadPod(f, r.size) || !ReadPod(f, r.mtime) || !ReadPod(f, r.hash) || !ReadPod(f, cooked)) return false;
+        r.cooked = cooked != 0;
+        loaded.emplace(r.path, std::move(r));
+    }
+    entries = std::move(loaded);
+    return true;
+}
+
+bool AssetIndex::save(const std::filesystem::path& file) const {
+    std::filesystem::path tmp = file; tmp += ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) return false;
+        WritePod(f, kAssetIndexMagic); WritePod(f, kAssetIndexVersion); WritePod(f, uint32_t(entries.size()));
+        for (const auto& [key, r] : entries) {
+            WritePod(f, uint32_t(key.size())); f.write(key.data(), std::streamsize(key.size()));
+            WritePod(f, r.size); WritePod(f, r.mtime); WritePod(f, r.hash); WritePod(f, uint8_t(r.cooked));
+        }
+        if (!f) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, file, ec);
+    if (ec) { std::filesystem::remove(tmp, ec); return false; }
+    return true;
+}
+
+void AssetIndex::refreshFile(const std::filesystem::path& path, const std::string& key, std::vector<AssetChange>& outChanges) {
+    SourceFingerprint fp;
+    if (!ComputeSourceFingerprint(path, fp, false)) return;
+    auto it = entries.find(key);
+    if (it != entries.end() && it->second.size == fp.size && it->second.mtime == fp.mtime) return;
+    if (!ComputeSourceFingerprint(path, fp, true)) return;
+    ++hashedCount;
+    const bool cooked = IsCookedMeshValid(CookedMeshPath(path), path);
+    if (it != entries.end() && it->second.size == fp.size && it->second.hash == fp.hash) { it->second.mtime = fp.mtime; it->second.cooked = cooked; return; }
+    AssetRecord r{ key, fp.size, fp.mtime, fp.hash, cooked };
+    outChanges.push_back({ it == entries.end() ? AssetChangeKind::Added : AssetChangeKind::Modified, r });
+    entries[key] = std::move(r);
+}
+
+void AssetIndex::removeUnder(const std::string& key, const std::vector<std::string>& keep, std::vector<AssetChange>& outChanges) {
+    for (auto it = key.empty() ? entries.begin() : entries.lower_bound(key); it != entries.end();) {
+        if (it->first != key && !IsUnder(it->first, key)) { if (it->first.compare(0, key.size(), key) > 0) break; ++it; continue; }
+        if (std::binary_search(keep.begin(), keep.end(), it->first)) { ++it; continue; }
+        outChanges.push_back({ AssetChangeKind::Removed, it->second });
+        it = entries.erase(it);
+    }
+}
+
+void AssetIndex::refresh(const std::filesystem::path& root, const std::filesystem::path& path, std::vector<AssetChange>& outChanges) {
+    const std::string key = KeyFor(root, path);
+    if (key.starts_with("..")) return;
+    std::error_code ec;
+    const auto status = std::filesystem::status(path, ec);
+    if (std::filesystem::is_directory(status)) {
+        std::vector<std::string> seen;
+        for (auto it = std::filesystem::recursive_directory_iterator(path, std::filesystem::directory_options::skip_permission_denied, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (!it->is_regular_file(ec) || !accepts(it->path())) continue;
+            std::string fileKey = KeyFor(root, it->path());
+            refreshFile(it->path(), fileKey, outChanges);
+            seen.push_back(std::move(fileKey));
+        }
+        if (ec) return;
+        std::sort(seen.begin(), seen.end());
+        removeUnder(key, seen, outChanges);
+    } else if (std::filesystem::is_regular_file(status)) {
+        if (accepts(path)) refreshFile(path, key, outChanges);
+    } else if (!key.empty()) {
+        removeUnder(key, {}, outChanges);
+    }
+}
+
+bool AssetIndexService::start(const std::filesystem::path& assetRoot, const std::filesystem::path& file, bool forcePolling) {
+    stop();
+    root = assetRoot; indexFile = file; stopping = false;
+    if (!watcher.start(root, std::chrono::milliseconds(1000), forcePolling)) return false;
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void AssetIndexService::stop() {
+    if (!thread.joinable()) return;
+    stopping = true; watcher.wake();
+    thread.join(); watcher.stop();
+}
+
+void AssetIndexService::publish(std::vector<AssetChange>& changes) {
+    std::vector<AssetRecord> records; records.reserve(index.records().size());
+    for (const auto& [key, r] : index.records()) records.push_back(r);
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.insert(pending.end(), std::make_move_iterator(changes.begin()), std::make_move_iterator(changes.end()));
+    published = std::move(records); ++publishedVersion;
+    serviceStats.records = published.size(); serviceStats.filesHashed = index.filesHashed(); serviceStats.backend = watcher.backend();
+    changes.clear();
+}
+
+void AssetIndexService::run() {
+    std::vector<AssetChange> changes;
+    index.load(indexFile);
+    publish(changes);
+    bool dirty = false; auto lastSave = std::chrono::steady_clock::now();
+    std::vector<std::filesystem::path> paths{ root };
+    while (!stopping) {
+        if (!paths.empty()) {
+            const auto start = std::chrono::steady_clock::now();
+            if (std::find(paths.begin(), paths.end(), root) != paths.end()) paths.assign(1, root);
+            for (const auto& p : paths) index.refresh(root, p, changes);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            dirty = dirty || !changes.empty();
+            { std::lock_guard<std::mutex> lock(mutex); ++serviceStats.refreshes; serviceStats.lastRefreshMilliseconds = ms; }
+            publish(changes);
+            paths.clear();
+        }
+        if (dirty && std::chrono::steady_clock::now() - lastSave > std::chrono::seconds(2)) { index.save(indexFile); dirty = false; lastSave = std::chrono::steady_clock::now(); }
+        if (watcher.waitForChanges(paths, std::chrono::milliseconds(500))) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            watcher.waitForChanges(paths, std::chrono::milliseconds(0));
+        }
+    }
+    if (dirty) index.save(indexFile);
+}
+
+size_t AssetIndexService::pollChanges(std::vector<AssetChange>& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const size_t n = pending.size();
+    out.insert(out.end(), std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end())); pending.clear();
+    return n;
+}
+
+bool AssetIndexService::snapshot(std::vector<AssetRecord>& out, uint64_t& version) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (version == publishedVersion) return false;
+    out = published; version = publishedVersion;
+    return true;
+}
+
+AssetIndexStats AssetIndexService::stats() const { std::lock_guard<std::mutex> lock(mutex); return serviceStats; }
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FileWatcher.h"
+
+constexpr uint32_t kAssetIndexMagic = 0x58494747u;
+constexpr uint32_t kAssetIndexVersion = 1;
+
+enum class AssetChangeKind : uint8_t { Added, Modified, Removed };
+
+struct AssetRecord {
+    std::string path;
+    uint64_t size{0};
+    int64_t mtime{0};
+    uint64_t hash{0};
+    bool cooked{false};
+};
+
+struct AssetChange {
+    AssetChangeKind kind;
+    AssetRecord record;
+};
+
+// Records are keyed by UTF-8 paths relative to the asset root with '/' separators.
+class AssetIndex {
+public:
+    explicit AssetIndex(std::vector<std::string> extensions = { ".obj" }) : extensions(std::move(extensions)) {}
+    bool load(const std::filesystem::path& file);
+    bool save(const std::filesystem::path& file) const;
+    void refresh(const std::filesystem::path& root, const std::filesystem::path& path, std::vector<AssetChange>& outChanges);
+    bool accepts(const std::filesystem::path& path) const;
+    const std::map<std::string, AssetRecord>& records() const { return entries; }
+    uint64_t filesHashed() const { return hashedCount; }
+
+    static std::string KeyFor(const std::filesystem::path& root, const std::filesystem::path& path);
+    static std::filesystem::path PathFor(const std::filesystem::path& root, const std::string& key);
+
+private:
+    void refreshFile(const std::filesystem::path& path, const std::string& key, std::vector<AssetChange>& outChanges);
+    void removeUnder(const std::string& key, const std::vector<std::string>& keep, std::vector<AssetChange>& outChanges);
+
+    std::vector<std::string> extensions;
+    std::map<std::string, AssetRecord> entries;
+    uint64_t hashedCount{0};
+};
+
+struct AssetIndexStats {
+    size_t records{0};
+    uint64_t filesHashed{0};
+    uint64_t refreshes{0};
+    double lastRefreshMilliseconds{0.0};
+    FileWatchBackend backend{FileWatchBackend::None};
+};
+
+// Owns an AssetIndex on a background thread: loads the persisted index, verifies it against disk,
+// then applies watcher notifications and saves the index when it changes.
+class AssetIndexService {
+public:
+    AssetIndexService() = default;
+    ~AssetIndexService() { stop(); }
+    AssetIndexService(const AssetIndexService&) = delete;
+    AssetIndexService& operator=(const AssetIndexService&) = delete;
+
+    bool start(const std::filesystem::path& root, const std::filesystem::path& indexFile, bool forcePolling = false);
+    void stop();
+    size_t pollChanges(std::vector<AssetChange>& out);
+    bool snapshot(std::vector<AssetRecord>& out, uint64_t& version) const;
+    AssetIndexStats stats() const;
+
+private:
+    void run();
+    void publish(std::vector<AssetChange>& changes);
+
+    std::filesystem::path root;
+    std::filesystem::path indexFile;
+    AssetIndex index;
+    FileWatcher watcher;
+    std::thread thread;
+    std::atomic<bool> stopping{false};
+    mutable std::mutex mutex;
+    std::vector<AssetChange> pending;
+    std::vector<AssetRecord> published;
+    uint64_t publishedVersion{0};
+    AssetIndexStats serviceStats;
+};
@@ -0,0 +1,133 @@
+#include "AssetStreamer.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+
+AssetStreamStages DefaultMeshStreamStages(JobSystem* jobs, const MeshCookOptions& options) {
+    AssetStreamStages stages;
+    stages.read = [](StreamedMesh& m) {
+        if (OpenCookedMeshIfValid(m.source, m.mesh)) { m.stats.fromCache = true; return true; }
+        SourceFingerprint fp;
+        if (!ComputeSourceFingerprint(m.source, fp, false)) return false;
+        m.sourceMtime = fp.mtime;
+        std::ifstream f(m.source, std::ios::binary | std::ios::ate);
+        if (!f) return false;
+        m.sourceBytes.resize(size_t(f.tellg())); f.seekg(0);
+        return bool(f.read(m.sourceBytes.data(), std::streamsize(m.sourceBytes.size())));
+    };
+    stages.cook = [jobs, options](StreamedMesh& m) { return CookObjMeshFromMemory(m.source, m.sourceBytes.data(), m.sourceBytes.size(), m.sourceMtime, m.mesh, &m.stats, options, jobs); };
+    return stages;
+}
+
+AssetStreamer::AssetStreamer(JobSystem* jobs, AssetStreamStages stages) : jobs(jobs && jobs->workerCount() > 0 ? jobs : nullptr), stages(std::move(stages)) {
+    ioThread = std::thread([this] { ioLoop(); });
+}
+
+AssetStreamer::~AssetStreamer() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (uint32_t index : queue) { slots[index].state = StreamState::Cancelled; slots[index].payload.reset(); completed.push_back(index); --inFlight; }
+    queue.clear(); stopping = true;
+    wake.notify_all();
+    lock.unlock(); ioThread.join(); lock.lock();
+    idle.wait(lock, [this] { return inFlight == 0; });
+}
+
+StreamHandle AssetStreamer::request(const std::filesystem::path& source, StreamPriority priority) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t index;
+    if (!freeSlots.empty()) { index = freeSlots.back(); freeSlots.pop_back(); }
+    else { index = uint32_t(slots.size()); slots.emplace_back(); }
+    Slot& s = slots[index];
+    s.state = StreamState::Queued; s.priority = priority; s.cancelRequested = false; s.sequence = nextSequence++;
+    s.payload = std::make_unique<StreamedMesh>(); s.payload->source = source;
+    queue.push_back(index); ++inFlight;
+    wake.notify_one();
+    return { index, s.generation };
+}
+
+bool AssetStreamer::cancel(StreamHandle handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!resolveLocked(handle)) return false;
+    Slot& s = slots[handle.index];
+    switch (s.state) {
+    case StreamState::Queued:
+        queue.erase(std::find(queue.begin(), queue.end(), handle.index));
+        s.state = StreamState::Cancelled; s.payload.reset(); completed.push_back(handle.index);
+        if (--inFlight == 0) idle.notify_all();
+        break;
+    case StreamState::Reading: case StreamState::Cooking: s.cancelRequested = true; break;
+    case StreamState::Ready: case StreamState::Failed: s.state = StreamState::Cancelled; s.payload.reset(); break;
+    default: break;
+    }
+    return true;
+}
+
+bool AssetStreamer::setPriority(StreamHandle handle, StreamPriority priority) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!resolveLocked(handle) || slots[handle.index].state != StreamState::Queued) return false;
+    slots[handle.index].priority = priority;
+    return true;
+}
+
+StreamState AssetStreamer::state(StreamHandle handle) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return resolveLocked(handle) ? slots[handle.index].state : StreamState::Invalid;
+}
+
+size_t AssetStreamer::drainCompleted(std::vector<StreamCompletion>& out, size_t maxCount) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const size_t n = std::min(maxCount, completed.size());
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t index = completed[i]; Slot& s = slots[index];
+        out.push_back({ { index, s.generation }, s.state, std::move(s.payload) });
+        s.state = StreamState::Invalid; ++s.generation; freeSlots.push_back(index);
+    }
+    completed.erase(completed.begin(), completed.begin() + ptrdiff_t(n));
+    return n;
+}
+
+size_t AssetStreamer::pendingCount() const { std::lock_guard<std::mutex> lock(mutex); return inFlight; }
+
+void AssetStreamer::waitIdle() { std::unique_lock<std::mutex> lock(mutex); idle.wait(lock, [this] { return inFlight == 0; }); }
+
+void AssetStreamer::finishLocked(uint32_t index, bool ok) {
+    Slot& s = slots[index];
+    s.state = s.cancelRequested ? StreamState::Cancelled : ok ? StreamState::Ready : StreamState::Failed;
+    if (s.state == StreamState::Cancelled) s.payload.reset();
+    else { s.payload->sourceBytes.clear(); s.payload->sourceBytes.shrink_to_fit(); }
+    completed.push_back(index);
+    if (--inFlight == 0) idle.notify_all();
+}
+
+void AssetStreamer::cookJob(uint32_t index) {
+    StreamedMesh* payload;
+    { std::lock_guard<std::mutex> lock(mutex); payload = slots[index].payload.get(); }
+    bool ok;
+    { PROFILE_ZONE("Cook asset"); ok = stages.cook(*payload); }
+    std::lock_guard<std::mutex> lock(mutex);
+    finishLocked(index, ok);
+}
+
+void AssetStreamer::ioLoop() {
+    PROFILE_THREAD("Asset I/O");
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping) return;
+        auto best = std::min_element(queue.begin(), queue.end(), [this](uint32_t a, uint32_t b) { return slots[a].priority != slots[b].priority ? slots[a].priority > slots[b].priority : slots[a].sequence < slots[b].sequence; });
+        const uint32_t index = *best; *best = queue.back(); queue.pop_back();
+        slots[index].state = StreamState::Reading;
+        StreamedMesh* payload = slots[index].payload.get();
+        lock.unlock();
+        bool ok;
+        { PROFILE_ZONE("Read asset"); ok = stages.read(*payload); }
+        lock.lock();
+        if (!ok || slots[index].cancelRequested || payload->mesh.isOpen() || !stages.cook) { finishLocked(index, ok); continue; }
+        slots[index].state = StreamState::Cooking;
+        lock.unlock();
+        if (jobs) jobs->run([this, index] { cookJob(index); }, nullptr, JobAffinity::Background);
+        else cookJob(index);
+        lock.lock();
+    }
+}
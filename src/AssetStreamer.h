@@ -0,0 +1,91 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MeshCache.h"
+
+class JobSystem;
+
+enum class StreamPriority : uint8_t { Background, Normal, Immediate };
+enum class StreamState : uint8_t { Invalid, Queued, Reading, Cooking, Ready, Failed, Cancelled };
+
+struct StreamHandle {
+    uint32_t index{~0u};
+    uint32_t generation{0};
+    bool isValid() const { return index != ~0u; }
+    bool operator==(const StreamHandle&) const = default;
+};
+
+struct StreamedMesh {
+    std::filesystem::path source;
+    std::vector<char> sourceBytes;
+    int64_t sourceMtime{0};   // taken before sourceBytes were read
+    CookedMesh mesh;
+    MeshCookStats stats;
+};
+
+// read runs on the I/O thread; when it leaves mesh closed, cook runs on a job worker with the bytes it read.
+struct AssetStreamStages {
+    std::function<bool(StreamedMesh&)> read;
+    std::function<bool(StreamedMesh&)> cook;
+};
+
+// Cooks parse their OBJ text on jobs when given; pass the streamer's own job system.
+AssetStreamStages DefaultMeshStreamStages(JobSystem* jobs = nullptr, const MeshCookOptions& options = {});
+
+struct StreamCompletion {
+    StreamHandle handle;
+    StreamState state{StreamState::Invalid};
+    std::unique_ptr<StreamedMesh> payload;
+};
+
+class AssetStreamer {
+public:
+    explicit AssetStreamer(JobSystem* jobs = nullptr, AssetStreamStages stages = DefaultMeshStreamStages());
+    ~AssetStreamer();
+    AssetStreamer(const AssetStreamer&) = delete;
+    AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+    StreamHandle request(const std::filesystem::path& source, StreamPriority priority = StreamPriority::Normal);
+    bool cancel(StreamHandle handle);
+    bool setPriority(StreamHandle handle, StreamPriority priority);
+    StreamState state(StreamHandle handle) const;
+    size_t drainCompleted(std::vector<StreamCompletion>& out, size_t maxCount = SIZE_MAX);
+    size_t pendingCount() const;
+    void waitIdle();
+
+private:
+    struct Slot {
+        uint32_t generation{0};
+        StreamState state{StreamState::Invalid};
+        StreamPriority priority{StreamPriority::Normal};
+        bool cancelRequested{false};
+        uint64_t sequence{0};
+        std::unique_ptr<StreamedMesh> payload;
+    };
+
+    void ioLoop();
+    void cookJob(uint32_t index);
+    void finishLocked(uint32_t index, bool ok);
+    bool resolveLocked(StreamHandle handle) const { return handle.index < slots.size() && slots[handle.index].generation == handle.generation && slots[handle.index].state != StreamState::Invalid; }
+
+    JobSystem* jobs;
+    AssetStreamStages stages;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> queue;
+    std::vector<uint32_t> completed;
+    uint64_t nextSequence{0};
+    uint32_t inFlight{0};
+    bool stopping{false};
+    std::thread ioThread;
+};
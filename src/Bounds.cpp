@@ -0,0 +1,50 @@
+#include "Bounds.h"
+#include <algorithm>
+#include <cmath>
+
+Aabb ComputeAabb(const Float3* points, size_t count) {
+    if (count == 0) return {};
+    Aabb b{ points[0], points[0] };
+    for (size_t i = 1; i < count; ++i) {
+        const Float3& p = points[i];
+        b.min = { std::min(b.min.x, p.x), std::min(b.min.y, p.y), std::min(b.min.z, p.z) };
+        b.max = { std::max(b.max.x, p.x), std::max(b.max.y, p.y), std::max(b.max.z, p.z) };
+    }
+    return b;
+}
+
+Sphere ComputeBoundingSphere(const Float3* points, size_t count) {
+    if (count == 0) return {};
+    auto dist2 = [](const Float3& a, const Float3& b) { const float x = a.x - b.x, y = a.y - b.y, z = a.z - b.z; return x * x + y * y + z * z; };
+    auto farthest = [&](const Float3& from) { size_t best = 0; float bestD = -1.0f; for (size_t i = 0; i < count; ++i) { const float d = dist2(points[i], from); if (d > bestD) { bestD = d; best = i; } } return points[best]; };
+    const Float3 a = farthest(points[0]);
+    const Float3 b = farthest(a);
+    Sphere s{ { (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f }, std::sqrt(dist2(a, b)) * 0.5f };
+    for (size_t i = 0; i < count; ++i) {
+        const float d2 = dist2(points[i], s.center);
+        if (d2 <= s.radius * s.radius) continue;
+        const float d = std::sqrt(d2), grow = (d - s.radius) * 0.5f, t = grow / d;
+        s.radius += grow;
+        s.center = { s.center.x + (points[i].x - s.center.x) * t, s.center.y + (points[i].y - s.center.y) * t, s.center.z + (points[i].z - s.center.z) * t };
+    }
+    return s;
+}
+
+Aabb TransformAabb(const Aabb& box, const Float4x4& m) {
+    const float c[3] = { (box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f };
+    const float e[3] = { (box.max.x - box.min.x) * 0.5f, (box.max.y - box.min.y) * 0.5f, (box.max.z - box.min.z) * 0.5f };
+    float wc[3], we[3];
+    for (int j = 0; j < 3; ++j) {
+        wc[j] = m.m[3][j] + c[0] * m.m[0][j] + c[1] * m.m[1][j] + c[2] * m.m[2][j];
+        we[j] = e[0] * std::fabs(m.m[0][j]) + e[1] * std::fabs(m.m[1][j]) + e[2] * std::fabs(m.m[2][j]);
+    }
+    return { { wc[0] - we[0], wc[1] - we[1], wc[2] - we[2] }, { wc[0] + we[0], wc[1] + we[1], wc[2] + we[2] } };
+}
+
+Sphere TransformSphere(const Sphere& s, const Float4x4& m) {
+    const Float3& c = s.center;
+    Float3 wc{ m.m[3][0] + c.x * m.m[0][0] + c.y * m.m[1][0] + c.z * m.m[2][0], m.m[3][1] + c.x * m.m[0][1] + c.y * m.m[1][1] + c.z * m.m[2][1], m.m[3][2] + c.x * m.m[0][2] + c.y * m.m[1][2] + c.z * m.m[2][2] };
+    float scale2 = 0.0f;
+    for (int r = 0; r < 3; ++r) scale2 = std::max(scale2, m.m[r][0] * m.m[r][0] + m.m[r][1] * m.m[r][1] + m.m[r][2] * m.m[r][2]);
+    return { wc, s.radius * std::sqrt(scale2) };
+}
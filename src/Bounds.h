@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "MathTypes.h"
+
+Aabb ComputeAabb(const Float3* points, size_t count);
+Sphere ComputeBoundingSphere(const Float3* points, size_t count);
+Aabb TransformAabb(const Aabb& box, const Float4x4& m);
+Sphere TransformSphere(const Sphere& s, const Float4x4& m);
+
+inline Aabb UnionAabb(const Aabb& a, const Aabb& b) {
+    return { { a.min.x < b.min.x ? a.min.x : b.min.x, a.min.y < b.min.y ? a.min.y : b.min.y, a.min.z < b.min.z ? a.min.z : b.min.z },
+             { a.max.x > b.max.x ? a.max.x : b.max.x, a.max.y > b.max.y ? a.max.y : b.max.y, a.max.z > b.max.z ? a.max.z : b.max.z } };
+}
+
+inline bool ContainsAabb(const Aabb& outer, const Aabb& inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+inline float SurfaceArea(const Aabb& b) {
+    const float dx = b.max.x - b.min.x, dy = b.max.y - b.min.y, dz = b.max.z - b.min.z;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+// Slab test for origin + t * direction given invDirection = 1 / direction; tEnter is where the ray enters, at least 0.
+inline bool IntersectRayAabb(const Aabb& b, const Float3& origin, const Float3& invDirection, float maxT, float& tEnter) {
+    const float x0 = (b.min.x - origin.x) * invDirection.x, x1 = (b.max.x - origin.x) * invDirection.x;
+    const float y0 = (b.min.y - origin.y) * invDirection.y, y1 = (b.max.y - origin.y) * invDirection.y;
+    const float z0 = (b.min.z - origin.z) * invDirection.z, z1 = (b.max.z - origin.z) * invDirection.z;
+    float lo = x0 < x1 ? x0 : x1, hi = x0 < x1 ? x1 : x0;
+    const float ylo = y0 < y1 ? y0 : y1, yhi = y0 < y1 ? y1 : y0, zlo = z0 < z1 ? z0 : z1, zhi = z0 < z1 ? z1 : z0;
+    lo = ylo > lo ? ylo : lo; lo = zlo > lo ? zlo : lo; lo = lo > 0.0f ? lo : 0.0f;
+    hi = yhi < hi ? yhi : hi; hi = zhi < hi ? zhi : hi; hi = hi < maxT ? hi : maxT;
+    tEnter = lo; return lo <= hi;
+}
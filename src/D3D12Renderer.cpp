@@ -0,0 +1,19 @@
+#include "D3D12Renderer.h"
+#include "Profiler.h"
+
+void D3D12Renderer::execute(const RenderCommandStream& stream) {
+    PROFILE_ZONE("Translate render commands");
+    const std::vector<RenderDraw>& draws = stream.draws();
+    for (const RenderOp& op : stream.ops()) {
+        const RenderDraw& d = draws[op.draw];
+        switch (op.type) {
+        case RenderOpType::SetPipeline: commandList->SetPipelineState(pipelines[d.pipeline]); break;
+        case RenderOpType::SetVertexBuffer: { const D3D12_VERTEX_BUFFER_VIEW v{ d.vertexBuffer.address, d.vertexBuffer.size, d.vertexBuffer.stride }; commandList->IASetVertexBuffers(0, 1, &v); break; }
+        case RenderOpType::SetIndexBuffer: { const D3D12_INDEX_BUFFER_VIEW v{ d.indexBuffer.address, d.indexBuffer.size, d.indexBuffer.stride == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT }; commandList->IASetIndexBuffer(&v); break; }
+        case RenderOpType::SetConstants: commandList->SetGraphicsRoot32BitConstants(kDrawConstantsParameter, kRenderDrawConstants, d.constants, 1); break;
+        case RenderOpType::SetInstanceOffset: commandList->SetGraphicsRoot32BitConstant(kDrawConstantsParameter, d.instanceOffset, 0); break;
+        case RenderOpType::DrawIndexed: commandList->DrawIndexedInstanced(d.count, d.instanceCount, d.firstIndex, 0, 0); break;
+        case RenderOpType::Draw: commandList->DrawInstanced(d.count, d.instanceCount, 0, 0); break;
+        }
+    }
+}
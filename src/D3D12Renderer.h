@@ -0,0 +1,19 @@
+#pragma once
+#include <d3d12.h>
+#include <utility>
+#include <vector>
+#include "Renderer.h"
+
+// Translates compiled command streams onto a direct command list. Pipeline ids index the table from setPipelines;
+// root parameter kDrawConstantsParameter holds the instance offset followed by the per-geometry constants.
+class D3D12Renderer final : public Renderer {
+public:
+    static constexpr UINT kDrawConstantsParameter = 1;
+    void setPipelines(std::vector<ID3D12PipelineState*> table) { pipelines = std::move(table); }
+    void setCommandList(ID3D12GraphicsCommandList* list) { commandList = list; }
+    void execute(const RenderCommandStream& stream) override;
+
+private:
+    ID3D12GraphicsCommandList* commandList{nullptr};
+    std::vector<ID3D12PipelineState*> pipelines;
+};
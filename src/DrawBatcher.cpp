@@ -0,0 +1,32 @@
+#include "DrawBatcher.h"
+#include <utility>
+
+void RadixSortDrawItems(std::vector<DrawItem>& items, std::vector<DrawItem>& scratch) {
+    const size_t n = items.size();
+    if (n < 2) return;
+    uint64_t varying = 0;
+    for (size_t i = 1; i < n; ++i) varying |= items[i].sortKey ^ items[0].sortKey;
+    scratch.resize(n);
+    DrawItem* src = items.data(); DrawItem* dst = scratch.data();
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (((varying >> shift) & 0xFFu) == 0) continue;
+        uint32_t counts[256] = {};
+        for (size_t i = 0; i < n; ++i) ++counts[(src[i].sortKey >> shift) & 0xFFu];
+        uint32_t sum = 0;
+        for (uint32_t& c : counts) { const uint32_t t = c; c = sum; sum += t; }
+        for (size_t i = 0; i < n; ++i) dst[counts[(src[i].sortKey >> shift) & 0xFFu]++] = src[i];
+        std::swap(src, dst);
+    }
+    if (src != items.data()) items.swap(scratch);
+}
+
+void DrawBatcher::build() {
+    RadixSortDrawItems(items, scratch);
+    order.resize(items.size());
+    drawBatches.clear();
+    for (size_t i = 0; i < items.size(); ++i) {
+        order[i] = items[i].objectIndex;
+        if (drawBatches.empty() || drawBatches.back().sortKey != items[i].sortKey) drawBatches.push_back({ items[i].sortKey, uint32_t(i), 0, items[i].objectIndex });
+        ++drawBatches.back().instanceCount;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct DrawItem {
+    uint64_t sortKey;
+    uint32_t objectIndex;
+};
+
+struct DrawBatch {
+    uint64_t sortKey;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+    uint32_t objectIndex;
+};
+
+inline uint64_t MakeDrawSortKey(uint32_t pipeline, uint32_t material, uint64_t geometry) {
+    return (uint64_t(pipeline & 0xFFu) << 56) | (uint64_t(material & 0xFFFFu) << 40) | (geometry & 0xFFFFFFFFFFull);
+}
+
+class DrawBatcher {
+public:
+    void clear() { items.clear(); }
+    void add(uint64_t sortKey, uint32_t objectIndex) { items.push_back({ sortKey, objectIndex }); }
+    void resize(size_t count) { items.resize(count); }
+    void set(size_t i, uint64_t sortKey, uint32_t objectIndex) { items[i] = { sortKey, objectIndex }; }
+    void build();
+
+    const std::vector<DrawBatch>& batches() const { return drawBatches; }
+    const std::vector<uint32_t>& instanceOrder() const { return order; }
+    size_t itemCount() const { return items.size(); }
+
+private:
+    std::vector<DrawItem> items;
+    std::vector<DrawItem> scratch;
+    std::vector<uint32_t> order;
+    std::vector<DrawBatch> drawBatches;
+};
+
+void RadixSortDrawItems(std::vector<DrawItem>& items, std::vector<DrawItem>& scratch);
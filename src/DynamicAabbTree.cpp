@@ -0,0 +1,166 @@
+#include "DynamicAabbTree.h"
+#include <algorithm>
+
+namespace {
+Aabb Fatten(const Aabb& b, float margin) { return { { b.min.x - margin, b.min.y - margin, b.min.z - margin }, { b.max.x + margin, b.max.y + margin, b.max.z + margin } }; }
+}
+
+int32_t DynamicAabbTree::allocateNode() {
+    if (freeList != kNull) { const int32_t i = freeList; freeList = nodes[size_t(i)].parent; nodes[size_t(i)] = Node{}; return i; }
+    nodes.emplace_back();
+    return int32_t(nodes.size() - 1);
+}
+
+void DynamicAabbTree::freeNode(int32_t index) { nodes[size_t(index)] = Node{}; nodes[size_t(index)].parent = freeList; nodes[size_t(index)].height = -1; freeList = index; }
+
+void DynamicAabbTree::clear() { nodes.clear(); root = kNull; freeList = kNull; proxies = 0; }
+
+int32_t DynamicAabbTree::createProxy(const Aabb& box, uint32_t userData) {
+    const int32_t leaf = allocateNode();
+    nodes[size_t(leaf)].box = Fatten(box, fatMargin); nodes[size_t(leaf)].userData = userData;
+    insertLeaf(leaf); ++proxies;
+    return leaf;
+}
+
+void DynamicAabbTree::destroyProxy(int32_t proxy) { removeLeaf(proxy); freeNode(proxy); --proxies; }
+
+bool DynamicAabbTree::moveProxy(int32_t proxy, const Aabb& box) {
+    if (ContainsAabb(nodes[size_t(proxy)].box, box)) return false;
+    removeLeaf(proxy);
+    nodes[size_t(proxy)].box = Fatten(box, fatMargin);
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicAabbTree::insertLeaf(int32_t leaf) {
+    if (root == kNull) { root = leaf; nodes[size_t(root)].parent = kNull; return; }
+    const Aabb leafBox = nodes[size_t(leaf)].box;
+    int32_t index = root;
+    while (!nodes[size_t(index)].isLeaf()) {
+        const Node& n = nodes[size_t(index)];
+        const float area = SurfaceArea(n.box);
+        const float combinedArea = SurfaceArea(UnionAabb(n.box, leafBox));
+        const float cost = 2.0f * combinedArea, inheritance = 2.0f * (combinedArea - area);
+        auto descendCost = [&](int32_t c) { const Node& child = nodes[size_t(c)]; const float merged = SurfaceArea(UnionAabb(leafBox, child.box)); return (child.isLeaf() ? merged : merged - SurfaceArea(child.box)) + inheritance; };
+        const float cost1 = descendCost(n.child1), cost2 = descendCost(n.child2);
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? n.child1 : n.child2;
+    }
+    const int32_t sibling = index;
+    const int32_t newParent = allocateNode();
+    const int32_t oldParent = nodes[size_t(sibling)].parent;
+    Node& p = nodes[size_t(newParent)];
+    p.parent = oldParent; p.box = UnionAabb(leafBox, nodes[size_t(sibling)].box); p.height = nodes[size_t(sibling)].height + 1;
+    p.child1 = sibling; p.child2 = leaf;
+    if (oldParent != kNull) { Node& op = nodes[size_t(oldParent)]; if (op.child1 == sibling) op.child1 = newParent; else op.child2 = newParent; }
+    else root = newParent;
+    nodes[size_t(sibling)].parent = newParent; nodes[size_t(leaf)].parent = newParent;
+    refitUpwards(nodes[size_t(leaf)].parent);
+}
+
+void DynamicAabbTree::removeLeaf(int32_t leaf) {
+    if (leaf == root) { root = kNull; return; }
+    const int32_t parent = nodes[size_t(leaf)].parent;
+    const int32_t grandParent = nodes[size_t(parent)].parent;
+    const int32_t sibling = nodes[size_t(parent)].child1 == leaf ? nodes[size_t(parent)].child2 : nodes[size_t(parent)].child1;
+    if (grandParent != kNull) {
+        Node& g = nodes[size_t(grandParent)];
+        if (g.child1 == parent) g.child1 = sibling; else g.child2 = sibling;
+        nodes[size_t(sibling)].parent = grandParent;
+        freeNode(parent);
+        refitUpwards(grandParent);
+    } else {
+        root = sibling; nodes[size_t(sibling)].parent = kNull;
+        freeNode(parent);
+    }
+}
+
+void DynamicAabbTree::refitUpwards(int32_t index) {
+    while (index != kNull) {
+        index = balance(index);
+        Node& n = nodes[size_t(index)];
+        const Node& c1 = nodes[size_t(n.child1)]; const Node& c2 = nodes[size_t(n.child2)];
+        n.height = 1 + std::max(c1.height, c2.height);
+        n.box = UnionAabb(c1.box, c2.box);
+        index = n.parent;
+    }
+}
+
+int32_t DynamicAabbTree::balance(int32_t iA) {
+    Node& A = nodes[size_t(iA)];
+    if (A.isLeaf() || A.height < 2) return iA;
+    const int32_t iB = A.child1, iC = A.child2;
+    Node& B = nodes[size_t(iB)]; Node& C = nodes[size_t(iC)];
+    const int32_t diff = C.height - B.height;
+    auto replaceInParent = [this, iA](int32_t parent, int32_t replacement) {
+        if (parent == kNull) { root = replacement; return; }
+        Node& P = nodes[size_t(parent)];
+        if (P.child1 == iA) P.child1 = replacement; else P.child2 = replacement;
+    };
+    if (diff > 1) {
+        const int32_t iF = C.child1, iG = C.child2;
+        Node& F = nodes[size_t(iF)]; Node& G = nodes[size_t(iG)];
+        C.child1 = iA; C.parent = A.parent; A.parent = iC;
+        replaceInParent(C.parent, iC);
+        if (F.height > G.height) {
+            C.child2 = iF; A.child2 = iG; G.parent = iA;
+            A.box = UnionAabb(B.box, G.box); C.box = UnionAabb(A.box, F.box);
+            A.height = 1 + std::max(B.height, G.height); C.height = 1 + std::max(A.height, F.height);
+        } else {
+            C.child2 = iG; A.child2 = iF; F.parent = iA;
+            A.box = UnionAabb(B.box, F.box); C.box = UnionAabb(A.box, G.box);
+            A.height = 1 + std::max(B.height, F.height); C.height = 1 + std::max(A.height, G.height);
+        }
+        return iC;
+    }
+    if (diff < -1) {
+        const int32_t iD = B.child1, iE = B.child2;
+        Node& D = nodes[size_t(iD)]; Node& E = nodes[size_t(iE)];
+        B.child1 = iA; B.parent = A.parent; A.parent = iB;
+        replaceInParent(B.parent, iB);
+        if (D.height > E.height) {
+            B.child2 = iD; A.child1 = iE; E.parent = iA;
+            A.box = UnionAabb(C.box, E.box); B.box = UnionAabb(A.box, D.box);
+            A.height = 1 + std::max(C.height, E.height); B.height = 1 + std::max(A.height, D.height);
+        } else {
+            B.child2 = iE; A.child1 = iD; D.parent = iA;
+            A.box = UnionAabb(C.box, D.box); B.box = UnionAabb(A.box, E.box);
+            A.height = 1 + std::max(C.height, D.height); B.height = 1 + std::max(A.height, E.height);
+        }
+        return iB;
+    }
+    return iA;
+}
+
+void DynamicAabbTree::collectLeaves(int32_t index, std::vector<uint32_t>& out) const {
+    int32_t stack[128]; int sp = 0; stack[sp++] = index;
+    while (sp > 0) {
+        const Node& n = nodes[size_t(stack[--sp])];
+        if (n.isLeaf()) out.push_back(n.userData);
+        else { stack[sp++] = n.child1; stack[sp++] = n.child2; }
+    }
+}
+
+void DynamicAabbTree::collectFrontier(size_t targetCount, std::vector<int32_t>& outNodes) const {
+    outNodes.clear();
+    if (root == kNull) return;
+    outNodes.push_back(root);
+    for (size_t i = 0; i < outNodes.size() && outNodes.size() < targetCount;) {
+        const Node& n = nodes[size_t(outNodes[i])];
+        if (n.isLeaf()) { ++i; continue; }
+        outNodes[i] = n.child1; outNodes.push_back(n.child2);
+    }
+}
+
+void DynamicAabbTree::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& outUserData, int32_t startNode) const {
+    int32_t stack[128]; int sp = 0; stack[sp++] = startNode;
+    while (sp > 0) {
+        const int32_t index = stack[--sp];
+        const Node& n = nodes[size_t(index)];
+        const CullResult r = TestAabb(frustum, n.box);
+        if (r == CullResult::Outside) continue;
+        if (n.isLeaf()) outUserData.push_back(n.userData);
+        else if (r == CullResult::Inside) collectLeaves(index, outUserData);
+        else { stack[sp++] = n.child1; stack[sp++] = n.child2; }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+
+class DynamicAabbTree {
+public:
+    static constexpr int32_t kNull = -1;
+
+    explicit DynamicAabbTree(float margin = 0.1f) : fatMargin(margin) {}
+
+    int32_t createProxy(const Aabb& box, uint32_t userData);
+    void destroyProxy(int32_t proxy);
+    bool moveProxy(int32_t proxy, const Aabb& box);
+    void clear();
+
+    uint32_t userData(int32_t proxy) const { return nodes[size_t(proxy)].userData; }
+    void setUserData(int32_t proxy, uint32_t value) { nodes[size_t(proxy)].userData = value; }
+    const Aabb& fatAabb(int32_t proxy) const { return nodes[size_t(proxy)].box; }
+    size_t proxyCount() const { return proxies; }
+    int32_t height() const { return root == kNull ? 0 : nodes[size_t(root)].height; }
+    int32_t rootNode() const { return root; }
+
+    void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& outUserData) const { if (root != kNull) queryFrustum(frustum, outUserData, root); }
+    void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& outUserData, int32_t startNode) const;
+    void collectFrontier(size_t targetCount, std::vector<int32_t>& outNodes) const;
+
+    template <typename Fn>
+    void queryAabb(const Aabb& box, Fn&& fn) const {
+        if (root == kNull) return;
+        int32_t stack[128]; int sp = 0; stack[sp++] = root;
+        while (sp > 0) {
+            const Node& n = nodes[size_t(stack[--sp])];
+            if (n.box.max.x < box.min.x || n.box.min.x > box.max.x || n.box.max.y < box.min.y || n.box.min.y > box.max.y || n.box.max.z < box.min.z || n.box.min.z > box.max.z) continue;
+            if (n.isLeaf()) fn(n.userData);
+            else { stack[sp++] = n.child1; stack[sp++] = n.child2; }
+        }
+    }
+
+    // Leaves whose fat box the ray enters before maxT, nearer subtree first. fn(userData) returns the new maxT, e.g. the
+    // closest hit so far, and subtrees the ray only reaches beyond it are skipped.
+    template <typename Fn>
+    void queryRay(const Float3& origin, const Float3& direction, float maxT, Fn&& fn) const {
+        if (root == kNull) return;
+        const Float3 inv{ 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+        struct Entry { int32_t node; float t; };
+        Entry stack[128]; int sp = 0; float t;
+        if (IntersectRayAabb(nodes[size_t(root)].box, origin, inv, maxT, t)) stack[sp++] = { root, t };
+        while (sp > 0) {
+            const Entry e = stack[--sp];
+            if (e.t > maxT) continue;
+            const Node& n = nodes[size_t(e.node)];
+            if (n.isLeaf()) { const float hit = fn(n.userData); maxT = hit < maxT ? hit : maxT; continue; }
+            float t1, t2; const bool hit1 = IntersectRayAabb(nodes[size_t(n.child1)].box, origin, inv, maxT, t1), hit2 = IntersectRayAabb(nodes[size_t(n.child2)].box, origin, inv, maxT, t2);
+            if (hit1 && hit2) { if (t1 <= t2) { stack[sp++] = { n.child2, t2 }; stack[sp++] = { n.child1, t1 }; } else { stack[sp++] = { n.child1, t1 }; stack[sp++] = { n.child2, t2 }; } }
+            else if (hit1) stack[sp++] = { n.child1, t1 };
+            else if (hit2) stack[sp++] = { n.child2, t2 };
+        }
+    }
+
+    struct Node {
+        Aabb box;
+        int32_t parent{kNull};
+        int32_t child1{kNull};
+        int32_t child2{kNull};
+        int32_t height{0};
+        uint32_t userData{0};
+        bool isLeaf() const { return child1 == kNull; }
+    };
+    const Node& node(int32_t index) const { return nodes[size_t(index)]; }
+
+private:
+    int32_t allocateNode();
+    void freeNode(int32_t index);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    int32_t balance(int32_t index);
+    void refitUpwards(int32_t index);
+    void collectLeaves(int32_t index, std::vector<uint32_t>& out) const;
+
+    std::vector<Node> nodes;
+    int32_t root{kNull};
+    int32_t freeList{kNull};
+    size_t proxies{0};
+    float fatMargin;
+};
@@ -3,14 +3,36 @@
 #include <filesystem>
 #include <assert.h>
 #include <cmath>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <string_view>
 #include "imgui.h"
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx12.h"
 #include "ObjLoader.h"
+#include "MeshOptimizer.h"
+#include "MeshCache.h"
+#include "SceneFile.h"
+#include "AllocationCounter.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
 
+static_assert(sizeof(Float4x4) == sizeof(XMFLOAT4X4), "Float4x4 must match XMFLOAT4X4 layout");
+static_assert(sizeof(PositionDequantize) == kRenderDrawConstants * sizeof(uint32_t), "draw constants carry the dequantization transform");
+
+// Pass a ScratchArena's resource for names that only live until they are interned or drawn.
+static std::pmr::string ToUtf8(const std::wstring& w, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+    if (w.empty()) return std::pmr::string(memory); const int n = WideCharToMultiByte(CP_UTF8, 0, w.data(), int(w.size()), nullptr, 0, nullptr, nullptr);
+    std::pmr::string s(size_t(std::max(n, 0)), '\0', memory); if (n > 0) WideCharToMultiByte(CP_UTF8, 0, w.data(), int(w.size()), s.data(), n, nullptr, nullptr); return s;
+}
+
+static std::wstring FromUtf8(std::string_view s) {
+    if (s.empty()) return {}; const int n = MultiByteToWideChar(CP_UTF8, 0, s.data(), int(s.size()), nullptr, 0);
+    std::wstring w(size_t(std::max(n, 0)), L'\0'); if (n > 0) MultiByteToWideChar(CP_UTF8, 0, s.data(), int(s.size()), w.data(), n); return w;
+}
+
 static ComPtr<IDXGIAdapter1> SelectHardwareAdapter(ComPtr<IDXGIFactory6> factory) {
     ComPtr<IDXGIAdapter1> bestAdapter; SIZE_T bestVideoMemory = 0; ComPtr<IDXGIAdapter1> adapter;
     for (UINT i = 0; factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; ++i) { DXGI_ADAPTER_DESC1 d{}; adapter->GetDesc1(&d); if (d.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) continue; if (d.DedicatedVideoMemory > bestVideoMemory) { bestVideoMemory = d.DedicatedVideoMemory; bestAdapter = adapter; } }
@@ -23,20 +45,163 @@ Engine::Engine(UINT width, UINT height) : clientWidth(width), clientHeight(heigh
 
 std::vector<uint8_t> Engine::readFileBytes(const std::wstring& path) { std::ifstream f(path, std::ios::binary); if (!f) return {}; f.seekg(0, std::ios::end); size_t size = static_cast<size_t>(f.tellg()); f.seekg(0, std::ios::beg); std::vector<uint8_t> data(size); f.read(reinterpret_cast<char*>(data.data()), size); return data; }
 
-bool Engine::uploadVerticesToBuffer(const std::vector<XMFLOAT3>& vertices, ComPtr<ID3D12Resource>& outVB, D3D12_VERTEX_BUFFER_VIEW& outVBV) {
-    D3D12_HEAP_PROPERTIES heapProps{}; heapProps.Type = D3D12_HEAP_TYPE_UPLOAD; D3D12_RESOURCE_DESC resDesc{}; resDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER; resDesc.Width = UINT(vertices.size() * sizeof(XMFLOAT3)); resDesc.Height = 1; resDesc.DepthOrArraySize = 1; resDesc.MipLevels = 1; resDesc.SampleDesc.Count = 1; resDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR; outVB.Reset(); if (FAILED(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &resDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&outVB)))) return false; void* mapped = nullptr; D3D12_RANGE readRange{0,0}; outVB->Map(0, &readRange, &mapped); memcpy(mapped, vertices.data(), vertices.size() * sizeof(XMFLOAT3)); outVB->Unmap(0, nullptr); outVBV.BufferLocation = outVB->GetGPUVirtualAddress(); outVBV.StrideInBytes = sizeof(XMFLOAT3); outVBV.SizeInBytes = UINT(vertices.size() * sizeof(XMFLOAT3)); return true;
+bool Engine::createBuffer(UINT64 byteSize, D3D12_HEAP_TYPE heap, D3D12_RESOURCE_STATES state, ComPtr<ID3D12Resource>& outBuffer) {
+    D3D12_HEAP_PROPERTIES heapProps{}; heapProps.Type = heap; D3D12_RESOURCE_DESC resDesc{}; resDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER; resDesc.Width = byteSize; resDesc.Height = 1; resDesc.DepthOrArraySize = 1; resDesc.MipLevels = 1; resDesc.SampleDesc.Count = 1; resDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR; outBuffer.Reset(); return SUCCEEDED(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &resDesc, state, nullptr, IID_PPV_ARGS(&outBuffer)));
+}
+
+bool Engine::createConstantRing(UINT64 capacity) {
+    D3D12_HEAP_PROPERTIES hp{}; hp.Type = D3D12_HEAP_TYPE_UPLOAD; D3D12_RESOURCE_DESC rd{}; rd.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER; rd.Width = capacity; rd.Height = 1; rd.DepthOrArraySize = 1; rd.MipLevels = 1; rd.SampleDesc.Count = 1; rd.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    ComPtr<ID3D12Resource> buffer; if (FAILED(device->CreateCommittedResource(&hp, D3D12_HEAP_FLAG_NONE, &rd, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&buffer)))) return false; uint8_t* mapped = nullptr; D3D12_RANGE rr{0,0}; if (FAILED(buffer->Map(0, &rr, reinterpret_cast<void**>(&mapped)))) return false;
+    if (constantRingBuffer) { retiredConstantRings.push_back({ constantRingBuffer, renderSerial }); constantRing.grow(capacity); } else constantRing.reset(capacity);
+    constantRingBuffer = buffer; constantRingMapped = mapped; return true;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS Engine::allocateUpload(size_t byteSize, void** outCpu) {
+    UINT64 offset = constantRing.allocate(byteSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    if (offset == UploadRing::kInvalidOffset) { UINT64 capacity = constantRing.capacity() * 2; while (capacity < byteSize) capacity *= 2; if (!createConstantRing(capacity)) return 0; offset = constantRing.allocate(byteSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT); if (offset == UploadRing::kInvalidOffset) return 0; }
+    *outCpu = constantRingMapped + offset; return constantRingBuffer->GetGPUVirtualAddress() + offset;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS Engine::allocateConstants(const void* data, size_t byteSize) { void* cpu = nullptr; D3D12_GPU_VIRTUAL_ADDRESS gpu = allocateUpload(byteSize, &cpu); if (gpu) memcpy(cpu, data, byteSize); return gpu; }
+
+void Engine::retireUploads() {
+    const UINT64 completed = fence->GetCompletedValue(); constantRing.retire(completed);
+    retiredConstantRings.erase(std::remove_if(retiredConstantRings.begin(), retiredConstantRings.end(), [completed](const RetiredBuffer& r) { return r.fenceValue <= completed; }), retiredConstantRings.end());
+}
+
+bool Engine::createStagingBuffer(UINT64 capacity) {
+    ComPtr<ID3D12Resource> buffer; if (!createBuffer(capacity, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ, buffer)) return false; uint8_t* mapped = nullptr; D3D12_RANGE rr{0,0}; if (FAILED(buffer->Map(0, &rr, reinterpret_cast<void**>(&mapped)))) return false;
+    if (stagingBuffer) stagingRing.grow(capacity); else stagingRing.reset(capacity);
+    stagingBuffer = buffer; stagingMapped = mapped; return true;
+}
+
+bool Engine::reserveStaging(UINT64 byteSize) { if (byteSize <= stagingRing.capacity()) return true; if (stagingRing.bytesInFlight() != 0) return false; return createStagingBuffer(std::bit_ceil(byteSize)); }
+
+std::shared_ptr<GeometryRange> Engine::allocateGeometry(UINT64 byteSize) {
+    // Ranges are released on the main thread when neither the scene nor a snapshot holds them; no frame after frameSerial can draw them.
+    auto release = [this](GeometryRange* r) { geometryBlocks[r->block].allocator.freeAfter(r->allocation, frameSerial); delete r; };
+    for (uint32_t b = 0; b < geometryBlocks.size(); ++b) { const TlsfAllocation a = geometryBlocks[b].allocator.allocate(byteSize); if (a.isValid()) return std::shared_ptr<GeometryRange>(new GeometryRange{ b, a }, release); }
+    GeometryBlock block; const UINT64 capacity = std::max(kGeometryBlockBytes, std::bit_ceil(byteSize)); if (!createBuffer(capacity, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COMMON, block.buffer)) return nullptr; block.allocator.reset(capacity);
+    const TlsfAllocation a = block.allocator.allocate(byteSize); if (!a.isValid()) return nullptr; geometryBlocks.push_back(std::move(block));
+    return std::shared_ptr<GeometryRange>(new GeometryRange{ uint32_t(geometryBlocks.size() - 1), a }, release);
+}
+
+// Quantization, normal packing and index narrowing happen while writing the staging buffer, so the cooked data stays float/32-bit.
+bool Engine::stageGeometry(const GeometryRange& range, const GeometryFormat& format, const Aabb& bounds, const Float3* positions, const uint32_t* normals, UINT vertexCount, const uint32_t* indices, UINT indexCount) {
+    const UINT64 vbBytes = format.vertexBytes(vertexCount), ibBytes = format.indexBytes(indexCount);
+    const UINT64 offset = stagingRing.allocate(vbBytes + ibBytes, sizeof(uint32_t)); if (offset == UploadRing::kInvalidOffset) return false;
+    if (format.vertex == MeshVertexFormat::Quantized16) QuantizePositions(positions, vertexCount, PositionDequantizeFor(bounds), reinterpret_cast<QuantizedPosition*>(stagingMapped + offset), normals); else PackFloatVertices(positions, normals, vertexCount, reinterpret_cast<FloatVertex*>(stagingMapped + offset));
+    if (format.shortIndices) { uint16_t* dst = reinterpret_cast<uint16_t*>(stagingMapped + offset + vbBytes); for (UINT i=0; i<indexCount; ++i) dst[i] = uint16_t(indices[i]); } else memcpy(stagingMapped + offset + vbBytes, indices, size_t(ibBytes));
+    if (!copyRecording) { copyAllocator->Reset(); copyList->Reset(copyAllocator.Get(), nullptr); copyRecording = true; }
+    copyList->CopyBufferRegion(geometryBlocks[range.block].buffer.Get(), range.allocation.offset, stagingBuffer.Get(), offset, vbBytes + ibBytes); return true;
+}
+
+void Engine::submitCopies() {
+    if (!copyRecording) return; copyRecording = false;
+    copyList->Close(); ID3D12CommandList* lists[] = { copyList.Get() }; copyQueue->ExecuteCommandLists(1, lists); copyQueue->Signal(copyFence.Get(), ++copyFenceValue); stagingRing.endFrame(copyFenceValue);
+}
+
+void Engine::waitForCopyQueue() { if (copyFence->GetCompletedValue() < copyFenceValue) { copyFence->SetEventOnCompletion(copyFenceValue, fenceEvent); WaitForSingleObject(fenceEvent, INFINITE); } stagingRing.retire(copyFenceValue); }
+
+// Every LOD indexes the same vertices, so one index buffer view covers the whole chain and draws pick a range.
+void Engine::bindGeometry(MeshObject& m, std::shared_ptr<GeometryRange> geometry, const GeometryFormat& format, UINT vertexCount, UINT indexCount, const MeshLod* lods, uint32_t lodCount) {
+    const D3D12_GPU_VIRTUAL_ADDRESS base = geometryBlocks[geometry->block].buffer->GetGPUVirtualAddress() + geometry->allocation.offset;
+    m.vertexCount = vertexCount; m.indexCount = indexCount; m.geometry = std::move(geometry); m.meshlets.reset(); m.format = format; m.dequantize = format.vertex == MeshVertexFormat::Quantized16 ? PositionDequantizeFor(m.localBounds) : PositionDequantize{ {1,1,1}, {0,0,0} };
+    if (lods && lodCount > 0) { m.lodCount = std::min(lodCount, kMaxMeshLods); std::copy(lods, lods + m.lodCount, m.lods.begin()); } else { m.lodCount = 1; m.lods[0] = { 0, indexCount, 0.0f }; } m.lod = 0;
+    m.vbv.BufferLocation = base; m.vbv.StrideInBytes = UINT(VertexStride(format.vertex)); m.vbv.SizeInBytes = UINT(format.vertexBytes(vertexCount));
+    m.ibv.BufferLocation = base + m.vbv.SizeInBytes; m.ibv.Format = format.shortIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT; m.ibv.SizeInBytes = UINT(format.indexBytes(indexCount));
+}
+
+bool Engine::createMeshGeometry(const Float3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, MeshObject& m) {
+    if (vertexCount == 0 || indexCount == 0) return false; waitForCopyQueue();
+    const GeometryFormat format = geometryFormatFor(UINT(vertexCount)); const Aabb bounds = ComputeAabb(positions, vertexCount);
+    const UINT64 bytes = format.bytes(UINT(vertexCount), UINT(indexCount)); std::shared_ptr<GeometryRange> range = allocateGeometry(bytes); std::vector<uint32_t> normals; ComputeVertexNormals(positions, vertexCount, indices, indexCount, normals);
+    if (!range || !reserveStaging(bytes) || !stageGeometry(*range, format, bounds, positions, normals.data(), UINT(vertexCount), indices, UINT(indexCount))) return false; submitCopies(); waitForCopyQueue();
+    m.localBounds = bounds; m.localSphere = ComputeBoundingSphere(positions, vertexCount);
+    { auto cpu = std::make_shared<MeshCpuData>(); cpu->ownedPositions.assign(positions, positions + vertexCount); cpu->ownedIndices.assign(indices, indices + indexCount); BuildMeshBvh(positions, indices, indexCount, cpu->ownedBvh);
+      cpu->triangles = { cpu->ownedPositions.data(), uint32_t(vertexCount), cpu->ownedIndices.data(), uint32_t(indexCount) }; cpu->bvhNodes = cpu->ownedBvh.nodes.data(); cpu->bvhTriangles = cpu->ownedBvh.triangles.data(); m.cpu = std::move(cpu); }
+    m.geometryId = nextGeometryId++; bindGeometry(m, std::move(range), format, UINT(vertexCount), UINT(indexCount)); return true;
+}
+
+void Engine::addMeshObject(MeshObject&& m) {
+    if (!scene.transforms.isAlive(m.transform)) m.transform = scene.transforms.create(); m.cullProxy = scene.meshTree.createProxy(m.localBounds, uint32_t(scene.meshes.size())); scene.transforms.setUserData(m.transform, uint32_t(m.cullProxy)); { ScratchArena scratch; hierarchyView.add(m.transform, ToUtf8(m.name, scratch.resource()), int32_t(scene.meshes.size())); } scene.meshes.push_back(std::move(m)); if (scene.selectedMesh < 0) scene.selectedMesh = 0;
+}
+
+bool Engine::createMeshObject(const std::wstring& name, const Float3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount) {
+    MeshObject m; m.name = name; if (!createMeshGeometry(positions, vertexCount, indices, indexCount, m)) return false; addMeshObject(std::move(m)); return true;
+}
+
+static void BuildCubeMesh(std::vector<Float3>& verts, std::vector<uint32_t>& indices) {
+    const float s = 0.5f; const Float3 v[] = { {-s,-s,-s},{-s, s,-s},{ s, s,-s}, { s, s,-s},{ s,-s,-s},{-s,-s,-s}, {-s,-s, s},{ s,-s, s},{ s, s, s}, { s, s, s},{-s, s, s},{-s,-s, s}, {-s, s,-s},{-s, s, s},{-s,-s, s}, {-s,-s, s},{-s,-s,-s},{-s, s,-s}, { s, s,-s},{ s,-s,-s},{ s,-s, s}, { s,-s, s},{ s, s, s},{ s, s,-s}, {-s,-s,-s},{ s,-s,-s},{ s,-s, s}, { s,-s, s},{-s,-s, s},{-s,-s,-s}, {-s, s,-s},{-s, s, s},{ s, s, s}, { s, s, s},{ s, s,-s},{-s, s,-s}, };
+    verts.assign(std::begin(v), std::end(v)); indices.resize(verts.size()); for (size_t i = 0; i < indices.size(); ++i) indices[i] = uint32_t(i); OptimizeMesh(verts, indices);
 }
 
 bool Engine::createCubeObject(const std::wstring& name) {
-    const float s = 0.5f; const XMFLOAT3 v[] = { {-s,-s,-s},{-s, s,-s},{ s, s,-s}, { s, s,-s},{ s,-s,-s},{-s,-s,-s}, {-s,-s, s},{ s,-s, s},{ s, s, s}, { s, s, s},{-s, s, s},{-s,-s, s}, {-s, s,-s},{-s, s, s},{-s,-s, s}, {-s,-s, s},{-s,-s,-s},{-s, s,-s}, { s, s,-s},{ s,-s,-s},{ s,-s, s}, { s,-s, s},{ s, s, s},{ s, s,-s}, {-s,-s,-s},{ s,-s,-s},{ s,-s, s}, { s,-s, s},{-s,-s, s},{-s,-s,-s}, {-s, s,-s},{-s, s, s},{ s, s, s}, { s, s, s},{ s, s,-s},{-s, s,-s}, };
-    std::vector<XMFLOAT3> verts(std::begin(v), std::end(v)); MeshObject m; m.name = name; m.vertexCount = UINT(verts.size()); if (!uploadVerticesToBuffer(verts, m.vertexBuffer, m.vbv)) return false; scene.meshes.push_back(std::move(m)); if (scene.selectedMesh < 0) scene.selectedMesh = 0; return true;
+    std::vector<Float3> verts; std::vector<uint32_t> indices; BuildCubeMesh(verts, indices); return createMeshObject(name, verts.data(), verts.size(), indices.data(), indices.size());
 }
 
-bool Engine::createObjObject(const std::wstring& path, const std::wstring& name) {
-    ObjMeshData mesh; if (!LoadObjPositionsAndIndices(path, mesh)) return false; if (mesh.indices.empty() || mesh.positions.empty()) return false; std::vector<XMFLOAT3> vertices; vertices.reserve(mesh.indices.size()); for (uint32_t idx : mesh.indices) vertices.push_back(mesh.positions[idx]); MeshObject m; m.name = name; m.vertexCount = UINT(vertices.size()); if (!uploadVerticesToBuffer(vertices, m.vertexBuffer, m.vbv)) return false; scene.meshes.push_back(std::move(m)); if (scene.selectedMesh < 0) scene.selectedMesh = 0; return true;
+void Engine::streamObjObject(const std::wstring& path, const std::wstring& name) {
+    MeshObject m = placeholderMesh; m.name = name; m.sourcePath = path; m.pendingLoad = assetStreamer.request(std::filesystem::path(path)); addMeshObject(std::move(m));
 }
 
-void Engine::createLightObject(const std::wstring& name) { LightObject l; l.name = name; l.color = {1,1,1}; l.intensity = 1.0f; l.transform.position = {0,1,0}; scene.lights.push_back(std::move(l)); if (scene.selectedLight < 0) scene.selectedLight = 0; }
+bool Engine::createCopyQueue() {
+    D3D12_COMMAND_QUEUE_DESC q{}; q.Type = D3D12_COMMAND_LIST_TYPE_COPY; if (FAILED(device->CreateCommandQueue(&q, IID_PPV_ARGS(&copyQueue)))) return false;
+    if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&copyAllocator)))) return false;
+    if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, copyAllocator.Get(), nullptr, IID_PPV_ARGS(&copyList)))) return false; copyList->Close();
+    return SUCCEEDED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&copyFence)));
+}
+
+// Streamed meshes become drawable only once the CPU has observed the copy fence, so the direct queue never needs a GPU-side wait.
+void Engine::pumpAssetStreaming() {
+    PROFILE_ZONE("Asset streaming");
+    const UINT64 copied = copyFence->GetCompletedValue(); stagingRing.retire(copied);
+    { const UINT64 completed = fence->GetCompletedValue(); for (GeometryBlock& b : geometryBlocks) b.allocator.retire(completed); }
+    for (auto it = meshUploads.begin(); it != meshUploads.end();) {
+        if (it->fenceValue == 0 || it->fenceValue > copied) { ++it; continue; }
+        auto cpu = std::make_shared<MeshCpuData>(); cpu->cooked = std::move(it->payload->mesh); const CookedMesh& cooked = cpu->cooked; const uint32_t geometryId = nextGeometryId++; const Sphere sphere = ComputeBoundingSphere(cooked.positions(), cooked.vertexCount());
+        std::shared_ptr<const std::vector<Meshlet>> meshlets; if (cooked.meshletCount() > 1) meshlets = std::make_shared<const std::vector<Meshlet>>(cooked.meshlets(), cooked.meshlets() + cooked.meshletCount());
+        const MeshLod& full = cooked.lods()[0]; cpu->triangles = { cooked.positions(), cooked.vertexCount(), cooked.indices() + full.firstIndex, full.indexCount };
+        if (cooked.bvhNodeCount()) { cpu->bvhNodes = cooked.bvhNodes(); cpu->bvhTriangles = cooked.bvhTriangles(); } else { BuildMeshBvh(cpu->triangles.positions, cpu->triangles.indices, cpu->triangles.indexCount, cpu->ownedBvh); cpu->bvhNodes = cpu->ownedBvh.nodes.data(); cpu->bvhTriangles = cpu->ownedBvh.triangles.data(); }
+        for (MeshObject& m : scene.meshes) {
+            if (m.pendingLoad != it->handle) continue;
+            m.pendingLoad = {}; m.localBounds = cooked.info().bounds; m.localSphere = sphere; bindGeometry(m, it->geometry, it->format, cooked.vertexCount(), cooked.indexCount(), cooked.lods(), cooked.lodCount()); m.geometryId = geometryId; m.meshlets = meshlets; m.cpu = cpu;
+            scene.meshTree.moveProxy(m.cullProxy, TransformAabb(m.localBounds, scene.transforms.world(m.transform)));
+        }
+        it = meshUploads.erase(it);
+    }
+
+    streamCompletions.clear(); assetStreamer.drainCompleted(streamCompletions);
+    for (StreamCompletion& c : streamCompletions) {
+        if (c.state == StreamState::Ready) { lastMeshCookStats = c.payload->stats; for (auto& a : assetObjFiles) if (std::filesystem::path(a.path) == c.payload->source) a.cooked = true; meshUploads.push_back({ c.handle, std::move(c.payload) }); }
+        else if (c.state == StreamState::Failed) failPendingLoad(c.handle);
+    }
+
+    if (copied < copyFenceValue) return;
+    for (auto it = meshUploads.begin(); it != meshUploads.end();) {
+        PendingMeshUpload& u = *it;
+        if (u.fenceValue != 0) { ++it; continue; }
+        const CookedMesh& cooked = u.payload->mesh; if (!u.geometry) u.format = geometryFormatFor(cooked.vertexCount()); const UINT64 bytes = u.format.bytes(cooked.vertexCount(), cooked.indexCount());
+        if (!reserveStaging(bytes)) break;
+        if (!u.geometry && !(u.geometry = allocateGeometry(bytes))) {
+            if (++u.allocationAttempts < kMaxGeometryAllocationAttempts) { ++it; continue; }
+            failPendingLoad(u.handle); it = meshUploads.erase(it); continue;
+        }
+        if (!stageGeometry(*u.geometry, u.format, cooked.info().bounds, cooked.positions(), cooked.normals(), cooked.vertexCount(), cooked.indices(), cooked.indexCount())) break;
+        u.fenceValue = copyFenceValue + 1; ++it;
+    }
+    submitCopies();
+}
+
+// The meshes keep their placeholder geometry and are renamed so the hierarchy shows which loads gave up.
+void Engine::failPendingLoad(StreamHandle handle) {
+    for (MeshObject& m : scene.meshes) if (m.pendingLoad == handle) { m.pendingLoad = {}; m.name += L" (failed)"; ScratchArena scratch; hierarchyView.rename(m.transform, ToUtf8(m.name, scratch.resource())); }
+}
+
+void Engine::createLightObject(const std::wstring& name) { LightObject l; l.name = name; l.color = {1,1,1}; l.intensity = 1.0f; l.transform = scene.transforms.create({0,1,0}); addLightObject(std::move(l)); }
+
+void Engine::addLightObject(LightObject&& l) {
+    l.cullProxy = scene.lightTree.createProxy(LightBounds(scene.transforms.world(l.transform), l.intensity), uint32_t(scene.lights.size())); scene.transforms.setUserData(l.transform, kLightProxyFlag | uint32_t(l.cullProxy)); { ScratchArena scratch; hierarchyView.add(l.transform, ToUtf8(l.name, scratch.resource()), ~int32_t(scene.lights.size())); } scene.lights.push_back(std::move(l)); if (scene.selectedLight < 0) scene.selectedLight = 0;
+}
 
 bool Engine::initialize(HWND windowHandle) {
     hwnd = windowHandle;
@@ -49,50 +214,274 @@ bool Engine::initialize(HWND windowHandle) {
 #endif
     if (FAILED(CreateDXGIFactory2(factoryFlags, IID_PPV_ARGS(&dxgiFactory)))) return false; BOOL allowTearing = FALSE; if (SUCCEEDED(dxgiFactory->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing)))) tearingSupported = allowTearing == TRUE; ComPtr<IDXGIAdapter1> ad = SelectHardwareAdapter(dxgiFactory); if (ad) { if (FAILED(D3D12CreateDevice(ad.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device)))) return false; } else { ComPtr<IDXGIAdapter> warp; if (FAILED(dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(&warp)))) return false; if (FAILED(D3D12CreateDevice(warp.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device)))) return false; }
     D3D12_COMMAND_QUEUE_DESC q{}; q.Type = D3D12_COMMAND_LIST_TYPE_DIRECT; q.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE; if (FAILED(device->CreateCommandQueue(&q, IID_PPV_ARGS(&commandQueue)))) return false; createSwapChain(); rtvDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV); D3D12_DESCRIPTOR_HEAP_DESC rtv{}; rtv.NumDescriptors = kFrameCount; rtv.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV; if (FAILED(device->CreateDescriptorHeap(&rtv, IID_PPV_ARGS(&rtvDescriptorHeap)))) return false; D3D12_DESCRIPTOR_HEAP_DESC dsv{}; dsv.NumDescriptors = 1; dsv.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV; if (FAILED(device->CreateDescriptorHeap(&dsv, IID_PPV_ARGS(&dsvDescriptorHeap)))) return false; createRenderTargets(); createDepthResources(); for (UINT i=0;i<kFrameCount;++i) { if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocators[i])))) return false; }
-    if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators[currentFrameIndex].Get(), nullptr, IID_PPV_ARGS(&commandList)))) return false; commandList->Close(); if (FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)))) return false; fenceValues[currentFrameIndex]=1; fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr); if (!fenceEvent) return false; if (!createPipeline()) return false; if (!createCubeObject(L"Cube")) return false; createLightObject(L"Light"); for (UINT i=0;i<kFrameCount;++i) { D3D12_HEAP_PROPERTIES hp{}; hp.Type = D3D12_HEAP_TYPE_UPLOAD; D3D12_RESOURCE_DESC rd{}; rd.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER; rd.Width = 256; rd.Height = 1; rd.DepthOrArraySize = 1; rd.MipLevels = 1; rd.SampleDesc.Count = 1; rd.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR; if (FAILED(device->CreateCommittedResource(&hp, D3D12_HEAP_FLAG_NONE, &rd, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&cameraCBs[i])))) return false; D3D12_RANGE rr{0,0}; cameraCBs[i]->Map(0, &rr, reinterpret_cast<void**>(&cameraCBMapped[i])); }
-    if (!initImGui()) return false; frameTimeMs.assign(240,0.0f); QueryPerformanceFrequency(&perfFreq); QueryPerformanceCounter(&lastCounter); timingInitialized = true; scene.selectedMesh = scene.meshes.empty() ? -1 : 0; initAssetsDir(); scanAssets(); return true;
+    if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators[currentFrameIndex].Get(), nullptr, IID_PPV_ARGS(&commandList)))) return false; commandList->Close(); if (FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)))) return false; fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr); renderFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr); if (!fenceEvent || !renderFenceEvent) return false; if (!createCopyQueue() || !createStagingBuffer(kInitialStagingBytes)) return false; if (!createPipeline()) return false;
+#if GGINE_ENABLE_PROFILER
+    PROFILE_THREAD("Main"); createTimestampQueries();
+#endif
+    { std::vector<Float3> verts; std::vector<uint32_t> indices; BuildCubeMesh(verts, indices); placeholderMesh.name = L"Placeholder"; if (!createMeshGeometry(verts.data(), verts.size(), indices.data(), indices.size(), placeholderMesh)) return false; }
+    initAssetsDir(); if (!loadScene(sceneFileW)) { if (!createCubeObject(L"Cube")) return false; createLightObject(L"Light"); } if (!createConstantRing(kInitialConstantRingBytes)) return false;
+    if (!initImGui()) return false; frameTimeMs.assign(240,0.0f); QueryPerformanceFrequency(&perfFreq); QueryPerformanceCounter(&lastCounter); timingInitialized = true; scene.selectedMesh = scene.meshes.empty() ? -1 : 0; syncAssetIndex();
+    previousCamera = cameraPose(); framePipeline = std::make_unique<FramePipeline<FrameSnapshot>>([this](FrameSnapshot& frame) { recordFrame(frame); }); return true;
 }
 
 bool Engine::createPipeline() {
     D3D12_DESCRIPTOR_HEAP_DESC heapDesc{}; heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV; heapDesc.NumDescriptors = 1; heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE; if (FAILED(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&imguiSrvHeap)))) return false; D3D12_FEATURE_DATA_ROOT_SIGNATURE feat{}; feat.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1; if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &feat, sizeof(feat)))) { feat.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0; }
-    D3D12_ROOT_PARAMETER1 param{}; param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV; param.ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX; param.Descriptor.ShaderRegister = 0; param.Descriptor.RegisterSpace = 0; D3D12_VERSIONED_ROOT_SIGNATURE_DESC rs{}; rs.Version = D3D_ROOT_SIGNATURE_VERSION_1_1; D3D12_ROOT_SIGNATURE_DESC1 rs1{}; rs1.NumParameters = 1; rs1.pParameters = &param; rs1.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT; rs.Desc_1_1 = rs1; ComPtr<ID3DBlob> s; ComPtr<ID3DBlob> e; if (FAILED(D3D12SerializeVersionedRootSignature(&rs, &s, &e))) return false; if (FAILED(device->CreateRootSignature(0, s->GetBufferPointer(), s->GetBufferSize(), IID_PPV_ARGS(&rootSignature)))) return false; std::filesystem::path exeDir; wchar_t modulePath[MAX_PATH]; GetModuleFileNameW(nullptr, modulePath, MAX_PATH); exeDir = std::filesystem::path(modulePath).parent_path(); auto vsBytes = readFileBytes((exeDir / L"shaders/triangle_vs.cso").wstring()); auto psBytes = readFileBytes((exeDir / L"shaders/triangle_ps.cso").wstring()); if (vsBytes.empty() || psBytes.empty()) return false; D3D12_SHADER_BYTECODE vs{}; vs.pShaderBytecode = vsBytes.data(); vs.BytecodeLength = vsBytes.size(); D3D12_SHADER_BYTECODE ps{}; ps.pShaderBytecode = psBytes.data(); ps.BytecodeLength = psBytes.size(); D3D12_INPUT_ELEMENT_DESC layout[] = { { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }, }; D3D12_GRAPHICS_PIPELINE_STATE_DESC pso{}; pso.pRootSignature = rootSignature.Get(); pso.VS = vs; pso.PS = ps; D3D12_BLEND_DESC blend{}; D3D12_RENDER_TARGET_BLEND_DESC rt{}; rt.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL; blend.RenderTarget[0] = rt; pso.BlendState = blend; pso.SampleMask = UINT_MAX; D3D12_RASTERIZER_DESC rast{}; rast.FillMode = D3D12_FILL_MODE_SOLID; rast.CullMode = D3D12_CULL_MODE_NONE; rast.DepthClipEnable = TRUE; pso.RasterizerState = rast; D3D12_DEPTH_STENCIL_DESC ds{}; ds.DepthEnable = TRUE; ds.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL; ds.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL; pso.DepthStencilState = ds; pso.InputLayout = { layout, _countof(layout) }; pso.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE; pso.NumRenderTargets = 1; pso.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM; pso.DSVFormat = DXGI_FORMAT_D32_FLOAT; pso.SampleDesc.Count = 1; if (FAILED(device->CreateGraphicsPipelineState(&pso, IID_PPV_ARGS(&pipelineState)))) return false; return true;
+    D3D12_ROOT_PARAMETER1 params[6]{}; params[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV; params[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL; params[0].Descriptor.ShaderRegister = 0; params[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS; params[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX; params[1].Constants.ShaderRegister = 1; params[1].Constants.Num32BitValues = sizeof(DrawConstants) / 4; params[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV; params[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX; params[2].Descriptor.ShaderRegister = 0; for (UINT i=3; i<6; ++i) { params[i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV; params[i].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL; params[i].Descriptor.ShaderRegister = i - 2; } D3D12_VERSIONED_ROOT_SIGNATURE_DESC rs{}; rs.Version = D3D_ROOT_SIGNATURE_VERSION_1_1; D3D12_ROOT_SIGNATURE_DESC1 rs1{}; rs1.NumParameters = _countof(params); rs1.pParameters = params; rs1.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT; rs.Desc_1_1 = rs1; ComPtr<ID3DBlob> s; ComPtr<ID3DBlob> e; if (FAILED(D3D12SerializeVersionedRootSignature(&rs, &s, &e))) return false; if (FAILED(device->CreateRootSignature(0, s->GetBufferPointer(), s->GetBufferSize(), IID_PPV_ARGS(&rootSignature)))) return false; std::filesystem::path exeDir; wchar_t modulePath[MAX_PATH]; GetModuleFileNameW(nullptr, modulePath, MAX_PATH); exeDir = std::filesystem::path(modulePath).parent_path(); auto vsBytes = readFileBytes((exeDir / L"shaders/triangle_vs.cso").wstring()); auto psBytes = readFileBytes((exeDir / L"shaders/triangle_ps.cso").wstring()); if (vsBytes.empty() || psBytes.empty()) return false; D3D12_SHADER_BYTECODE vs{}; vs.pShaderBytecode = vsBytes.data(); vs.BytecodeLength = vsBytes.size(); D3D12_SHADER_BYTECODE ps{}; ps.pShaderBytecode = psBytes.data(); ps.BytecodeLength = psBytes.size(); D3D12_INPUT_ELEMENT_DESC layout[] = { { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }, { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(FloatVertex, normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }, }; D3D12_GRAPHICS_PIPELINE_STATE_DESC pso{}; pso.pRootSignature = rootSignature.Get(); pso.VS = vs; pso.PS = ps; D3D12_BLEND_DESC blend{}; D3D12_RENDER_TARGET_BLEND_DESC rt{}; rt.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL; blend.RenderTarget[0] = rt; pso.BlendState = blend; pso.SampleMask = UINT_MAX; D3D12_RASTERIZER_DESC rast{}; rast.FillMode = D3D12_FILL_MODE_SOLID; rast.CullMode = D3D12_CULL_MODE_NONE; rast.DepthClipEnable = TRUE; pso.RasterizerState = rast; D3D12_DEPTH_STENCIL_DESC ds{}; ds.DepthEnable = TRUE; ds.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL; ds.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL; pso.DepthStencilState = ds; pso.InputLayout = { layout, _countof(layout) }; pso.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE; pso.NumRenderTargets = 1; pso.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM; pso.DSVFormat = DXGI_FORMAT_D32_FLOAT; pso.SampleDesc.Count = 1; if (FAILED(device->CreateGraphicsPipelineState(&pso, IID_PPV_ARGS(&pipelineState)))) return false;
+    auto quantizedVsBytes = readFileBytes((exeDir / L"shaders/triangle_vs_quantized.cso").wstring()); if (quantizedVsBytes.empty()) return false;
+    D3D12_INPUT_ELEMENT_DESC quantizedLayout[] = { { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }, };
+    pso.VS = { quantizedVsBytes.data(), quantizedVsBytes.size() }; pso.InputLayout = { quantizedLayout, _countof(quantizedLayout) };
+    if (FAILED(device->CreateGraphicsPipelineState(&pso, IID_PPV_ARGS(&quantizedPipelineState)))) return false;
+    d3d12Renderer.setPipelines({ pipelineState.Get(), quantizedPipelineState.Get() }); return true;
 }
 
-bool Engine::initImGui() { IMGUI_CHECKVERSION(); ImGui::CreateContext(); ImGuiIO& io = ImGui::GetIO(); io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard; if (!ImGui_ImplWin32_Init(hwnd)) return false; if (!ImGui_ImplDX12_Init(device.Get(), kFrameCount, DXGI_FORMAT_R8G8B8A8_UNORM, imguiSrvHeap.Get(), imguiSrvHeap->GetCPUDescriptorHandleForHeapStart(), imguiSrvHeap->GetGPUDescriptorHandleForHeapStart())) return false; return true; }
+bool Engine::initImGui() { IMGUI_CHECKVERSION(); ImGui::SetAllocatorFunctions([](size_t bytes, void*) { return ::operator new(bytes); }, [](void* p, void*) { ::operator delete(p); }); ImGui::CreateContext(); ImGuiIO& io = ImGui::GetIO(); io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard; if (!ImGui_ImplWin32_Init(hwnd)) return false; if (!ImGui_ImplDX12_Init(device.Get(), kFrameCount, DXGI_FORMAT_R8G8B8A8_UNORM, imguiSrvHeap.Get(), imguiSrvHeap->GetCPUDescriptorHandleForHeapStart(), imguiSrvHeap->GetGPUDescriptorHandleForHeapStart())) return false; return true; }
 
-void Engine::createSwapChain() { DXGI_SWAP_CHAIN_DESC1 d{}; d.BufferCount = kFrameCount; d.Width = clientWidth; d.Height = clientHeight; d.Format = DXGI_FORMAT_R8G8B8A8_UNORM; d.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT; d.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD; d.SampleDesc.Count = 1; d.Flags = tearingSupported ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0; ComPtr<IDXGISwapChain1> t; dxgiFactory->CreateSwapChainForHwnd(commandQueue.Get(), hwnd, &d, nullptr, nullptr, &t); t.As(&swapChain); swapChain->SetMaximumFrameLatency(kFrameCount); frameLatencyWaitableObject = swapChain->GetFrameLatencyWaitableObject(); dxgiFactory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER); currentFrameIndex = swapChain->GetCurrentBackBufferIndex(); }
+void Engine::createSwapChain() { DXGI_SWAP_CHAIN_DESC1 d{}; d.BufferCount = kFrameCount; d.Width = clientWidth; d.Height = clientHeight; d.Format = DXGI_FORMAT_R8G8B8A8_UNORM; d.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT; d.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD; d.SampleDesc.Count = 1; d.Flags = tearingSupported ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0; ComPtr<IDXGISwapChain1> t; dxgiFactory->CreateSwapChainForHwnd(commandQueue.Get(), hwnd, &d, nullptr, nullptr, &t); t.As(&swapChain); swapChain->SetMaximumFrameLatency(kFrameCount); frameLatencyWaitableObject = swapChain->GetFrameLatencyWaitableObject(); dxgiFactory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER); }
 
 void Engine::createRenderTargets() { D3D12_CPU_DESCRIPTOR_HANDLE h = rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(); for (UINT i=0;i<kFrameCount;++i) { swapChain->GetBuffer(i, IID_PPV_ARGS(&renderTargets[i])); device->CreateRenderTargetView(renderTargets[i].Get(), nullptr, h); h.ptr += rtvDescriptorSize; } }
 
 void Engine::createDepthResources() { D3D12_RESOURCE_DESC d{}; d.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D; d.Width = clientWidth; d.Height = clientHeight; d.DepthOrArraySize = 1; d.MipLevels = 1; d.Format = DXGI_FORMAT_D32_FLOAT; d.SampleDesc.Count = 1; d.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN; d.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL; D3D12_HEAP_PROPERTIES hp{}; hp.Type = D3D12_HEAP_TYPE_DEFAULT; D3D12_CLEAR_VALUE cv{}; cv.Format = DXGI_FORMAT_D32_FLOAT; cv.DepthStencil.Depth = 1.0f; if (FAILED(device->CreateCommittedResource(&hp, D3D12_HEAP_FLAG_NONE, &d, D3D12_RESOURCE_STATE_DEPTH_WRITE, &cv, IID_PPV_ARGS(&depthStencil)))) return; D3D12_DEPTH_STENCIL_VIEW_DESC v{}; v.Format = DXGI_FORMAT_D32_FLOAT; v.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D; device->CreateDepthStencilView(depthStencil.Get(), &v, dsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart()); }
 
 void Engine::update(double dt) {
-    ImGuiIO& io = ImGui::GetIO(); bool usingMouse = (GetKeyState(VK_RBUTTON) & 0x8000) && !io.WantCaptureMouse; POINT p; GetCursorPos(&p); ScreenToClient(hwnd, &p); static bool first = true; if (first) { lastMouse = p; first = false; } float dx = float(p.x - lastMouse.x); float dy = float(p.y - lastMouse.y); lastMouse = p; if (usingMouse) { const float sensitivity = 0.005f; cameraYaw += dx * sensitivity; cameraPitch -= dy * sensitivity; const float limit = XM_PIDIV2 - 0.01f; if (cameraPitch > limit) cameraPitch = limit; if (cameraPitch < -limit) cameraPitch = -limit; } XMVECTOR forward = XMVectorSet(cosf(cameraPitch) * sinf(cameraYaw), sinf(cameraPitch), cosf(cameraPitch) * cosf(cameraYaw), 0.0f); XMVECTOR right = XMVector3Normalize(XMVector3Cross(XMVectorSet(0,1,0,0), forward)); XMVECTOR up = XMVectorSet(0,1,0,0); float move = 3.0f * static_cast<float>(dt); if (!io.WantCaptureKeyboard) { if (GetAsyncKeyState('W') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorAdd(p0, XMVectorScale(forward, move))); } if (GetAsyncKeyState('S') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorSubtract(p0, XMVectorScale(forward, move))); } if (GetAsyncKeyState('A') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorSubtract(p0, XMVectorScale(right, move))); } if (GetAsyncKeyState('D') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorAdd(p0, XMVectorScale(right, move))); } if (GetAsyncKeyState('Q') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorSubtract(p0, XMVectorScale(up, move))); } if (GetAsyncKeyState('E') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorAdd(p0, XMVectorScale(up, move))); } }
-    assetsRescanAccum += dt; if (assetsRescanAccum > 1.0) { assetsRescanAccum = 0.0; scanAssets(); }
+    previousCamera = cameraPose();
+    ImGuiIO& io = ImGui::GetIO(); bool usingMouse = (GetKeyState(VK_RBUTTON) & 0x8000) && !io.WantCaptureMouse; POINT p; GetCursorPos(&p); ScreenToClient(hwnd, &p); static bool first = true; if (first) { lastMouse = p; first = false; } float dx = float(p.x - lastMouse.x); float dy = float(p.y - lastMouse.y); lastMouse = p; const bool leftDown = (GetKeyState(VK_LBUTTON) & 0x8000) != 0; if (leftDown && !leftMouseDown && !io.WantCaptureMouse) { const int picked = pickMesh(p); selectionKind = picked >= 0 ? SelectionKind::Mesh : SelectionKind::None; selectedIndex = picked; } leftMouseDown = leftDown; if (usingMouse) { const float sensitivity = 0.005f; cameraYaw += dx * sensitivity; cameraPitch -= dy * sensitivity; const float limit = XM_PIDIV2 - 0.01f; if (cameraPitch > limit) cameraPitch = limit; if (cameraPitch < -limit) cameraPitch = -limit; } XMVECTOR forward = XMVectorSet(cosf(cameraPitch) * sinf(cameraYaw), sinf(cameraPitch), cosf(cameraPitch) * cosf(cameraYaw), 0.0f); XMVECTOR right = XMVector3Normalize(XMVector3Cross(XMVectorSet(0,1,0,0), forward)); XMVECTOR up = XMVectorSet(0,1,0,0); float move = 3.0f * static_cast<float>(dt); if (!io.WantCaptureKeyboard) { if (GetAsyncKeyState('W') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorAdd(p0, XMVectorScale(forward, move))); } if (GetAsyncKeyState('S') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorSubtract(p0, XMVectorScale(forward, move))); } if (GetAsyncKeyState('A') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorSubtract(p0, XMVectorScale(right, move))); } if (GetAsyncKeyState('D') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorAdd(p0, XMVectorScale(right, move))); } if (GetAsyncKeyState('Q') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorSubtract(p0, XMVectorScale(up, move))); } if (GetAsyncKeyState('E') & 0x8000) { XMVECTOR p0 = XMLoadFloat3(&cameraPosition); XMStoreFloat3(&cameraPosition, XMVectorAdd(p0, XMVectorScale(up, move))); } }
+    syncAssetIndex();
 }
 
 void Engine::setWindowClientSize(UINT width, UINT height) { RECT wr{0,0,(LONG)width,(LONG)height}; AdjustWindowRectEx(&wr, GetWindowLong(hwnd, GWL_STYLE), FALSE, GetWindowLong(hwnd, GWL_EXSTYLE)); SetWindowPos(hwnd, nullptr, 0, 0, wr.right - wr.left, wr.bottom - wr.top, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE); }
 
 void Engine::setFullscreen(bool enable) { if (isFullscreen == enable) return; isFullscreen = enable; if (enable) { windowStyle = (DWORD)GetWindowLongPtr(hwnd, GWL_STYLE); GetWindowRect(hwnd, &windowRect); SetWindowLongPtr(hwnd, GWL_STYLE, windowStyle & ~WS_OVERLAPPEDWINDOW); HMONITOR hMon = MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST); MONITORINFO mi{sizeof(mi)}; GetMonitorInfo(hMon, &mi); SetWindowPos(hwnd, HWND_TOP, mi.rcMonitor.left, mi.rcMonitor.top, mi.rcMonitor.right - mi.rcMonitor.left, mi.rcMonitor.bottom - mi.rcMonitor.top, SWP_NOOWNERZORDER | SWP_FRAMECHANGED); } else { SetWindowLongPtr(hwnd, GWL_STYLE, windowStyle); SetWindowPos(hwnd, nullptr, windowRect.left, windowRect.top, windowRect.right - windowRect.left, windowRect.bottom - windowRect.top, SWP_NOOWNERZORDER | SWP_FRAMECHANGED); } }
 
-void Engine::render() {
+// The ray under the cursor goes through the mesh tree, nearest boxes first, then through each candidate's triangle BVH in
+// object space. Its direction has a unit forward component and is transformed unnormalised, so t is view depth in every
+// mesh and one hit carries across them.
+int Engine::pickMesh(POINT cursor) {
+    PROFILE_ZONE("Pick");
+    const auto start = std::chrono::steady_clock::now();
+    const float width = float(clientWidth ? clientWidth : 1), height = float(clientHeight ? clientHeight : 1), tanHalf = tanf(kCameraFovY * 0.5f);
+    const float sx = (2.0f * (float(cursor.x) + 0.5f) / width - 1.0f) * tanHalf * width / height, sy = (1.0f - 2.0f * (float(cursor.y) + 0.5f) / height) * tanHalf;
+    const XMVECTOR forward = XMVectorSet(cosf(cameraPitch) * sinf(cameraYaw), sinf(cameraPitch), cosf(cameraPitch) * cosf(cameraYaw), 0.0f);
+    const XMVECTOR right = XMVector3Normalize(XMVector3Cross(XMVectorSet(0,1,0,0), forward)), up = XMVector3Cross(forward, right);
+    const XMVECTOR eye = XMLoadFloat3(&cameraPosition), direction = XMVectorAdd(forward, XMVectorAdd(XMVectorScale(right, sx), XMVectorScale(up, sy)));
+    Ray ray; XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(&ray.origin), eye); XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(&ray.direction), direction);
+    int picked = -1; RayHit hit; hit.t = kCameraFar; lastPickCandidates = 0;
+    scene.meshTree.queryRay(ray.origin, ray.direction, kCameraFar, [&](uint32_t i) {
+        const MeshObject& m = scene.meshes[i]; ++lastPickCandidates;
+        if (!m.cpu || !m.cpu->bvhNodes) return hit.t;
+        const XMMATRIX toLocal = XMMatrixInverse(nullptr, XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(&scene.transforms.world(m.transform))));
+        Ray local; XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(&local.origin), XMVector3TransformCoord(eye, toLocal)); XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(&local.direction), XMVector3TransformNormal(direction, toLocal));
+        if (IntersectMeshBvh(m.cpu->bvhNodes, m.cpu->bvhTriangles, m.cpu->triangles.positions, m.cpu->triangles.indices, local, hit)) picked = int(i);
+        return hit.t; });
+    lastPickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    // Open the picked mesh's ancestors so its Hierarchy row is listed.
+    if (picked >= 0) for (TransformHandle p = scene.transforms.parent(scene.meshes[picked].transform); scene.transforms.isAlive(p); p = scene.transforms.parent(p)) hierarchyView.setExpanded(p, true);
+    return picked;
+}
+
+// Copies what the render thread reads out of the scene, so it never touches scene data the main thread keeps editing.
+void Engine::buildFrameSnapshot(FrameSnapshot& frame) {
+    PROFILE_ZONE("Build snapshot");
+    const DrawBatcher& drawBatcher = framePrep.drawBatcher();
+    frame.worlds.resize(drawBatcher.instanceOrder().size()); framePrep.copyInstanceWorlds(scene, frame.worlds.data(), jobs);
+    frame.batches.reserve(drawBatcher.batches().size());
+    for (const DrawBatch& batch : drawBatcher.batches()) {
+        const MeshObject& obj = scene.meshes[batch.objectIndex]; const bool clustered = clusterCulling && obj.geometry && obj.meshlets && (batch.sortKey & 7) == 0;
+        frame.batches.push_back({ batch.sortKey, obj.geometry, clustered ? obj.meshlets : nullptr, obj.vbv, obj.ibv, obj.format.vertex, obj.dequantize, obj.lods[std::min<uint32_t>(uint32_t(batch.sortKey & 7), obj.lodCount ? obj.lodCount - 1 : 0)], obj.vertexCount, batch.firstInstance, batch.instanceCount });
+    }
+    const std::vector<ClusterLight>& clusterLights = framePrep.clusterLights(); const LightClusterGrid& lightGrid = framePrep.lightGrid();
+    frame.lights.assign(clusterLights.begin(), clusterLights.end()); frame.lightRanges.assign(lightGrid.ranges().begin(), lightGrid.ranges().end()); frame.lightIndices.assign(lightGrid.indices().begin(), lightGrid.indices().end()); frame.lightGrid = lightGrid.shaderParams(clientWidth, clientHeight, uint32_t(clusterLights.size()));
+}
+
+// The render thread draws the UI while ImGui builds the next frame, so the draw lists are copied into the snapshot's own lists.
+// ImVector's assignment frees and reallocates every time; resizing keeps the slot's buffers once they are large enough.
+template <typename T> static void CopyImVector(const ImVector<T>& src, ImVector<T>& dst) { dst.resize(src.Size); if (src.Size) memcpy(dst.Data, src.Data, size_t(src.Size) * sizeof(T)); }
+
+static void CopyDrawData(const ImDrawData& src, ImDrawData& dst, std::vector<std::unique_ptr<ImDrawList>>& lists) {
+    ImVector<ImDrawList*> dstLists; dstLists.swap(dst.CmdLists); dst = src; dst.CmdLists.swap(dstLists); dst.CmdLists.resize(0);
+    for (int i = 0; i < src.CmdListsCount; ++i) {
+        if (lists.size() <= size_t(i)) lists.push_back(std::make_unique<ImDrawList>(nullptr));
+        ImDrawList& l = *lists[i]; const ImDrawList& from = *src.CmdLists[i];
+        CopyImVector(from.CmdBuffer, l.CmdBuffer); CopyImVector(from.IdxBuffer, l.IdxBuffer); CopyImVector(from.VtxBuffer, l.VtxBuffer); l.Flags = from.Flags; dst.CmdLists.push_back(&l);
+    }
+}
+
+// Main thread: simulation has already stepped; this builds the UI and the visible draw list for frame N while the render
+// thread is still recording and presenting frame N - 1. The camera is interpolated between the last two fixed steps.
+void Engine::render(float interpolation) {
+    const HeapAllocationScope frameAllocations;
+    PROFILE_FRAME();
+    PROFILE_ZONE("Build frame");
     LARGE_INTEGER now; if (timingInitialized) { QueryPerformanceCounter(&now); double ms = double(now.QuadPart - lastCounter.QuadPart) * 1000.0 / double(perfFreq.QuadPart); lastCounter = now; if (!frameTimeMs.empty()) { frameTimeMs[frameTimeWriteIdx] = static_cast<float>(ms); frameTimeWriteIdx = (frameTimeWriteIdx + 1) % frameTimeMs.size(); }}
-    if (frameLatencyWaitableObject) WaitForSingleObject(frameLatencyWaitableObject, 1000);
-    commandAllocators[currentFrameIndex]->Reset();
+    { PROFILE_ZONE("Main thread jobs"); jobs.runMainThreadJobs(); }
+    pumpAssetStreaming();
     if (selectionKind==SelectionKind::Mesh && (selectedIndex < 0 || selectedIndex >= (int)scene.meshes.size())) { selectionKind = SelectionKind::None; selectedIndex = -1; }
     if (selectionKind==SelectionKind::Light && (selectedIndex < 0 || selectedIndex >= (int)scene.lights.size())) { selectionKind = SelectionKind::None; selectedIndex = -1; }
-    commandList->Reset(commandAllocators[currentFrameIndex].Get(), nullptr);
-    ID3D12DescriptorHeap* heaps[] = { imguiSrvHeap.Get() };
-    commandList->SetDescriptorHeaps(1, heaps);
+    FrameSnapshot* frame = nullptr; { PROFILE_ZONE("Wait for render thread"); frame = &framePipeline->beginFrame(); }
+    frame->recycle();
+    lastRenderStats = frame->renderStats; lastClusterStats = frame->clusterStats;
+
     ImGui_ImplDX12_NewFrame();
     ImGui_ImplWin32_NewFrame();
     ImGui::NewFrame();
+    { PROFILE_ZONE("Build UI"); buildEditorUi(); }
+    ImGui::Render();
+    CopyDrawData(*ImGui::GetDrawData(), frame->ui, frame->uiLists);
+
+    const CameraPose camera = LerpCameraPose(previousCamera, cameraPose(), interpolation);
+    XMVECTOR eye = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&camera.position));
+    XMVECTOR forward = XMVectorSet(cosf(camera.pitch) * sinf(camera.yaw), sinf(camera.pitch), cosf(camera.pitch) * cosf(camera.yaw), 0.0f);
+    XMMATRIX view = XMMatrixLookAtLH(eye, XMVectorAdd(eye, forward), XMVectorSet(0,1,0,0));
+    float aspect = clientWidth > 0 ? float(clientWidth) / float(clientHeight ? clientHeight : 1) : 1.0f;
+    XMMATRIX proj = XMMatrixPerspectiveFovLH(kCameraFovY, aspect, kCameraNear, kCameraFar);
+
+    XMStoreFloat4x4(reinterpret_cast<XMFLOAT4X4*>(&frame->viewProj), view * proj); XMStoreFloat4x4(reinterpret_cast<XMFLOAT4X4*>(&frame->view), view); frame->eye = camera.position;
+    const FrameView frameView{ frame->view, frame->viewProj, camera.position, XMVectorGetX(proj.r[0]), XMVectorGetY(proj.r[1]), kCameraNear, kCameraFar, clientWidth, clientHeight };
+    framePrep.prepareDrawList(scene, frameView, framePrepSettings, jobs);
+    framePrep.binVisibleLights(scene, frameView, framePrepSettings, jobs);
+    buildFrameSnapshot(*frame);
+    frame->serial = ++frameSerial; frame->clusterBackfaceCulling = clusterBackfaceCulling; frame->vsync = enableVsync; frame->tearing = tearingSupported && enableTearing && !enableVsync;
+#if GGINE_ENABLE_PROFILER
+    frame->profilerFrame = ProfilerFrameIndex();
+#endif
+    lastFrameArenaBytes = frame->arena.bytesUsed();
+    framePipeline->publish();
+    lastFrameHeapAllocations = frameAllocations.elapsed().allocations;
+}
+
+// Render thread: owns the direct command list, constant ring, swap chain presentation and GPU timestamps. Frame N reuses
+// the allocator and timestamp slot of frame N - kFrameCount, whose fence value is its serial.
+void Engine::recordFrame(FrameSnapshot& frame) {
+    PROFILE_ZONE("Render");
+    if (frameLatencyWaitableObject) { PROFILE_ZONE("Wait frame latency"); WaitForSingleObject(frameLatencyWaitableObject, 1000); }
+    renderSerial = frame.serial; currentFrameIndex = UINT(frame.serial % kFrameCount);
+    waitForFrame(frame.serial > kFrameCount ? frame.serial - kFrameCount : 0);
+#if GGINE_ENABLE_PROFILER
+    collectGpuZones();
+#endif
+    commandAllocators[currentFrameIndex]->Reset();
+    commandList->Reset(commandAllocators[currentFrameIndex].Get(), nullptr);
+    ID3D12DescriptorHeap* heaps[] = { imguiSrvHeap.Get() };
+    commandList->SetDescriptorHeaps(1, heaps);
+#if GGINE_ENABLE_PROFILER
+    { GpuFrameZones& g = gpuFrameZones[currentFrameIndex]; g.profilerFrame = frame.profilerFrame; commandQueue->GetClockCalibration(&g.calibrationGpu, &g.calibrationCpu); }
+    const uint32_t gpuFrameZone = beginGpuZone("GPU frame");
+#endif
+    const UINT backBuffer = swapChain->GetCurrentBackBufferIndex();
+
+    D3D12_RESOURCE_BARRIER toRT{};
+    toRT.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    toRT.Transition.pResource = renderTargets[backBuffer].Get();
+    toRT.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
+    toRT.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
+    toRT.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    commandList->ResourceBarrier(1, &toRT);
+    D3D12_CPU_DESCRIPTOR_HANDLE rtv = rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    rtv.ptr += backBuffer * rtvDescriptorSize;
+    D3D12_CPU_DESCRIPTOR_HANDLE dsv = dsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    float clear[4] = {0.05f, 0.05f, 0.07f, 1.0f};
+    commandList->RSSetViewports(1, &viewport);
+    commandList->RSSetScissorRects(1, &scissorRect);
+    commandList->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
+    commandList->ClearRenderTargetView(rtv, clear, 0, nullptr);
+    commandList->ClearDepthStencilView(dsv, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    commandList->SetGraphicsRootSignature(rootSignature.Get());
+    commandList->SetPipelineState(pipelineState.Get());
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    // Instances drawn at LOD 0 with clusters are culled per meshlet in object space and drawn as compacted index ranges.
+    clusterCull.begin(frame.worlds.size());
+    for (const FrameBatch& batch : frame.batches) if (batch.meshlets) for (uint32_t i=0; i<batch.instanceCount; ++i) clusterCull.add(batch.firstInstance + i, *batch.meshlets);
+    clusterCull.cull(frame.worlds.data(), frame.viewProj, frame.eye, frame.clusterBackfaceCulling, jobs); frame.clusterStats = clusterCull.stats();
+
+    FrameCB frameCB{}; memcpy(&frameCB.viewProj, &frame.viewProj, sizeof(Float4x4)); memcpy(&frameCB.view, &frame.view, sizeof(Float4x4)); frameCB.eye = frame.eye; frameCB.lightGrid = frame.lightGrid;
+    D3D12_GPU_VIRTUAL_ADDRESS frameAddress = allocateConstants(&frameCB, sizeof(FrameCB));
+    void* instanceCpu = nullptr; D3D12_GPU_VIRTUAL_ADDRESS instanceAddress = frame.worlds.empty() ? 0 : allocateUpload(frame.worlds.size() * sizeof(InstanceData), &instanceCpu);
+    // The light lists go up as root SRVs; an empty list still gets one element so every view points at something.
+    void* lightsCpu = nullptr; void* rangesCpu = nullptr; void* indicesCpu = nullptr;
+    const D3D12_GPU_VIRTUAL_ADDRESS lightsAddress = allocateUpload(std::max<size_t>(frame.lights.size(), 1) * sizeof(ClusterLight), &lightsCpu), rangesAddress = allocateUpload(std::max<size_t>(frame.lightRanges.size(), 1) * sizeof(LightClusterRange), &rangesCpu), indicesAddress = allocateUpload(std::max<size_t>(frame.lightIndices.size(), 1) * sizeof(uint32_t), &indicesCpu);
+    frame.renderStats = {};
+    if (frameAddress && instanceAddress && lightsAddress && rangesAddress && indicesAddress) {
+        PROFILE_ZONE("Record draws");
+#if GGINE_ENABLE_PROFILER
+        const uint32_t sceneZone = beginGpuZone("Scene");
+#endif
+        memcpy(instanceCpu, frame.worlds.data(), frame.worlds.size() * sizeof(InstanceData));
+        commandList->SetGraphicsRootConstantBufferView(0, frameAddress);
+        commandList->SetGraphicsRootShaderResourceView(2, instanceAddress);
+        memcpy(lightsCpu, frame.lights.data(), frame.lights.size() * sizeof(ClusterLight)); memcpy(rangesCpu, frame.lightRanges.data(), frame.lightRanges.size() * sizeof(LightClusterRange)); memcpy(indicesCpu, frame.lightIndices.data(), frame.lightIndices.size() * sizeof(uint32_t));
+        commandList->SetGraphicsRootShaderResourceView(3, lightsAddress); commandList->SetGraphicsRootShaderResourceView(4, rangesAddress); commandList->SetGraphicsRootShaderResourceView(5, indicesAddress);
+        // Clustered instances become one packet per visible index range; the stream drops the state those packets repeat.
+        renderCommands.clear();
+        for (const FrameBatch& batch : frame.batches) {
+            RenderDraw d; d.pipeline = uint32_t(batch.vertex); d.vertexBuffer = { batch.vbv.BufferLocation, batch.vbv.SizeInBytes, batch.vbv.StrideInBytes }; memcpy(d.constants, &batch.dequantize, sizeof(d.constants)); d.instanceOffset = batch.firstInstance; d.instanceCount = batch.instanceCount;
+            if (batch.geometry) d.indexBuffer = { batch.ibv.BufferLocation, batch.ibv.SizeInBytes, batch.ibv.Format == DXGI_FORMAT_R16_UINT ? 2u : 4u };
+            if (batch.meshlets) { d.instanceCount = 1; for (uint32_t i=0; i<batch.instanceCount; ++i) { d.instanceOffset = batch.firstInstance + i; for (const MeshletRange& r : clusterCull.ranges(batch.firstInstance + i)) { d.count = r.indexCount; d.firstIndex = r.firstIndex; renderCommands.submit(batch.sortKey, d); } } }
+            else if (batch.geometry) { d.count = batch.lod.indexCount; d.firstIndex = batch.lod.firstIndex; renderCommands.submit(batch.sortKey, d); }
+            else { d.count = batch.vertexCount; renderCommands.submit(batch.sortKey, d); }
+        }
+        renderCommands.compile();
+        d3d12Renderer.setCommandList(commandList.Get()); d3d12Renderer.execute(renderCommands);
+        frame.renderStats = renderCommands.stats();
+#if GGINE_ENABLE_PROFILER
+        endGpuZone(sceneZone);
+#endif
+    }
 
+    {
+        PROFILE_ZONE("Record UI");
+#if GGINE_ENABLE_PROFILER
+        const uint32_t uiZone = beginGpuZone("UI");
+#endif
+        ImGui_ImplDX12_RenderDrawData(&frame.ui, commandList.Get());
+#if GGINE_ENABLE_PROFILER
+        endGpuZone(uiZone);
+#endif
+    }
+
+    D3D12_RESOURCE_BARRIER toPresent{};
+    toPresent.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    toPresent.Transition.pResource = renderTargets[backBuffer].Get();
+    toPresent.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+    toPresent.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
+    toPresent.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    commandList->ResourceBarrier(1, &toPresent);
+#if GGINE_ENABLE_PROFILER
+    endGpuZone(gpuFrameZone); resolveGpuZones();
+#endif
+    commandList->Close();
+    ID3D12CommandList* lists[] = { commandList.Get() };
+    commandQueue->ExecuteCommandLists(1, lists);
+    { PROFILE_ZONE("Present"); swapChain->Present(frame.vsync ? 1 : 0, frame.tearing ? DXGI_PRESENT_ALLOW_TEARING : 0); }
+    commandQueue->Signal(fence.Get(), frame.serial); constantRing.endFrame(frame.serial);
+}
+
+void Engine::buildEditorUi() {
     ImGui::Begin("Tools");
     if (tearingSupported) ImGui::Checkbox("Enable Tearing", &enableTearing);
     ImGui::Checkbox("VSync", &enableVsync);
     if (!frameTimeMs.empty()) ImGui::PlotLines("Frame ms", frameTimeMs.data(), static_cast<int>(frameTimeMs.size()), static_cast<int>(frameTimeWriteIdx), nullptr, 0.0f, 40.0f, ImVec2(0, 80));
     ImGui::Text("GPU Waitable: %s", frameLatencyWaitableObject ? "on" : "off");
+    ImGui::Text("Draws: %zu batches for %zu instances", framePrep.drawBatcher().batches().size(), framePrep.drawBatcher().itemCount());
+    ImGui::Text("Transforms: %zu of %zu recomputed", framePrep.transformUpdates(), scene.transforms.size());
+    if (ImGui::Button("Save Scene")) sceneSaveFailed = !saveScene(sceneFileW);
+    ImGui::SameLine(); if (sceneSaveFailed) ImGui::Text("save failed"); else if (sceneLoadMs >= 0.0) ImGui::Text("loaded %zu meshes, %zu lights in %.1f ms", scene.meshes.size(), scene.lights.size(), sceneLoadMs); else ImGui::Text("new scene");
+    ImGui::Checkbox("Quantize new geometry", &quantizeGeometry);
+    ImGui::SliderFloat("LOD error (px)", &framePrepSettings.lodThresholdPixels, 0.25f, 8.0f, "%.2f"); ImGui::Text("Triangles: %llu drawn", (unsigned long long)lastRenderStats.primitives);
+    ImGui::Text("Commands: %u draws; %u pipeline, %u VB, %u IB, %u constant, %u instance offset changes; %u redundant sets skipped", lastRenderStats.draws, lastRenderStats.pipelineChanges, lastRenderStats.vertexBufferChanges, lastRenderStats.indexBufferChanges, lastRenderStats.constantChanges, lastRenderStats.instanceOffsetChanges, lastRenderStats.redundantStateSkipped);
+    ImGui::Text("Culling: %zu visible, %zu culled (tree height %d)", framePrep.visibleMeshes().size(), scene.meshes.size() - framePrep.visibleMeshes().size(), scene.meshTree.height());
+    ImGui::Checkbox("Occlusion culling", &framePrepSettings.occlusionCulling); ImGui::SameLine(); ImGui::Checkbox("Show occlusion buffer", &showOcclusionBuffer);
+    ImGui::SliderFloat("Occluder min radius (px)", &framePrepSettings.occluderMinPixels, 8.0f, 256.0f, "%.0f"); { const uint32_t lo = 1024, hi = 262144; ImGui::SliderScalar("Occluder triangles", ImGuiDataType_U32, &framePrepSettings.occluderTriangleBudget, &lo, &hi); }
+    { const OcclusionStats& os = framePrep.occlusionBuffer().stats(); ImGui::Text("Occlusion: %u occluders, %u of %u triangles rasterized, %zu meshes hidden", os.occluders, os.rasterizedTriangles, os.triangles, framePrep.occludedMeshes()); }
+    ImGui::Text("Last pick: %.3f ms, %u meshes tested (click the viewport to select)", lastPickMs, lastPickCandidates);
+    ImGui::Checkbox("Clustered lighting", &framePrepSettings.clusteredLighting);
+    { const LightClusterStats& ls = framePrep.lightGrid().stats(); ImGui::Text("Lights: %u of %zu in view, %u cluster entries, %u of %u clusters lit, at most %u in one", ls.visibleLights, scene.lights.size(), ls.indices, ls.occupiedClusters, kLightClusterCount, ls.maxPerCluster); }
+    ImGui::Checkbox("Cluster culling", &clusterCulling); ImGui::SameLine(); ImGui::Checkbox("Backface cones (single-sided meshes)", &clusterBackfaceCulling);
+    ImGui::Text("Clusters: %u tested, %u frustum culled, %u backface culled, %u index ranges", lastClusterStats.clusters, lastClusterStats.frustumCulled, lastClusterStats.backfaceCulled, lastClusterStats.ranges);
+    if (ImGui::TreeNode("Job workers")) { ScratchArena scratch; const auto ws = jobs.stats(scratch.resource()); for (size_t w=0; w<ws.size(); ++w) { char label[64]; snprintf(label, sizeof(label), "%s %zu: %llu jobs, %llu stolen", w + 1 == ws.size() ? "main" : "worker", w, (unsigned long long)ws[w].jobsExecuted, (unsigned long long)ws[w].jobsStolen); ImGui::ProgressBar(float(ws[w].utilization), ImVec2(-1, 0), label); } if (ImGui::Button("Reset stats")) jobs.resetStats(); ImGui::TreePop(); }
+    if (kHeapAllocationCounting) ImGui::Text("Heap: %llu allocations last frame, frame arena %.1f KB", (unsigned long long)lastFrameHeapAllocations, lastFrameArenaBytes / 1024.0);
+    { const UploadRingStats& rs = constantRing.stats(); ImGui::Text("CB ring: %.1f KB/frame (%u allocs), peak %.1f KB, high-water %.1f / %.1f KB, grown %u", rs.lastFrameBytes / 1024.0, rs.lastFrameAllocations, rs.peakFrameBytes / 1024.0, rs.highWaterMark / 1024.0, constantRing.capacity() / 1024.0, rs.growCount); }
+    { UINT64 used = 0, capacity = 0, largest = 0; uint32_t allocations = 0; for (const GeometryBlock& b : geometryBlocks) { const TlsfStats ts = b.allocator.stats(); used += ts.usedBytes; capacity += ts.capacity; largest = std::max(largest, ts.largestFreeBlock); allocations += ts.allocationCount; } ImGui::Text("Geometry heap: %.1f / %.1f MB in %zu blocks, %u ranges, largest free %.1f MB, staging %.1f MB (grown %u)", used / 1048576.0, capacity / 1048576.0, geometryBlocks.size(), allocations, largest / 1048576.0, stagingRing.capacity() / 1048576.0, stagingRing.stats().growCount);
+      for (size_t b = 0; b < geometryBlocks.size(); ++b) { const TlsfStats ts = geometryBlocks[b].allocator.stats(); ImGui::Text("  block %zu: %.1f%% used, %u free blocks, fragmentation %.2f, %.1f KB pending free", b, 100.0 * double(ts.usedBytes) / double(ts.capacity), ts.freeBlockCount, ts.fragmentation, ts.pendingFreeBytes / 1024.0); } }
     ImGui::End();
 
     ImGui::Begin("Hierarchy");
@@ -114,25 +503,45 @@ void Engine::render() {
             ImGui::EndPopup();
         }
     }
-    if (ImGui::CollapsingHeader("Meshes", ImGuiTreeNodeFlags_DefaultOpen)) {
-        int meshToDelete = -1;
-        int meshToDuplicate = -1;
-        for (int i=0;i<(int)scene.meshes.size();++i) {
-            ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen | ((selectionKind==SelectionKind::Mesh && selectedIndex==i)?ImGuiTreeNodeFlags_Selected:0);
-            std::string utf8(scene.meshes[i].name.begin(), scene.meshes[i].name.end());
-            ImGui::TreeNodeEx((void*)(intptr_t)(1000+i), flags, "%s", utf8.c_str());
-            if (ImGui::IsItemClicked()) { selectionKind = SelectionKind::Mesh; selectedIndex = i; }
-            if (ImGui::BeginPopupContextItem((std::string("MeshCtx")+std::to_string(i)).c_str())) {
-                if (ImGui::MenuItem("Duplicate")) { meshToDuplicate = i; ImGui::CloseCurrentPopup(); }
-                if (ImGui::MenuItem("Delete")) { meshToDelete = i; ImGui::CloseCurrentPopup(); }
+    // Meshes and lights share the transform hierarchy. Rows come from hierarchyView, which rebuilds them only when the tree,
+    // expansion or filter changes, and only the rows in view are submitted. Dragging a node onto another parents it there
+    // (keeping its local transform); dropping it on the Scene header makes it a root again.
+    if (ImGui::CollapsingHeader("Scene", ImGuiTreeNodeFlags_DefaultOpen)) {
+        PROFILE_ZONE("Hierarchy panel");
+        int meshToDelete = -1, meshToDuplicate = -1, lightToDelete = -1, lightToDuplicate = -1;
+        TransformHandle reparentNode{}, reparentTo{};
+        auto dropTarget = [&](TransformHandle parent) { if (ImGui::BeginDragDropTarget()) { if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("SCENE_NODE")) { reparentNode = *static_cast<const TransformHandle*>(payload->Data); reparentTo = parent; } ImGui::EndDragDropTarget(); } };
+        dropTarget({});
+        static char filterBuf[128] = {};
+        if (ImGui::InputTextWithHint("##HierarchyFilter", "Filter", filterBuf, sizeof(filterBuf))) hierarchyView.setFilter(filterBuf);
+        ImGui::BeginChild("SceneRows");
+        const std::vector<HierarchyRow>& rows = hierarchyView.rows(scene.transforms);
+        ImGuiListClipper clipper; clipper.Begin(int(rows.size()));
+        while (clipper.Step()) for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; ++r) {
+            const HierarchyRow row = rows[r]; const TransformHandle h = row.node;
+            const int32_t object = hierarchyView.object(h); const bool isMesh = object >= 0; const int i = isMesh ? object : ~object;
+            const std::string_view name = hierarchyView.name(h); const bool loading = isMesh && scene.meshes[i].pendingLoad.isValid();
+            const bool selected = selectionKind == (isMesh ? SelectionKind::Mesh : SelectionKind::Light) && selectedIndex == i;
+            const ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_SpanAvailWidth | (row.hasChildren ? 0 : ImGuiTreeNodeFlags_Leaf) | (selected ? ImGuiTreeNodeFlags_Selected : 0);
+            const float indent = float(row.depth) * ImGui::GetTreeNodeToLabelSpacing();
+            if (indent > 0.0f) ImGui::Indent(indent);
+            const bool filtering = !hierarchyView.filter().empty();
+            ImGui::SetNextItemOpen(filtering || hierarchyView.expanded(h));
+            const bool open = ImGui::TreeNodeEx((void*)(intptr_t)(h.index + 1), flags, "%.*s%s", int(name.size()), name.data(), loading ? " (loading)" : "");
+            if (indent > 0.0f) ImGui::Unindent(indent);
+            if (row.hasChildren && !filtering && open != hierarchyView.expanded(h)) hierarchyView.setExpanded(h, open);
+            if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen()) { selectionKind = isMesh ? SelectionKind::Mesh : SelectionKind::Light; selectedIndex = i; }
+            if (ImGui::BeginDragDropSource()) { ImGui::SetDragDropPayload("SCENE_NODE", &h, sizeof(h)); ImGui::Text("%.*s", int(name.size()), name.data()); ImGui::EndDragDropSource(); }
+            dropTarget(h);
+            if (ImGui::BeginPopupContextItem()) {
+                if (ImGui::MenuItem("Duplicate")) { (isMesh ? meshToDuplicate : lightToDuplicate) = i; ImGui::CloseCurrentPopup(); }
+                if (ImGui::MenuItem("Delete")) { (isMesh ? meshToDelete : lightToDelete) = i; ImGui::CloseCurrentPopup(); }
+                if (!(scene.transforms.parent(h) == TransformHandle{}) && ImGui::MenuItem("Unparent")) { reparentNode = h; reparentTo = {}; ImGui::CloseCurrentPopup(); }
                 static char renameBuf[128] = {};
-                if (ImGui::IsWindowAppearing()) {
-                    std::string n(scene.meshes[i].name.begin(), scene.meshes[i].name.end());
-                    strncpy_s(renameBuf, n.c_str(), sizeof(renameBuf)-1);
-                }
+                if (ImGui::IsWindowAppearing()) { const size_t n = std::min(name.size(), sizeof(renameBuf) - 1); memcpy(renameBuf, name.data(), n); renameBuf[n] = 0; }
                 ImGui::InputText("Rename", renameBuf, sizeof(renameBuf));
-                if (ImGui::MenuItem("Apply Rename##mesh")) {
-                    std::string s(renameBuf); std::wstring ws(s.begin(), s.end()); scene.meshes[i].name = ws; ImGui::CloseCurrentPopup();
+                if (ImGui::MenuItem("Apply Rename")) {
+                    (isMesh ? scene.meshes[i].name : scene.lights[i].name) = FromUtf8(renameBuf); hierarchyView.rename(h, renameBuf); ImGui::CloseCurrentPopup();
                 }
                 ImGui::Separator();
                 if (ImGui::MenuItem("Add New Cube")) { createCubeObject(L"Cube"); }
@@ -140,51 +549,36 @@ void Engine::render() {
                 ImGui::EndPopup();
             }
         }
+        ImGui::EndChild();
+        if (!(reparentNode == TransformHandle{}) && scene.transforms.setParent(reparentNode, reparentTo)) hierarchyView.invalidate();
         if (meshToDuplicate >= 0 && meshToDuplicate < (int)scene.meshes.size()) {
             MeshObject copy = scene.meshes[meshToDuplicate];
             copy.name += L" (copy)";
-            scene.meshes.push_back(copy);
+            const TransformHandle src = copy.transform; copy.transform = scene.transforms.create(scene.transforms.position(src), scene.transforms.eulerDegrees(src), scene.transforms.scale(src), scene.transforms.parent(src));
+            copy.cullProxy = scene.meshTree.createProxy(TransformAabb(copy.localBounds, scene.transforms.world(src)), uint32_t(scene.meshes.size())); scene.transforms.setUserData(copy.transform, uint32_t(copy.cullProxy)); { ScratchArena scratch; hierarchyView.add(copy.transform, ToUtf8(copy.name, scratch.resource()), int32_t(scene.meshes.size())); }
+            scene.meshes.push_back(std::move(copy));
             selectionKind = SelectionKind::Mesh; selectedIndex = (int)scene.meshes.size()-1;
         }
         if (meshToDelete >= 0 && meshToDelete < (int)scene.meshes.size()) {
+            const StreamHandle load = scene.meshes[meshToDelete].pendingLoad;
+            if (load.isValid() && std::count_if(scene.meshes.begin(), scene.meshes.end(), [&](const MeshObject& m) { return m.pendingLoad == load; }) == 1) { assetStreamer.cancel(load); meshUploads.erase(std::remove_if(meshUploads.begin(), meshUploads.end(), [&](const PendingMeshUpload& u) { return u.handle == load && u.fenceValue == 0; }), meshUploads.end()); }
+            scene.transforms.destroy(scene.meshes[meshToDelete].transform);
+            scene.meshTree.destroyProxy(scene.meshes[meshToDelete].cullProxy); hierarchyView.remove(scene.meshes[meshToDelete].transform);
             scene.meshes.erase(scene.meshes.begin()+meshToDelete);
+            for (int j=meshToDelete;j<(int)scene.meshes.size();++j) { scene.meshTree.setUserData(scene.meshes[j].cullProxy, uint32_t(j)); hierarchyView.setObject(scene.meshes[j].transform, j); }
             selectionKind = SelectionKind::None; selectedIndex = -1;
         }
-    }
-    if (ImGui::CollapsingHeader("Lights", ImGuiTreeNodeFlags_DefaultOpen)) {
-        int lightToDelete = -1;
-        int lightToDuplicate = -1;
-        for (int i=0;i<(int)scene.lights.size();++i) {
-            ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen | ((selectionKind==SelectionKind::Light && selectedIndex==i)?ImGuiTreeNodeFlags_Selected:0);
-            std::string utf8(scene.lights[i].name.begin(), scene.lights[i].name.end());
-            ImGui::TreeNodeEx((void*)(intptr_t)(2000+i), flags, "%s", utf8.c_str());
-            if (ImGui::IsItemClicked()) { selectionKind = SelectionKind::Light; selectedIndex = i; }
-            if (ImGui::BeginPopupContextItem((std::string("LightCtx")+std::to_string(i)).c_str())) {
-                if (ImGui::MenuItem("Duplicate")) { lightToDuplicate = i; ImGui::CloseCurrentPopup(); }
-                if (ImGui::MenuItem("Delete")) { lightToDelete = i; ImGui::CloseCurrentPopup(); }
-                static char lrename[128] = {};
-                if (ImGui::IsWindowAppearing()) {
-                    std::string n(scene.lights[i].name.begin(), scene.lights[i].name.end());
-                    strncpy_s(lrename, n.c_str(), sizeof(lrename)-1);
-                }
-                ImGui::InputText("Rename", lrename, sizeof(lrename));
-                if (ImGui::MenuItem("Apply Rename##light")) {
-                    std::string s(lrename); std::wstring ws(s.begin(), s.end()); scene.lights[i].name = ws; ImGui::CloseCurrentPopup();
-                }
-                ImGui::Separator();
-                if (ImGui::MenuItem("Add New Cube")) { createCubeObject(L"Cube"); }
-                if (ImGui::MenuItem("Add New Light")) { createLightObject(L"Light"); }
-                ImGui::EndPopup();
-            }
-        }
         if (lightToDuplicate >= 0 && lightToDuplicate < (int)scene.lights.size()) {
             LightObject copy = scene.lights[lightToDuplicate];
             copy.name += L" (copy)";
-            scene.lights.push_back(copy);
+            const TransformHandle src = copy.transform; copy.transform = scene.transforms.create(scene.transforms.position(src), scene.transforms.eulerDegrees(src), scene.transforms.scale(src), scene.transforms.parent(src));
+            addLightObject(std::move(copy));
             selectionKind = SelectionKind::Light; selectedIndex = (int)scene.lights.size()-1;
         }
         if (lightToDelete >= 0 && lightToDelete < (int)scene.lights.size()) {
+            scene.transforms.destroy(scene.lights[lightToDelete].transform); scene.lightTree.destroyProxy(scene.lights[lightToDelete].cullProxy); hierarchyView.remove(scene.lights[lightToDelete].transform);
             scene.lights.erase(scene.lights.begin()+lightToDelete);
+            for (int j=lightToDelete;j<(int)scene.lights.size();++j) { scene.lightTree.setUserData(scene.lights[j].cullProxy, uint32_t(j)); hierarchyView.setObject(scene.lights[j].transform, ~j); }
             selectionKind = SelectionKind::None; selectedIndex = -1;
         }
     }
@@ -194,113 +588,196 @@ void Engine::render() {
     if (selectionKind==SelectionKind::Camera) {
         float pos[3] = { cameraPosition.x, cameraPosition.y, cameraPosition.z };
         if (ImGui::DragFloat3("Position", pos, 0.01f)) {
-            cameraPosition = {pos[0],pos[1],pos[2]};
+            cameraPosition = {pos[0],pos[1],pos[2]}; previousCamera = cameraPose();
         }
         float yawPitch[2] = { cameraYaw, cameraPitch };
         if (ImGui::DragFloat2("Yaw/Pitch", yawPitch, 0.01f)) {
             cameraYaw = yawPitch[0];
-            cameraPitch = yawPitch[1];
+            cameraPitch = yawPitch[1]; previousCamera = cameraPose();
         }
     } else if (selectionKind==SelectionKind::Mesh && selectedIndex>=0 && selectedIndex<(int)scene.meshes.size()) {
-        auto& t = scene.meshes[selectedIndex].transform;
-        float pos[3] = { t.position.x, t.position.y, t.position.z };
-        float rot[3] = { t.rotationEuler.x, t.rotationEuler.y, t.rotationEuler.z };
-        float scl[3] = { t.scale.x, t.scale.y, t.scale.z };
-        if (ImGui::DragFloat3("Position", pos, 0.01f)) t.position = {pos[0],pos[1],pos[2]};
-        if (ImGui::DragFloat3("Rotation", rot, 0.5f)) t.rotationEuler = {rot[0],rot[1],rot[2]};
-        if (ImGui::DragFloat3("Scale", scl, 0.01f)) t.scale = {scl[0],scl[1],scl[2]};
+        const TransformHandle t = scene.meshes[selectedIndex].transform;
+        Float3 p = scene.transforms.position(t), r = scene.transforms.eulerDegrees(t), k = scene.transforms.scale(t);
+        float pos[3] = { p.x, p.y, p.z };
+        float rot[3] = { r.x, r.y, r.z };
+        float scl[3] = { k.x, k.y, k.z };
+        if (ImGui::DragFloat3("Position", pos, 0.01f)) scene.transforms.setPosition(t, {pos[0],pos[1],pos[2]});
+        if (ImGui::DragFloat3("Rotation", rot, 0.5f)) scene.transforms.setEulerDegrees(t, {rot[0],rot[1],rot[2]});
+        if (ImGui::DragFloat3("Scale", scl, 0.01f)) scene.transforms.setScale(t, {scl[0],scl[1],scl[2]});
+        const MeshObject& m = scene.meshes[selectedIndex];
+        if (m.geometry) { const UINT64 bytes = m.format.bytes(m.vertexCount, m.indexCount), raw = GeometryFormat{}.bytes(m.vertexCount, m.indexCount); ImGui::Text("Geometry: %.1f KB (%s, %u-bit indices), %.1f KB as float3/32-bit, %.0f%% saved", bytes / 1024.0, m.format.vertex == MeshVertexFormat::Quantized16 ? "unorm16 positions, snorm8 normals" : "float3 positions, snorm16 normals", m.format.shortIndices ? 16u : 32u, raw / 1024.0, 100.0 * (1.0 - double(bytes) / double(raw))); }
     } else if (selectionKind==SelectionKind::Light && selectedIndex>=0 && selectedIndex<(int)scene.lights.size()) {
         auto& l = scene.lights[selectedIndex];
-        float pos[3] = { l.transform.position.x, l.transform.position.y, l.transform.position.z };
+        const Float3 p = scene.transforms.position(l.transform);
+        float pos[3] = { p.x, p.y, p.z };
         float col[3] = { l.color.x, l.color.y, l.color.z };
-        if (ImGui::DragFloat3("Position", pos, 0.01f)) l.transform.position = {pos[0],pos[1],pos[2]};
+        if (ImGui::DragFloat3("Position", pos, 0.01f)) scene.transforms.setPosition(l.transform, {pos[0],pos[1],pos[2]});
         if (ImGui::ColorEdit3("Color", col)) l.color = {col[0],col[1],col[2]};
-        ImGui::DragFloat("Intensity", &l.intensity, 0.05f, 0.0f, 32.0f);
+        if (ImGui::DragFloat("Intensity", &l.intensity, 0.05f, 0.0f, 32.0f)) scene.lightTree.moveProxy(l.cullProxy, LightBounds(scene.transforms.world(l.transform), l.intensity));
     }
     ImGui::End();
 
     ImGui::Begin("Assets");
     ImGui::Text("Folder: %ls", assetsDirW.c_str());
+    { const AssetIndexStats is = assetIndex.stats(); static const char* kBackends[] = { "none", "inotify", "ReadDirectoryChangesW", "polling" }; ImGui::Text("Index: %zu assets, %llu hashed, last refresh %.1f ms (%s)", is.records, (unsigned long long)is.filesHashed, is.lastRefreshMilliseconds, kBackends[int(is.backend)]); }
+    if (lastMeshCookStats.fromCache) ImGui::Text("Last mesh: cooked cache in %.2f ms", lastMeshCookStats.milliseconds);
+    else if (lastMeshCookStats.objLoad.bytes > 0) {
+        ImGui::Text("Last OBJ: %.1f MB in %.1f ms (%.0f MB/s, %u chunks), cooked in %.1f ms", double(lastMeshCookStats.objLoad.bytes) / (1024.0 * 1024.0), lastMeshCookStats.objLoad.milliseconds, lastMeshCookStats.objLoad.megabytesPerSecond, lastMeshCookStats.objLoad.chunks, lastMeshCookStats.milliseconds);
+        const MeshOptimizeReport& r = lastMeshCookStats.optimize; ImGui::Text("Last mesh: %zu -> %zu verts, ACMR %.2f -> %.2f, ATVR %.2f -> %.2f", r.inputVertices, r.outputVertices, r.before.acmr, r.after.acmr, r.before.atvr, r.after.atvr);
+        ImGui::Text("Last mesh: %u LODs built in %.1f ms, %u meshlets in %.1f ms, %u BVH nodes in %.1f ms", lastMeshCookStats.lodCount, lastMeshCookStats.lodMilliseconds, lastMeshCookStats.meshletCount, lastMeshCookStats.meshletMilliseconds, lastMeshCookStats.bvhNodeCount, lastMeshCookStats.bvhMilliseconds);
+        if (lastMeshCookStats.encodedBytes) ImGui::Text("Last mesh: cooked %.1f KB, %.1f KB encoded on disk", lastMeshCookStats.imageBytes / 1024.0, lastMeshCookStats.encodedBytes / 1024.0);
+        else ImGui::Text("Last mesh: cooked %.1f KB", lastMeshCookStats.imageBytes / 1024.0);
+    }
+    if (assetStreamer.pendingCount() + meshUploads.size() > 0) ImGui::Text("Streaming: %zu loading, %zu uploading", assetStreamer.pendingCount(), meshUploads.size());
     static int selectedAsset = -1;
     for (int i=0;i<(int)assetObjFiles.size();++i) {
-        std::string name(assetObjFiles[i].begin(), assetObjFiles[i].end());
+        ScratchArena scratch; std::pmr::string name(assetObjFiles[i].path.begin(), assetObjFiles[i].path.end(), scratch.resource());
+        if (assetObjFiles[i].cooked) name += " [cooked]";
         bool sel = (selectedAsset==i);
         if (ImGui::Selectable(name.c_str(), sel)) selectedAsset = i;
     }
     if (selectedAsset>=0 && selectedAsset<(int)assetObjFiles.size()) {
         if (ImGui::Button("Add Selected OBJ")) {
-            createObjObject(assetObjFiles[selectedAsset], L"OBJ");
+            streamObjObject(assetObjFiles[selectedAsset].path, L"OBJ");
         }
     }
     ImGui::End();
+    if (showOcclusionBuffer) drawOcclusionBufferWindow();
+#if GGINE_ENABLE_PROFILER
+    drawProfilerWindow();
+#endif
+}
 
-    ImGui::Render();
+// Each tile is drawn at its far depth and the pixels of its working layer, tinted, at their nearer depth; nearer is
+// brighter and uncovered pixels are black. Shows the buffer from the previous frame, since the UI is built first.
+void Engine::drawOcclusionBufferWindow() {
+    ImGui::Begin("Occlusion Buffer", &showOcclusionBuffer);
+    const OcclusionBuffer& occlusionBuffer = framePrep.occlusionBuffer();
+    const OcclusionStats& os = occlusionBuffer.stats(); ImGui::Text("%ux%u, %u occluders, %u triangles, %u tile updates", occlusionBuffer.width(), occlusionBuffer.height(), os.occluders, os.rasterizedTriangles, os.tilesUpdated);
+    const float scale = std::max(1.0f, std::floor(ImGui::GetContentRegionAvail().x / float(std::max(occlusionBuffer.width(), 1u)))); const ImVec2 origin = ImGui::GetCursorScreenPos(); ImDrawList* dl = ImGui::GetWindowDrawList();
+    ImGui::Dummy(ImVec2(float(occlusionBuffer.width()) * scale, float(occlusionBuffer.height()) * scale));
+    float nearest = 1.0f; for (uint32_t ty=0; ty<occlusionBuffer.tilesY(); ++ty) for (uint32_t tx=0; tx<occlusionBuffer.tilesX(); ++tx) { const OcclusionTile& t = occlusionBuffer.tile(tx, ty); nearest = std::min(nearest, t.mask ? t.workDepth : t.farDepth); }
+    auto shade = [&](float depth, bool working) { if (depth >= 1.0f) return IM_COL32(0, 0, 0, 255); const int v = int(48.0f + 207.0f * (1.0f - (depth - nearest) / std::max(1.0f - nearest, 1e-6f))); return working ? IM_COL32(v * 3 / 4, v * 7 / 8, v, 255) : IM_COL32(v, v, v, 255); };
+    auto pixels = [&](uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, ImU32 color) { dl->AddRectFilled(ImVec2(origin.x + float(x0) * scale, origin.y + float(y0) * scale), ImVec2(origin.x + float(x1) * scale, origin.y + float(y1) * scale), color); };
+    for (uint32_t ty=0; ty<occlusionBuffer.tilesY(); ++ty) for (uint32_t tx=0; tx<occlusionBuffer.tilesX(); ++tx) {
+        const OcclusionTile& t = occlusionBuffer.tile(tx, ty); const uint32_t x = tx * kOcclusionTileWidth, y = ty * kOcclusionTileHeight;
+        pixels(x, y, x + kOcclusionTileWidth, y + kOcclusionTileHeight, shade(t.farDepth, false));
+        for (uint32_t r=0; r<kOcclusionTileHeight && t.mask; ++r) { const uint32_t bits = t.mask >> (r * kOcclusionTileWidth) & 0xFFu; for (uint32_t c=0; c<kOcclusionTileWidth;) { if (!(bits >> c & 1u)) { ++c; continue; } uint32_t e = c; while (e < kOcclusionTileWidth && (bits >> e & 1u)) ++e; pixels(x + c, y + r, x + e, y + r + 1, shade(t.workDepth, true)); c = e; } }
+    }
+    ImGui::End();
+}
 
-    D3D12_RESOURCE_BARRIER toRT{};
-    toRT.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    toRT.Transition.pResource = renderTargets[currentFrameIndex].Get();
-    toRT.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-    toRT.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    toRT.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    commandList->ResourceBarrier(1, &toRT);
-    D3D12_CPU_DESCRIPTOR_HANDLE rtv = rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-    rtv.ptr += currentFrameIndex * rtvDescriptorSize;
-    D3D12_CPU_DESCRIPTOR_HANDLE dsv = dsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-    float clear[4] = {0.05f, 0.05f, 0.07f, 1.0f};
-    commandList->RSSetViewports(1, &viewport);
-    commandList->RSSetScissorRects(1, &scissorRect);
-    commandList->OMSetRenderTargets(1, &rtv, FALSE, &dsv);
-    commandList->ClearRenderTargetView(rtv, clear, 0, nullptr);
-    commandList->ClearDepthStencilView(dsv, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-    commandList->SetGraphicsRootSignature(rootSignature.Get());
-    commandList->SetPipelineState(pipelineState.Get());
-    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+#if GGINE_ENABLE_PROFILER
+bool Engine::createTimestampQueries() {
+    D3D12_QUERY_HEAP_DESC qh{}; qh.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP; qh.Count = kFrameCount * kMaxGpuZones * 2;
+    if (FAILED(device->CreateQueryHeap(&qh, IID_PPV_ARGS(&timestampHeap)))) return false;
+    if (!createBuffer(UINT64(qh.Count) * sizeof(UINT64), D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST, timestampReadback)) { timestampHeap.Reset(); return false; }
+    void* mapped = nullptr; if (FAILED(timestampReadback->Map(0, nullptr, &mapped))) { timestampHeap.Reset(); return false; }
+    timestampMapped = static_cast<const UINT64*>(mapped);
+    if (FAILED(commandQueue->GetTimestampFrequency(&gpuTimestampFrequency)) || gpuTimestampFrequency == 0) { timestampHeap.Reset(); return false; }
+    return true;
+}
 
-    XMVECTOR eye = XMLoadFloat3(&cameraPosition);
-    XMVECTOR forward = XMVectorSet(cosf(cameraPitch) * sinf(cameraYaw), sinf(cameraPitch), cosf(cameraPitch) * cosf(cameraYaw), 0.0f);
-    XMMATRIX view = XMMatrixLookAtLH(eye, XMVectorAdd(eye, forward), XMVectorSet(0,1,0,0));
-    float aspect = clientWidth > 0 ? float(clientWidth) / float(clientHeight ? clientHeight : 1) : 1.0f;
-    XMMATRIX proj = XMMatrixPerspectiveFovLH(0.9f, aspect, 0.1f, 100.0f);
-
-    for (size_t i=0; i<scene.meshes.size(); ++i) {
-        const auto& obj = scene.meshes[i];
-        if (!obj.vertexBuffer) continue;
-        XMMATRIX S = XMMatrixScaling(obj.transform.scale.x, obj.transform.scale.y, obj.transform.scale.z);
-        XMMATRIX R = XMMatrixRotationRollPitchYaw(XMConvertToRadians(obj.transform.rotationEuler.x), XMConvertToRadians(obj.transform.rotationEuler.y), XMConvertToRadians(obj.transform.rotationEuler.z));
-        XMMATRIX T = XMMatrixTranslation(obj.transform.position.x, obj.transform.position.y, obj.transform.position.z);
-        XMMATRIX mvp = S * R * T * view * proj;
-        CameraCB cb{}; XMStoreFloat4x4(&cb.mvp, mvp);
-        memcpy(cameraCBMapped[currentFrameIndex], &cb, sizeof(CameraCB));
-        commandList->IASetVertexBuffers(0, 1, &obj.vbv);
-        commandList->SetGraphicsRootConstantBufferView(0, cameraCBs[currentFrameIndex]->GetGPUVirtualAddress());
-        commandList->DrawInstanced(obj.vertexCount, 1, 0, 0);
-    }
+uint32_t Engine::beginGpuZone(const char* name) {
+    GpuFrameZones& g = gpuFrameZones[currentFrameIndex];
+    if (!timestampHeap || g.zones.size() >= kMaxGpuZones) return ~0u;
+    const uint32_t zone = uint32_t(g.zones.size()); g.zones.push_back({ name, g.open++ });
+    commandList->EndQuery(timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, (currentFrameIndex * kMaxGpuZones + zone) * 2);
+    return zone;
+}
 
-    ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), commandList.Get());
+void Engine::endGpuZone(uint32_t zone) {
+    if (zone == ~0u) return;
+    --gpuFrameZones[currentFrameIndex].open;
+    commandList->EndQuery(timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, (currentFrameIndex * kMaxGpuZones + zone) * 2 + 1);
+}
 
-    D3D12_RESOURCE_BARRIER toPresent{};
-    toPresent.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    toPresent.Transition.pResource = renderTargets[currentFrameIndex].Get();
-    toPresent.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    toPresent.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
-    toPresent.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    commandList->ResourceBarrier(1, &toPresent);
-    commandList->Close();
-    ID3D12CommandList* lists[] = { commandList.Get() };
-    commandQueue->ExecuteCommandLists(1, lists);
-    UINT presentFlags = 0; if (tearingSupported && enableTearing && !enableVsync) presentFlags |= DXGI_PRESENT_ALLOW_TEARING;
-    UINT syncInterval = enableVsync ? 1 : 0;
-    swapChain->Present(syncInterval, presentFlags);
-    moveToNextFrame();
+void Engine::resolveGpuZones() {
+    const GpuFrameZones& g = gpuFrameZones[currentFrameIndex];
+    if (g.zones.empty()) return;
+    const UINT base = currentFrameIndex * kMaxGpuZones * 2;
+    commandList->ResolveQueryData(timestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, base, UINT(g.zones.size()) * 2, timestampReadback.Get(), UINT64(base) * sizeof(UINT64));
+}
+
+// Runs once this slot's fence has passed; GPU ticks are mapped onto the profiler clock through the calibration pair
+// sampled when the frame was recorded (steady_clock is QPC-based on Windows).
+void Engine::collectGpuZones() {
+    GpuFrameZones& g = gpuFrameZones[currentFrameIndex];
+    if (g.zones.empty() || !timestampMapped) { g.zones.clear(); g.open = 0; return; }
+    const UINT64 qpcFrequency = UINT64(perfFreq.QuadPart);
+    const uint64_t cpuNs = qpcFrequency ? (g.calibrationCpu / qpcFrequency) * 1000000000ull + (g.calibrationCpu % qpcFrequency) * 1000000000ull / qpcFrequency : 0;
+    auto toNs = [&](UINT64 ticks) { return uint64_t(int64_t(cpuNs) + int64_t(double(int64_t(ticks - g.calibrationGpu)) * 1e9 / double(gpuTimestampFrequency))); };
+    const UINT64* ticks = timestampMapped + size_t(currentFrameIndex) * kMaxGpuZones * 2;
+    gpuZoneScratch.clear();
+    for (size_t i = 0; i < g.zones.size(); ++i) gpuZoneScratch.push_back({ g.zones[i].name, toNs(ticks[i * 2]), toNs(ticks[i * 2 + 1]), kProfileGpuThread, g.zones[i].depth });
+    ProfilerSubmitGpuZones(g.profilerFrame, gpuZoneScratch.data(), gpuZoneScratch.size());
+    g.zones.clear(); g.open = 0;
+}
+
+void Engine::drawProfilerWindow() {
+    ImGui::Begin("Profiler");
+    if (std::vector<ProfileFrame> captured; ProfilerTakeCapture(captured)) {
+        const std::filesystem::path path = std::filesystem::current_path() / "ggine_trace.json";
+        ProfilerThreadNames(profilerThreadNames); profilerStatus = ExportChromeTrace(path, captured, profilerThreadNames) ? "Wrote " + std::to_string(captured.size()) + " frames to " + path.string() : "Failed to write " + path.string();
+    }
+    ImGui::SliderInt("Capture frames", &profilerCaptureFrames, 1, int(kProfilerHistoryFrames - kProfilerGpuLatencyFrames - 1)); ImGui::SameLine();
+    if (ProfilerCaptureActive()) ImGui::TextUnformatted("Capturing..."); else if (ImGui::Button("Export Chrome trace")) { ProfilerStartCapture(uint32_t(profilerCaptureFrames)); profilerStatus.clear(); }
+    if (!profilerStatus.empty()) ImGui::TextUnformatted(profilerStatus.c_str());
+    const ProfilerStats ps = ProfilerGetStats(); ImGui::Text("%u threads, %llu zones dropped, GPU timestamps %s", ps.threads, (unsigned long long)ps.droppedZones, timestampHeap ? "on" : "off");
+
+    // Frames younger than the GPU latency have no GPU zones yet, so the view defaults to a slightly older frame.
+    ProfilerFrameTimes(profilerFrameMs);
+    if (!profilerFrameMs.empty()) {
+        ImGui::PlotHistogram("##frames", profilerFrameMs.data(), int(profilerFrameMs.size()), 0, nullptr, 0.0f, 40.0f, ImVec2(-1, 60));
+        if (ImGui::IsItemClicked()) { const float t = (ImGui::GetIO().MousePos.x - ImGui::GetItemRectMin().x) / std::max(ImGui::GetItemRectSize().x, 1.0f); profilerFrameAge = profilerFrameMs.size() - 1 - std::min(size_t(std::max(t, 0.0f) * profilerFrameMs.size()), profilerFrameMs.size() - 1); profilerPaused = true; }
+    }
+    int age = int(profilerFrameAge); if (ImGui::SliderInt("Frames back", &age, 0, int(kProfilerHistoryFrames) - 1)) profilerFrameAge = size_t(age);
+    ImGui::SameLine(); ImGui::Checkbox("Pause", &profilerPaused);
+    ImGui::SliderFloat("Zoom", &profilerZoom, 1.0f, 64.0f, "%.1fx", ImGuiSliderFlags_Logarithmic);
+    if (!profilerPaused || profilerFrame.index == 0) ProfilerCopyFrame(profilerFrameAge, profilerFrame);
+    const ProfileFrame& f = profilerFrame;
+    if (f.index == 0) { ImGui::End(); return; }
+    ImGui::Text("Frame %llu: %.2f ms", (unsigned long long)f.index, double(f.endNs - f.beginNs) / 1e6);
+
+    // One lane per thread plus the GPU; nested zones stack downwards so each lane reads as a flame graph.
+    ProfilerThreadNames(profilerThreadNames); const std::vector<std::string>& threads = profilerThreadNames;
+    const uint32_t gpuLane = uint32_t(threads.size());
+    ScratchArena scratch; std::pmr::vector<uint32_t> laneDepth(threads.size() + 1, 0, scratch.resource());
+    for (const ProfileZone& z : f.zones) { const uint32_t lane = z.thread == kProfileGpuThread ? gpuLane : z.thread; if (lane < laneDepth.size()) laneDepth[lane] = std::max(laneDepth[lane], z.depth + 1); }
+    ImGui::BeginChild("Timeline", ImVec2(0, 0), ImGuiChildFlags_Border, ImGuiWindowFlags_HorizontalScrollbar);
+    const float rowHeight = ImGui::GetTextLineHeight() + 4.0f, width = std::max(ImGui::GetContentRegionAvail().x, 100.0f) * profilerZoom;
+    std::pmr::vector<ImVec2> laneOrigin(laneDepth.size(), ImVec2(0, 0), scratch.resource());
+    for (uint32_t lane = 0; lane < laneDepth.size(); ++lane) {
+        if (!laneDepth[lane]) continue;
+        ImGui::TextUnformatted(lane == gpuLane ? "GPU" : threads[lane].c_str());
+        laneOrigin[lane] = ImGui::GetCursorScreenPos(); ImGui::Dummy(ImVec2(width, float(laneDepth[lane]) * rowHeight));
+    }
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    const double frameNs = double(std::max<uint64_t>(f.endNs - f.beginNs, 1));
+    for (const ProfileZone& z : f.zones) {
+        const uint32_t lane = z.thread == kProfileGpuThread ? gpuLane : z.thread;
+        if (lane >= laneDepth.size()) continue;
+        const ImVec2 o = laneOrigin[lane];
+        auto x = [&](uint64_t ns) { return o.x + width * float(std::clamp(double(int64_t(ns - f.beginNs)) / frameNs, 0.0, 1.0)); };
+        const ImVec2 lo(x(z.beginNs), o.y + float(z.depth) * rowHeight), hi(std::max(x(z.endNs), lo.x + 1.0f), lo.y + rowHeight - 1.0f);
+        const float hue = float(std::hash<std::string_view>{}(z.name) % 1024) / 1024.0f;
+        draw->AddRectFilled(lo, hi, ImColor::HSV(hue, 0.45f, 0.75f));
+        if (ImGui::CalcTextSize(z.name).x + 4.0f < hi.x - lo.x) draw->AddText(ImVec2(lo.x + 2.0f, lo.y + 1.0f), IM_COL32(0, 0, 0, 255), z.name);
+        if (ImGui::IsMouseHoveringRect(lo, hi) && ImGui::IsWindowHovered()) ImGui::SetTooltip("%s\n%.3f ms", z.name, double(z.endNs - z.beginNs) / 1e6);
+    }
+    ImGui::EndChild();
+    ImGui::End();
 }
+#endif
 
-void Engine::moveToNextFrame() { const UINT64 fv = fenceValues[currentFrameIndex]; commandQueue->Signal(fence.Get(), fv); currentFrameIndex = swapChain->GetCurrentBackBufferIndex(); if (fence->GetCompletedValue() < fenceValues[currentFrameIndex]) { fence->SetEventOnCompletion(fenceValues[currentFrameIndex], fenceEvent); WaitForSingleObject(fenceEvent, INFINITE);} fenceValues[currentFrameIndex] = fv + 1; }
+void Engine::waitForFrame(UINT64 serial) { if (fence->GetCompletedValue() < serial) { PROFILE_ZONE("Wait for GPU"); fence->SetEventOnCompletion(serial, renderFenceEvent); WaitForSingleObject(renderFenceEvent, INFINITE); } retireUploads(); }
 
-void Engine::waitForGpu() { commandQueue->Signal(fence.Get(), fenceValues[currentFrameIndex]); fence->SetEventOnCompletion(fenceValues[currentFrameIndex], fenceEvent); WaitForSingleObject(fenceEvent, INFINITE); fenceValues[currentFrameIndex]++; }
+// Main thread only: drains the render thread first, after which the main thread may touch its resources.
+void Engine::waitForGpu() { if (framePipeline) framePipeline->waitIdle(); if (fence->GetCompletedValue() < frameSerial) { fence->SetEventOnCompletion(frameSerial, fenceEvent); WaitForSingleObject(fenceEvent, INFINITE); } retireUploads(); for (GeometryBlock& b : geometryBlocks) b.allocator.retire(frameSerial); }
 
-void Engine::resize(UINT width, UINT height) { if (!swapChain) { clientWidth = width; clientHeight = height; return; } if (width==0 || height==0) return; waitForGpu(); for (UINT i=0;i<kFrameCount;++i) renderTargets[i].Reset(); depthStencil.Reset(); DXGI_SWAP_CHAIN_DESC desc{}; swapChain->GetDesc(&desc); if (FAILED(swapChain->ResizeBuffers(kFrameCount, width, height, desc.BufferDesc.Format, desc.Flags))) return; swapChain->SetMaximumFrameLatency(kFrameCount); frameLatencyWaitableObject = swapChain->GetFrameLatencyWaitableObject(); currentFrameIndex = swapChain->GetCurrentBackBufferIndex(); createRenderTargets(); clientWidth=width; clientHeight=height; viewport.Width = (float)width; viewport.Height = (float)height; scissorRect.right = (LONG)width; scissorRect.bottom = (LONG)height; createDepthResources(); }
+void Engine::resize(UINT width, UINT height) { if (!swapChain) { clientWidth = width; clientHeight = height; return; } if (width==0 || height==0) return; waitForGpu(); for (UINT i=0;i<kFrameCount;++i) renderTargets[i].Reset(); depthStencil.Reset(); DXGI_SWAP_CHAIN_DESC desc{}; swapChain->GetDesc(&desc); if (FAILED(swapChain->ResizeBuffers(kFrameCount, width, height, desc.BufferDesc.Format, desc.Flags))) return; swapChain->SetMaximumFrameLatency(kFrameCount); frameLatencyWaitableObject = swapChain->GetFrameLatencyWaitableObject(); createRenderTargets(); clientWidth=width; clientHeight=height; viewport.Width = (float)width; viewport.Height = (float)height; scissorRect.right = (LONG)width; scissorRect.bottom = (LONG)height; createDepthResources(); }
 
-Engine::~Engine() { if (commandQueue && fence && fenceEvent) waitForGpu(); ImGui_ImplDX12_Shutdown(); ImGui_ImplWin32_Shutdown(); ImGui::DestroyContext(); if (fenceEvent) CloseHandle(fenceEvent); }
+Engine::~Engine() { framePipeline.reset(); if (commandQueue && fence && fenceEvent) waitForGpu(); if (copyFence && fenceEvent && copyFence->GetCompletedValue() < copyFenceValue) { copyFence->SetEventOnCompletion(copyFenceValue, fenceEvent); WaitForSingleObject(fenceEvent, INFINITE); } ImGui_ImplDX12_Shutdown(); ImGui_ImplWin32_Shutdown(); ImGui::DestroyContext(); if (fenceEvent) CloseHandle(fenceEvent); if (renderFenceEvent) CloseHandle(renderFenceEvent); }
 
 void Engine::initAssetsDir() {
     std::filesystem::path base = std::filesystem::path(L".");
@@ -308,23 +785,62 @@ void Engine::initAssetsDir() {
     if (!std::filesystem::exists(assets)) {
         std::error_code ec; std::filesystem::create_directories(assets, ec);
     }
-    assetsDirW = assets.wstring();
-}
-
-void Engine::scanAssets() {
-    assetObjFiles.clear();
-    if (assetsDirW.empty()) return;
-    std::filesystem::path root(assetsDirW);
-    std::error_code ec;
-    for (auto& entry : std::filesystem::directory_iterator(root, ec)) {
-        if (!entry.is_regular_file()) continue;
-        auto p = entry.path();
-        if (p.has_extension()) {
-            auto ext = p.extension().wstring();
-            for (auto& c : ext) c = (wchar_t)towlower(c);
-            if (ext == L".obj") {
-                assetObjFiles.push_back(p.wstring());
-            }
+    assetsDirW = assets.wstring(); sceneFileW = (assets / L"scene.ggscene").wstring();
+    assetIndex.start(assets, assets / L".ggindex");
+}
+
+// Transforms are written in slot order, so parents precede children; meshes name their source by asset index key.
+bool Engine::saveScene(const std::wstring& path) const {
+    PROFILE_ZONE("Save scene");
+    SceneFileData data; data.camera = { { cameraPosition.x, cameraPosition.y, cameraPosition.z }, cameraYaw, cameraPitch };
+    data.resizeNodes(scene.transforms.size()); scene.transforms.exportSlots(data.positions.data(), data.eulerDegrees.data(), data.scales.data(), data.parents.data());
+    data.meshes.reserve(scene.meshes.size()); data.lights.reserve(scene.lights.size());
+    for (const MeshObject& m : scene.meshes) { ScratchArena scratch; const std::pmr::string name = ToUtf8(m.name, scratch.resource()); data.meshes.push_back({ scene.transforms.slotOf(m.transform), m.sourcePath.empty() ? kSceneBuiltinCube : data.addAsset(AssetIndex::KeyFor(assetsDirW, m.sourcePath)), m.materialId, data.addString(name) }); }
+    for (const LightObject& l : scene.lights) { ScratchArena scratch; const std::pmr::string name = ToUtf8(l.name, scratch.resource()); data.lights.push_back({ scene.transforms.slotOf(l.transform), { l.color.x, l.color.y, l.color.z }, l.intensity, data.addString(name) }); }
+    return WriteSceneFile(path, data);
+}
+
+// Meshes start out as the placeholder cube and stream their cooked asset in; each distinct asset is requested once.
+bool Engine::loadScene(const std::wstring& path) {
+    PROFILE_ZONE("Load scene");
+    const auto start = std::chrono::steady_clock::now();
+    SceneFile file; if (!file.open(path)) return false;
+    const GgsceneHeader& h = file.info();
+    std::vector<TransformHandle> nodes(h.nodeCount); scene.transforms.append(h.nodeCount, file.positions(), file.eulerDegrees(), file.scales(), file.parents(), nodes.data());
+    std::vector<StreamHandle> requests(h.assetCount); std::vector<std::wstring> sources(h.assetCount);
+    scene.meshes.reserve(scene.meshes.size() + h.meshCount); scene.lights.reserve(scene.lights.size() + h.lightCount);
+    for (uint32_t i = 0; i < h.meshCount; ++i) {
+        const SceneMeshRecord& r = file.meshes()[i]; const std::string_view name = file.string(r.name);
+        MeshObject m = placeholderMesh; m.name = FromUtf8(name); m.materialId = r.materialId; m.transform = nodes[r.node];
+        if (r.asset != kSceneBuiltinCube) {
+            if (!requests[r.asset].isValid()) { sources[r.asset] = AssetIndex::PathFor(assetsDirW, std::string(file.string(file.assets()[r.asset].key))).wstring(); requests[r.asset] = assetStreamer.request(std::filesystem::path(sources[r.asset])); }
+            m.sourcePath = sources[r.asset]; m.pendingLoad = requests[r.asset];
         }
+        addMeshObject(std::move(m));
+    }
+    for (uint32_t i = 0; i < h.lightCount; ++i) {
+        const SceneLightRecord& r = file.lights()[i]; const std::string_view name = file.string(r.name);
+        LightObject l; l.name = FromUtf8(name); l.transform = nodes[r.node]; l.color = { r.color.x, r.color.y, r.color.z }; l.intensity = r.intensity; addLightObject(std::move(l));
+    }
+    cameraPosition = { h.camera.position.x, h.camera.position.y, h.camera.position.z }; cameraYaw = h.camera.yaw; cameraPitch = h.camera.pitch; previousCamera = cameraPose();
+    if (scene.selectedLight < 0 && !scene.lights.empty()) scene.selectedLight = 0;
+    sceneLoadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void Engine::syncAssetIndex() {
+    std::vector<AssetRecord> records;
+    if (assetIndex.snapshot(records, assetIndexVersion)) { assetObjFiles.clear(); assetObjFiles.reserve(records.size()); for (const AssetRecord& r : records) assetObjFiles.push_back({ AssetIndex::PathFor(assetsDirW, r.path).wstring(), r.cooked }); }
+    assetChanges.clear(); assetIndex.pollChanges(assetChanges);
+    for (const AssetChange& c : assetChanges) if (c.kind == AssetChangeKind::Modified) reloadMeshSource(AssetIndex::PathFor(assetsDirW, c.record.path).wstring());
+}
+
+void Engine::reloadMeshSource(const std::wstring& path) {
+    StreamHandle handle{};
+    for (MeshObject& m : scene.meshes) {
+        if (m.sourcePath != path) continue;
+        if (!handle.isValid()) handle = assetStreamer.request(std::filesystem::path(path), StreamPriority::Immediate);
+        if (m.pendingLoad.isValid()) assetStreamer.cancel(m.pendingLoad);
+        m.pendingLoad = handle;
     }
 }
@@ -7,35 +7,99 @@
 #include <vector>
 #include <string>
 #include <DirectXMath.h>
+#include <memory>
+#include <memory_resource>
+#include "imgui.h"
 #include "Scene.h"
+#include "MeshCache.h"
+#include "UploadRing.h"
+#include "DrawBatcher.h"
+#include "FramePrep.h"
+#include "JobSystem.h"
+#include "AssetStreamer.h"
+#include "AssetIndex.h"
+#include "Profiler.h"
+#include "FramePipeline.h"
+#include "D3D12Renderer.h"
+#include "HierarchyView.h"
+#include "LinearArena.h"
 
 class Engine {
 public:
     Engine(UINT width, UINT height);
     bool initialize(HWND windowHandle);
     void resize(UINT width, UINT height);
-    void render();
+    void render(float interpolation);
     void update(double dt);
     void waitForGpu();
     ~Engine();
 
 private:
     static constexpr UINT kFrameCount = 2;
-    void moveToNextFrame();
+    static_assert(kFrameCount + 1 <= UploadRing::kMaxFramesInFlight, "the constant ring must hold a mark for every frame in flight");
+    struct FrameBatch { uint64_t sortKey; std::shared_ptr<GeometryRange> geometry; std::shared_ptr<const std::vector<Meshlet>> meshlets; D3D12_VERTEX_BUFFER_VIEW vbv; D3D12_INDEX_BUFFER_VIEW ibv; MeshVertexFormat vertex; PositionDequantize dequantize; MeshLod lod; UINT vertexCount; uint32_t firstInstance; uint32_t instanceCount; };
+    // Written by the main thread, read by the render thread. The batches keep their geometry alive until the slot is reused;
+    // renderStats and clusterStats are written back by the render thread. The per-frame arrays live in the slot's arena,
+    // which recycle() resets once beginFrame hands the slot back, i.e. after the render thread is done with it.
+    struct FrameSnapshot {
+        uint64_t serial{0}; uint64_t profilerFrame{0}; Float4x4 viewProj{}; Float4x4 view{}; Float3 eye{}; bool clusterBackfaceCulling{false}; bool vsync{true}; bool tearing{false};
+        LinearArena arena{ 1u << 20 };
+        std::pmr::vector<FrameBatch> batches{ &arena }; std::pmr::vector<Float4x4> worlds{ &arena };
+        LightGridParams lightGrid{}; std::pmr::vector<ClusterLight> lights{ &arena }; std::pmr::vector<LightClusterRange> lightRanges{ &arena }; std::pmr::vector<uint32_t> lightIndices{ &arena };
+        ImDrawData ui{}; std::vector<std::unique_ptr<ImDrawList>> uiLists;
+        RenderStreamStats renderStats{}; ClusterCullStats clusterStats{};
+        void recycle() { batches = decltype(batches)(&arena); worlds = decltype(worlds)(&arena); lights = decltype(lights)(&arena); lightRanges = decltype(lightRanges)(&arena); lightIndices = decltype(lightIndices)(&arena); arena.reset(); }
+    };
+    void waitForFrame(UINT64 serial);
+    void buildFrameSnapshot(FrameSnapshot& frame);
+    void recordFrame(FrameSnapshot& frame);
     void createSwapChain();
     void createRenderTargets();
     void createDepthResources();
     bool createPipeline();
     bool initImGui();
     bool createCubeObject(const std::wstring& name);
-    bool createObjObject(const std::wstring& path, const std::wstring& name);
+    void streamObjObject(const std::wstring& path, const std::wstring& name);
+    bool createMeshObject(const std::wstring& name, const Float3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount);
+    bool createMeshGeometry(const Float3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, MeshObject& m);
+    void addMeshObject(MeshObject&& m);
+    bool createCopyQueue();
+    bool createBuffer(UINT64 byteSize, D3D12_HEAP_TYPE heap, D3D12_RESOURCE_STATES state, Microsoft::WRL::ComPtr<ID3D12Resource>& outBuffer);
+    void pumpAssetStreaming();
+    void failPendingLoad(StreamHandle handle);
+    std::shared_ptr<GeometryRange> allocateGeometry(UINT64 byteSize);
+    GeometryFormat geometryFormatFor(UINT vertexCount) const { return { quantizeGeometry ? MeshVertexFormat::Quantized16 : MeshVertexFormat::Float3, vertexCount <= 0xFFFFu }; }
+    void bindGeometry(MeshObject& m, std::shared_ptr<GeometryRange> geometry, const GeometryFormat& format, UINT vertexCount, UINT indexCount, const MeshLod* lods = nullptr, uint32_t lodCount = 0);
+    bool createStagingBuffer(UINT64 capacity);
+    bool reserveStaging(UINT64 byteSize);
+    bool stageGeometry(const GeometryRange& range, const GeometryFormat& format, const Aabb& bounds, const Float3* positions, const uint32_t* normals, UINT vertexCount, const uint32_t* indices, UINT indexCount);
+    void submitCopies();
+    void waitForCopyQueue();
     void createLightObject(const std::wstring& name);
-    bool uploadVerticesToBuffer(const std::vector<DirectX::XMFLOAT3>& vertices, Microsoft::WRL::ComPtr<ID3D12Resource>& outVB, D3D12_VERTEX_BUFFER_VIEW& outVBV);
+    void addLightObject(LightObject&& l);
+    bool createConstantRing(UINT64 capacity);
+    D3D12_GPU_VIRTUAL_ADDRESS allocateUpload(size_t byteSize, void** outCpu);
+    D3D12_GPU_VIRTUAL_ADDRESS allocateConstants(const void* data, size_t byteSize);
+    void retireUploads();
     void setFullscreen(bool enable);
     void setWindowClientSize(UINT width, UINT height);
     std::vector<uint8_t> readFileBytes(const std::wstring& path);
     void initAssetsDir();
-    void scanAssets();
+    bool saveScene(const std::wstring& path) const;
+    bool loadScene(const std::wstring& path);
+    void syncAssetIndex();
+    void reloadMeshSource(const std::wstring& path);
+    void buildEditorUi();
+    void drawOcclusionBufferWindow();
+    int pickMesh(POINT cursor);
+#if GGINE_ENABLE_PROFILER
+    bool createTimestampQueries();
+    uint32_t beginGpuZone(const char* name);
+    void endGpuZone(uint32_t zone);
+    void resolveGpuZones();
+    void collectGpuZones();
+    void drawProfilerWindow();
+#endif
 
     UINT clientWidth; UINT clientHeight; HWND hwnd;
     Microsoft::WRL::ComPtr<IDXGIFactory6> dxgiFactory;
@@ -51,18 +115,82 @@ private:
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
     Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
     Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
-    struct alignas(256) CameraCB { DirectX::XMFLOAT4X4 mvp; };
-    Microsoft::WRL::ComPtr<ID3D12Resource> cameraCBs[kFrameCount];
-    uint8_t* cameraCBMapped[kFrameCount]{};
-    Microsoft::WRL::ComPtr<ID3D12Fence> fence; UINT64 fenceValues[kFrameCount]{}; HANDLE fenceEvent{};
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> quantizedPipelineState;
+    struct DrawConstants { uint32_t instanceOffset; Float3 dequantizeScale; Float3 dequantizeOffset; };
+    static_assert(sizeof(DrawConstants) == (kRenderDrawConstants + 1) * sizeof(uint32_t), "D3D12Renderer writes the instance offset then the draw constants");
+    bool quantizeGeometry{true};
+    struct alignas(256) FrameCB { DirectX::XMFLOAT4X4 viewProj; DirectX::XMFLOAT4X4 view; Float3 eye; float padding; LightGridParams lightGrid; };
+    struct InstanceData { DirectX::XMFLOAT4X4 world; };
+    static constexpr UINT64 kInitialConstantRingBytes = 4ull << 20;
+    struct RetiredBuffer { Microsoft::WRL::ComPtr<ID3D12Resource> buffer; UINT64 fenceValue; };
+    Microsoft::WRL::ComPtr<ID3D12Resource> constantRingBuffer;
+    uint8_t* constantRingMapped{nullptr};
+    UploadRing constantRing;
+    std::vector<RetiredBuffer> retiredConstantRings;
+    struct GeometryBlock { Microsoft::WRL::ComPtr<ID3D12Resource> buffer; TlsfAllocator allocator; };
+    static constexpr UINT64 kGeometryBlockBytes = 64ull << 20;
+    // Freed ranges come back a few frames after release, so a failed allocation is retried this many frames before the load fails.
+    static constexpr uint32_t kMaxGeometryAllocationAttempts = 8;
+    std::vector<GeometryBlock> geometryBlocks;
+    static constexpr UINT64 kInitialStagingBytes = 64ull << 20;
+    Microsoft::WRL::ComPtr<ID3D12Resource> stagingBuffer;
+    uint8_t* stagingMapped{nullptr};
+    UploadRing stagingRing;
+    FramePrep framePrep;
+    FramePrepSettings framePrepSettings;
+    uint32_t nextGeometryId{1};
+    RenderStreamStats lastRenderStats{};
+    uint64_t lastFrameHeapAllocations{0}; size_t lastFrameArenaBytes{0};
+    RenderCommandStream renderCommands;
+    D3D12Renderer d3d12Renderer;
+    ClusterCullPass clusterCull;
+    HierarchyView hierarchyView;
+    ClusterCullStats lastClusterStats{};
+    bool clusterCulling{true};
+    bool clusterBackfaceCulling{false};
+    bool showOcclusionBuffer{false};
+    static constexpr float kCameraFovY = 0.9f; static constexpr float kCameraNear = 0.1f; static constexpr float kCameraFar = 100.0f;
+    bool leftMouseDown{false}; double lastPickMs{0.0}; uint32_t lastPickCandidates{0};
+    JobSystem jobs;
+    AssetStreamer assetStreamer{&jobs, DefaultMeshStreamStages(&jobs)};
+    // The direct queue signals each frame's serial; frameSerial is the last frame the main thread published, renderSerial the one being recorded.
+    Microsoft::WRL::ComPtr<ID3D12Fence> fence; HANDLE fenceEvent{}; HANDLE renderFenceEvent{}; UINT64 frameSerial{0}; UINT64 renderSerial{0};
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> copyQueue;
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> copyAllocator;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> copyList;
+    Microsoft::WRL::ComPtr<ID3D12Fence> copyFence; UINT64 copyFenceValue{0}; bool copyRecording{false};
+    struct PendingMeshUpload { StreamHandle handle; std::unique_ptr<StreamedMesh> payload; std::shared_ptr<GeometryRange> geometry; GeometryFormat format{}; UINT64 fenceValue{0}; uint32_t allocationAttempts{0}; };
+    std::vector<PendingMeshUpload> meshUploads;
+    std::vector<StreamCompletion> streamCompletions;
+    MeshObject placeholderMesh;
     UINT currentFrameIndex; D3D12_VIEWPORT viewport; D3D12_RECT scissorRect;
     std::wstring cameraName{L"Camera"}; DirectX::XMFLOAT3 cameraPosition{0.0f,0.0f,-3.5f}; float cameraYaw{0.0f}; float cameraPitch{0.0f}; POINT lastMouse{};
+    CameraPose cameraPose() const { return { { cameraPosition.x, cameraPosition.y, cameraPosition.z }, cameraYaw, cameraPitch }; }
+    CameraPose previousCamera{};
     bool tearingSupported{false}; bool enableTearing{false}; bool enableVsync{true};
+#if GGINE_ENABLE_PROFILER
+    static constexpr UINT kMaxGpuZones = 32;
+    struct GpuZoneMarker { const char* name; uint32_t depth; };
+    struct GpuFrameZones { std::vector<GpuZoneMarker> zones; uint32_t open{0}; uint64_t profilerFrame{0}; UINT64 calibrationGpu{0}; UINT64 calibrationCpu{0}; };
+    Microsoft::WRL::ComPtr<ID3D12QueryHeap> timestampHeap;
+    Microsoft::WRL::ComPtr<ID3D12Resource> timestampReadback;
+    const UINT64* timestampMapped{nullptr}; UINT64 gpuTimestampFrequency{0};
+    GpuFrameZones gpuFrameZones[kFrameCount];
+    std::vector<ProfileZone> gpuZoneScratch;
+    ProfileFrame profilerFrame; std::vector<float> profilerFrameMs; size_t profilerFrameAge{kProfilerGpuLatencyFrames}; bool profilerPaused{false}; float profilerZoom{1.0f};
+    int profilerCaptureFrames{120}; std::string profilerStatus; std::vector<std::string> profilerThreadNames;
+#endif
     std::vector<float> frameTimeMs; size_t frameTimeWriteIdx{0}; LARGE_INTEGER perfFreq{}; LARGE_INTEGER lastCounter{}; bool timingInitialized{false};
     Scene scene; enum class SelectionKind { None, Camera, Mesh, Light }; SelectionKind selectionKind{SelectionKind::Mesh}; int selectedIndex{0};
     bool isFullscreen{false}; DWORD windowStyle{0}; RECT windowRect{0,0,0,0};
 
     std::wstring assetsDirW{};
-    std::vector<std::wstring> assetObjFiles;
-    double assetsRescanAccum{0.0};
+    std::wstring sceneFileW{}; double sceneLoadMs{-1.0}; bool sceneSaveFailed{false};
+    struct AssetEntry { std::wstring path; bool cooked{false}; };
+    std::vector<AssetEntry> assetObjFiles;
+    MeshCookStats lastMeshCookStats{};
+    AssetIndexService assetIndex;
+    std::vector<AssetChange> assetChanges;
+    uint64_t assetIndexVersion{0};
+    std::unique_ptr<FramePipeline<FrameSnapshot>> framePipeline;
 };
@@ -0,0 +1,143 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+bool FileWatcher::start(const std::filesystem::path& root, std::chrono::milliseconds pollInterval, bool forcePolling) {
+    stop();
+    watchRoot = root; interval = pollInterval; stopping = false;
+    std::error_code ec; if (!std::filesystem::is_directory(root, ec)) return false;
+    if (!forcePolling && openNative()) thread = std::thread([this] { nativeLoop(); });
+    else { activeBackend = FileWatchBackend::Polling; thread = std::thread([this] { pollingLoop(); }); }
+    return true;
+}
+
+void FileWatcher::stop() {
+    if (!thread.joinable()) return;
+    stopping = true; wake();
+    thread.join(); closeNative();
+    activeBackend = FileWatchBackend::None;
+    std::lock_guard<std::mutex> lock(mutex); dirty.clear(); woken = false;
+}
+
+void FileWatcher::wake() { { std::lock_guard<std::mutex> lock(mutex); woken = true; } changed.notify_all(); }
+
+void FileWatcher::markDirty(std::filesystem::path path) {
+    { std::lock_guard<std::mutex> lock(mutex); dirty.push_back(std::move(path)); }
+    changed.notify_all();
+}
+
+bool FileWatcher::waitForChanges(std::vector<std::filesystem::path>& outPaths, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait_for(lock, timeout, [this] { return woken || !dirty.empty(); });
+    woken = false;
+    if (dirty.empty()) return false;
+    std::sort(dirty.begin(), dirty.end()); dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    outPaths.insert(outPaths.end(), dirty.begin(), dirty.end()); dirty.clear();
+    return true;
+}
+
+void FileWatcher::pollingLoop() {
+    while (!stopping) {
+        markDirty(watchRoot);
+        const auto until = std::chrono::steady_clock::now() + interval;
+        while (!stopping && std::chrono::steady_clock::now() < until) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+}
+
+#if defined(_WIN32)
+bool FileWatcher::openNative() {
+    HANDLE dir = CreateFileW(watchRoot.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (dir == INVALID_HANDLE_VALUE) return false;
+    HANDLE ev = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!ev) { CloseHandle(dir); return false; }
+    directoryHandle = dir; overlappedEvent = ev; activeBackend = FileWatchBackend::ReadDirectoryChanges;
+    return true;
+}
+
+void FileWatcher::closeNative() {
+    if (directoryHandle) { CancelIo(directoryHandle); CloseHandle(directoryHandle); directoryHandle = nullptr; }
+    if (overlappedEvent) { CloseHandle(overlappedEvent); overlappedEvent = nullptr; }
+}
+
+void FileWatcher::nativeLoop() {
+    alignas(DWORD) uint8_t buffer[64 * 1024];
+    const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+    while (!stopping) {
+        OVERLAPPED ov{}; ov.hEvent = overlappedEvent; ResetEvent(overlappedEvent);
+        if (!ReadDirectoryChangesW(directoryHandle, buffer, sizeof(buffer), TRUE, filter, nullptr, &ov, nullptr)) { activeBackend = FileWatchBackend::Polling; pollingLoop(); return; }
+        DWORD bytes = 0;
+        while (!stopping && WaitForSingleObject(overlappedEvent, 100) == WAIT_TIMEOUT) {}
+        if (stopping) { CancelIoEx(directoryHandle, &ov); GetOverlappedResult(directoryHandle, &ov, &bytes, TRUE); return; }
+        if (!GetOverlappedResult(directoryHandle, &ov, &bytes, FALSE) || bytes == 0) { markDirty(watchRoot); continue; }
+        for (const uint8_t* p = buffer;;) {
+            const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+            markDirty(watchRoot / std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)));
+            if (!info->NextEntryOffset) break;
+            p += info->NextEntryOffset;
+        }
+    }
+}
+#elif defined(__linux__)
+namespace {
+constexpr uint32_t kInotifyMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF;
+}
+
+bool FileWatcher::openNative() {
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) return false;
+    addWatchRecursive(watchRoot);
+    if (watches.empty()) { closeNative(); return false; }
+    activeBackend = FileWatchBackend::Inotify;
+    return true;
+}
+
+void FileWatcher::closeNative() {
+    if (inotifyFd >= 0) { ::close(inotifyFd); inotifyFd = -1; }
+    watches.clear();
+}
+
+void FileWatcher::addWatchRecursive(const std::filesystem::path& dir) {
+    const int wd = inotify_add_watch(inotifyFd, dir.c_str(), kInotifyMask);
+    if (wd < 0) return;
+    watches[wd] = dir;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(dir, std::filesystem::directory_options::skip_permission_denied, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_directory(ec)) continue;
+        const int sub = inotify_add_watch(inotifyFd, it->path().c_str(), kInotifyMask);
+        if (sub >= 0) watches[sub] = it->path();
+    }
+}
+
+void FileWatcher::nativeLoop() {
+    alignas(inotify_event) char buffer[64 * 1024];
+    while (!stopping) {
+        pollfd pfd{ inotifyFd, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0) continue;
+        for (;;) {
+            const ssize_t n = read(inotifyFd, buffer, sizeof(buffer));
+            if (n <= 0) break;
+            for (char* p = buffer; p < buffer + n;) {
+                const inotify_event* e = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + e->len;
+                if (e->mask & IN_Q_OVERFLOW) { markDirty(watchRoot); continue; }
+                auto w = watches.find(e->wd);
+                if (w == watches.end()) continue;
+                if (e->mask & IN_IGNORED) { watches.erase(w); continue; }
+                const std::filesystem::path path = e->len ? w->second / e->name : w->second;
+                if ((e->mask & IN_ISDIR) && (e->mask & (IN_CREATE | IN_MOVED_TO))) addWatchRecursive(path);
+                markDirty(path);
+            }
+        }
+    }
+}
+#else
+bool FileWatcher::openNative() { return false; }
+void FileWatcher::closeNative() {}
+void FileWatcher::nativeLoop() {}
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class FileWatchBackend { None, Inotify, ReadDirectoryChanges, Polling };
+
+// Reports paths under a root that may have changed; a directory path means "anything below here".
+class FileWatcher {
+public:
+    FileWatcher() = default;
+    ~FileWatcher() { stop(); }
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool start(const std::filesystem::path& root, std::chrono::milliseconds pollInterval = std::chrono::milliseconds(1000), bool forcePolling = false);
+    void stop();
+    bool waitForChanges(std::vector<std::filesystem::path>& outPaths, std::chrono::milliseconds timeout);
+    void wake();
+    FileWatchBackend backend() const { return activeBackend; }
+    const std::filesystem::path& root() const { return watchRoot; }
+
+private:
+    bool openNative();
+    void closeNative();
+    void nativeLoop();
+    void pollingLoop();
+    void markDirty(std::filesystem::path path);
+
+    std::filesystem::path watchRoot;
+    std::chrono::milliseconds interval{1000};
+    std::atomic<FileWatchBackend> activeBackend{FileWatchBackend::None};
+    std::thread thread;
+    std::atomic<bool> stopping{false};
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::filesystem::path> dirty;
+    bool woken{false};
+#if defined(_WIN32)
+    void* directoryHandle{nullptr};
+    void* overlappedEvent{nullptr};
+#elif defined(__linux__)
+    void addWatchRecursive(const std::filesystem::path& dir);
+    int inotifyFd{-1};
+    std::unordered_map<int, std::filesystem::path> watches;
+#endif
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include "MathTypes.h"
+#include "Profiler.h"
+
+// Fixed simulation step with a render-rate interpolation factor taken from the leftover time.
+class FixedStepClock {
+public:
+    explicit FixedStepClock(double step = 1.0 / 60.0, double maxFrame = 0.25) : stepSeconds(step), maxFrameSeconds(maxFrame) {}
+    // Returns how many simulation steps the elapsed time pays for; long stalls are clamped instead of spiralling.
+    uint32_t advance(double frameSeconds) {
+        accumulator += std::clamp(frameSeconds, 0.0, maxFrameSeconds);
+        uint32_t steps = 0; while (accumulator >= stepSeconds) { accumulator -= stepSeconds; ++steps; }
+        return steps;
+    }
+    double step() const { return stepSeconds; }
+    // Fraction of a step between the previous and current simulation state that the rendered frame should show.
+    float alpha() const { return float(accumulator / stepSeconds); }
+
+private:
+    double stepSeconds;
+    double maxFrameSeconds;
+    double accumulator{0.0};
+};
+
+struct CameraPose {
+    Float3 position{};
+    float yaw{0.0f};
+    float pitch{0.0f};
+};
+
+inline CameraPose LerpCameraPose(const CameraPose& a, const CameraPose& b, float t) {
+    auto lerp = [t](float x, float y) { return x + (y - x) * t; };
+    return { { lerp(a.position.x, b.position.x), lerp(a.position.y, b.position.y), lerp(a.position.z, b.position.z) }, lerp(a.yaw, b.yaw), lerp(a.pitch, b.pitch) };
+}
+
+// Hands frames from a producer (simulation/UI thread) to a consumer thread through two snapshot slots.
+// The producer fills frame N while the consumer works on N - 1; beginFrame only blocks when the slot it is about to
+// reuse still holds N - 2. The slots are handed over by two frame counters, so neither side takes a lock.
+// The consumer may write results back into its snapshot; the producer sees them when beginFrame returns that slot.
+// With threaded == false publish() consumes inline, which keeps the same contract for serial runs and tests.
+template <typename Snapshot>
+class FramePipeline {
+public:
+    using Consumer = std::function<void(Snapshot&)>;
+
+    explicit FramePipeline(Consumer consume, bool threaded = true, std::string threadName = "Render") : consume(std::move(consume)) {
+        if (threaded) worker = std::thread([this, name = std::move(threadName)] { PROFILE_THREAD(name); (void)name; run(); });
+    }
+    ~FramePipeline() {
+        if (!worker.joinable()) return;
+        published.fetch_or(kStopBit, std::memory_order_release); published.notify_one();
+        worker.join();
+    }
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    Snapshot& beginFrame() {
+        const uint64_t frame = publishedFrames();
+        if (frame >= 2) waitConsumed(frame - 1);
+        return slots[frame & 1];
+    }
+    void publish() {
+        const uint64_t frame = published.fetch_add(1, std::memory_order_release) & ~kStopBit;
+        if (worker.joinable()) published.notify_one(); else { consume(slots[frame & 1]); consumed.store(frame + 1, std::memory_order_release); }
+    }
+    // Blocks until everything published has been consumed, e.g. before the consumer's resources are resized.
+    void waitIdle() { waitConsumed(publishedFrames()); }
+
+    uint64_t publishedFrames() const { return published.load(std::memory_order_relaxed) & ~kStopBit; }
+    uint64_t consumedFrames() const { return consumed.load(std::memory_order_acquire); }
+    bool threaded() const { return worker.joinable(); }
+
+private:
+    static constexpr uint64_t kStopBit = 1ull << 63;
+
+    void waitConsumed(uint64_t count) {
+        for (uint64_t c = consumed.load(std::memory_order_acquire); c < count; c = consumed.load(std::memory_order_acquire)) consumed.wait(c, std::memory_order_acquire);
+    }
+    void run() {
+        for (uint64_t frame = 0;;) {
+            uint64_t p = published.load(std::memory_order_acquire);
+            while ((p & ~kStopBit) == frame) { if (p & kStopBit) return; published.wait(p, std::memory_order_acquire); p = published.load(std::memory_order_acquire); }
+            consume(slots[frame & 1]);
+            consumed.store(++frame, std::memory_order_release); consumed.notify_all();
+        }
+    }
+
+    Consumer consume;
+    Snapshot slots[2];
+    alignas(64) std::atomic<uint64_t> published{0};
+    alignas(64) std::atomic<uint64_t> consumed{0};
+    std::thread worker;
+};
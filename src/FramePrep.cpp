@@ -0,0 +1,30 @@
+#include "FramePrep.h"
+
+// The tree is split into a frontier of subtrees, a few per thread, each queried into its own bucket.
+void FramePrep::cullFrustum(const DynamicAabbTree& tree, const Float4x4& viewProj, JobSystem& jobs) {
+    const Frustum frustum = ExtractFrustum(viewProj);
+    tree.collectFrontier(size_t(jobs.workerCount() + 1) * 8, frontier); if (buckets.size() < frontier.size()) buckets.resize(frontier.size());
+    jobs.parallelFor(uint32_t(frontier.size()), 1, [&](uint32_t begin, uint32_t end) { PROFILE_ZONE("Frustum cull"); for (uint32_t k=begin; k<end; ++k) { buckets[k].clear(); tree.queryFrustum(frustum, buckets[k], frontier[k]); } });
+    visible.clear(); for (size_t k=0; k<frontier.size(); ++k) visible.insert(visible.end(), buckets[k].begin(), buckets[k].end());
+    { size_t largest = 0; for (const auto& b : buckets) largest = std::max(largest, b.size()); for (auto& b : buckets) b.reserve(largest); }   // the frontier shifts as objects move; no bucket regrows
+}
+
+void FramePrep::rasterizeOccluders(const DynamicAabbTree& tree, const Float4x4& viewProj, JobSystem& jobs) {
+    occlusion.rasterize(&jobs);
+    occluded.resize(visible.size());
+    jobs.parallelFor(uint32_t(visible.size()), 1024, [&](uint32_t begin, uint32_t end) { PROFILE_ZONE("Occlusion test"); for (uint32_t k=begin; k<end; ++k) occluded[k] = !occlusion.testAabb(tree.fatAabb(int32_t(visibleProxies[k])), viewProj); });
+    size_t kept = 0; for (size_t k=0; k<visible.size(); ++k) if (!occluded[k]) visible[kept++] = visible[k];
+    lastOccluded = visible.size() - kept; visible.resize(kept);
+}
+
+void ClusterCullPass::begin(size_t instanceCount) {
+    instances.clear();
+    if (slotRanges.size() < instanceCount) slotRanges.resize(instanceCount);
+    slotStats.resize(instanceCount);
+}
+
+void ClusterCullPass::cull(const Float4x4* worlds, const Float4x4& viewProj, const Float3& eye, bool cullBackfaces, JobSystem& jobs) {
+    jobs.parallelFor(uint32_t(instances.size()), 16, [&](uint32_t begin, uint32_t end) { PROFILE_ZONE("Cluster cull"); for (uint32_t k=begin; k<end; ++k) { const Instance& in = instances[k]; const Float4x4& world = worlds[in.slot];
+        CullMeshlets(in.meshlets->data(), in.meshlets->size(), ExtractFrustum(MultiplyTransform(world, viewProj)), InverseTransformPoint(world, eye), cullBackfaces, slotRanges[in.slot], &slotStats[in.slot]); } });
+    totals = {}; for (const Instance& in : instances) totals.add(slotStats[in.slot]);
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Bounds.h"
+#include "DrawBatcher.h"
+#include "DynamicAabbTree.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "LightClusters.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+#include "OcclusionBuffer.h"
+#include "Profiler.h"
+#include "TransformStore.h"
+
+// Transform user data is a meshTree proxy, or a lightTree proxy with this bit set.
+constexpr uint32_t kLightProxyFlag = 0x80000000u;
+
+// The light's sphere of influence; the range follows from the intensity, see LightRange().
+inline Aabb LightBounds(const Float4x4& world, float intensity) {
+    const float r = LightRange(intensity);
+    return { { world.m[3][0] - r, world.m[3][1] - r, world.m[3][2] - r }, { world.m[3][0] + r, world.m[3][1] + r, world.m[3][2] + r } };
+}
+
+// The camera a frame is prepared for. projX and projY are the projection's m[0][0] and m[1][1]; width and height are the
+// viewport in pixels.
+struct FrameView {
+    Float4x4 view{};
+    Float4x4 viewProj{};
+    Float3 eye{};
+    float projX{1.0f}, projY{1.0f};
+    float nearZ{0.1f}, farZ{100.0f};
+    uint32_t width{1}, height{1};
+    // Screen pixels per world unit at distance one.
+    float projScale() const { return projY * float(std::max(height, 1u)) * 0.5f; }
+};
+
+struct FramePrepSettings {
+    float lodThresholdPixels{1.0f};
+    bool occlusionCulling{true};
+    float occluderMinPixels{48.0f};
+    uint32_t occluderTriangleBudget{65536};
+    uint32_t occlusionWidth{320};
+    bool clusteredLighting{true};
+};
+
+// The main thread's share of a frame: dirty transforms and the bounds they move, frustum and occlusion culling, LOD
+// selection, draw sorting and light binning. Engine and the bench run the same code over their own scenes; a Scene has
+// transforms, meshTree, lightTree, meshes and lights like the engine's. A mesh has transform, localBounds, localSphere,
+// lods, lodCount, lod, geometryId, materialId and cullProxy plus pipeline(), drawable() and occluder(), which may be null; a light has
+// transform, intensity and color. Scratch lists only grow, so a steady scene prepares its frames without the heap.
+class FramePrep {
+public:
+    template <typename Scene> void prepareDrawList(Scene& scene, const FrameView& view, const FramePrepSettings& settings, JobSystem& jobs);
+    // Lights have their own tree, so only those whose range reaches the frustum are gathered and binned; the cluster lists
+    // index clusterLights(), which is what the pixel shader reads.
+    template <typename Scene> void binVisibleLights(const Scene& scene, const FrameView& view, const FramePrepSettings& settings, JobSystem& jobs);
+    // World matrices in draw-instance order, one per drawBatcher().instanceOrder() entry.
+    template <typename Scene> void copyInstanceWorlds(const Scene& scene, Float4x4* out, JobSystem& jobs) const;
+
+    const DrawBatcher& drawBatcher() const { return batcher; }
+    const std::vector<uint32_t>& visibleMeshes() const { return visible; }
+    const OcclusionBuffer& occlusionBuffer() const { return occlusion; }
+    const LightClusterGrid& lightGrid() const { return grid; }
+    const std::vector<ClusterLight>& clusterLights() const { return lights; }
+    size_t transformUpdates() const { return lastTransformUpdates; }
+    size_t occludedMeshes() const { return lastOccluded; }
+
+private:
+    void cullFrustum(const DynamicAabbTree& tree, const Float4x4& viewProj, JobSystem& jobs);
+    // Occluders are the visible meshes covering the most screen, rasterized with their full-detail triangles up to a budget;
+    // every visible mesh is then tested by its fat bounds, so an occluder always passes its own test.
+    template <typename Scene> void cullOccludedMeshes(const Scene& scene, const FrameView& view, const FramePrepSettings& settings, JobSystem& jobs);
+    void rasterizeOccluders(const DynamicAabbTree& tree, const Float4x4& viewProj, JobSystem& jobs);
+
+    DrawBatcher batcher;
+    std::vector<uint32_t> visible;
+    std::vector<uint32_t> visibleProxies;
+    std::vector<Aabb> updatedBounds;
+    std::vector<int32_t> frontier;
+    std::vector<std::vector<uint32_t>> buckets;
+    OcclusionBuffer occlusion;
+    std::vector<std::pair<float, uint32_t>> occluderCandidates;
+    std::vector<uint8_t> occluded;
+    LightClusterGrid grid;
+    std::vector<uint32_t> visibleLights;
+    std::vector<ClusterLight> lights;
+    size_t lastTransformUpdates{0};
+    size_t lastOccluded{0};
+};
+
+// The render thread's share: instances drawn with clusters are culled per meshlet in object space, each into its own list
+// of surviving index ranges.
+class ClusterCullPass {
+public:
+    // Forgets last frame's instances; slots index the frame's instance worlds.
+    void begin(size_t instanceCount);
+    void add(uint32_t slot, const std::vector<Meshlet>& meshlets) { instances.push_back({ slot, &meshlets }); }
+    void cull(const Float4x4* worlds, const Float4x4& viewProj, const Float3& eye, bool cullBackfaces, JobSystem& jobs);
+
+    const std::vector<MeshletRange>& ranges(uint32_t slot) const { return slotRanges[slot]; }
+    size_t instanceCount() const { return instances.size(); }
+    const ClusterCullStats& stats() const { return totals; }
+
+private:
+    struct Instance { uint32_t slot; const std::vector<Meshlet>* meshlets; };
+    std::vector<Instance> instances;
+    std::vector<std::vector<MeshletRange>> slotRanges;
+    std::vector<ClusterCullStats> slotStats;
+    ClusterCullStats totals{};
+};
+
+template <typename Scene>
+void FramePrep::prepareDrawList(Scene& scene, const FrameView& view, const FramePrepSettings& settings, JobSystem& jobs) {
+    PROFILE_ZONE("Prepare draw list");
+    lastTransformUpdates = scene.transforms.updateWorldMatrices(&jobs);
+    const auto& updated = scene.transforms.lastUpdatedSlots(); updatedBounds.resize(updated.size());
+    jobs.parallelFor(uint32_t(updated.size()), 2048, [&](uint32_t begin, uint32_t end) { PROFILE_ZONE("Update bounds"); for (uint32_t k=begin; k<end; ++k) { const uint32_t proxy = scene.transforms.userDataAt(updated[k]); if (proxy == ~0u) continue;
+        if (proxy & kLightProxyFlag) updatedBounds[k] = LightBounds(scene.transforms.worldAt(updated[k]), scene.lights[scene.lightTree.userData(int32_t(proxy & ~kLightProxyFlag))].intensity); else updatedBounds[k] = TransformAabb(scene.meshes[scene.meshTree.userData(int32_t(proxy))].localBounds, scene.transforms.worldAt(updated[k])); } });
+    for (size_t k=0; k<updated.size(); ++k) { const uint32_t proxy = scene.transforms.userDataAt(updated[k]); if (proxy == ~0u) continue; if (proxy & kLightProxyFlag) scene.lightTree.moveProxy(int32_t(proxy & ~kLightProxyFlag), updatedBounds[k]); else scene.meshTree.moveProxy(int32_t(proxy), updatedBounds[k]); }
+
+    cullFrustum(scene.meshTree, view.viewProj, jobs);
+    std::erase_if(visible, [&](uint32_t i) { return !scene.meshes[i].drawable(); });
+    if (settings.occlusionCulling) cullOccludedMeshes(scene, view, settings, jobs); else lastOccluded = 0;
+
+    batcher.resize(visible.size());
+    // LOD is picked from the projected simplification error; it sits in the low bits of the geometry key so each level batches separately.
+    const Float3 eye = view.eye; const float projScale = view.projScale();
+    jobs.parallelFor(uint32_t(visible.size()), 4096, [&](uint32_t begin, uint32_t end) { PROFILE_ZONE("Select LOD"); for (uint32_t k=begin; k<end; ++k) { auto& obj = scene.meshes[visible[k]];
+        if (obj.lodCount > 1) { const Sphere s = TransformSphere(obj.localSphere, scene.transforms.world(obj.transform)); const float dx = s.center.x - eye.x, dy = s.center.y - eye.y, dz = s.center.z - eye.z; const float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - s.radius, 0.1f); const float worldScale = obj.localSphere.radius > 0.0f ? s.radius / obj.localSphere.radius : 1.0f; obj.lod = SelectLod(obj.lods.data(), obj.lodCount, projScale * worldScale / distance, settings.lodThresholdPixels, obj.lod); }
+        batcher.set(k, MakeDrawSortKey(obj.pipeline(), obj.materialId, (uint64_t(obj.geometryId) << 3) | obj.lod), visible[k]); } });
+    { PROFILE_ZONE("Sort draws"); batcher.build(); }
+}
+
+template <typename Scene>
+void FramePrep::cullOccludedMeshes(const Scene& scene, const FrameView& view, const FramePrepSettings& settings, JobSystem& jobs) {
+    PROFILE_ZONE("Occlusion cull");
+    occlusion.resize(settings.occlusionWidth, std::max(1u, settings.occlusionWidth * view.height / std::max(view.width, 1u))); occlusion.clear();
+    const Float3 eye = view.eye; const float projScale = view.projScale();
+    occluderCandidates.clear();
+    for (uint32_t i : visible) { const auto& m = scene.meshes[i]; if (!m.occluder()) continue; const Sphere s = TransformSphere(m.localSphere, scene.transforms.world(m.transform)); const float dx = s.center.x - eye.x, dy = s.center.y - eye.y, dz = s.center.z - eye.z; const float pixels = projScale * s.radius / std::max(std::sqrt(dx * dx + dy * dy + dz * dz), 0.1f); if (pixels >= settings.occluderMinPixels) occluderCandidates.push_back({ pixels, i }); }
+    std::sort(occluderCandidates.begin(), occluderCandidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    { PROFILE_ZONE("Set up occluders"); uint32_t triangles = 0; for (const auto& [pixels, i] : occluderCandidates) { const auto& m = scene.meshes[i]; const OccluderMesh& o = *m.occluder(); const uint32_t count = o.indexCount / 3; if (triangles + count > settings.occluderTriangleBudget) continue; triangles += count; occlusion.addOccluder(o.positions, o.vertexCount, o.indices, o.indexCount, MultiplyTransform(scene.transforms.world(m.transform), view.viewProj)); } }
+    visibleProxies.resize(visible.size());
+    for (size_t k=0; k<visible.size(); ++k) visibleProxies[k] = uint32_t(scene.meshes[visible[k]].cullProxy);
+    rasterizeOccluders(scene.meshTree, view.viewProj, jobs);
+}
+
+template <typename Scene>
+void FramePrep::binVisibleLights(const Scene& scene, const FrameView& view, const FramePrepSettings& settings, JobSystem& jobs) {
+    PROFILE_ZONE("Light clusters");
+    visibleLights.clear(); if (settings.clusteredLighting) scene.lightTree.queryFrustum(ExtractFrustum(view.viewProj), visibleLights);
+    lights.resize(visibleLights.size());
+    jobs.parallelFor(uint32_t(visibleLights.size()), 4096, [&](uint32_t begin, uint32_t end) { for (uint32_t k=begin; k<end; ++k) { const auto& l = scene.lights[visibleLights[k]]; const Float4x4& w = scene.transforms.world(l.transform);
+        lights[k] = { { w.m[3][0], w.m[3][1], w.m[3][2] }, LightRange(l.intensity), { l.color.x * l.intensity, l.color.y * l.intensity, l.color.z * l.intensity }, 0.0f }; } });
+    grid.setView(view.view, view.projX, view.projY, view.nearZ, view.farZ); grid.build(lights.data(), lights.size(), &jobs);
+}
+
+template <typename Scene>
+void FramePrep::copyInstanceWorlds(const Scene& scene, Float4x4* out, JobSystem& jobs) const {
+    const auto& order = batcher.instanceOrder();
+    jobs.parallelFor(uint32_t(order.size()), 2048, [&](uint32_t begin, uint32_t end) { for (uint32_t k=begin; k<end; ++k) out[k] = scene.transforms.world(scene.meshes[order[k]].transform); });
+}
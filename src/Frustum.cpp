@@ -0,0 +1,78 @@
+#include "Frustum.h"
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define GGINE_FRUSTUM_SSE 1
+#endif
+
+Frustum ExtractFrustum(const Float4x4& vp) {
+    auto col = [&vp](int j) { return Float4{ vp.m[0][j], vp.m[1][j], vp.m[2][j], vp.m[3][j] }; };
+    const Float4 c0 = col(0), c1 = col(1), c2 = col(2), c3 = col(3);
+    const Float4 raw[6] = {
+        { c3.x + c0.x, c3.y + c0.y, c3.z + c0.z, c3.w + c0.w }, { c3.x - c0.x, c3.y - c0.y, c3.z - c0.z, c3.w - c0.w },
+        { c3.x + c1.x, c3.y + c1.y, c3.z + c1.z, c3.w + c1.w }, { c3.x - c1.x, c3.y - c1.y, c3.z - c1.z, c3.w - c1.w },
+        c2, { c3.x - c2.x, c3.y - c2.y, c3.z - c2.z, c3.w - c2.w },
+    };
+    Frustum f{};
+    for (int i = 0; i < 8; ++i) {
+        Float4 p{ 0, 0, 0, 1 };
+        if (i < 6) { const float len = std::sqrt(raw[i].x * raw[i].x + raw[i].y * raw[i].y + raw[i].z * raw[i].z); p = len > 0.0f ? Float4{ raw[i].x / len, raw[i].y / len, raw[i].z / len, raw[i].w / len } : raw[i]; f.planes[i] = p; }
+        f.nx[i] = p.x; f.ny[i] = p.y; f.nz[i] = p.z; f.d[i] = p.w;
+    }
+    return f;
+}
+
+CullResult TestAabb(const Frustum& f, const Aabb& box) {
+    const float cx = (box.min.x + box.max.x) * 0.5f, cy = (box.min.y + box.max.y) * 0.5f, cz = (box.min.z + box.max.z) * 0.5f;
+    const float ex = (box.max.x - box.min.x) * 0.5f, ey = (box.max.y - box.min.y) * 0.5f, ez = (box.max.z - box.min.z) * 0.5f;
+#if defined(GGINE_FRUSTUM_SSE)
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy), vcz = _mm_set1_ps(cz), vex = _mm_set1_ps(ex), vey = _mm_set1_ps(ey), vez = _mm_set1_ps(ez);
+    int outside = 0, straddle = 0;
+    for (int g = 0; g < 8; g += 4) {
+        const __m128 nx = _mm_load_ps(f.nx + g), ny = _mm_load_ps(f.ny + g), nz = _mm_load_ps(f.nz + g), d = _mm_load_ps(f.d + g);
+        const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, vcx), _mm_mul_ps(ny, vcy)), _mm_add_ps(_mm_mul_ps(nz, vcz), d));
+        const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), vex), _mm_mul_ps(_mm_andnot_ps(signMask, ny), vey)), _mm_mul_ps(_mm_andnot_ps(signMask, nz), vez));
+        outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+        straddle |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dist, radius), _mm_setzero_ps()));
+    }
+    if (outside) return CullResult::Outside;
+    return straddle ? CullResult::Intersect : CullResult::Inside;
+#else
+    bool straddle = false;
+    for (int i = 0; i < 6; ++i) {
+        const float dist = f.nx[i] * cx + f.ny[i] * cy + f.nz[i] * cz + f.d[i];
+        const float radius = std::fabs(f.nx[i]) * ex + std::fabs(f.ny[i]) * ey + std::fabs(f.nz[i]) * ez;
+        if (dist + radius < 0.0f) return CullResult::Outside;
+        straddle |= dist - radius < 0.0f;
+    }
+    return straddle ? CullResult::Intersect : CullResult::Inside;
+#endif
+}
+
+size_t CullAabbsSoA(const Frustum& f, const float* cx, const float* cy, const float* cz, const float* ex, const float* ey, const float* ez, size_t count, uint32_t* outVisible) {
+    size_t visible = 0, i = 0;
+#if defined(GGINE_FRUSTUM_SSE)
+    for (; i + 4 <= count; i += 4) {
+        const __m128 vcx = _mm_loadu_ps(cx + i), vcy = _mm_loadu_ps(cy + i), vcz = _mm_loadu_ps(cz + i);
+        const __m128 vex = _mm_loadu_ps(ex + i), vey = _mm_loadu_ps(ey + i), vez = _mm_loadu_ps(ez + i);
+        __m128 out = _mm_setzero_ps();
+        for (int p = 0; p < 6; ++p) {
+            const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(f.nx[p]), vcx), _mm_mul_ps(_mm_set1_ps(f.ny[p]), vcy)), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(f.nz[p]), vcz), _mm_set1_ps(f.d[p])));
+            const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(f.nx[p])), vex), _mm_mul_ps(_mm_set1_ps(std::fabs(f.ny[p])), vey)), _mm_mul_ps(_mm_set1_ps(std::fabs(f.nz[p])), vez));
+            out = _mm_or_ps(out, _mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+        }
+        const int mask = ~_mm_movemask_ps(out) & 0xF;
+        for (int k = 0; k < 4; ++k) if (mask & (1 << k)) outVisible[visible++] = uint32_t(i + size_t(k));
+    }
+#endif
+    for (; i < count; ++i) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p) {
+            const float dist = f.nx[p] * cx[i] + f.ny[p] * cy[i] + f.nz[p] * cz[i] + f.d[p];
+            inside = dist + std::fabs(f.nx[p]) * ex[i] + std::fabs(f.ny[p]) * ey[i] + std::fabs(f.nz[p]) * ez[i] >= 0.0f;
+        }
+        if (inside) outVisible[visible++] = uint32_t(i);
+    }
+    return visible;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "MathTypes.h"
+
+enum class CullResult { Outside, Intersect, Inside };
+
+struct Frustum {
+    Float4 planes[6];
+    alignas(16) float nx[8];
+    alignas(16) float ny[8];
+    alignas(16) float nz[8];
+    alignas(16) float d[8];
+};
+
+Frustum ExtractFrustum(const Float4x4& viewProj);
+CullResult TestAabb(const Frustum& f, const Aabb& box);
+size_t CullAabbsSoA(const Frustum& f, const float* cx, const float* cy, const float* cz, const float* ex, const float* ey, const float* ez, size_t count, uint32_t* outVisible);
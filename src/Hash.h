@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+inline uint64_t HashMix64(uint64_t h) {
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdull; h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull; h ^= h >> 33;
+    return h;
+}
+
+inline uint64_t HashMemory(const void* data, size_t size, uint64_t seed = 0x9e3779b97f4a7c15ull) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t h = seed ^ (uint64_t(size) * 0x87c37b91114253d5ull);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) { uint64_t k; memcpy(&k, p + i, 8); h = (h ^ HashMix64(k)) * 0x4cf5ad432745937full; }
+    uint64_t tail = 0; if (i < size) memcpy(&tail, p + i, size - i);
+    return HashMix64(h ^ tail);
+}
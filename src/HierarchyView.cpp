@@ -0,0 +1,93 @@
+#include "HierarchyView.h"
+#include "Hash.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+char LowerAscii(char c) { return char(tolower(static_cast<unsigned char>(c))); }
+}
+
+void HierarchyView::add(TransformHandle node, std::string_view name, int32_t object) {
+    if (nodes.size() <= node.index) nodes.resize(node.index + 1);
+    Node& n = nodes[node.index];
+    if (!n.alive) ++liveCount;
+    if (!n.alive || n.generation != node.generation) order.push_back(node);
+    n = { node.generation, intern(name), object, true, true };
+    dirty = true;
+}
+
+void HierarchyView::remove(TransformHandle node) {
+    if (!contains(node)) return;
+    nodes[node.index].alive = false; --liveCount;
+    dirty = true;
+}
+
+void HierarchyView::rename(TransformHandle node, std::string_view name) {
+    if (!contains(node)) return;
+    const uint32_t id = intern(name);
+    if (nodes[node.index].name == id) return;
+    // Renames only move rows when they change what the filter shows.
+    if (matches(nodes[node.index].name) != matches(id)) dirty = true;
+    nodes[node.index].name = id;
+}
+
+void HierarchyView::setExpanded(TransformHandle node, bool open) {
+    if (!contains(node) || nodes[node.index].expanded == open) return;
+    nodes[node.index].expanded = open;
+    if (filterText.empty()) dirty = true;
+}
+
+uint32_t HierarchyView::intern(std::string_view text) {
+    const uint64_t hash = HashMemory(text.data(), text.size());
+    if (const auto it = nameLookup.find(hash); it != nameLookup.end() && nameText(it->second) == text) return it->second;
+    const Name n{ uint32_t(arena.size()), uint32_t(text.size()), uint32_t(arena.size() + text.size()) };
+    arena.append(text); for (char c : text) arena.push_back(LowerAscii(c));
+    const uint32_t id = uint32_t(names.size());
+    names.push_back(n); nameLookup.try_emplace(hash, id);
+    nameMatches.push_back(std::string_view(arena.data() + n.lowerOffset, n.length).find(filterText) != std::string_view::npos);
+    return id;
+}
+
+void HierarchyView::setFilter(std::string_view text) {
+    std::string lower(text); for (char& c : lower) c = LowerAscii(c);
+    if (lower == filterText) return;
+    filterText = std::move(lower);
+    for (size_t i = 0; i < names.size(); ++i) nameMatches[i] = std::string_view(arena.data() + names[i].lowerOffset, names[i].length).find(filterText) != std::string_view::npos;
+    dirty = true;
+}
+
+const std::vector<HierarchyRow>& HierarchyView::rows(const TransformStore& transforms) {
+    if (dirty) rebuild(transforms);
+    return rowList;
+}
+
+void HierarchyView::rebuild(const TransformStore& transforms) {
+    PROFILE_ZONE("Rebuild hierarchy rows");
+    std::erase_if(order, [&](TransformHandle h) { return !contains(h) || !transforms.isAlive(h); });
+    rowList.clear(); dirty = false; ++rebuilds;
+    const bool filtered = !filterText.empty();
+    if (filtered) {
+        // Each match keeps its ancestors; the walk up stops at the first node another match already kept.
+        keep.assign(nodes.size(), 0);
+        for (TransformHandle h : order) {
+            if (!matches(nodes[h.index].name)) continue;
+            for (TransformHandle a = h; !(a == TransformHandle{}) && contains(a) && !keep[a.index]; a = transforms.parent(a)) keep[a.index] = 1;
+        }
+    }
+    auto listed = [&](TransformHandle h) { return contains(h) && (!filtered || keep[h.index]); };
+    // Roots in the order they were added, each followed by its expanded subtree; the explicit stack keeps deep chains off the call stack.
+    for (TransformHandle root : order) {
+        if (!(transforms.parent(root) == TransformHandle{}) || !listed(root)) continue;
+        stack.push_back({ root, 0, false });
+        while (!stack.empty()) {
+            const HierarchyRow row = stack.back(); stack.pop_back();
+            const TransformHandle child = transforms.firstChild(row.node);
+            rowList.push_back({ row.node, row.depth, !(child == TransformHandle{}) });
+            if (child == TransformHandle{} || !(filtered || nodes[row.node.index].expanded)) continue;
+            const size_t first = stack.size();
+            for (TransformHandle c = child; !(c == TransformHandle{}); c = transforms.nextSibling(c)) if (listed(c)) stack.push_back({ c, row.depth + 1, false });
+            std::reverse(stack.begin() + ptrdiff_t(first), stack.end());
+        }
+    }
+}
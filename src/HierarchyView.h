@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "TransformStore.h"
+
+struct HierarchyRow {
+    TransformHandle node;
+    uint32_t depth;
+    bool hasChildren;
+};
+
+// Editor-side view of the transform forest for the Hierarchy panel. Names are converted to UTF-8 once, on add or
+// rename, and interned; the flattened row list (pre-order, collapsed subtrees skipped) is only rebuilt after the
+// structure, expansion or filter changes, so a frame that changes nothing costs nothing beyond the visible rows.
+// The filter is evaluated once per distinct name rather than per object.
+class HierarchyView {
+public:
+    // object is the caller's id for the node (Engine stores mesh i as i and light i as ~i).
+    void add(TransformHandle node, std::string_view name, int32_t object);
+    void remove(TransformHandle node);
+    void rename(TransformHandle node, std::string_view name);
+    void setObject(TransformHandle node, int32_t object) { nodes[node.index].object = object; }
+    // Call after reparenting; add and remove invalidate on their own.
+    void invalidate() { dirty = true; }
+
+    bool contains(TransformHandle node) const { return node.index < nodes.size() && nodes[node.index].alive && nodes[node.index].generation == node.generation; }
+    std::string_view name(TransformHandle node) const { return nameText(nodes[node.index].name); }
+    int32_t object(TransformHandle node) const { return nodes[node.index].object; }
+    bool expanded(TransformHandle node) const { return nodes[node.index].expanded; }
+    void setExpanded(TransformHandle node, bool open);
+
+    // Case-insensitive (ASCII) substring match; while a filter is set the matches are listed in place under their
+    // ancestors, with every kept node open regardless of its expanded state.
+    void setFilter(std::string_view text);
+    const std::string& filter() const { return filterText; }
+    const std::vector<HierarchyRow>& rows(const TransformStore& transforms);
+
+    size_t nodeCount() const { return liveCount; }
+    size_t distinctNames() const { return names.size(); }
+    uint64_t rebuildCount() const { return rebuilds; }
+
+private:
+    static constexpr uint32_t kNone = ~0u;
+    struct Node { uint32_t generation{0}; uint32_t name{kNone}; int32_t object{0}; bool alive{false}; bool expanded{true}; };
+    struct Name { uint32_t offset; uint32_t length; uint32_t lowerOffset; };
+
+    uint32_t intern(std::string_view text);
+    std::string_view nameText(uint32_t id) const { return id == kNone ? std::string_view() : std::string_view(arena.data() + names[id].offset, names[id].length); }
+    bool matches(uint32_t id) const { return filterText.empty() || (id != kNone && nameMatches[id]); }
+    void rebuild(const TransformStore& transforms);
+
+    std::vector<Node> nodes;
+    std::vector<TransformHandle> order;
+    size_t liveCount{0};
+    // Interned names live in one arena (original bytes, then a lowercased copy) for the lifetime of the view.
+    std::string arena;
+    std::vector<Name> names;
+    std::unordered_map<uint64_t, uint32_t> nameLookup;
+    std::string filterText;
+    std::vector<uint8_t> nameMatches;
+    std::vector<uint8_t> keep;
+    std::vector<HierarchyRow> rowList;
+    std::vector<HierarchyRow> stack;
+    bool dirty{true};
+    uint64_t rebuilds{0};
+};
@@ -0,0 +1,172 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <string>
+
+namespace {
+thread_local const JobSystem* tlsOwner = nullptr;
+thread_local unsigned tlsQueue = 0;
+}
+
+JobSystem::JobSystem(unsigned workerCount) : mainThread(std::this_thread::get_id()), statsStart(std::chrono::steady_clock::now()) {
+    if (workerCount == ~0u) { const unsigned hw = std::thread::hardware_concurrency(); workerCount = hw > 1 ? hw - 1 : 0; }
+    for (unsigned i = 0; i <= workerCount; ++i) queues.push_back(std::make_unique<Queue>());
+    workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i) workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+JobSystem::~JobSystem() {
+    { std::lock_guard<std::mutex> lock(sleepMutex); stopping = true; }
+    sleepCv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void JobSystem::JobRing::grow() {
+    std::vector<Job> larger(std::max<size_t>(64, slots.size() * 2));
+    for (uint64_t i = head; i < tail; ++i) larger[size_t(i - head)] = std::move(slots[i & (slots.size() - 1)]);
+    tail -= head; head = 0; slots.swap(larger);
+}
+
+unsigned JobSystem::currentQueue() const { return tlsOwner == this ? tlsQueue : unsigned(workers.size()); }
+
+void JobSystem::run(std::function<void()> fn, JobCounter* counter, JobAffinity affinity) {
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+    schedule({ std::move(fn), counter }, affinity);
+}
+
+void JobSystem::runAfter(JobCounter& dependency, std::function<void()> fn, JobCounter* counter, JobAffinity affinity) {
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(dependency.mutex);
+        if (dependency.pending.load(std::memory_order_acquire) > 0) { dependency.continuations.push_back({ std::move(fn), counter, affinity }); return; }
+    }
+    schedule({ std::move(fn), counter }, affinity);
+}
+
+void JobSystem::schedule(Job&& job, JobAffinity affinity) {
+    if (affinity == JobAffinity::MainThread) { std::lock_guard<std::mutex> lock(mainMutex); mainJobs.push_back(std::move(job)); return; }
+    if (affinity == JobAffinity::Background) { std::lock_guard<std::mutex> lock(backgroundMutex); backgroundJobs.push_back(std::move(job)); }
+    else { Queue& q = *queues[currentQueue()]; std::lock_guard<std::mutex> lock(q.mutex); q.jobs.push_back(std::move(job)); }
+    queued.fetch_add(1, std::memory_order_release);
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    sleepCv.notify_one();
+}
+
+void JobSystem::execute(Job& job, Queue& stats, bool stolen) {
+    const auto start = std::chrono::steady_clock::now();
+    { PROFILE_ZONE("Job"); job.fn(); }
+    stats.busyNanoseconds.fetch_add(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+    stats.executed.fetch_add(1, std::memory_order_relaxed);
+    if (stolen) stats.stolen.fetch_add(1, std::memory_order_relaxed);
+    finish(job.counter);
+}
+
+void JobSystem::finish(JobCounter* counter) {
+    if (!counter) return;
+    std::vector<JobCounter::Continuation> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) ready.swap(counter->continuations);
+    }
+    for (auto& c : ready) schedule({ std::move(c.fn), c.signal }, c.affinity);
+}
+
+bool JobSystem::tryRunOne(unsigned self) {
+    Job job; bool found = false, stolen = false;
+    {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) { job = own.jobs.pop_back(); found = true; }
+    }
+    for (size_t k = 1; !found && k < queues.size(); ++k) {
+        Queue& victim = *queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) { job = victim.jobs.pop_front(); found = stolen = true; }
+    }
+    if (!found) return false;
+    queued.fetch_sub(1, std::memory_order_acq_rel);
+    execute(job, *queues[self], stolen);
+    return true;
+}
+
+bool JobSystem::runOneMainJob() {
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(mainMutex);
+        if (mainJobs.empty()) return false;
+        job = mainJobs.pop_front();
+    }
+    execute(job, *queues[workers.size()], false);
+    return true;
+}
+
+bool JobSystem::runOneBackgroundJob(unsigned self) {
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        if (backgroundJobs.empty()) return false;
+        job = backgroundJobs.pop_front();
+    }
+    queued.fetch_sub(1, std::memory_order_acq_rel);
+    execute(job, *queues[self], false);
+    return true;
+}
+
+void JobSystem::runMainThreadJobs() { if (isMainThread()) while (runOneMainJob()) {} }
+
+void JobSystem::wait(JobCounter& counter) {
+    const unsigned self = currentQueue();
+    const bool onMain = isMainThread();
+    while (counter.pending.load(std::memory_order_acquire) > 0) {
+        if (onMain && runOneMainJob()) continue;
+        if (!tryRunOne(self)) std::this_thread::yield();
+    }
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::waitBackground(JobCounter& counter) {
+    const unsigned self = currentQueue();
+    while (counter.pending.load(std::memory_order_acquire) > 0) if (!runOneBackgroundJob(self)) std::this_thread::yield();
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t grainSize, RangeFunction fn, JobAffinity affinity) {
+    if (count == 0) return;
+    grainSize = std::max(1u, grainSize);
+    if (workers.empty() || count <= grainSize) { fn(0, count); return; }
+    const bool background = affinity == JobAffinity::Background;
+    JobCounter counter;
+    for (uint32_t begin = grainSize; begin < count; begin += grainSize) {
+        const uint32_t end = std::min(count, begin + grainSize);
+        run([&fn, begin, end] { fn(begin, end); }, &counter, background ? JobAffinity::Background : JobAffinity::Any);
+    }
+    fn(0, grainSize);
+    if (background) waitBackground(counter); else wait(counter);
+}
+
+void JobSystem::workerLoop(unsigned index) {
+    tlsOwner = this; tlsQueue = index;
+    PROFILE_THREAD("Worker " + std::to_string(index));
+    while (!stopping.load(std::memory_order_acquire)) {
+        if (tryRunOne(index) || runOneBackgroundJob(index)) continue;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCv.wait(lock, [this] { return stopping.load(std::memory_order_acquire) || queued.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+std::pmr::vector<JobWorkerStats> JobSystem::stats(std::pmr::memory_resource* memory) const {
+    const double elapsed = double(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - statsStart).count());
+    std::pmr::vector<JobWorkerStats> out(queues.size(), memory);
+    for (size_t i = 0; i < queues.size(); ++i) {
+        out[i].busyNanoseconds = queues[i]->busyNanoseconds.load(std::memory_order_relaxed);
+        out[i].jobsExecuted = queues[i]->executed.load(std::memory_order_relaxed);
+        out[i].jobsStolen = queues[i]->stolen.load(std::memory_order_relaxed);
+        out[i].utilization = elapsed > 0.0 ? double(out[i].busyNanoseconds) / elapsed : 0.0;
+    }
+    return out;
+}
+
+void JobSystem::resetStats() {
+    for (auto& q : queues) { q->busyNanoseconds = 0; q->executed = 0; q->stolen = 0; }
+    statsStart = std::chrono::steady_clock::now();
+}
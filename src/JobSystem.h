@@ -0,0 +1,118 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class JobAffinity { Any, MainThread, Background };
+
+class JobCounter {
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+    uint32_t value() const { return pending.load(std::memory_order_acquire); }
+
+private:
+    friend class JobSystem;
+    struct Continuation { std::function<void()> fn; JobCounter* signal; JobAffinity affinity; };
+    std::atomic<uint32_t> pending{0};
+    std::mutex mutex;
+    std::vector<Continuation> continuations;
+};
+
+struct JobWorkerStats {
+    uint64_t busyNanoseconds{0};
+    uint64_t jobsExecuted{0};
+    uint64_t jobsStolen{0};
+    double utilization{0.0};
+};
+
+// Non-owning view of a callable taking (begin, end), for parallelFor: the callable outlives the call, so nothing is
+// copied and capturing lambdas of any size never reach the heap the way a std::function would.
+class RangeFunction {
+public:
+    template <typename Fn>
+    RangeFunction(const Fn& fn) : object(&fn), invoke([](const void* o, uint32_t begin, uint32_t end) { (*static_cast<const Fn*>(o))(begin, end); }) {}
+    void operator()(uint32_t begin, uint32_t end) const { invoke(object, begin, end); }
+
+private:
+    const void* object;
+    void (*invoke)(const void*, uint32_t, uint32_t);
+};
+
+class JobSystem {
+public:
+    explicit JobSystem(unsigned workerCount = ~0u);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void run(std::function<void()> fn, JobCounter* counter = nullptr, JobAffinity affinity = JobAffinity::Any);
+    void runAfter(JobCounter& dependency, std::function<void()> fn, JobCounter* counter = nullptr, JobAffinity affinity = JobAffinity::Any);
+    void wait(JobCounter& counter);
+    // Background ranges go to the background queue, which threads waiting on frame work never take from; the caller
+    // waits by running background jobs only, so long loads split this way stay off the frame path.
+    void parallelFor(uint32_t count, uint32_t grainSize, RangeFunction fn, JobAffinity affinity = JobAffinity::Any);
+    void runMainThreadJobs();
+
+    bool isMainThread() const { return std::this_thread::get_id() == mainThread; }
+    unsigned workerCount() const { return unsigned(workers.size()); }
+    // One entry per worker, then the main thread; pass a scratch arena when polling every frame.
+    std::pmr::vector<JobWorkerStats> stats(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const;
+    void resetStats();
+
+private:
+    struct Job { std::function<void()> fn; JobCounter* counter{nullptr}; };
+    // Power-of-two ring used as a deque: owners pop the back, thieves and FIFO queues the front. It only ever grows, so a
+    // steady job load never touches the heap (std::deque frees and reallocates its blocks as the ends move).
+    class JobRing {
+    public:
+        bool empty() const { return head == tail; }
+        void push_back(Job&& job) { if (tail - head == slots.size()) grow(); slots[tail++ & (slots.size() - 1)] = std::move(job); }
+        Job pop_back() { return take(slots[--tail & (slots.size() - 1)]); }
+        Job pop_front() { return take(slots[head++ & (slots.size() - 1)]); }
+
+    private:
+        static Job take(Job& slot) { Job job = std::move(slot); slot.fn = nullptr; return job; }
+        void grow();
+        std::vector<Job> slots;
+        uint64_t head{0}, tail{0};
+    };
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        JobRing jobs;
+        std::atomic<uint64_t> busyNanoseconds{0};
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+    };
+
+    void workerLoop(unsigned index);
+    void schedule(Job&& job, JobAffinity affinity);
+    bool tryRunOne(unsigned self);
+    bool runOneMainJob();
+    bool runOneBackgroundJob(unsigned self);
+    void waitBackground(JobCounter& counter);
+    void execute(Job& job, Queue& stats, bool stolen);
+    void finish(JobCounter* counter);
+    unsigned currentQueue() const;
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::mutex mainMutex;
+    JobRing mainJobs;
+    std::mutex backgroundMutex;
+    JobRing backgroundJobs;
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+    std::atomic<uint32_t> queued{0};
+    std::atomic<bool> stopping{false};
+    std::thread::id mainThread;
+    std::chrono::steady_clock::time_point statsStart;
+};
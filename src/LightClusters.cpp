@@ -0,0 +1,164 @@
+#include "LightClusters.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define GGINE_LIGHTS_SSE 1
+#endif
+
+namespace {
+constexpr uint32_t kTilesPerSlice = kLightClustersX * kLightClustersY;
+// Slabs are widened by this fraction of their depth so a pixel the shader's log puts in the next slice still finds the light.
+constexpr float kSliceMargin = 1e-3f;
+
+inline int TileOf(float ndc, uint32_t tiles) { return std::clamp(int(std::floor((ndc + 1.0f) * 0.5f * float(tiles))), 0, int(tiles) - 1); }
+}
+
+void LightClusterGrid::setView(const Float4x4& view, float projX, float projY, float nearZ, float farZ) {
+    viewMatrix = view; scaleX = projX; scaleY = projY; nearPlane = nearZ; farPlane = farZ;
+    const float logRange = std::log(farZ / nearZ);
+    sliceScale = float(kLightClustersZ) / logRange; sliceBias = -float(kLightClustersZ) * std::log(nearZ) / logRange;
+    for (uint32_t z = 0; z <= kLightClustersZ; ++z) sliceDepth[z] = nearZ * std::pow(farZ / nearZ, float(z) / float(kLightClustersZ));
+    // A tile edge at NDC n is the plane x = n * z / projX, so over a slab the box takes the edge at whichever end reaches further.
+    for (uint32_t z = 0; z < kLightClustersZ; ++z) {
+        const float zn = sliceDepth[z], zf = sliceDepth[z + 1];
+        for (uint32_t x = 0; x < kLightClustersX; ++x) {
+            const float n0 = -1.0f + 2.0f * float(x) / float(kLightClustersX), n1 = -1.0f + 2.0f * float(x + 1) / float(kLightClustersX);
+            columnMin[z * kLightClustersX + x] = std::min(n0 * zn, n0 * zf) / projX; columnMax[z * kLightClustersX + x] = std::max(n1 * zn, n1 * zf) / projX;
+        }
+        for (uint32_t y = 0; y < kLightClustersY; ++y) {
+            const float n1 = 1.0f - 2.0f * float(y) / float(kLightClustersY), n0 = 1.0f - 2.0f * float(y + 1) / float(kLightClustersY);
+            rowMin[z * kLightClustersY + y] = std::min(n0 * zn, n0 * zf) / projY; rowMax[z * kLightClustersY + y] = std::max(n1 * zn, n1 * zf) / projY;
+        }
+    }
+}
+
+uint32_t LightClusterGrid::sliceOf(float viewZ) const {
+    if (!(viewZ > nearPlane)) return 0;
+    return uint32_t(std::clamp(int(std::floor(std::log(viewZ) * sliceScale + sliceBias)), 0, int(kLightClustersZ) - 1));
+}
+
+LightGridParams LightClusterGrid::shaderParams(uint32_t width, uint32_t height, uint32_t lightCount) const {
+    return { float(kLightClustersX) / float(std::max(width, 1u)), float(kLightClustersY) / float(std::max(height, 1u)), sliceScale, sliceBias, kLightClustersX, kLightClustersY, kLightClustersZ, lightCount };
+}
+
+Aabb LightClusterGrid::clusterBounds(uint32_t x, uint32_t y, uint32_t z) const {
+    return { { columnMin[z * kLightClustersX + x], rowMin[z * kLightClustersY + y], sliceDepth[z] }, { columnMax[z * kLightClustersX + x], rowMax[z * kLightClustersY + y], sliceDepth[z + 1] } };
+}
+
+void LightClusterGrid::build(const ClusterLight* lights, size_t count, JobSystem* jobs) {
+    PROFILE_ZONE("Bin lights");
+    slices.resize(kLightClustersZ); for (Slice& s : slices) s.lights.clear();
+    viewLights.clear(); buildStats = {}; buildStats.lights = uint32_t(count);
+    const Float4x4& v = viewMatrix;
+    // Side planes through the eye, e.g. projX * x + z >= 0 on the left, normalized so the test compares against the radius.
+    const float sideX = 1.0f / std::sqrt(scaleX * scaleX + 1.0f), sideY = 1.0f / std::sqrt(scaleY * scaleY + 1.0f);
+    auto accept = [&](float x, float y, float z, float r, uint32_t light) {
+        const uint32_t first = sliceOf((z - r) * (1.0f - kSliceMargin)), last = sliceOf((z + r) * (1.0f + kSliceMargin));
+        const uint32_t index = uint32_t(viewLights.size()); viewLights.push_back({ x, y, z, r, light });
+        for (uint32_t s = first; s <= last; ++s) slices[s].lights.push_back(index);
+    };
+    size_t i = 0;
+#if GGINE_LIGHTS_SSE
+    {
+        const __m128 m00 = _mm_set1_ps(v.m[0][0]), m01 = _mm_set1_ps(v.m[0][1]), m02 = _mm_set1_ps(v.m[0][2]);
+        const __m128 m10 = _mm_set1_ps(v.m[1][0]), m11 = _mm_set1_ps(v.m[1][1]), m12 = _mm_set1_ps(v.m[1][2]);
+        const __m128 m20 = _mm_set1_ps(v.m[2][0]), m21 = _mm_set1_ps(v.m[2][1]), m22 = _mm_set1_ps(v.m[2][2]);
+        const __m128 m30 = _mm_set1_ps(v.m[3][0]), m31 = _mm_set1_ps(v.m[3][1]), m32 = _mm_set1_ps(v.m[3][2]);
+        const __m128 nearZ = _mm_set1_ps(nearPlane), farZ = _mm_set1_ps(farPlane), zero = _mm_setzero_ps();
+        const __m128 px = _mm_set1_ps(scaleX * sideX), pzx = _mm_set1_ps(sideX), py = _mm_set1_ps(scaleY * sideY), pzy = _mm_set1_ps(sideY);
+        alignas(16) float vx[4], vy[4], vz[4], vr[4];
+        for (; i + 4 <= count; i += 4) {
+            // Position and range are the first four floats of a light, so one transpose gives x, y, z and r lanes.
+            __m128 x = _mm_loadu_ps(&lights[i].position.x), y = _mm_loadu_ps(&lights[i + 1].position.x), z = _mm_loadu_ps(&lights[i + 2].position.x), r = _mm_loadu_ps(&lights[i + 3].position.x);
+            _MM_TRANSPOSE4_PS(x, y, z, r);
+            const __m128 ex = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)), _mm_add_ps(_mm_mul_ps(z, m20), m30));
+            const __m128 ey = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)), _mm_add_ps(_mm_mul_ps(z, m21), m31));
+            const __m128 ez = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m02), _mm_mul_ps(y, m12)), _mm_add_ps(_mm_mul_ps(z, m22), m32));
+            const __m128 negR = _mm_sub_ps(zero, r), sx = _mm_mul_ps(ex, px), sy = _mm_mul_ps(ey, py), szx = _mm_mul_ps(ez, pzx), szy = _mm_mul_ps(ez, pzy);
+            __m128 in = _mm_and_ps(_mm_cmpgt_ps(r, zero), _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(ez, r), nearZ), _mm_cmplt_ps(_mm_sub_ps(ez, r), farZ)));
+            in = _mm_and_ps(in, _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(sx, szx), negR), _mm_cmpgt_ps(_mm_sub_ps(szx, sx), negR)));
+            in = _mm_and_ps(in, _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(sy, szy), negR), _mm_cmpgt_ps(_mm_sub_ps(szy, sy), negR)));
+            int mask = _mm_movemask_ps(in); if (!mask) continue;
+            _mm_store_ps(vx, ex); _mm_store_ps(vy, ey); _mm_store_ps(vz, ez); _mm_store_ps(vr, r);
+            for (; mask; mask &= mask - 1) { const int lane = std::countr_zero(unsigned(mask)); accept(vx[lane], vy[lane], vz[lane], vr[lane], uint32_t(i) + uint32_t(lane)); }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const Float3& p = lights[i].position; const float r = lights[i].range;
+        const float x = p.x * v.m[0][0] + p.y * v.m[1][0] + p.z * v.m[2][0] + v.m[3][0];
+        const float y = p.x * v.m[0][1] + p.y * v.m[1][1] + p.z * v.m[2][1] + v.m[3][1];
+        const float z = p.x * v.m[0][2] + p.y * v.m[1][2] + p.z * v.m[2][2] + v.m[3][2];
+        if (!(r > 0.0f) || z + r <= nearPlane || z - r >= farPlane) continue;
+        if ((scaleX * x + z) * sideX <= -r || (z - scaleX * x) * sideX <= -r || (scaleY * y + z) * sideY <= -r || (z - scaleY * y) * sideY <= -r) continue;
+        accept(x, y, z, r, uint32_t(i));
+    }
+    buildStats.visibleLights = uint32_t(viewLights.size());
+
+    if (jobs) jobs->parallelFor(kLightClustersZ, 1, [this](uint32_t begin, uint32_t end) { PROFILE_ZONE("Bin light slices"); for (uint32_t z = begin; z < end; ++z) binSlice(z); });
+    else for (uint32_t z = 0; z < kLightClustersZ; ++z) binSlice(z);
+
+    uint32_t sliceBase[kLightClustersZ + 1]{};
+    for (uint32_t z = 0; z < kLightClustersZ; ++z) { sliceBase[z + 1] = sliceBase[z] + uint32_t(slices[z].sorted.size()); buildStats.clusterTests += slices[z].tests; }
+    clusterRanges.resize(kLightClusterCount); lightIndices.resize(sliceBase[kLightClustersZ]);
+    for (uint32_t z = 0; z < kLightClustersZ; ++z) {
+        const Slice& s = slices[z];
+        if (!s.sorted.empty()) memcpy(lightIndices.data() + sliceBase[z], s.sorted.data(), s.sorted.size() * sizeof(uint32_t));
+        for (uint32_t t = 0; t < kTilesPerSlice; ++t) {
+            clusterRanges[z * kTilesPerSlice + t] = { sliceBase[z] + s.offsets[t], s.counts[t] };
+            buildStats.occupiedClusters += s.counts[t] != 0; buildStats.maxPerCluster = std::max(buildStats.maxPerCluster, s.counts[t]);
+        }
+    }
+    buildStats.indices = uint32_t(lightIndices.size());
+}
+
+// Each light is clipped to the slab, projected to a conservative tile rectangle, and then tested against the boxes of
+// that rectangle four columns at a time; the squared distance splits into the slab, row and column terms.
+void LightClusterGrid::binSlice(uint32_t z) {
+    Slice& s = slices[z];
+    s.hitTiles.clear(); s.hitLights.clear(); s.tests = 0; memset(s.counts, 0, sizeof(s.counts));
+    const float zn = sliceDepth[z] * (1.0f - kSliceMargin), zf = sliceDepth[z + 1] * (1.0f + kSliceMargin);
+    const float* colMin = columnMin + z * kLightClustersX; const float* colMax = columnMax + z * kLightClustersX;
+    for (uint32_t index : s.lights) {
+        const ViewLight& l = viewLights[index];
+        const float dz = l.z < zn ? zn - l.z : l.z > zf ? l.z - zf : 0.0f, slab = l.r * l.r - dz * dz;
+        if (slab < 0.0f) continue;
+        const float disc = std::sqrt(slab), a = std::max(zn, l.z - l.r), b = std::min(zf, l.z + l.r);
+        const float left = l.x - disc, right = l.x + disc, bottom = l.y - disc, top = l.y + disc;
+        const float ndcLeft = scaleX * left / (left < 0.0f ? a : b), ndcRight = scaleX * right / (right > 0.0f ? a : b);
+        const float ndcBottom = scaleY * bottom / (bottom < 0.0f ? a : b), ndcTop = scaleY * top / (top > 0.0f ? a : b);
+        if (ndcRight < -1.0f || ndcLeft > 1.0f || ndcTop < -1.0f || ndcBottom > 1.0f) continue;
+        const uint32_t x0 = uint32_t(TileOf(ndcLeft, kLightClustersX)), x1 = uint32_t(TileOf(ndcRight, kLightClustersX));
+        const uint32_t y0 = uint32_t(kLightClustersY - 1 - TileOf(ndcTop, kLightClustersY)), y1 = uint32_t(kLightClustersY - 1 - TileOf(ndcBottom, kLightClustersY));
+        for (uint32_t y = y0; y <= y1; ++y) {
+            const float below = rowMin[z * kLightClustersY + y] - l.y, above = l.y - rowMax[z * kLightClustersY + y];
+            const float dy = std::max(below, 0.0f) + std::max(above, 0.0f), limit = slab - dy * dy;
+            if (limit < 0.0f) continue;
+            const uint16_t rowTile = uint16_t(y * kLightClustersX);
+#if GGINE_LIGHTS_SSE
+            const __m128 cx = _mm_set1_ps(l.x), lim = _mm_set1_ps(limit), zero = _mm_setzero_ps();
+            for (uint32_t x = x0 & ~3u; x <= x1; x += 4) {
+                const __m128 d = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(colMin + x), cx), zero), _mm_max_ps(_mm_sub_ps(cx, _mm_load_ps(colMax + x)), zero));
+                int mask = _mm_movemask_ps(_mm_cmple_ps(_mm_mul_ps(d, d), lim));
+                mask &= (0xF << (x0 > x ? x0 - x : 0)) & (0xF >> (x + 3 > x1 ? x + 3 - x1 : 0));
+                s.tests += 4;
+                for (; mask; mask &= mask - 1) { const uint16_t tile = uint16_t(rowTile + x + uint32_t(std::countr_zero(unsigned(mask)))); s.hitTiles.push_back(tile); s.hitLights.push_back(l.light); ++s.counts[tile]; }
+            }
+#else
+            for (uint32_t x = x0; x <= x1; ++x) {
+                const float dx = std::max(colMin[x] - l.x, 0.0f) + std::max(l.x - colMax[x], 0.0f);
+                ++s.tests;
+                if (dx * dx <= limit) { const uint16_t tile = uint16_t(rowTile + x); s.hitTiles.push_back(tile); s.hitLights.push_back(l.light); ++s.counts[tile]; }
+            }
+#endif
+        }
+    }
+    uint32_t cursor[kTilesPerSlice]; uint32_t total = 0;
+    for (uint32_t t = 0; t < kTilesPerSlice; ++t) { s.offsets[t] = total; cursor[t] = total; total += s.counts[t]; }
+    s.sorted.resize(total);
+    for (size_t k = 0; k < s.hitTiles.size(); ++k) s.sorted[cursor[s.hitTiles[k]]++] = s.hitLights[k];
+}
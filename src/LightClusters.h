@@ -0,0 +1,102 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+class JobSystem;
+
+constexpr uint32_t kLightClustersX = 16;
+constexpr uint32_t kLightClustersY = 8;
+constexpr uint32_t kLightClustersZ = 24;
+constexpr uint32_t kLightClusterCount = kLightClustersX * kLightClustersY * kLightClustersZ;
+// A point light's inverse-square falloff is windowed to zero where intensity / d^2 drops to this, which bounds its range.
+constexpr float kLightCutoff = 1.0f / 64.0f;
+
+inline float LightRange(float intensity) { return intensity > 0.0f ? std::sqrt(intensity / kLightCutoff) : 0.0f; }
+
+// A point light as the pixel shader reads it; radiance is colour times intensity.
+struct ClusterLight {
+    Float3 position;
+    float range;
+    Float3 radiance;
+    float padding;
+};
+
+// One cluster's run in the light-index list.
+struct LightClusterRange {
+    uint32_t offset;
+    uint32_t count;
+};
+
+// What the pixel shader needs to find its cluster from SV_Position and view depth; matches the LightGrid constants.
+struct LightGridParams {
+    float clustersPerPixelX, clustersPerPixelY;
+    float sliceScale, sliceBias;   // slice = log(viewZ) * sliceScale + sliceBias
+    uint32_t clustersX, clustersY, clustersZ;
+    uint32_t lightCount;
+};
+
+struct LightClusterStats {
+    uint32_t lights{0};
+    uint32_t visibleLights{0};    // inside the depth range and the side planes
+    uint32_t clusterTests{0};
+    uint32_t indices{0};
+    uint32_t occupiedClusters{0};
+    uint32_t maxPerCluster{0};
+};
+
+// Froxel grid for forward+ clustered shading. The screen is split into kLightClustersX x kLightClustersY tiles and view
+// depth into kLightClustersZ exponential slices between the near and far planes. build() assigns every light to each
+// cluster whose view-space bounds its sphere touches and packs the result into one index list with a range per cluster.
+class LightClusterGrid {
+public:
+    // view maps world to view space (+z forward); projX and projY are the projection's m[0][0] and m[1][1].
+    void setView(const Float4x4& view, float projX, float projY, float nearZ, float farZ);
+    // Lights outside the depth range or the side planes are dropped in one SIMD pass before any cluster is touched, so the
+    // binning itself costs in proportion to the lights in view. Depth slices are binned as parallel jobs.
+    void build(const ClusterLight* lights, size_t count, JobSystem* jobs = nullptr);
+
+    static uint32_t clusterIndex(uint32_t x, uint32_t y, uint32_t z) { return (z * kLightClustersY + y) * kLightClustersX + x; }
+    // Slice holding a view depth, clamped to the grid; the shader computes the same thing from LightGridParams.
+    uint32_t sliceOf(float viewZ) const;
+    LightGridParams shaderParams(uint32_t width, uint32_t height, uint32_t lightCount) const;
+    Aabb clusterBounds(uint32_t x, uint32_t y, uint32_t z) const;
+
+    const Float4x4& view() const { return viewMatrix; }
+    // Indices refer to the lights passed to build().
+    const std::vector<LightClusterRange>& ranges() const { return clusterRanges; }
+    const std::vector<uint32_t>& indices() const { return lightIndices; }
+    const LightClusterStats& stats() const { return buildStats; }
+
+private:
+    struct ViewLight { float x, y, z, r; uint32_t light; };
+    // Hits are gathered in light order and then counting-sorted by tile, so each cluster lists its lights in input order.
+    struct Slice {
+        std::vector<uint32_t> lights;      // into viewLights
+        std::vector<uint16_t> hitTiles;
+        std::vector<uint32_t> hitLights;
+        std::vector<uint32_t> sorted;
+        uint32_t counts[kLightClustersX * kLightClustersY]{};
+        uint32_t offsets[kLightClustersX * kLightClustersY]{};
+        uint32_t tests{0};
+    };
+
+    void binSlice(uint32_t z);
+
+    Float4x4 viewMatrix{};
+    float scaleX{1.0f}, scaleY{1.0f}, nearPlane{0.1f}, farPlane{100.0f};
+    float sliceScale{0.0f}, sliceBias{0.0f};
+    float sliceDepth[kLightClustersZ + 1]{};
+    // A froxel's view-space box is separable: its x extent depends only on the tile column and slice, y only on the row.
+    alignas(16) float columnMin[kLightClustersZ * kLightClustersX]{};
+    alignas(16) float columnMax[kLightClustersZ * kLightClustersX]{};
+    float rowMin[kLightClustersZ * kLightClustersY]{};
+    float rowMax[kLightClustersZ * kLightClustersY]{};
+    std::vector<ViewLight> viewLights;
+    std::vector<Slice> slices;
+    std::vector<LightClusterRange> clusterRanges;
+    std::vector<uint32_t> lightIndices;
+    LightClusterStats buildStats;
+};
@@ -0,0 +1,26 @@
+#include "LinearArena.h"
+#include <algorithm>
+
+namespace {
+constexpr size_t kScratchBlockBytes = 256u << 10;
+}
+
+void* LinearArena::allocateBytes(size_t bytes, size_t alignment) {
+    for (;;) {
+        // Requests that do not fit the current block move on to the next retained one; only past the last is a block added,
+        // at least twice the previous so a frame's growth settles in a few steps.
+        if (current == blocks.size()) { const size_t size = std::max({ firstBlockBytes, blocks.empty() ? size_t(0) : blocks.back().size * 2, bytes + alignment }); blocks.push_back({ std::unique_ptr<std::byte[]>(new std::byte[size]), size }); }
+        Block& b = blocks[current];
+        const uintptr_t base = uintptr_t(b.data.get());
+        const size_t start = size_t(((base + offset + alignment - 1) & ~uintptr_t(alignment - 1)) - base);
+        if (start + bytes <= b.size) { offset = start + bytes; peak = std::max(peak, usedBefore + offset); return b.data.get() + start; }
+        usedBefore += b.size; ++current; offset = 0;
+    }
+}
+
+void LinearArena::rewind(Marker marker) {
+    current = std::min<uint32_t>(marker.block, uint32_t(blocks.size())); offset = current < blocks.size() ? marker.offset : 0;
+    usedBefore = 0; for (uint32_t b = 0; b < current; ++b) usedBefore += blocks[b].size;
+}
+
+LinearArena& ScratchArena::ThreadArena() { thread_local LinearArena arena(kScratchBlockBytes); return arena; }
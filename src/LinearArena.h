@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator over a chain of blocks taken from the general heap. Deallocation is a no-op: memory comes back all at
+// once through reset(), or through rewind() for stack-like scratch use. Blocks are kept across resets, so once the
+// arena has seen its peak it stops touching the heap. As a pmr memory_resource it backs std::pmr containers, which must
+// not be used past the reset that reclaims their memory.
+class LinearArena final : public std::pmr::memory_resource {
+public:
+    struct Marker { uint32_t block{0}; size_t offset{0}; };
+
+    explicit LinearArena(size_t initialBlockBytes = 64u << 10) : firstBlockBytes(initialBlockBytes) {}
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* allocateBytes(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    Marker mark() const { return { current, offset }; }
+    void rewind(Marker marker);
+    void reset() { rewind({}); }
+
+    // Used counts the unused tails of blocks that were skipped, so it is what the arena needed rather than what was asked.
+    size_t bytesUsed() const { return usedBefore + offset; }
+    size_t peakBytes() const { return peak; }
+    size_t capacity() const { size_t total = 0; for (const Block& b : blocks) total += b.size; return total; }
+    uint32_t blockCount() const { return uint32_t(blocks.size()); }
+
+private:
+    struct Block { std::unique_ptr<std::byte[]> data; size_t size; };
+
+    void* do_allocate(size_t bytes, size_t alignment) override { return allocateBytes(bytes, alignment); }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::vector<Block> blocks;
+    uint32_t current{0};
+    size_t offset{0};
+    size_t usedBefore{0};   // sizes of the blocks before current
+    size_t peak{0};
+    size_t firstBlockBytes;
+};
+
+// Scratch memory for temporaries that die before the function that made them returns, from an arena owned by the
+// calling thread. Scopes nest like a stack: each rewinds the thread's arena to where it found it on destruction, so
+// containers built on resource() must be destroyed first (declare the scope before them) and never cross threads.
+class ScratchArena {
+public:
+    ScratchArena() : arena(ThreadArena()), start(arena.mark()) {}
+    ~ScratchArena() { arena.rewind(start); }
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arena; }
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) { return arena.allocateBytes(bytes, alignment); }
+
+private:
+    static LinearArena& ThreadArena();
+
+    LinearArena& arena;
+    LinearArena::Marker start;
+};
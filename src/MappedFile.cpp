@@ -0,0 +1,91 @@
+#include "MappedFile.h"
+#include <cstring>
+#include <utility>
+#if defined(_WIN32)
+#include <vector>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    bytes = std::exchange(other.bytes, nullptr); length = std::exchange(other.length, 0); opened = std::exchange(other.opened, false);
+#if defined(_WIN32)
+    fileHandle = std::exchange(other.fileHandle, nullptr); mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#else
+    fd = std::exchange(other.fd, -1);
+#endif
+    return *this;
+}
+
+MappedFile::~MappedFile() { close(); }
+
+#if defined(_WIN32)
+// A plain rename fails while the target has open handles; POSIX semantics unlink the old name and leave those handles on
+// the old file. Windows before 10 1709 lacks them and falls back to MoveFileExW.
+bool ReplaceMappedFile(const std::filesystem::path& from, const std::filesystem::path& to) {
+    std::error_code ec; const std::wstring target = std::filesystem::absolute(to, ec).wstring(); if (ec) return false;
+    HANDLE f = CreateFileW(from.c_str(), DELETE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f != INVALID_HANDLE_VALUE) {
+        std::vector<uint8_t> buffer(sizeof(FILE_RENAME_INFO) + target.size() * sizeof(wchar_t));
+        FILE_RENAME_INFO* info = reinterpret_cast<FILE_RENAME_INFO*>(buffer.data());
+        info->Flags = FILE_RENAME_FLAG_REPLACE_IF_EXISTS | FILE_RENAME_FLAG_POSIX_SEMANTICS; info->RootDirectory = nullptr;
+        info->FileNameLength = DWORD(target.size() * sizeof(wchar_t)); memcpy(info->FileName, target.data(), info->FileNameLength);
+        const BOOL renamed = SetFileInformationByHandle(f, FileRenameInfoEx, info, DWORD(buffer.size()));
+        CloseHandle(f);
+        if (renamed) return true;
+    }
+    return MoveFileExW(from.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+}
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+    HANDLE f = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER sz{}; if (!GetFileSizeEx(f, &sz)) { CloseHandle(f); return false; }
+    fileHandle = f; length = static_cast<size_t>(sz.QuadPart); opened = true;
+    if (length == 0) return true;
+    HANDLE m = CreateFileMappingW(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m) { close(); return false; }
+    mappingHandle = m;
+    bytes = static_cast<const uint8_t*>(MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0));
+    if (!bytes) { close(); return false; }
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    bytes = nullptr; length = 0; opened = false; mappingHandle = nullptr; fileHandle = nullptr;
+}
+#else
+bool ReplaceMappedFile(const std::filesystem::path& from, const std::filesystem::path& to) { std::error_code ec; std::filesystem::rename(from, to, ec); return !ec; }
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+    int f = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (f < 0) return false;
+    struct stat st{}; if (fstat(f, &st) != 0) { ::close(f); return false; }
+    fd = f; length = static_cast<size_t>(st.st_size); opened = true;
+    if (length == 0) return true;
+    void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, f, 0);
+    if (p == MAP_FAILED) { close(); return false; }
+    madvise(p, length, MADV_SEQUENTIAL);
+    bytes = static_cast<const uint8_t*>(p);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+    if (fd >= 0) ::close(fd);
+    bytes = nullptr; length = 0; opened = false; fd = -1;
+}
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Renames from over to, even while to is mapped by a MappedFile; the mapping keeps reading the old contents.
+bool ReplaceMappedFile(const std::filesystem::path& from, const std::filesystem::path& to);
+
+// Mappings share delete access, so a cache can be replaced underneath a mesh that still reads it.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    bool open(const std::filesystem::path& path);
+    void close();
+    bool isOpen() const { return opened; }
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes{nullptr};
+    size_t length{0};
+    bool opened{false};
+#if defined(_WIN32)
+    void* fileHandle{nullptr};
+    void* mappingHandle{nullptr};
+#else
+    int fd{-1};
+#endif
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+struct Float2 { float x{0}, y{0}; };
+
+struct Float3 {
+    float x{0}, y{0}, z{0};
+    Float3() = default;
+    constexpr Float3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+};
+
+struct Float4 {
+    float x{0}, y{0}, z{0}, w{0};
+    Float4() = default;
+    constexpr Float4(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {}
+};
+
+struct Float4x4 { float m[4][4]{}; };
+
+struct Aabb { Float3 min; Float3 max; };
+
+struct Sphere { Float3 center; float radius{0}; };
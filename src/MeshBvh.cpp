@@ -0,0 +1,189 @@
+#include "MeshBvh.h"
+#include "Bounds.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define GGINE_BVH_SSE 1
+#endif
+
+namespace {
+constexpr uint32_t kBins = 16;
+// Below this depth ranges are split at the median, which adds at most 32 more levels, so no tree outgrows the stack.
+constexpr uint32_t kSahMaxDepth = kBvhMaxDepth - 32;
+constexpr float kTraversalCost = 1.0f;
+
+float GroupCost(uint32_t count) { return float((count + 3) / 4); }
+float AxisOf(const Float3& p, int axis) { return axis == 0 ? p.x : axis == 1 ? p.y : p.z; }
+Aabb EmptyAabb() { return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } }; }
+void Grow(Aabb& b, const Float3& p) { b.min = { std::min(b.min.x, p.x), std::min(b.min.y, p.y), std::min(b.min.z, p.z) }; b.max = { std::max(b.max.x, p.x), std::max(b.max.y, p.y), std::max(b.max.z, p.z) }; }
+
+struct Bin { Aabb box{ EmptyAabb() }; uint32_t count{0}; };
+
+#if defined(GGINE_BVH_SSE)
+// Moller-Trumbore on four triangles per step; lanes past the end repeat the last triangle.
+bool IntersectLeaf(const uint32_t* ids, uint32_t count, const Float3* positions, const uint32_t* indices, const Ray& ray, RayHit& hit) {
+    const __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+    const __m128 dx = _mm_set1_ps(ray.direction.x), dy = _mm_set1_ps(ray.direction.y), dz = _mm_set1_ps(ray.direction.z);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    bool found = false;
+    for (uint32_t i = 0; i < count; i += 4) {
+        alignas(16) float lanes[9][4]; uint32_t id[4];
+        for (uint32_t k = 0; k < 4; ++k) {
+            id[k] = ids[std::min(i + k, count - 1)]; const uint32_t* tri = indices + size_t(id[k]) * 3;
+            const Float3& a = positions[tri[0]]; const Float3& b = positions[tri[1]]; const Float3& c = positions[tri[2]];
+            lanes[0][k] = a.x; lanes[1][k] = a.y; lanes[2][k] = a.z;
+            lanes[3][k] = b.x - a.x; lanes[4][k] = b.y - a.y; lanes[5][k] = b.z - a.z;
+            lanes[6][k] = c.x - a.x; lanes[7][k] = c.y - a.y; lanes[8][k] = c.z - a.z;
+        }
+        const __m128 e1x = _mm_load_ps(lanes[3]), e1y = _mm_load_ps(lanes[4]), e1z = _mm_load_ps(lanes[5]);
+        const __m128 e2x = _mm_load_ps(lanes[6]), e2y = _mm_load_ps(lanes[7]), e2z = _mm_load_ps(lanes[8]);
+        const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y)), py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z)), pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+        const __m128 inv = _mm_div_ps(one, det);
+        const __m128 sx = _mm_sub_ps(ox, _mm_load_ps(lanes[0])), sy = _mm_sub_ps(oy, _mm_load_ps(lanes[1])), sz = _mm_sub_ps(oz, _mm_load_ps(lanes[2]));
+        const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv);
+        const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y)), qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z)), qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv);
+        const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv);
+        const __m128 valid = _mm_and_ps(_mm_and_ps(_mm_and_ps(_mm_cmpneq_ps(det, zero), _mm_cmpge_ps(u, zero)), _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one))),
+                                        _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmplt_ps(t, _mm_set1_ps(hit.t))));
+        const int bits = _mm_movemask_ps(valid);
+        if (!bits) continue;
+        alignas(16) float ts[4], us[4], vs[4]; _mm_store_ps(ts, t); _mm_store_ps(us, u); _mm_store_ps(vs, v);
+        for (int k = 0; k < 4; ++k) if ((bits >> k & 1) && ts[k] < hit.t) { hit = { ts[k], id[k], us[k], vs[k] }; found = true; }
+    }
+    return found;
+}
+#else
+bool IntersectLeaf(const uint32_t* ids, uint32_t count, const Float3* positions, const uint32_t* indices, const Ray& ray, RayHit& hit) {
+    const Float3& o = ray.origin; const Float3& d = ray.direction;
+    bool found = false;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t* tri = indices + size_t(ids[i]) * 3;
+        const Float3& a = positions[tri[0]]; const Float3& b = positions[tri[1]]; const Float3& c = positions[tri[2]];
+        const Float3 e1{ b.x - a.x, b.y - a.y, b.z - a.z }, e2{ c.x - a.x, c.y - a.y, c.z - a.z };
+        const Float3 p{ d.y * e2.z - d.z * e2.y, d.z * e2.x - d.x * e2.z, d.x * e2.y - d.y * e2.x };
+        const float det = e1.x * p.x + e1.y * p.y + e1.z * p.z;
+        if (det == 0.0f) continue;
+        const float inv = 1.0f / det; const Float3 s{ o.x - a.x, o.y - a.y, o.z - a.z };
+        const float u = (s.x * p.x + s.y * p.y + s.z * p.z) * inv;
+        const Float3 q{ s.y * e1.z - s.z * e1.y, s.z * e1.x - s.x * e1.z, s.x * e1.y - s.y * e1.x };
+        const float v = (d.x * q.x + d.y * q.y + d.z * q.z) * inv, t = (e2.x * q.x + e2.y * q.y + e2.z * q.z) * inv;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < hit.t) { hit = { t, ids[i], u, v }; found = true; }
+    }
+    return found;
+}
+#endif
+}
+
+size_t BuildMeshBvh(const Float3* positions, const uint32_t* indices, size_t indexCount, MeshBvh& out, BvhBuildStats* outStats) {
+    PROFILE_ZONE("BuildMeshBvh");
+    const auto start = std::chrono::steady_clock::now();
+    const uint32_t triangleCount = uint32_t(indexCount / 3);
+    BvhBuildStats stats;
+    out.nodes.clear(); out.triangles.resize(triangleCount);
+    if (triangleCount == 0) { if (outStats) *outStats = stats; return 0; }
+
+    std::vector<Aabb> boxes(triangleCount); std::vector<Float3> centroids(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        Aabb b = EmptyAabb(); for (int k = 0; k < 3; ++k) Grow(b, positions[indices[size_t(t) * 3 + size_t(k)]]);
+        boxes[t] = b; centroids[t] = { (b.min.x + b.max.x) * 0.5f, (b.min.y + b.max.y) * 0.5f, (b.min.z + b.max.z) * 0.5f };
+    }
+    uint32_t* tris = out.triangles.data(); std::iota(tris, tris + triangleCount, 0u);
+    out.nodes.reserve(size_t(triangleCount) * 2 - 1); out.nodes.emplace_back();
+
+    struct Task { uint32_t node, first, count, depth; };
+    std::vector<Task> tasks{ { 0, 0, triangleCount, 0 } };
+    float rootArea = 0.0f; double cost = 0.0;
+    while (!tasks.empty()) {
+        const Task task = tasks.back(); tasks.pop_back();
+        Aabb bounds = EmptyAabb(), centroidBounds = EmptyAabb();
+        for (uint32_t i = task.first; i < task.first + task.count; ++i) { bounds = UnionAabb(bounds, boxes[tris[i]]); Grow(centroidBounds, centroids[tris[i]]); }
+        out.nodes[task.node].min = bounds.min; out.nodes[task.node].max = bounds.max;
+        stats.maxDepth = std::max(stats.maxDepth, task.depth);
+        const float area = SurfaceArea(bounds); if (task.node == 0) rootArea = area;
+        const float relativeArea = rootArea > 0.0f ? area / rootArea : 1.0f;
+
+        // Costs are scaled by the node's area rather than divided by it, so flat and degenerate boxes compare sanely.
+        int axis = -1; uint32_t splitBin = 0; float bestCost = FLT_MAX;
+        if (task.count > 1 && task.depth < kSahMaxDepth) for (int a = 0; a < 3; ++a) {
+            const float lo = AxisOf(centroidBounds.min, a), extent = AxisOf(centroidBounds.max, a) - lo;
+            if (!(extent > 0.0f)) continue;
+            const float scale = float(kBins) / extent;
+            Bin bins[kBins];
+            for (uint32_t i = task.first; i < task.first + task.count; ++i) { Bin& b = bins[std::min(kBins - 1, uint32_t((AxisOf(centroids[tris[i]], a) - lo) * scale))]; ++b.count; b.box = UnionAabb(b.box, boxes[tris[i]]); }
+            float leftArea[kBins - 1]; uint32_t leftCount[kBins - 1]; Aabb grown = EmptyAabb(); uint32_t n = 0;
+            for (uint32_t b = 0; b + 1 < kBins; ++b) { n += bins[b].count; if (bins[b].count) grown = UnionAabb(grown, bins[b].box); leftCount[b] = n; leftArea[b] = n ? SurfaceArea(grown) : 0.0f; }
+            grown = EmptyAabb(); n = 0;
+            for (uint32_t b = kBins - 1; b > 0; --b) {
+                n += bins[b].count; if (bins[b].count) grown = UnionAabb(grown, bins[b].box);
+                if (!n || !leftCount[b - 1]) continue;
+                const float c = leftArea[b - 1] * GroupCost(leftCount[b - 1]) + SurfaceArea(grown) * GroupCost(n);
+                if (c < bestCost) { bestCost = c; axis = a; splitBin = b; }
+            }
+        }
+        const bool fits = task.count <= kBvhMaxLeafTriangles;
+        if (task.count == 1 || (fits && (axis < 0 || kTraversalCost * area + bestCost >= GroupCost(task.count) * area))) {
+            out.nodes[task.node].leftFirst = task.first; out.nodes[task.node].count = task.count;
+            ++stats.leaves; cost += double(relativeArea) * GroupCost(task.count);
+            continue;
+        }
+
+        uint32_t* begin = tris + task.first; uint32_t* end = begin + task.count; uint32_t* mid = begin;
+        if (axis >= 0) {
+            const float lo = AxisOf(centroidBounds.min, axis), scale = float(kBins) / (AxisOf(centroidBounds.max, axis) - lo);
+            mid = std::partition(begin, end, [&](uint32_t t) { return std::min(kBins - 1, uint32_t((AxisOf(centroids[t], axis) - lo) * scale)) < splitBin; });
+        }
+        if (mid == begin || mid == end) {
+            const Float3 extent{ centroidBounds.max.x - centroidBounds.min.x, centroidBounds.max.y - centroidBounds.min.y, centroidBounds.max.z - centroidBounds.min.z };
+            const int widest = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+            mid = begin + task.count / 2;
+            std::nth_element(begin, mid, end, [&](uint32_t a, uint32_t b) { return AxisOf(centroids[a], widest) < AxisOf(centroids[b], widest); });
+        }
+        const uint32_t left = uint32_t(out.nodes.size()), leftCount = uint32_t(mid - begin);
+        out.nodes.emplace_back(); out.nodes.emplace_back();
+        out.nodes[task.node].leftFirst = left; out.nodes[task.node].count = 0;
+        cost += double(relativeArea) * kTraversalCost;
+        tasks.push_back({ left + 1, task.first + leftCount, task.count - leftCount, task.depth + 1 });
+        tasks.push_back({ left, task.first, leftCount, task.depth + 1 });
+    }
+    stats.nodes = uint32_t(out.nodes.size()); stats.sahCost = float(cost);
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (outStats) *outStats = stats;
+    return out.nodes.size();
+}
+
+bool ValidateMeshBvh(const BvhNode* nodes, size_t nodeCount, const uint32_t* triangles, size_t triangleCount, uint32_t meshTriangles) {
+    if (nodeCount == 0) return triangleCount == 0;
+    for (size_t i = 0; i < triangleCount; ++i) if (triangles[i] >= meshTriangles) return false;
+    std::vector<uint8_t> depth(nodeCount, 0);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        const BvhNode& n = nodes[i];
+        if (n.count) { if (n.leftFirst > triangleCount || n.count > triangleCount - n.leftFirst) return false; continue; }
+        if (n.leftFirst <= i || size_t(n.leftFirst) + 1 >= nodeCount || depth[i] + 1u >= kBvhMaxDepth) return false;
+        depth[n.leftFirst] = depth[n.leftFirst + 1] = uint8_t(depth[i] + 1);
+    }
+    return true;
+}
+
+bool IntersectMeshBvh(const BvhNode* nodes, const uint32_t* triangles, const Float3* positions, const uint32_t* indices, const Ray& ray, RayHit& hit) {
+    const Float3 inv{ 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z };
+    auto enter = [&](const BvhNode& n, float& t) { return IntersectRayAabb({ n.min, n.max }, ray.origin, inv, hit.t, t); };
+    struct Entry { uint32_t node; float t; };
+    Entry stack[kBvhMaxDepth]; uint32_t sp = 0, current = 0; bool found = false; float t;
+    if (!enter(nodes[0], t)) return false;
+    for (;;) {
+        const BvhNode& n = nodes[current];
+        if (n.count) found |= IntersectLeaf(triangles + n.leftFirst, n.count, positions, indices, ray, hit);
+        else {
+            float tl, tr; const bool hl = enter(nodes[n.leftFirst], tl), hr = enter(nodes[n.leftFirst + 1], tr);
+            if (hl && hr) { const bool leftFirst = tl <= tr; stack[sp++] = { leftFirst ? n.leftFirst + 1 : n.leftFirst, leftFirst ? tr : tl }; current = leftFirst ? n.leftFirst : n.leftFirst + 1; continue; }
+            if (hl || hr) { current = hl ? n.leftFirst : n.leftFirst + 1; continue; }
+        }
+        // Entries the nearest hit has since moved in front of are dropped without touching their nodes.
+        for (;;) { if (sp == 0) return found; const Entry e = stack[--sp]; if (e.t < hit.t) { current = e.node; break; } }
+    }
+}
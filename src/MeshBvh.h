@@ -0,0 +1,54 @@
+#pragma once
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+constexpr uint32_t kBvhMaxLeafTriangles = 8;
+constexpr uint32_t kBvhMaxDepth = 128;   // bounds the traversal stack; builds stay below it
+
+// Interior nodes have count 0 and their children at leftFirst and leftFirst + 1, always after the parent; leaves cover
+// triangles[leftFirst, leftFirst + count).
+struct BvhNode {
+    Float3 min;
+    uint32_t leftFirst{0};
+    Float3 max;
+    uint32_t count{0};
+};
+
+// Triangle ids are in leaf order and name the triangle at indices[3 * id] of the mesh the BVH was built over.
+struct MeshBvh {
+    std::vector<BvhNode> nodes;
+    std::vector<uint32_t> triangles;
+};
+
+struct BvhBuildStats {
+    uint32_t nodes{0};
+    uint32_t leaves{0};
+    uint32_t maxDepth{0};
+    float sahCost{0.0f};   // expected node visits plus four-triangle tests per ray, relative to the root box
+    double milliseconds{0.0};
+};
+
+struct Ray {
+    Float3 origin;
+    Float3 direction;   // need not be unit length; t is in units of it
+};
+
+struct RayHit {
+    float t{FLT_MAX};
+    uint32_t triangle{~0u};
+    float u{0.0f}, v{0.0f};   // barycentrics of vertices 1 and 2
+};
+
+// Binned SAH build over indices[0, indexCount). Costs count leaf triangles in groups of four, the width of the ray test.
+size_t BuildMeshBvh(const Float3* positions, const uint32_t* indices, size_t indexCount, MeshBvh& out, BvhBuildStats* outStats = nullptr);
+
+// For trees read from disk: child links point forward, ranges and triangle ids are in bounds and the depth fits.
+bool ValidateMeshBvh(const BvhNode* nodes, size_t nodeCount, const uint32_t* triangles, size_t triangleCount, uint32_t meshTriangles);
+
+// Nearest hit with 0 <= t < hit.t, both faces; hit is only written when a closer triangle is found, so one RayHit can
+// be carried across several meshes whose rays share a parameterisation.
+bool IntersectMeshBvh(const BvhNode* nodes, const uint32_t* triangles, const Float3* positions, const uint32_t* indices, const Ray& ray, RayHit& hit);
+inline bool IntersectMeshBvh(const MeshBvh& bvh, const Float3* positions, const uint32_t* indices, const Ray& ray, RayHit& hit) { return !bvh.nodes.empty() && IntersectMeshBvh(bvh.nodes.data(), bvh.triangles.data(), positions, indices, ray, hit); }
@@ -0,0 +1,278 @@
+#include "MeshCache.h"
+#include "Hash.h"
+#include "Profiler.h"
+#include "VertexCodec.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+namespace {
+size_t AlignUp(size_t v, size_t a) { return (v + a - 1) & ~(a - 1); }
+bool IsVertexStream(uint32_t type) { return type == uint32_t(MeshStreamType::Positions) || type == uint32_t(MeshStreamType::Normals); }
+// A max reduction rather than an early out, so the scan over a mapped index stream vectorizes.
+bool IndicesBelow(const uint32_t* indices, size_t count, uint32_t vertexCount) { uint32_t largest = 0; for (size_t i = 0; i < count; ++i) largest = std::max(largest, indices[i]); return count == 0 || largest < vertexCount; }
+
+bool ReadHeader(const std::filesystem::path& cooked, GgmeshHeader& out) {
+    std::ifstream f(cooked, std::ios::binary);
+    if (!f) return false;
+    f.read(reinterpret_cast<char*>(&out), sizeof(out));
+    return f.gcount() == std::streamsize(sizeof(out)) && out.magic == kGgmeshMagic && out.version == kGgmeshVersion;
+}
+}
+
+bool ComputeSourceFingerprint(const std::filesystem::path& source, SourceFingerprint& out, bool hashContents) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(source, ec); if (ec) return false;
+    const auto mtime = std::filesystem::last_write_time(source, ec); if (ec) return false;
+    out.size = uint64_t(size); out.mtime = int64_t(mtime.time_since_epoch().count()); out.hash = 0;
+    if (hashContents) { MappedFile f; if (!f.open(source)) return false; out.hash = HashMemory(f.data(), f.size()); }
+    return true;
+}
+
+std::filesystem::path CookedMeshPath(const std::filesystem::path& source) { std::filesystem::path p = source; p.replace_extension(".ggmesh"); return p; }
+
+bool IsCookedMeshValid(const std::filesystem::path& cooked, const std::filesystem::path& source) {
+    GgmeshHeader h{};
+    if (!ReadHeader(cooked, h)) return false;
+    SourceFingerprint fp;
+    if (!ComputeSourceFingerprint(source, fp, false) || fp.size != h.sourceSize) return false;
+    if (fp.mtime == h.sourceMtime) return true;
+    if (!ComputeSourceFingerprint(source, fp, true) || fp.hash != h.sourceHash) return false;
+    // The new mtime goes into a copy that replaces the cache: a loaded mesh may map it, and on Windows that mapping
+    // refuses writers, so patching in place would quietly fail and every later load would rehash the source.
+    std::vector<uint8_t> image;
+    { std::ifstream f(cooked, std::ios::binary | std::ios::ate); if (!f) return true; image.resize(size_t(f.tellg())); f.seekg(0); if (!f.read(reinterpret_cast<char*>(image.data()), std::streamsize(image.size()))) return true; }
+    if (image.size() >= sizeof(GgmeshHeader)) { memcpy(image.data() + offsetof(GgmeshHeader, sourceMtime), &fp.mtime, sizeof(fp.mtime)); WriteCookedMesh(cooked, image); }
+    return true;
+}
+
+std::vector<uint8_t> BuildCookedMeshImage(const SourceFingerprint& source, const std::vector<MeshStreamData>& streams, const Aabb& bounds, uint32_t flags) {
+    PROFILE_ZONE("BuildCookedMeshImage");
+    GgmeshHeader h{};
+    h.magic = kGgmeshMagic; h.version = kGgmeshVersion; h.streamCount = uint32_t(streams.size()); h.flags = flags;
+    h.sourceSize = source.size; h.sourceMtime = source.mtime; h.sourceHash = source.hash; h.bounds = bounds;
+    std::vector<GgmeshStreamEntry> table(streams.size());
+    std::vector<std::vector<uint8_t>> encoded(streams.size());
+    size_t cursor = AlignUp(sizeof(GgmeshHeader) + sizeof(GgmeshStreamEntry) * streams.size(), kGgmeshAlignment);
+    for (size_t i = 0; i < streams.size(); ++i) {
+        const MeshStreamData& s = streams[i];
+        if (s.type == MeshStreamType::Positions) h.vertexCount = uint32_t(s.byteSize / s.elementSize);
+        if (s.type == MeshStreamType::Indices) h.indexCount = uint32_t(s.byteSize / s.elementSize);
+        if ((flags & kGgmeshFlagEncodedStreams) && IsVertexStream(uint32_t(s.type))) EncodeVertexStream(s.data, s.byteSize / s.elementSize, s.elementSize, encoded[i]);
+        if ((flags & kGgmeshFlagEncodedStreams) && s.type == MeshStreamType::Indices) EncodeIndexStream(static_cast<const uint32_t*>(s.data), s.byteSize / sizeof(uint32_t), encoded[i]);
+        const size_t bytes = encoded[i].empty() ? s.byteSize : encoded[i].size();
+        table[i] = { uint32_t(s.type), s.elementSize, uint64_t(cursor), uint64_t(bytes) };
+        cursor = AlignUp(cursor + bytes, kGgmeshAlignment);
+    }
+    std::vector<uint8_t> image(cursor, 0);
+    memcpy(image.data(), &h, sizeof(h));
+    if (!table.empty()) memcpy(image.data() + sizeof(h), table.data(), sizeof(GgmeshStreamEntry) * table.size());
+    for (size_t i = 0; i < streams.size(); ++i) if (table[i].byteSize) memcpy(image.data() + table[i].offset, encoded[i].empty() ? streams[i].data : encoded[i].data(), size_t(table[i].byteSize));
+    return image;
+}
+
+namespace {
+bool DecodeCookedMeshImage(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    if (size < sizeof(GgmeshHeader)) return false;
+    GgmeshHeader h; memcpy(&h, data, sizeof(h));
+    if (sizeof(GgmeshHeader) + size_t(h.streamCount) * sizeof(GgmeshStreamEntry) > size) return false;
+    std::vector<GgmeshStreamEntry> table(h.streamCount);
+    if (h.streamCount) memcpy(table.data(), data + sizeof(h), sizeof(GgmeshStreamEntry) * table.size());
+    // The counts are untrusted: each stream may only expand as far as its codec can, and the whole image is capped.
+    std::vector<uint64_t> rawSizes(table.size());
+    uint64_t total = AlignUp(sizeof(GgmeshHeader) + sizeof(GgmeshStreamEntry) * table.size(), kGgmeshAlignment);
+    for (size_t i = 0; i < table.size(); ++i) {
+        const GgmeshStreamEntry& e = table[i];
+        if (e.offset > size || e.byteSize > size - e.offset) return false;
+        const bool vertices = IsVertexStream(e.type), indices = e.type == uint32_t(MeshStreamType::Indices);
+        rawSizes[i] = vertices ? uint64_t(h.vertexCount) * e.elementSize : indices ? uint64_t(h.indexCount) * sizeof(uint32_t) : e.byteSize;
+        if (rawSizes[i] > e.byteSize * (vertices ? kVertexStreamMaxExpansion : indices ? kIndexStreamMaxExpansion : 1)) return false;
+        total = AlignUp(total + rawSizes[i], kGgmeshAlignment);
+        if (total > kGgmeshMaxDecodedBytes) return false;
+    }
+    out.assign(size_t(total), 0);
+    size_t cursor = AlignUp(sizeof(GgmeshHeader) + sizeof(GgmeshStreamEntry) * table.size(), kGgmeshAlignment);
+    for (size_t i = 0; i < table.size(); ++i) {
+        GgmeshStreamEntry& e = table[i]; const uint8_t* src = data + e.offset; uint8_t* dst = out.data() + cursor;
+        if (IsVertexStream(e.type)) { if (e.elementSize == 0 || !DecodeVertexStream(src, size_t(e.byteSize), dst, h.vertexCount, e.elementSize)) return false; }
+        else if (e.type == uint32_t(MeshStreamType::Indices)) { if (!DecodeIndexStream(src, size_t(e.byteSize), reinterpret_cast<uint32_t*>(dst), h.indexCount)) return false; }
+        else memcpy(dst, src, size_t(e.byteSize));
+        e.offset = cursor; e.byteSize = rawSizes[i];
+        cursor = AlignUp(cursor + size_t(rawSizes[i]), kGgmeshAlignment);
+    }
+    h.flags &= ~kGgmeshFlagEncodedStreams;
+    memcpy(out.data(), &h, sizeof(h));
+    if (!table.empty()) memcpy(out.data() + sizeof(h), table.data(), sizeof(GgmeshStreamEntry) * table.size());
+    return true;
+}
+}
+
+bool WriteCookedMesh(const std::filesystem::path& cooked, const std::vector<uint8_t>& image) {
+    std::filesystem::path tmp = cooked; tmp += ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) return false;
+        f.write(reinterpret_cast<const char*>(image.data()), std::streamsize(image.size()));
+        if (!f) return false;
+    }
+    // A loaded mesh may still map the old cache.
+    if (!ReplaceMappedFile(tmp, cooked)) { std::error_code ec; std::filesystem::remove(tmp, ec); return false; }
+    return true;
+}
+
+bool CookedMesh::open(const std::filesystem::path& path) {
+    close();
+    if (!file.open(path)) return false;
+    if (file.size() >= sizeof(GgmeshHeader) && (reinterpret_cast<const GgmeshHeader*>(file.data())->flags & kGgmeshFlagEncodedStreams)) {
+        std::vector<uint8_t> decoded;
+        const bool ok = DecodeCookedMeshImage(file.data(), file.size(), decoded);
+        file.close();
+        return ok && adopt(std::move(decoded));
+    }
+    if (!bind(file.data(), file.size())) { close(); return false; }
+    return true;
+}
+
+bool CookedMesh::adopt(std::vector<uint8_t>&& image) {
+    close();
+    if (image.size() >= sizeof(GgmeshHeader) && (reinterpret_cast<const GgmeshHeader*>(image.data())->flags & kGgmeshFlagEncodedStreams)) {
+        if (!DecodeCookedMeshImage(image.data(), image.size(), ownedImage)) return false;
+    } else ownedImage = std::move(image);
+    if (!bind(ownedImage.data(), ownedImage.size())) { close(); return false; }
+    return true;
+}
+
+void CookedMesh::close() { header = nullptr; streams.clear(); lodTable = nullptr; lodTableCount = 0; file.close(); ownedImage.clear(); }
+
+bool CookedMesh::bind(const uint8_t* data, size_t size) {
+    if (size < sizeof(GgmeshHeader)) return false;
+    const GgmeshHeader* h = reinterpret_cast<const GgmeshHeader*>(data);
+    if (h->magic != kGgmeshMagic || h->version != kGgmeshVersion || (h->flags & kGgmeshFlagEncodedStreams)) return false;
+    if (sizeof(GgmeshHeader) + size_t(h->streamCount) * sizeof(GgmeshStreamEntry) > size) return false;
+    const GgmeshStreamEntry* table = reinterpret_cast<const GgmeshStreamEntry*>(data + sizeof(GgmeshHeader));
+    streams.clear(); streams.reserve(h->streamCount);
+    for (uint32_t i = 0; i < h->streamCount; ++i) {
+        const GgmeshStreamEntry& e = table[i];
+        if (e.offset % kGgmeshAlignment != 0 || e.offset > size || e.byteSize > size - e.offset) return false;
+        streams.push_back({ MeshStreamType(e.type), e.elementSize, data + e.offset, size_t(e.byteSize) });
+    }
+    header = h;
+    const MeshStreamData* p = stream(MeshStreamType::Positions); const MeshStreamData* ix = stream(MeshStreamType::Indices);
+    if (!p || !ix || p->elementSize != sizeof(Float3) || ix->elementSize != sizeof(uint32_t)) { header = nullptr; return false; }
+    if (p->byteSize != size_t(h->vertexCount) * sizeof(Float3) || ix->byteSize != size_t(h->indexCount) * sizeof(uint32_t)) { header = nullptr; return false; }
+    if (const MeshStreamData* n = stream(MeshStreamType::Normals)) if (n->elementSize != sizeof(uint32_t) || n->byteSize != size_t(h->vertexCount) * sizeof(uint32_t)) { header = nullptr; return false; }
+    // Every index must name a vertex: the GPU and the CPU copies made from this mesh read positions through them unchecked.
+    if (h->indexCount % 3 != 0 || !IndicesBelow(indices(), h->indexCount, h->vertexCount)) { header = nullptr; return false; }
+    fallbackLod = { 0, h->indexCount, 0.0f }; lodTable = nullptr; lodTableCount = 1;
+    if (const MeshStreamData* l = stream(MeshStreamType::Lods)) {
+        const uint32_t count = uint32_t(l->byteSize / sizeof(MeshLod));
+        if (l->elementSize != sizeof(MeshLod) || count == 0 || count > kMaxMeshLods) { header = nullptr; return false; }
+        const MeshLod* table = static_cast<const MeshLod*>(l->data);
+        for (uint32_t i = 0; i < count; ++i) if (table[i].indexCount % 3 != 0 || table[i].firstIndex > h->indexCount || table[i].indexCount > h->indexCount - table[i].firstIndex) { header = nullptr; return false; }
+        lodTable = table; lodTableCount = count;
+    }
+    if (const MeshStreamData* c = stream(MeshStreamType::Meshlets)) {
+        const Meshlet* clusters = static_cast<const Meshlet*>(c->data); const size_t count = c->byteSize / sizeof(Meshlet); const uint32_t lod0 = lods()[0].indexCount;
+        if (c->elementSize != sizeof(Meshlet)) { header = nullptr; return false; }
+        for (size_t i = 0; i < count; ++i) { const Meshlet& m = clusters[i];
+            if (m.firstIndex > lod0 || m.indexCount > lod0 - m.firstIndex || m.firstIndex % 3 != 0 || m.indexCount % 3 != 0 || m.indexCount / 3 > kMeshletMaxTriangles) { header = nullptr; return false; }
+            if (m.vertexCount > kMeshletMaxVertices || m.vertexCount > h->vertexCount || m.vertexCount > m.indexCount) { header = nullptr; return false; } }
+    }
+    const MeshStreamData* bn = stream(MeshStreamType::BvhNodes); const MeshStreamData* bt = stream(MeshStreamType::BvhTriangles);
+    if (bn || bt) {
+        if (!bn || !bt || bn->elementSize != sizeof(BvhNode) || bt->elementSize != sizeof(uint32_t)) { header = nullptr; return false; }
+        if (!ValidateMeshBvh(bvhNodes(), bvhNodeCount(), bvhTriangles(), bvhTriangleCount(), lods()[0].indexCount / 3)) { header = nullptr; return false; }
+    }
+    return true;
+}
+
+const MeshStreamData* CookedMesh::stream(MeshStreamType type) const {
+    for (const auto& s : streams) if (s.type == type) return &s;
+    return nullptr;
+}
+
+const Float3* CookedMesh::positions() const { const MeshStreamData* s = stream(MeshStreamType::Positions); return s ? static_cast<const Float3*>(s->data) : nullptr; }
+
+const uint32_t* CookedMesh::normals() const { const MeshStreamData* s = stream(MeshStreamType::Normals); return s ? static_cast<const uint32_t*>(s->data) : nullptr; }
+
+const uint32_t* CookedMesh::indices() const { const MeshStreamData* s = stream(MeshStreamType::Indices); return s ? static_cast<const uint32_t*>(s->data) : nullptr; }
+
+namespace {
+bool CookParsedObjMesh(const std::filesystem::path& source, const SourceFingerprint& fp, ObjMeshData& mesh, CookedMesh& out, MeshCookStats& stats, const MeshCookOptions& options) {
+    if (mesh.positions.empty() || mesh.indices.empty()) return false;
+    stats.optimize = OptimizeMesh(mesh.positions, mesh.indices);
+    std::vector<uint32_t> normals;
+    ComputeVertexNormals(mesh.positions.data(), mesh.positions.size(), mesh.indices.data(), mesh.indices.size(), normals);
+    Aabb bounds{ mesh.positions[0], mesh.positions[0] };
+    for (const Float3& p : mesh.positions) {
+        bounds.min = { std::min(bounds.min.x, p.x), std::min(bounds.min.y, p.y), std::min(bounds.min.z, p.z) };
+        bounds.max = { std::max(bounds.max.x, p.x), std::max(bounds.max.y, p.y), std::max(bounds.max.z, p.z) };
+    }
+    const auto meshletStart = std::chrono::steady_clock::now();
+    std::vector<Meshlet> meshlets;
+    stats.meshletCount = uint32_t(BuildMeshlets(mesh.positions.data(), mesh.positions.size(), mesh.indices.data(), mesh.indices.size(), meshlets));
+    stats.meshletMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - meshletStart).count();
+    const auto lodStart = std::chrono::steady_clock::now();
+    std::vector<MeshLod> lods;
+    BuildLodChain(mesh.positions, mesh.indices, lods);
+    stats.lodCount = uint32_t(lods.size());
+    stats.lodMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lodStart).count();
+    MeshBvh bvh; BvhBuildStats bvhStats;
+    stats.bvhNodeCount = uint32_t(BuildMeshBvh(mesh.positions.data(), mesh.indices.data() + lods[0].firstIndex, lods[0].indexCount, bvh, &bvhStats));
+    stats.bvhMilliseconds = bvhStats.milliseconds;
+    const std::vector<MeshStreamData> streams = {
+        { MeshStreamType::Positions, sizeof(Float3), mesh.positions.data(), mesh.positions.size() * sizeof(Float3) },
+        { MeshStreamType::Normals, sizeof(uint32_t), normals.data(), normals.size() * sizeof(uint32_t) },
+        { MeshStreamType::Indices, sizeof(uint32_t), mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t) },
+        { MeshStreamType::Lods, sizeof(MeshLod), lods.data(), lods.size() * sizeof(MeshLod) },
+        { MeshStreamType::Meshlets, sizeof(Meshlet), meshlets.data(), meshlets.size() * sizeof(Meshlet) },
+        { MeshStreamType::BvhNodes, sizeof(BvhNode), bvh.nodes.data(), bvh.nodes.size() * sizeof(BvhNode) },
+        { MeshStreamType::BvhTriangles, sizeof(uint32_t), bvh.triangles.data(), bvh.triangles.size() * sizeof(uint32_t) },
+    };
+    std::vector<uint8_t> image = BuildCookedMeshImage(fp, streams, bounds);
+    stats.imageBytes = image.size(); stats.encodedBytes = 0;
+    if (options.encodeStreams) { const std::vector<uint8_t> encoded = BuildCookedMeshImage(fp, streams, bounds, kGgmeshFlagEncodedStreams); stats.encodedBytes = encoded.size(); WriteCookedMesh(CookedMeshPath(source), encoded); }
+    // A raw cache is reopened from the file, so a caller that keeps the mesh holds clean file pages rather than heap.
+    else if (WriteCookedMesh(CookedMeshPath(source), image) && out.open(CookedMeshPath(source))) return true;
+    return out.adopt(std::move(image));
+}
+
+bool CookObjText(const std::filesystem::path& source, const char* text, size_t size, int64_t sourceMtime, CookedMesh& out, MeshCookStats& stats, const MeshCookOptions& options, JobSystem* jobs) {
+    ObjMeshData mesh;
+    if (!ParseObjPositionsAndIndices(text, size, mesh, &stats.objLoad, jobs)) return false;
+    const SourceFingerprint fp{ uint64_t(size), sourceMtime, HashMemory(text, size) };
+    return CookParsedObjMesh(source, fp, mesh, out, stats, options);
+}
+}
+
+bool OpenCookedMeshIfValid(const std::filesystem::path& source, CookedMesh& out) {
+    const std::filesystem::path cooked = CookedMeshPath(source);
+    return IsCookedMeshValid(cooked, source) && out.open(cooked);
+}
+
+bool CookObjMeshFromMemory(const std::filesystem::path& source, const char* text, size_t size, int64_t sourceMtime, CookedMesh& out, MeshCookStats* outStats, const MeshCookOptions& options, JobSystem* jobs) {
+    const auto start = std::chrono::steady_clock::now();
+    MeshCookStats stats;
+    if (!CookObjText(source, text, size, sourceMtime, out, stats, options, jobs)) return false;
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (outStats) *outStats = stats;
+    return true;
+}
+
+bool LoadOrCookObjMesh(const std::filesystem::path& source, CookedMesh& out, MeshCookStats* outStats, const MeshCookOptions& options, JobSystem* jobs) {
+    const auto start = std::chrono::steady_clock::now();
+    MeshCookStats stats;
+    if (OpenCookedMeshIfValid(source, out)) {
+        stats.fromCache = true;
+    } else {
+        // One mapping is parsed and hashed, so the cache can never describe a different file than the one cooked.
+        SourceFingerprint fp; MappedFile file;
+        if (!ComputeSourceFingerprint(source, fp, false) || !file.open(source)) return false;
+        if (!CookObjText(source, reinterpret_cast<const char*>(file.data()), file.size(), fp.mtime, out, stats, options, jobs)) return false;
+    }
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (outStats) *outStats = stats;
+    return true;
+}
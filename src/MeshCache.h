@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include "MappedFile.h"
+#include "MathTypes.h"
+#include "MeshBvh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+#include "ObjLoader.h"
+
+constexpr uint32_t kGgmeshMagic = 0x534D4747u;
+constexpr uint32_t kGgmeshVersion = 7;
+constexpr size_t kGgmeshAlignment = 64;
+// Vertex streams and indices are stored with the lossless VertexCodec encodings and decoded on open; see MeshCookOptions.
+constexpr uint32_t kGgmeshFlagEncodedStreams = 1u;
+// Encoded images whose header claims more than this, or more than the codecs could expand to, fail to open.
+constexpr uint64_t kGgmeshMaxDecodedBytes = uint64_t(2) << 30;
+
+// Normals are octahedral SNORM16, one per position. The BVH streams cover the level 0 triangles, for picking.
+enum class MeshStreamType : uint32_t { Positions = 1, Indices = 2, Lods = 3, Meshlets = 4, Normals = 5, BvhNodes = 6, BvhTriangles = 7 };
+
+struct GgmeshHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t streamCount;
+    uint32_t flags;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint64_t sourceHash;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    Aabb bounds;
+    uint32_t reserved[2];
+};
+
+struct GgmeshStreamEntry {
+    uint32_t type;
+    uint32_t elementSize;
+    uint64_t offset;
+    uint64_t byteSize;
+};
+
+static_assert(sizeof(GgmeshHeader) == 80, "ggmesh header layout changed");
+static_assert(sizeof(GgmeshStreamEntry) == 24, "ggmesh stream entry layout changed");
+static_assert(sizeof(MeshLod) == 12, "ggmesh LOD table layout changed");
+static_assert(sizeof(Meshlet) == 56, "ggmesh meshlet layout changed");
+static_assert(sizeof(BvhNode) == 32, "ggmesh BVH node layout changed");
+
+struct SourceFingerprint {
+    uint64_t size{0};
+    int64_t mtime{0};
+    uint64_t hash{0};
+};
+
+struct MeshStreamData {
+    MeshStreamType type;
+    uint32_t elementSize;
+    const void* data;
+    size_t byteSize;
+};
+
+struct MeshCookStats {
+    bool fromCache{false};
+    double milliseconds{0.0};
+    ObjLoadStats objLoad;
+    MeshOptimizeReport optimize;
+    uint32_t lodCount{1};
+    double lodMilliseconds{0.0};
+    uint32_t meshletCount{0};
+    double meshletMilliseconds{0.0};
+    uint32_t bvhNodeCount{0};
+    double bvhMilliseconds{0.0};
+    size_t imageBytes{0};
+    size_t encodedBytes{0};   // zero unless the streams were encoded
+};
+
+// Raw caches are bound straight from the file mapping; encoded ones are smaller on disk but decoded into memory on every open.
+struct MeshCookOptions {
+    bool encodeStreams{false};
+};
+
+bool ComputeSourceFingerprint(const std::filesystem::path& source, SourceFingerprint& out, bool hashContents);
+std::filesystem::path CookedMeshPath(const std::filesystem::path& source);
+bool IsCookedMeshValid(const std::filesystem::path& cooked, const std::filesystem::path& source);
+std::vector<uint8_t> BuildCookedMeshImage(const SourceFingerprint& source, const std::vector<MeshStreamData>& streams, const Aabb& bounds, uint32_t flags = 0);
+bool WriteCookedMesh(const std::filesystem::path& cooked, const std::vector<uint8_t>& image);
+
+class CookedMesh {
+public:
+    bool open(const std::filesystem::path& path);
+    bool adopt(std::vector<uint8_t>&& image);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+    const GgmeshHeader& info() const { return *header; }
+    const MeshStreamData* stream(MeshStreamType type) const;
+    const Float3* positions() const;
+    const uint32_t* normals() const;
+    const uint32_t* indices() const;
+    uint32_t vertexCount() const { return header ? header->vertexCount : 0; }
+    uint32_t indexCount() const { return header ? header->indexCount : 0; }
+    // Level 0 covers the source triangles; coarser levels follow it in the same index stream.
+    const MeshLod* lods() const { return lodTable ? lodTable : &fallbackLod; }
+    uint32_t lodCount() const { return lodTableCount; }
+    // Clusters partition the level 0 index range.
+    const Meshlet* meshlets() const { const MeshStreamData* s = stream(MeshStreamType::Meshlets); return s ? static_cast<const Meshlet*>(s->data) : nullptr; }
+    uint32_t meshletCount() const { const MeshStreamData* s = stream(MeshStreamType::Meshlets); return s ? uint32_t(s->byteSize / sizeof(Meshlet)) : 0; }
+    // Triangle BVH over level 0; triangle ids count from lods()[0].firstIndex.
+    const BvhNode* bvhNodes() const { const MeshStreamData* s = stream(MeshStreamType::BvhNodes); return s ? static_cast<const BvhNode*>(s->data) : nullptr; }
+    uint32_t bvhNodeCount() const { const MeshStreamData* s = stream(MeshStreamType::BvhNodes); return s ? uint32_t(s->byteSize / sizeof(BvhNode)) : 0; }
+    const uint32_t* bvhTriangles() const { const MeshStreamData* s = stream(MeshStreamType::BvhTriangles); return s ? static_cast<const uint32_t*>(s->data) : nullptr; }
+    uint32_t bvhTriangleCount() const { const MeshStreamData* s = stream(MeshStreamType::BvhTriangles); return s ? uint32_t(s->byteSize / sizeof(uint32_t)) : 0; }
+
+private:
+    bool bind(const uint8_t* data, size_t size);
+
+    MappedFile file;
+    std::vector<uint8_t> ownedImage;
+    const GgmeshHeader* header{nullptr};
+    std::vector<MeshStreamData> streams;
+    MeshLod fallbackLod;
+    const MeshLod* lodTable{nullptr};
+    uint32_t lodTableCount{0};
+};
+
+bool OpenCookedMeshIfValid(const std::filesystem::path& source, CookedMesh& out);
+// The cache is stamped with the text's own size and hash; sourceMtime must be read before the text so a later edit always
+// fails the mtime check and gets rehashed.
+// jobs, when given, parse the OBJ text in parallel.
+bool CookObjMeshFromMemory(const std::filesystem::path& source, const char* text, size_t size, int64_t sourceMtime, CookedMesh& out, MeshCookStats* outStats = nullptr, const MeshCookOptions& options = {}, JobSystem* jobs = nullptr);
+bool LoadOrCookObjMesh(const std::filesystem::path& source, CookedMesh& out, MeshCookStats* outStats = nullptr, const MeshCookOptions& options = {}, JobSystem* jobs = nullptr);
@@ -0,0 +1,172 @@
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+#include "VertexCodec.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+constexpr int kForsythCacheSize = 32;
+constexpr uint32_t kUnmapped = std::numeric_limits<uint32_t>::max();
+
+uint64_t HashBytes(const uint8_t* p, size_t n) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    return h ^ (h >> 29);
+}
+
+float ForsythVertexScore(int cachePos, uint32_t liveTriangles) {
+    if (liveTriangles == 0) return -1.0f;
+    float score = 0.0f;
+    if (cachePos >= 0) score = cachePos < 3 ? 0.75f : std::pow(1.0f - float(cachePos - 3) / float(kForsythCacheSize - 3), 1.5f);
+    return score + 2.0f / std::sqrt(float(liveTriangles));
+}
+}
+
+size_t BuildVertexWeldRemap(const void* vertices, size_t vertexCount, size_t stride, std::vector<uint32_t>& outRemap) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+    size_t tableSize = 1; while (tableSize < vertexCount * 2) tableSize <<= 1;
+    std::vector<uint32_t> table(tableSize, kUnmapped);
+    outRemap.assign(vertexCount, kUnmapped);
+    size_t unique = 0;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const uint8_t* vb = bytes + v * stride;
+        size_t slot = size_t(HashBytes(vb, stride)) & (tableSize - 1);
+        for (;;) {
+            const uint32_t existing = table[slot];
+            if (existing == kUnmapped) { table[slot] = uint32_t(v); outRemap[v] = uint32_t(unique++); break; }
+            if (memcmp(bytes + size_t(existing) * stride, vb, stride) == 0) { outRemap[v] = outRemap[existing]; break; }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+    }
+    return unique;
+}
+
+size_t BuildVertexFetchRemap(const uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& outRemap) {
+    outRemap.assign(vertexCount, kUnmapped);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i) if (outRemap[indices[i]] == kUnmapped) outRemap[indices[i]] = next++;
+    return next;
+}
+
+void RemapIndices(uint32_t* indices, size_t indexCount, const std::vector<uint32_t>& remap) {
+    for (size_t i = 0; i < indexCount; ++i) indices[i] = remap[indices[i]];
+}
+
+void RemapVertexStream(void* dst, const void* src, size_t vertexCount, size_t stride, const std::vector<uint32_t>& remap) {
+    uint8_t* d = static_cast<uint8_t*>(dst); const uint8_t* s = static_cast<const uint8_t*>(src);
+    for (size_t v = 0; v < vertexCount; ++v) if (remap[v] != kUnmapped) memcpy(d + size_t(remap[v]) * stride, s + v * stride, stride);
+}
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    const size_t triCount = indexCount / 3;
+    if (triCount == 0) return;
+    const std::vector<uint32_t> src(indices, indices + triCount * 3);
+    std::vector<uint32_t> live(vertexCount, 0), offsets(vertexCount + 1, 0);
+    for (uint32_t v : src) ++live[v];
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + live[v];
+    std::vector<uint32_t> adjacency(src.size()), fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triCount; ++t) for (int k = 0; k < 3; ++k) adjacency[fill[src[t * 3 + k]]++] = uint32_t(t);
+
+    std::vector<int> cachePos(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount), triScore(triCount);
+    std::vector<char> emitted(triCount, 0);
+    for (size_t v = 0; v < vertexCount; ++v) vertexScore[v] = ForsythVertexScore(-1, live[v]);
+    for (size_t t = 0; t < triCount; ++t) triScore[t] = vertexScore[src[t * 3]] + vertexScore[src[t * 3 + 1]] + vertexScore[src[t * 3 + 2]];
+
+    uint32_t cache[kForsythCacheSize + 3]; int cacheCount = 0;
+    size_t written = 0, scanCursor = 0;
+    int64_t best = -1;
+    while (written < triCount) {
+        if (best < 0) { while (emitted[scanCursor]) ++scanCursor; best = int64_t(scanCursor); }
+        const uint32_t* tri = &src[size_t(best) * 3];
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t v = tri[k];
+            indices[written * 3 + k] = v;
+            uint32_t* adj = &adjacency[offsets[v]];
+            for (uint32_t a = 0; a < live[v]; ++a) if (adj[a] == uint32_t(best)) { adj[a] = adj[live[v] - 1]; break; }
+            --live[v];
+        }
+        emitted[size_t(best)] = 1; ++written;
+
+        uint32_t next[kForsythCacheSize + 3]; int nextCount = 0;
+        for (int k = 0; k < 3; ++k) { bool dup = false; for (int j = 0; j < nextCount; ++j) dup |= next[j] == tri[k]; if (!dup) next[nextCount++] = tri[k]; }
+        for (int i = 0; i < cacheCount; ++i) { const uint32_t v = cache[i]; if (v != tri[0] && v != tri[1] && v != tri[2]) next[nextCount++] = v; }
+        for (int i = 0; i < nextCount; ++i) {
+            const uint32_t v = next[i];
+            cachePos[v] = i < kForsythCacheSize ? i : -1;
+            vertexScore[v] = ForsythVertexScore(cachePos[v], live[v]);
+        }
+        cacheCount = nextCount < kForsythCacheSize ? nextCount : kForsythCacheSize;
+        memcpy(cache, next, sizeof(uint32_t) * size_t(cacheCount));
+
+        best = -1; float bestScore = -std::numeric_limits<float>::max();
+        for (int i = 0; i < nextCount; ++i) {
+            const uint32_t v = next[i];
+            for (uint32_t a = 0; a < live[v]; ++a) {
+                const uint32_t t = adjacency[offsets[v] + a];
+                const float s = vertexScore[src[t * 3]] + vertexScore[src[t * 3 + 1]] + vertexScore[src[t * 3 + 2]];
+                triScore[t] = s;
+                if (s > bestScore) { bestScore = s; best = int64_t(t); }
+            }
+        }
+    }
+}
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize) {
+    VertexCacheStats stats;
+    const size_t triCount = indexCount / 3;
+    if (triCount == 0 || cacheSize == 0) return stats;
+    std::vector<uint32_t> stamp(vertexCount, 0);
+    std::vector<char> referenced(vertexCount, 0);
+    uint32_t time = cacheSize + 1; size_t misses = 0, unique = 0;
+    for (size_t i = 0; i < triCount * 3; ++i) {
+        const uint32_t v = indices[i];
+        if (!referenced[v]) { referenced[v] = 1; ++unique; }
+        if (time - stamp[v] > cacheSize) { stamp[v] = time++; ++misses; }
+    }
+    stats.acmr = float(misses) / float(triCount);
+    stats.atvr = float(misses) / float(unique);
+    return stats;
+}
+
+MeshOptimizeReport OptimizeMesh(std::vector<Float3>& positions, std::vector<uint32_t>& indices) {
+    PROFILE_ZONE("OptimizeMesh");
+    MeshOptimizeReport report;
+    report.inputVertices = positions.size();
+    report.triangles = indices.size() / 3;
+    report.before = AnalyzeVertexCache(indices.data(), indices.size(), positions.size());
+
+    std::vector<uint32_t> remap;
+    size_t unique = BuildVertexWeldRemap(positions.data(), positions.size(), sizeof(Float3), remap);
+    RemapIndices(indices.data(), indices.size(), remap);
+    std::vector<Float3> welded(unique);
+    RemapVertexStream(welded.data(), positions.data(), positions.size(), sizeof(Float3), remap);
+
+    OptimizeVertexCache(indices.data(), indices.size(), welded.size());
+
+    unique = BuildVertexFetchRemap(indices.data(), indices.size(), welded.size(), remap);
+    RemapIndices(indices.data(), indices.size(), remap);
+    positions.assign(unique, Float3{});
+    RemapVertexStream(positions.data(), welded.data(), welded.size(), sizeof(Float3), remap);
+
+    report.outputVertices = positions.size();
+    report.after = AnalyzeVertexCache(indices.data(), indices.size(), positions.size());
+    return report;
+}
+
+void ComputeVertexNormals(const Float3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, std::vector<uint32_t>& outNormals) {
+    PROFILE_ZONE("ComputeVertexNormals");
+    std::vector<Float3> sums(vertexCount);
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        const Float3& a = positions[indices[i]]; const Float3& b = positions[indices[i + 1]]; const Float3& c = positions[indices[i + 2]];
+        const Float3 e0{ b.x - a.x, b.y - a.y, b.z - a.z }, e1{ c.x - a.x, c.y - a.y, c.z - a.z };
+        const Float3 n{ e0.y * e1.z - e0.z * e1.y, e0.z * e1.x - e0.x * e1.z, e0.x * e1.y - e0.y * e1.x };
+        for (size_t k = 0; k < 3; ++k) { Float3& s = sums[indices[i + k]]; s.x += n.x; s.y += n.y; s.z += n.z; }
+    }
+    outNormals.resize(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const Float3& s = sums[v]; const float length = std::sqrt(s.x * s.x + s.y * s.y + s.z * s.z);
+        outNormals[v] = EncodeOctahedral(length > 0.0f ? Float3{ s.x / length, s.y / length, s.z / length } : Float3{ 0.0f, 1.0f, 0.0f });
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+struct VertexCacheStats {
+    float acmr{0.0f};
+    float atvr{0.0f};
+};
+
+struct MeshOptimizeReport {
+    size_t inputVertices{0};
+    size_t outputVertices{0};
+    size_t triangles{0};
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+size_t BuildVertexWeldRemap(const void* vertices, size_t vertexCount, size_t stride, std::vector<uint32_t>& outRemap);
+size_t BuildVertexFetchRemap(const uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& outRemap);
+void RemapIndices(uint32_t* indices, size_t indexCount, const std::vector<uint32_t>& remap);
+void RemapVertexStream(void* dst, const void* src, size_t vertexCount, size_t stride, const std::vector<uint32_t>& remap);
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize = 16);
+MeshOptimizeReport OptimizeMesh(std::vector<Float3>& positions, std::vector<uint32_t>& indices);
+// Smooth per-vertex normals, each the area-weighted sum of its triangles' face normals, as octahedral SNORM16.
+void ComputeVertexNormals(const Float3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, std::vector<uint32_t>& outNormals);
@@ -0,0 +1,175 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+struct Quadric {
+    double a00{0}, a01{0}, a02{0}, a11{0}, a12{0}, a22{0}, b0{0}, b1{0}, b2{0}, c{0}, w{0};
+    void addPlane(double nx, double ny, double nz, double d, double weight) {
+        a00 += weight * nx * nx; a01 += weight * nx * ny; a02 += weight * nx * nz; a11 += weight * ny * ny; a12 += weight * ny * nz; a22 += weight * nz * nz;
+        b0 += weight * nx * d; b1 += weight * ny * d; b2 += weight * nz * d; c += weight * d * d; w += weight;
+    }
+    void add(const Quadric& q) { a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22; b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; w += q.w; }
+};
+
+double QuadricError(const Quadric& a, const Quadric& b, const Float3& p) {
+    const double x = p.x, y = p.y, z = p.z;
+    const double r = (a.a00 + b.a00) * x * x + (a.a11 + b.a11) * y * y + (a.a22 + b.a22) * z * z
+        + 2.0 * ((a.a01 + b.a01) * x * y + (a.a02 + b.a02) * x * z + (a.a12 + b.a12) * y * z)
+        + 2.0 * ((a.b0 + b.b0) * x + (a.b1 + b.b1) * y + (a.b2 + b.b2) * z) + (a.c + b.c);
+    const double w = a.w + b.w;
+    return w > 0.0 ? std::fabs(r) / w : 0.0;
+}
+
+Float3 Sub(const Float3& a, const Float3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+Float3 Cross(const Float3& a, const Float3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+enum VertexKind : uint8_t { kManifold, kBorder, kLocked };
+constexpr double kBorderWeight = 10.0;
+
+struct Collapse { double cost; uint32_t from; uint32_t to; };
+}
+
+size_t SimplifyMesh(const Float3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float maxError, std::vector<uint32_t>& outIndices, SimplifyStats* outStats) {
+    const auto start = std::chrono::steady_clock::now();
+    outIndices.assign(indices, indices + indexCount);
+    SimplifyStats stats; stats.inputTriangles = indexCount / 3;
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t + 2 < indexCount; t += 3) {
+        const Float3& p0 = positions[indices[t]]; const Float3& p1 = positions[indices[t + 1]]; const Float3& p2 = positions[indices[t + 2]];
+        const Float3 n = Cross(Sub(p1, p0), Sub(p2, p0)); const float len = std::sqrt(Dot(n, n));
+        if (len <= 0.0f) continue;
+        const double nx = n.x / len, ny = n.y / len, nz = n.z / len, d = -(nx * p0.x + ny * p0.y + nz * p0.z), area = 0.5 * len;
+        for (int k = 0; k < 3; ++k) quadrics[indices[t + k]].addPlane(nx, ny, nz, d, area);
+    }
+
+    std::vector<uint64_t> halfEdges; std::vector<uint8_t> kind(vertexCount); std::vector<uint32_t> triOffsets(vertexCount + 1), triList;
+    std::vector<Collapse> candidates; std::vector<uint8_t> locked(vertexCount); std::vector<uint32_t> remap(vertexCount);
+    const double maxCost = double(maxError) * double(maxError);
+    double worst = 0.0;
+    bool borderQuadricsAdded = false;
+    while (outIndices.size() > targetIndexCount && stats.passes < 64) {
+        ++stats.passes;
+        const size_t triCount = outIndices.size() / 3;
+        halfEdges.clear(); halfEdges.reserve(outIndices.size());
+        for (size_t t = 0; t < triCount; ++t) for (int k = 0; k < 3; ++k) halfEdges.push_back((uint64_t(outIndices[t * 3 + k]) << 32) | outIndices[t * 3 + (k + 1) % 3]);
+        std::sort(halfEdges.begin(), halfEdges.end());
+        std::fill(kind.begin(), kind.end(), uint8_t(kManifold));
+        auto hasHalfEdge = [&](uint32_t a, uint32_t b) { return std::binary_search(halfEdges.begin(), halfEdges.end(), (uint64_t(a) << 32) | b); };
+        for (size_t i = 0; i < halfEdges.size(); ++i) {
+            const uint32_t a = uint32_t(halfEdges[i] >> 32), b = uint32_t(halfEdges[i]);
+            if (i + 1 < halfEdges.size() && halfEdges[i + 1] == halfEdges[i]) { kind[a] = kind[b] = kLocked; continue; }
+            if (!hasHalfEdge(b, a)) { kind[a] = std::max<uint8_t>(kind[a], kBorder); kind[b] = std::max<uint8_t>(kind[b], kBorder); }
+        }
+        if (!borderQuadricsAdded) {
+            // Constrain border vertices to a plane through each open edge, perpendicular to its face.
+            for (size_t t = 0; t < triCount; ++t) {
+                const uint32_t* tri = &outIndices[t * 3];
+                const Float3 fn = Cross(Sub(positions[tri[1]], positions[tri[0]]), Sub(positions[tri[2]], positions[tri[0]]));
+                for (int k = 0; k < 3; ++k) {
+                    const uint32_t a = tri[k], b = tri[(k + 1) % 3];
+                    if (hasHalfEdge(b, a)) continue;
+                    const Float3 e = Sub(positions[b], positions[a]); const Float3 n = Cross(e, fn); const float len = std::sqrt(Dot(n, n));
+                    if (len <= 0.0f) continue;
+                    const double nx = n.x / len, ny = n.y / len, nz = n.z / len, d = -(nx * positions[a].x + ny * positions[a].y + nz * positions[a].z);
+                    const double weight = kBorderWeight * Dot(e, e);
+                    quadrics[a].addPlane(nx, ny, nz, d, weight); quadrics[b].addPlane(nx, ny, nz, d, weight);
+                }
+            }
+        }
+        borderQuadricsAdded = true;
+
+        std::fill(triOffsets.begin(), triOffsets.end(), 0u);
+        for (uint32_t v : outIndices) ++triOffsets[v + 1];
+        for (size_t v = 0; v < vertexCount; ++v) triOffsets[v + 1] += triOffsets[v];
+        triList.resize(outIndices.size());
+        { std::vector<uint32_t> cursor(triOffsets.begin(), triOffsets.end() - 1); for (size_t i = 0; i < outIndices.size(); ++i) triList[cursor[outIndices[i]]++] = uint32_t(i / 3); }
+
+        candidates.clear();
+        for (size_t i = 0; i < halfEdges.size(); ++i) {
+            if (i > 0 && halfEdges[i] == halfEdges[i - 1]) continue;
+            const uint32_t a = uint32_t(halfEdges[i] >> 32), b = uint32_t(halfEdges[i]);
+            const bool border = !hasHalfEdge(b, a);
+            if (!border && a > b) continue;
+            const bool ab = kind[a] == kManifold || (kind[a] == kBorder && border && kind[b] != kManifold);
+            const bool ba = kind[b] == kManifold || (kind[b] == kBorder && border && kind[a] != kManifold);
+            const double cab = ab ? QuadricError(quadrics[a], quadrics[b], positions[b]) : 1e300;
+            const double cba = ba ? QuadricError(quadrics[a], quadrics[b], positions[a]) : 1e300;
+            if (!ab && !ba) continue;
+            candidates.push_back(cab <= cba ? Collapse{ cab, a, b } : Collapse{ cba, b, a });
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        std::fill(locked.begin(), locked.end(), uint8_t(0));
+        for (uint32_t v = 0; v < vertexCount; ++v) remap[v] = v;
+        const size_t targetTris = targetIndexCount / 3;
+        size_t removed = 0, collapses = 0;
+        for (const Collapse& c : candidates) {
+            if (c.cost > maxCost || triCount - removed <= targetTris) break;
+            if (locked[c.from] || locked[c.to]) continue;
+            bool flips = false; size_t shared = 0;
+            for (uint32_t k = triOffsets[c.from]; k < triOffsets[c.from + 1] && !flips; ++k) {
+                const uint32_t* tri = &outIndices[size_t(triList[k]) * 3];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) { ++shared; continue; }
+                Float3 p[3], q[3];
+                for (int j = 0; j < 3; ++j) { p[j] = positions[tri[j]]; q[j] = tri[j] == c.from ? positions[c.to] : p[j]; }
+                const Float3 n0 = Cross(Sub(p[1], p[0]), Sub(p[2], p[0])), n1 = Cross(Sub(q[1], q[0]), Sub(q[2], q[0]));
+                flips = Dot(n0, n1) <= 0.25f * std::sqrt(Dot(n0, n0) * Dot(n1, n1));
+            }
+            if (flips) continue;
+            remap[c.from] = c.to; quadrics[c.to].add(quadrics[c.from]); worst = std::max(worst, c.cost);
+            for (uint32_t k = triOffsets[c.from]; k < triOffsets[c.from + 1]; ++k) { const uint32_t* tri = &outIndices[size_t(triList[k]) * 3]; locked[tri[0]] = locked[tri[1]] = locked[tri[2]] = 1; }
+            removed += shared; ++collapses;
+        }
+        if (collapses == 0) break;
+
+        size_t write = 0;
+        for (size_t t = 0; t < triCount; ++t) {
+            const uint32_t a = remap[outIndices[t * 3]], b = remap[outIndices[t * 3 + 1]], c = remap[outIndices[t * 3 + 2]];
+            if (a == b || b == c || a == c) continue;
+            outIndices[write++] = a; outIndices[write++] = b; outIndices[write++] = c;
+        }
+        outIndices.resize(write);
+    }
+    stats.outputTriangles = outIndices.size() / 3; stats.error = float(std::sqrt(worst));
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (outStats) *outStats = stats;
+    return outIndices.size();
+}
+
+void BuildLodChain(const std::vector<Float3>& positions, std::vector<uint32_t>& indices, std::vector<MeshLod>& outLods, float maxRelativeError) {
+    PROFILE_ZONE("BuildLodChain");
+    outLods.assign(1, MeshLod{ 0, uint32_t(indices.size()), 0.0f });
+    if (positions.empty()) return;
+    Float3 lo = positions[0], hi = positions[0];
+    for (const Float3& p : positions) { lo = { std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z) }; hi = { std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z) }; }
+    const Float3 extent = Sub(hi, lo); const float maxError = std::sqrt(Dot(extent, extent)) * maxRelativeError;
+    std::vector<uint32_t> current(indices), next;
+    float error = 0.0f;
+    while (outLods.size() < kMaxMeshLods && current.size() / 3 >= 64) {
+        SimplifyStats stats;
+        SimplifyMesh(positions.data(), positions.size(), current.data(), current.size(), current.size() / 6 * 3, maxError, next, &stats);
+        if (next.empty() || next.size() * 20 > current.size() * 17) break;
+        error += stats.error;
+        OptimizeVertexCache(next.data(), next.size(), positions.size());
+        outLods.push_back({ uint32_t(indices.size()), uint32_t(next.size()), error });
+        indices.insert(indices.end(), next.begin(), next.end());
+        current.swap(next);
+    }
+}
+
+uint32_t SelectLod(const MeshLod* lods, uint32_t lodCount, float pixelsPerUnit, float thresholdPixels, uint32_t currentLod, float hysteresis) {
+    uint32_t allowed = 0, relaxed = 0;
+    for (uint32_t i = 1; i < lodCount; ++i) {
+        const float projected = lods[i].error * pixelsPerUnit;
+        if (projected <= thresholdPixels) allowed = i;
+        if (projected <= thresholdPixels * (1.0f - hysteresis)) relaxed = i;
+    }
+    currentLod = std::min(currentLod, lodCount ? lodCount - 1 : 0);
+    if (currentLod > allowed) return allowed;
+    return std::max(currentLod, relaxed);
+}
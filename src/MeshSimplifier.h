@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+constexpr uint32_t kMaxMeshLods = 8;
+
+struct MeshLod {
+    uint32_t firstIndex{0};
+    uint32_t indexCount{0};
+    float error{0.0f};
+};
+
+struct SimplifyStats {
+    size_t inputTriangles{0};
+    size_t outputTriangles{0};
+    float error{0.0f};
+    uint32_t passes{0};
+    double milliseconds{0.0};
+};
+
+// Quadric-error edge collapse that only rewrites indices, so every level shares the source vertex buffer.
+// Stops at targetIndexCount or before a collapse whose error (object-space distance) would exceed maxError.
+size_t SimplifyMesh(const Float3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float maxError, std::vector<uint32_t>& outIndices, SimplifyStats* outStats = nullptr);
+
+// Appends coarser levels to `indices` after LOD 0; each level's error is cumulative relative to LOD 0.
+void BuildLodChain(const std::vector<Float3>& positions, std::vector<uint32_t>& indices, std::vector<MeshLod>& outLods, float maxRelativeError = 0.05f);
+
+// Picks the coarsest level whose projected error stays under thresholdPixels; switching coarser needs
+// a (1 - hysteresis) margin so meshes near a boundary do not flicker between levels.
+uint32_t SelectLod(const MeshLod* lods, uint32_t lodCount, float pixelsPerUnit, float thresholdPixels, uint32_t currentLod, float hysteresis = 0.25f);
@@ -0,0 +1,111 @@
+#include "Meshlet.h"
+#include "Bounds.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+Float3 Sub(const Float3& a, const Float3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+Float3 Cross(const Float3& a, const Float3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+void FinishMeshlet(const Float3* positions, const uint32_t* indices, const std::vector<uint32_t>& vertices, Meshlet& m) {
+    std::vector<Float3> points(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) points[i] = positions[vertices[i]];
+    m.bounds = ComputeBoundingSphere(points.data(), points.size());
+    m.vertexCount = uint32_t(vertices.size());
+
+    Float3 axis{ 0, 0, 0 }; std::vector<std::pair<Float3, Float3>> planes; planes.reserve(m.indexCount / 3);
+    for (uint32_t t = m.firstIndex; t < m.firstIndex + m.indexCount; t += 3) {
+        const Float3& p0 = positions[indices[t]];
+        const Float3 n = Cross(Sub(positions[indices[t + 1]], p0), Sub(positions[indices[t + 2]], p0)); const float len = std::sqrt(Dot(n, n));
+        if (len <= 0.0f) continue;
+        const Float3 unit{ n.x / len, n.y / len, n.z / len };
+        planes.push_back({ p0, unit }); axis = { axis.x + unit.x, axis.y + unit.y, axis.z + unit.z };
+    }
+    const float axisLen = std::sqrt(Dot(axis, axis));
+    m.coneCutoff = 2.0f;
+    if (planes.empty() || axisLen <= 0.0f) return;
+    axis = { axis.x / axisLen, axis.y / axisLen, axis.z / axisLen };
+    float minDot = 1.0f;
+    for (const auto& [p0, n] : planes) minDot = std::min(minDot, Dot(n, axis));
+    if (minDot <= 0.1f) return;
+    // Move the apex back along the axis until it lies behind every triangle plane.
+    float maxT = 0.0f;
+    for (const auto& [p0, n] : planes) maxT = std::max(maxT, Dot(Sub(m.bounds.center, p0), n) / Dot(axis, n));
+    m.coneAxis = axis; m.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    m.coneApex = { m.bounds.center.x - axis.x * maxT, m.bounds.center.y - axis.y * maxT, m.bounds.center.z - axis.z * maxT };
+}
+}
+
+size_t BuildMeshlets(const Float3* positions, size_t vertexCount, uint32_t* indices, size_t indexCount, std::vector<Meshlet>& outMeshlets, uint32_t maxVertices, uint32_t maxTriangles) {
+    PROFILE_ZONE("BuildMeshlets");
+    outMeshlets.clear();
+    const size_t triCount = indexCount / 3;
+    if (triCount == 0 || maxVertices < 3 || maxTriangles == 0) return 0;
+    const std::vector<uint32_t> src(indices, indices + triCount * 3);
+    std::vector<uint32_t> offsets(vertexCount + 1, 0), adjacency(src.size());
+    for (uint32_t v : src) ++offsets[v + 1];
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+    { std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1); for (size_t i = 0; i < src.size(); ++i) adjacency[fill[src[i]]++] = uint32_t(i / 3); }
+
+    constexpr uint32_t kNone = ~0u;
+    std::vector<uint32_t> live(vertexCount, 0); for (uint32_t v : src) ++live[v];
+    std::vector<uint32_t> owner(vertexCount, kNone); std::vector<char> emitted(triCount, 0);
+    std::vector<uint32_t> vertices; vertices.reserve(maxVertices);
+    Meshlet current; size_t written = 0, cursor = 0; uint32_t last = kNone;
+    auto newVertices = [&](uint32_t t) {
+        const uint32_t* tri = &src[size_t(t) * 3]; const uint32_t id = uint32_t(outMeshlets.size());
+        return uint32_t(owner[tri[0]] != id) + uint32_t(owner[tri[1]] != id && tri[1] != tri[0]) + uint32_t(owner[tri[2]] != id && tri[2] != tri[0] && tri[2] != tri[1]);
+    };
+    auto bestAround = [&](const uint32_t* verts, size_t count) {
+        // Fewest new vertices first, then the triangle whose vertices have the fewest triangles left so fans close up.
+        uint32_t best = kNone, bestScore = ~0u;
+        for (size_t i = 0; i < count; ++i) for (uint32_t a = offsets[verts[i]]; a < offsets[verts[i] + 1]; ++a) {
+            const uint32_t t = adjacency[a];
+            if (emitted[t]) continue;
+            const uint32_t* tri = &src[size_t(t) * 3];
+            const uint32_t score = (newVertices(t) << 16) + std::min(live[tri[0]] + live[tri[1]] + live[tri[2]], 0xFFFFu);
+            if (score < bestScore) { bestScore = score; best = t; }
+        }
+        return best;
+    };
+    while (written < triCount) {
+        uint32_t t = last == kNone ? kNone : bestAround(&src[size_t(last) * 3], 3);
+        if ((t == kNone || newVertices(t) > 0) && !vertices.empty()) t = bestAround(vertices.data(), vertices.size());
+        if (t == kNone) { while (emitted[cursor]) ++cursor; t = uint32_t(cursor); }
+        if (current.indexCount / 3 + 1 > maxTriangles || vertices.size() + newVertices(t) > maxVertices) {
+            FinishMeshlet(positions, indices, vertices, current); outMeshlets.push_back(current);
+            current = Meshlet{}; current.firstIndex = uint32_t(written * 3); vertices.clear(); last = kNone;
+            continue;
+        }
+        for (int k = 0; k < 3; ++k) { const uint32_t v = src[size_t(t) * 3 + k]; indices[written * 3 + k] = v; if (owner[v] != uint32_t(outMeshlets.size())) { owner[v] = uint32_t(outMeshlets.size()); vertices.push_back(v); } }
+        for (int k = 0; k < 3; ++k) --live[src[size_t(t) * 3 + k]];
+        emitted[t] = 1; ++written; current.indexCount += 3; last = t;
+    }
+    FinishMeshlet(positions, indices, vertices, current); outMeshlets.push_back(current);
+    return outMeshlets.size();
+}
+
+size_t CullMeshlets(const Meshlet* meshlets, size_t count, const Frustum& frustum, const Float3& eye, bool cullBackfaces, std::vector<MeshletRange>& outRanges, ClusterCullStats* outStats) {
+    ClusterCullStats stats; stats.clusters = uint32_t(count);
+    // Callers keep one list per instance slot while the mesh in a slot changes from frame to frame; reserving the bound
+    // up front lets every slot reach its final size at once instead of growing whenever a busier view lands there.
+    outRanges.clear(); outRanges.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Meshlet& m = meshlets[i];
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; ++p) { const Float4& pl = frustum.planes[p]; outside = pl.x * m.bounds.center.x + pl.y * m.bounds.center.y + pl.z * m.bounds.center.z + pl.w < -m.bounds.radius; }
+        if (outside) { ++stats.frustumCulled; continue; }
+        if (cullBackfaces && m.coneCutoff <= 1.0f) {
+            const Float3 v = Sub(m.coneApex, eye); const float len = std::sqrt(Dot(v, v));
+            if (Dot(v, m.coneAxis) >= m.coneCutoff * len) { ++stats.backfaceCulled; continue; }
+        }
+        if (!outRanges.empty() && outRanges.back().firstIndex + outRanges.back().indexCount == m.firstIndex) outRanges.back().indexCount += m.indexCount;
+        else outRanges.push_back({ m.firstIndex, m.indexCount });
+    }
+    stats.ranges = uint32_t(outRanges.size());
+    if (outStats) *outStats = stats;
+    return outRanges.size();
+}
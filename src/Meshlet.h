@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Frustum.h"
+#include "MathTypes.h"
+
+constexpr uint32_t kMeshletMaxVertices = 64;
+constexpr uint32_t kMeshletMaxTriangles = 124;
+
+// A contiguous run of triangles in the mesh index stream. The normal cone is disabled (coneCutoff > 1)
+// when its triangles face too many directions for a single backface test.
+struct Meshlet {
+    uint32_t firstIndex{0};
+    uint32_t indexCount{0};
+    uint32_t vertexCount{0};
+    Sphere bounds{};
+    Float3 coneApex{};
+    Float3 coneAxis{};
+    float coneCutoff{2.0f};
+};
+
+struct MeshletRange {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+struct ClusterCullStats {
+    uint32_t clusters{0};
+    uint32_t frustumCulled{0};
+    uint32_t backfaceCulled{0};
+    uint32_t ranges{0};
+    void add(const ClusterCullStats& o) { clusters += o.clusters; frustumCulled += o.frustumCulled; backfaceCulled += o.backfaceCulled; ranges += o.ranges; }
+};
+
+// Reorders indices[0, indexCount) so each meshlet owns a contiguous range; triangles are grown greedily
+// across shared vertices so clusters stay spatially compact.
+size_t BuildMeshlets(const Float3* positions, size_t vertexCount, uint32_t* indices, size_t indexCount, std::vector<Meshlet>& outMeshlets, uint32_t maxVertices = kMeshletMaxVertices, uint32_t maxTriangles = kMeshletMaxTriangles);
+
+// Frustum planes and eye are in the mesh's object space; surviving neighbours are merged into one range.
+size_t CullMeshlets(const Meshlet* meshlets, size_t count, const Frustum& frustum, const Float3& eye, bool cullBackfaces, std::vector<MeshletRange>& outRanges, ClusterCullStats* outStats = nullptr);
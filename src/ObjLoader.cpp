@@ -1,46 +1,143 @@
 #include "ObjLoader.h"
-#include <fstream>
-#include <sstream>
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 
-static inline bool ParseUInt(const char* s, size_t& i, uint32_t& out) {
-    uint32_t v = 0; size_t start = i; while (s[i] >= '0' && s[i] <= '9') { v = v * 10 + (uint32_t)(s[i]-'0'); ++i; }
-    if (i == start) return false; out = v; return true;
-}
+namespace {
+constexpr size_t kMinChunkBytes = size_t(1) << 20;
+
+// A negative face index resolved against the chunk's own vertices; below zero it names one from an earlier chunk.
+struct RelativeIndex {
+    uint32_t slot;
+    int64_t local;
+};
 
-bool LoadObjPositionsAndIndices(const std::wstring& path, ObjMeshData& outMesh) {
-    std::ifstream f(path);
-    if (!f) return false;
-    std::string line;
-    std::vector<DirectX::XMFLOAT3> positions;
+struct ObjChunk {
+    const char* begin{nullptr};
+    const char* end{nullptr};
+    std::vector<Float3> positions;
     std::vector<uint32_t> indices;
-    positions.reserve(1024);
-    indices.reserve(2048);
-    while (std::getline(f, line)) {
-        if (line.size() < 2) continue;
-        if (line[0] == 'v' && line[1] == ' ') {
-            std::istringstream ss(line.substr(2));
-            float x,y,z; ss >> x >> y >> z; positions.emplace_back(x,y,z);
-        } else if (line[0] == 'f' && line[1] == ' ') {
-            const char* s = line.c_str() + 2;
-            uint32_t v[4]{}; int count = 0;
-            while (*s && count < 4) {
-                while (*s == ' ') ++s;
-                size_t i = 0; uint32_t a=0; uint32_t b=0; uint32_t c=0; uint32_t r=0;
-                const char* start = s;
-                while (s[i] && s[i] != ' ') ++i;
-                std::string token(start, i);
-                const char* t = token.c_str(); size_t k = 0;
-                if (!ParseUInt(t, k, a)) { s += i; continue; }
-                if (t[k] == '/') { ++k; ParseUInt(t, k, b); if (t[k] == '/') { ++k; ParseUInt(t, k, c); }}
-                v[count++] = a; s += i;
-            }
-            if (count >= 3) {
-                indices.push_back(v[0]-1); indices.push_back(v[1]-1); indices.push_back(v[2]-1);
-                if (count == 4) { indices.push_back(v[0]-1); indices.push_back(v[2]-1); indices.push_back(v[3]-1); }
+    std::vector<RelativeIndex> relatives;
+    bool ok{true};
+};
+
+template <typename Fn>
+void ForEachChunk(JobSystem* jobs, unsigned count, const Fn& fn) {
+    // Chunks take milliseconds each; as background jobs a thread waiting on frame work never picks one up.
+    if (jobs) jobs->parallelFor(count, 1, [&fn](uint32_t begin, uint32_t end) { for (uint32_t i = begin; i < end; ++i) fn(unsigned(i)); }, JobAffinity::Background);
+    else for (unsigned i = 0; i < count; ++i) fn(i);
+}
+
+inline const char* SkipBlanks(const char* s, const char* e) { while (s < e && (*s == ' ' || *s == '\t')) ++s; return s; }
+
+inline const char* FindLineEnd(const char* s, const char* e) { const void* p = memchr(s, '\n', size_t(e - s)); return p ? static_cast<const char*>(p) : e; }
+
+inline bool ParseFloat(const char*& s, const char* e, float& out) {
+    s = SkipBlanks(s, e);
+    if (s < e && *s == '+') ++s;
+    auto r = std::from_chars(s, e, out);
+    if (r.ec != std::errc()) return false;
+    s = r.ptr; return true;
+}
+
+void ParseFace(ObjChunk& c, const char* s, const char* e) {
+    int64_t corner[3]{}; bool relative[3]{}; int count = 0;
+    auto emit = [&c](int64_t v, bool rel) { if (rel) c.relatives.push_back({ uint32_t(c.indices.size()), v }); c.indices.push_back(rel ? 0u : uint32_t(v)); };
+    for (;;) {
+        s = SkipBlanks(s, e);
+        if (s >= e || *s == '\r' || *s == '#') break;
+        int64_t v = 0; auto r = std::from_chars(s, e, v);
+        if (r.ec != std::errc() || v == 0) { c.ok = false; return; }
+        s = r.ptr;
+        while (s < e && *s != ' ' && *s != '\t' && *s != '\r') ++s;
+        // Absolute indices must fit 32 bits before the range check; relative ones stay 64-bit until they are resolved.
+        if (v > int64_t(UINT32_MAX)) { c.ok = false; return; }
+        const bool rel = v < 0;
+        const int64_t idx = rel ? int64_t(c.positions.size()) + v : v - 1;
+        if (count < 2) { corner[count] = idx; relative[count] = rel; ++count; continue; }
+        emit(corner[0], relative[0]); emit(corner[1], relative[1]); emit(idx, rel);
+        corner[1] = idx; relative[1] = rel; ++count;
+    }
+}
+
+void ParseChunk(ObjChunk& c) {
+    const char* s = c.begin; const char* end = c.end;
+    const size_t bytes = size_t(end - s);
+    c.positions.reserve(bytes / 48); c.indices.reserve(bytes / 12);
+    while (s < end && c.ok) {
+        const char* eol = FindLineEnd(s, end);
+        const char* p = SkipBlanks(s, eol);
+        if (eol - p >= 2 && (p[1] == ' ' || p[1] == '\t')) {
+            if (p[0] == 'v') {
+                Float3 v; const char* q = p + 2;
+                if (!ParseFloat(q, eol, v.x) || !ParseFloat(q, eol, v.y) || !ParseFloat(q, eol, v.z)) { c.ok = false; break; }
+                c.positions.push_back(v);
+            } else if (p[0] == 'f') {
+                ParseFace(c, p + 2, eol);
             }
         }
+        s = eol + 1;
+    }
+}
+}
+
+bool ParseObjPositionsAndIndices(const char* text, size_t size, ObjMeshData& outMesh, ObjLoadStats* outStats, JobSystem* jobs) {
+    PROFILE_ZONE("ParseObj");
+    const auto start = std::chrono::steady_clock::now();
+    unsigned chunkCount = jobs ? jobs->workerCount() + 1 : 1u;
+    chunkCount = unsigned(std::min<size_t>(chunkCount, std::max<size_t>(1, size / kMinChunkBytes)));
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* cursor = text; const char* end = text + size;
+    for (unsigned i = 0; i < chunkCount; ++i) {
+        const char* split = i + 1 == chunkCount ? end : std::max(cursor, text + size * (i + 1) / chunkCount);
+        if (split < end) { split = FindLineEnd(split, end); if (split < end) ++split; }
+        chunks[i].begin = cursor; chunks[i].end = split; cursor = split;
+    }
+    ForEachChunk(jobs, chunkCount, [&chunks](unsigned i) { ParseChunk(chunks[i]); });
+
+    std::vector<size_t> positionBase(chunkCount + 1, 0), indexBase(chunkCount + 1, 0);
+    for (unsigned i = 0; i < chunkCount; ++i) {
+        if (!chunks[i].ok) return false;
+        positionBase[i + 1] = positionBase[i] + chunks[i].positions.size();
+        indexBase[i + 1] = indexBase[i] + chunks[i].indices.size();
     }
+    const size_t positionCount = positionBase[chunkCount];
+    if (positionCount > UINT32_MAX) return false;
+    std::vector<Float3> positions(positionCount);
+    std::vector<uint32_t> indices(indexBase[chunkCount]);
+    std::vector<char> valid(chunkCount, 1);
+    ForEachChunk(jobs, chunkCount, [&](unsigned i) {
+        ObjChunk& c = chunks[i];
+        for (const RelativeIndex& r : c.relatives) { const int64_t idx = int64_t(positionBase[i]) + r.local; if (idx < 0 || idx >= int64_t(positionCount)) { valid[i] = 0; return; } c.indices[r.slot] = uint32_t(idx); }
+        for (uint32_t idx : c.indices) if (idx >= positionCount) { valid[i] = 0; break; }
+        std::copy(c.positions.begin(), c.positions.end(), positions.begin() + ptrdiff_t(positionBase[i]));
+        std::copy(c.indices.begin(), c.indices.end(), indices.begin() + ptrdiff_t(indexBase[i]));
+    });
+    if (std::find(valid.begin(), valid.end(), 0) != valid.end()) return false;
     outMesh.positions = std::move(positions);
     outMesh.indices = std::move(indices);
+    if (outStats) {
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        outStats->bytes = size; outStats->chunks = chunkCount; outStats->milliseconds = ms;
+        outStats->megabytesPerSecond = ms > 0.0 ? double(size) / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+    }
+    return true;
+}
+
+bool LoadObjPositionsAndIndices(const std::wstring& path, ObjMeshData& outMesh, ObjLoadStats* outStats, JobSystem* jobs) {
+    const auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.open(std::filesystem::path(path))) return false;
+    if (!ParseObjPositionsAndIndices(reinterpret_cast<const char*>(file.data()), file.size(), outMesh, outStats, jobs)) return false;
+    if (outStats) {
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        outStats->milliseconds = ms;
+        outStats->megabytesPerSecond = ms > 0.0 ? double(file.size()) / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+    }
     return true;
 }
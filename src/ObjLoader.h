@@ -1,11 +1,25 @@
 #pragma once
 #include <vector>
 #include <string>
-#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include "MathTypes.h"
+
+class JobSystem;
 
 struct ObjMeshData {
-    std::vector<DirectX::XMFLOAT3> positions;
+    std::vector<Float3> positions;
     std::vector<uint32_t> indices;
 };
 
-bool LoadObjPositionsAndIndices(const std::wstring& path, ObjMeshData& outMesh);
+struct ObjLoadStats {
+    size_t bytes{0};
+    unsigned chunks{0};
+    double milliseconds{0.0};
+    double megabytesPerSecond{0.0};
+};
+
+// Large files are split into line-aligned chunks, one per job worker plus the caller, parsed as background jobs so frame
+// waits never run one; without jobs they parse serially.
+bool ParseObjPositionsAndIndices(const char* text, size_t size, ObjMeshData& outMesh, ObjLoadStats* outStats = nullptr, JobSystem* jobs = nullptr);
+bool LoadObjPositionsAndIndices(const std::wstring& path, ObjMeshData& outMesh, ObjLoadStats* outStats = nullptr, JobSystem* jobs = nullptr);
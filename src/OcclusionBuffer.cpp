@@ -0,0 +1,247 @@
+#include "OcclusionBuffer.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <utility>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define GGINE_OCCLUSION_SSE 1
+#endif
+
+namespace {
+constexpr uint32_t kFullMask = ~0u;
+constexpr uint8_t kClipPlaneBits = 0x1F;   // x and y against +-w, and the near plane; the far bit only rejects
+constexpr float kMinTestW = 1e-5f;
+
+uint8_t Outcode(const Float4& v) {
+    return uint8_t((v.x < -v.w) | (v.x > v.w) << 1 | (v.y < -v.w) << 2 | (v.y > v.w) << 3 | (v.z < 0.0f) << 4 | (v.z > v.w) << 5);
+}
+
+// Sutherland-Hodgman in clip space. Nothing needs clipping against the far plane: pixels past it are no nearer than
+// the cleared buffer, so those triangles can only fail to help.
+uint32_t ClipPolygon(Float4* poly, uint32_t count) {
+    Float4 out[16];
+    for (int plane = 0; plane < 5 && count >= 3; ++plane) {
+        auto distance = [plane](const Float4& v) { switch (plane) { case 0: return v.w + v.x; case 1: return v.w - v.x; case 2: return v.w + v.y; case 3: return v.w - v.y; default: return v.z; } };
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            const Float4& a = poly[i]; const Float4& b = poly[(i + 1) % count];
+            const float da = distance(a), db = distance(b);
+            if (da >= 0.0f) out[n++] = a;
+            if ((da >= 0.0f) != (db >= 0.0f)) { const float t = da / (da - db); out[n++] = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t }; }
+        }
+        std::copy(out, out + n, poly); count = n;
+    }
+    return count;
+}
+
+// Bit y * 8 + x is set when the pixel centre at (x, y) in the tile is inside all three edges; e0 holds the edge values
+// at the tile's first pixel centre.
+uint32_t CoverageMask(const float* ea, const float* eb, const float* e0) {
+    uint32_t mask = kFullMask;
+#if defined(GGINE_OCCLUSION_SSE)
+    const __m128 columns = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), zero = _mm_setzero_ps();
+    for (int k = 0; k < 3; ++k) {
+        const __m128 left = _mm_add_ps(_mm_set1_ps(e0[k]), _mm_mul_ps(_mm_set1_ps(ea[k]), columns)), right = _mm_add_ps(left, _mm_set1_ps(ea[k] * 4.0f));
+        uint32_t edge = 0;
+        for (uint32_t y = 0; y < kOcclusionTileHeight; ++y) {
+            const __m128 dy = _mm_set1_ps(eb[k] * float(y));
+            const int bits = _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(left, dy), zero)) | _mm_movemask_ps(_mm_cmpge_ps(_mm_add_ps(right, dy), zero)) << 4;
+            edge |= uint32_t(bits) << (y * kOcclusionTileWidth);
+        }
+        mask &= edge;
+    }
+#else
+    for (int k = 0; k < 3; ++k) {
+        uint32_t edge = 0;
+        for (uint32_t y = 0; y < kOcclusionTileHeight; ++y) for (uint32_t x = 0; x < kOcclusionTileWidth; ++x) if (e0[k] + ea[k] * float(x) + eb[k] * float(y) >= 0.0f) edge |= 1u << (y * kOcclusionTileWidth + x);
+        mask &= edge;
+    }
+#endif
+    return mask;
+}
+
+// Folds a triangle covering `coverage` at no farther than depth into the tile. A new working layer replaces the old one
+// when it covers it, or when its depth is further from the working layer than the working layer is from the far depth
+// (merging would lose more than it keeps); a full working layer becomes the tile's far depth.
+bool MergeTile(OcclusionTile& t, uint32_t coverage, float depth) {
+    if (!(depth < t.farDepth)) return false;
+    if (coverage == kFullMask) { if (!(t.mask && t.workDepth < depth)) t.mask = 0; t.farDepth = depth; return true; }
+    if (t.mask == 0 || (t.mask & ~coverage) == 0 || std::fabs(depth - t.workDepth) > t.farDepth - t.workDepth) { t.mask = coverage; t.workDepth = depth; }
+    else { t.mask |= coverage; t.workDepth = std::max(t.workDepth, depth); }
+    if (t.mask == kFullMask) { t.farDepth = t.workDepth; t.mask = 0; }
+    return true;
+}
+}
+
+void OcclusionBuffer::resize(uint32_t width, uint32_t height) {
+    width = (width + kOcclusionTileWidth - 1) / kOcclusionTileWidth * kOcclusionTileWidth; height = (height + kOcclusionTileHeight - 1) / kOcclusionTileHeight * kOcclusionTileHeight;
+    if (width == bufferWidth && height == bufferHeight) return;
+    bufferWidth = width; bufferHeight = height;
+    tiles.resize(size_t(tilesX()) * tilesY()); rowBins.resize(tilesY());
+    clear();
+}
+
+void OcclusionBuffer::clear() {
+    std::fill(tiles.begin(), tiles.end(), OcclusionTile{ 1.0f, 1.0f, 0 });
+    triangles.clear(); frameStats = {};
+}
+
+void OcclusionBuffer::addOccluder(const Float3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, const Float4x4& m) {
+    if (tiles.empty() || vertexCount == 0) return;
+    ++frameStats.occluders; frameStats.triangles += uint32_t(indexCount / 3);
+    clipScratch.resize(vertexCount); outcodeScratch.resize(vertexCount);
+#if defined(GGINE_OCCLUSION_SSE)
+    const __m128 r0 = _mm_loadu_ps(m.m[0]), r1 = _mm_loadu_ps(m.m[1]), r2 = _mm_loadu_ps(m.m[2]), r3 = _mm_loadu_ps(m.m[3]);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const Float3& p = positions[v];
+        _mm_storeu_ps(&clipScratch[v].x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.x), r0), _mm_mul_ps(_mm_set1_ps(p.y), r1)), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.z), r2), r3)));
+        outcodeScratch[v] = Outcode(clipScratch[v]);
+    }
+#else
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const Float3& p = positions[v]; float c[4];
+        for (int j = 0; j < 4; ++j) c[j] = p.x * m.m[0][j] + p.y * m.m[1][j] + p.z * m.m[2][j] + m.m[3][j];
+        clipScratch[v] = { c[0], c[1], c[2], c[3] }; outcodeScratch[v] = Outcode(clipScratch[v]);
+    }
+#endif
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        const uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        const uint8_t oa = outcodeScratch[a], ob = outcodeScratch[b], oc = outcodeScratch[c];
+        if (oa & ob & oc) continue;
+        Float4 poly[16] = { clipScratch[a], clipScratch[b], clipScratch[c] };
+        if (((oa | ob | oc) & kClipPlaneBits) == 0) { setupTriangle(poly); continue; }
+        const uint32_t n = ClipPolygon(poly, 3);
+        for (uint32_t k = 1; k + 1 < n; ++k) { const Float4 fan[3] = { poly[0], poly[k], poly[k + 1] }; setupTriangle(fan); }
+    }
+}
+
+void OcclusionBuffer::setupTriangle(const Float4* clip) {
+    float x[3], y[3], z[3];
+    for (int i = 0; i < 3; ++i) {
+        if (!(clip[i].w > 0.0f)) return;
+        const float inv = 1.0f / clip[i].w;
+        x[i] = (clip[i].x * inv * 0.5f + 0.5f) * float(bufferWidth); y[i] = (0.5f - clip[i].y * inv * 0.5f) * float(bufferHeight); z[i] = clip[i].z * inv;
+    }
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (!(std::fabs(area) > 1e-6f)) return;
+    if (area < 0.0f) { std::swap(x[1], x[2]); std::swap(y[1], y[2]); std::swap(z[1], z[2]); area = -area; }
+    Triangle t;
+    // Pixel centres sit at half-integer coordinates; the box keeps only the centres the triangle can reach.
+    t.minX = std::max(0, int32_t(std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f))); t.maxX = std::min(int32_t(bufferWidth) - 1, int32_t(std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f)));
+    t.minY = std::max(0, int32_t(std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f))); t.maxY = std::min(int32_t(bufferHeight) - 1, int32_t(std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f)));
+    if (t.minX > t.maxX || t.minY > t.maxY) return;
+    for (int k = 0; k < 3; ++k) {
+        const int n = (k + 1) % 3;
+        t.ea[k] = y[k] - y[n]; t.eb[k] = x[n] - x[k]; t.ec[k] = -(t.ea[k] * x[k] + t.eb[k] * y[k]);
+    }
+    const float dx1 = x[1] - x[0], dy1 = y[1] - y[0], dz1 = z[1] - z[0], dx2 = x[2] - x[0], dy2 = y[2] - y[0], dz2 = z[2] - z[0];
+    t.za = (dz1 * dy2 - dz2 * dy1) / area; t.zb = (dz2 * dx1 - dz1 * dx2) / area; t.zc = z[0] - t.za * x[0] - t.zb * y[0];
+    t.zMax = std::max({ z[0], z[1], z[2] });
+    triangles.push_back(t);
+}
+
+uint32_t OcclusionBuffer::rasterizeRow(uint32_t tileRow) {
+    OcclusionTile* row = &tiles[size_t(tileRow) * tilesX()];
+    const float py = float(tileRow * kOcclusionTileHeight) + 0.5f, spanX = float(kOcclusionTileWidth - 1), spanY = float(kOcclusionTileHeight - 1);
+    uint32_t updated = 0;
+    for (uint32_t index : rowBins[tileRow]) {
+        const Triangle& t = triangles[index];
+        for (int32_t tx = t.minX / int32_t(kOcclusionTileWidth); tx <= t.maxX / int32_t(kOcclusionTileWidth); ++tx) {
+            const float px = float(uint32_t(tx) * kOcclusionTileWidth) + 0.5f;
+            // The edge values at the corner pixel centres bound every centre in the tile, which settles most tiles whole.
+            float e0[3]; bool outside = false, inside = true;
+            for (int k = 0; k < 3; ++k) {
+                e0[k] = t.ea[k] * px + t.eb[k] * py + t.ec[k];
+                const float dx = t.ea[k] * spanX, dy = t.eb[k] * spanY;
+                outside |= e0[k] + std::max(dx, 0.0f) + std::max(dy, 0.0f) < 0.0f;
+                inside &= e0[k] + std::min(dx, 0.0f) + std::min(dy, 0.0f) >= 0.0f;
+            }
+            if (outside) continue;
+            // The plane's largest value over the tile's centres, and never more than the farthest vertex, bounds every covered
+            // pixel; a triangle no nearer than the tile already is cannot help, so it is dropped before any per-pixel work.
+            const float depth = std::min(t.za * px + t.zb * py + t.zc + std::max(t.za * spanX, 0.0f) + std::max(t.zb * spanY, 0.0f), t.zMax);
+            if (!(depth < row[tx].farDepth)) continue;
+            const uint32_t coverage = inside ? kFullMask : CoverageMask(t.ea, t.eb, e0);
+            if (coverage == 0) continue;
+            updated += MergeTile(row[tx], coverage, depth) ? 1u : 0u;
+        }
+    }
+    return updated;
+}
+
+void OcclusionBuffer::rasterize(JobSystem* jobs) {
+    PROFILE_ZONE("Rasterize occluders");
+    for (std::vector<uint32_t>& bin : rowBins) bin.clear();
+    for (uint32_t i = 0; i < uint32_t(triangles.size()); ++i) for (int32_t r = triangles[i].minY / int32_t(kOcclusionTileHeight); r <= triangles[i].maxY / int32_t(kOcclusionTileHeight); ++r) rowBins[size_t(r)].push_back(i);
+    std::atomic<uint32_t> updated{0};
+    auto rows = [&](uint32_t begin, uint32_t end) { PROFILE_ZONE("Occlusion tile rows"); uint32_t n = 0; for (uint32_t r = begin; r < end; ++r) n += rasterizeRow(r); updated.fetch_add(n, std::memory_order_relaxed); };
+    if (jobs) jobs->parallelFor(tilesY(), 2, rows);
+    else rows(0, tilesY());
+    frameStats.rasterizedTriangles = uint32_t(triangles.size()); frameStats.tilesUpdated += updated.load(std::memory_order_relaxed);
+}
+
+float OcclusionBuffer::pixelDepth(uint32_t x, uint32_t y) const {
+    const OcclusionTile& t = tile(x / kOcclusionTileWidth, y / kOcclusionTileHeight);
+    return t.mask >> ((y % kOcclusionTileHeight) * kOcclusionTileWidth + x % kOcclusionTileWidth) & 1u ? std::min(t.workDepth, t.farDepth) : t.farDepth;
+}
+
+bool OcclusionBuffer::testRect(float minX, float minY, float maxX, float maxY, float nearestDepth) const {
+    const float w = float(bufferWidth), h = float(bufferHeight);
+    if (tiles.empty()) return true;
+    if (maxX <= 0.0f || maxY <= 0.0f || minX >= w || minY >= h) return false;
+    // Clamped first, so the touched pixel range is plain truncation; a NaN bound clamps to the whole buffer.
+    auto last = [](float lo, float hi, float size) { const float v = std::min(size, hi); const int32_t i = int32_t(v); return std::max(int32_t(lo), std::min(int32_t(size) - 1, i - (float(i) == v))); };
+    const int32_t x0 = int32_t(std::max(0.0f, minX)), x1 = last(std::max(0.0f, minX), maxX, w), y0 = int32_t(std::max(0.0f, minY)), y1 = last(std::max(0.0f, minY), maxY, h);
+    const int32_t tw = int32_t(kOcclusionTileWidth), th = int32_t(kOcclusionTileHeight);
+    for (int32_t ty = y0 / th; ty <= y1 / th; ++ty) {
+        const int32_t rowLo = std::max(y0 - ty * th, 0), rowHi = std::min(y1 - ty * th, th - 1);
+        for (int32_t tx = x0 / tw; tx <= x1 / tw; ++tx) {
+            const OcclusionTile& t = tiles[size_t(ty) * tilesX() + size_t(tx)];
+            if (nearestDepth > t.farDepth) continue;
+            if (t.mask && nearestDepth > t.workDepth) {
+                const int32_t colLo = std::max(x0 - tx * tw, 0), colHi = std::min(x1 - tx * tw, tw - 1);
+                const uint32_t columns = ((1u << (colHi + 1)) - 1) & ~((1u << colLo) - 1);
+                uint32_t rect = 0; for (int32_t r = rowLo; r <= rowHi; ++r) rect |= columns << (r * tw);
+                if ((rect & ~t.mask) == 0) continue;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OcclusionBuffer::testAabb(const Aabb& box, const Float4x4& m) const {
+    if (tiles.empty()) return true;
+    float minX, minY, maxX, maxY, nearest;
+#if defined(GGINE_OCCLUSION_SSE)
+    // The eight corners go through the matrix as two groups of four, one per z face.
+    const __m128 xs = _mm_setr_ps(box.min.x, box.max.x, box.min.x, box.max.x), ys = _mm_setr_ps(box.min.y, box.min.y, box.max.y, box.max.y);
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 lo = _mm_set1_ps(INFINITY), hi = _mm_set1_ps(-INFINITY), nearZ = _mm_set1_ps(INFINITY), yLo = lo, yHi = hi;
+    for (const float z : { box.min.z, box.max.z }) {
+        auto column = [&](int j) { return _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, _mm_set1_ps(m.m[0][j])), _mm_mul_ps(ys, _mm_set1_ps(m.m[1][j]))), _mm_set1_ps(z * m.m[2][j] + m.m[3][j])); };
+        const __m128 cx = column(0), cy = column(1), cz = column(2), cw = column(3);
+        // A box reaching in front of the near plane may cover the whole view.
+        if (_mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(cw, _mm_set1_ps(kMinTestW)), _mm_cmplt_ps(cz, _mm_setzero_ps())))) return true;
+        const __m128 inv = _mm_div_ps(one, cw), sx = _mm_mul_ps(cx, inv), sy = _mm_mul_ps(cy, inv);
+        lo = _mm_min_ps(lo, sx); hi = _mm_max_ps(hi, sx); yLo = _mm_min_ps(yLo, sy); yHi = _mm_max_ps(yHi, sy); nearZ = _mm_min_ps(nearZ, _mm_mul_ps(cz, inv));
+    }
+    auto reduce = [](__m128 v, bool wantMin) { __m128 s = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)); v = wantMin ? _mm_min_ps(v, s) : _mm_max_ps(v, s); s = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)); return _mm_cvtss_f32(wantMin ? _mm_min_ps(v, s) : _mm_max_ps(v, s)); };
+    minX = reduce(lo, true); maxX = reduce(hi, false); minY = reduce(yLo, true); maxY = reduce(yHi, false); nearest = reduce(nearZ, true);
+#else
+    minX = minY = nearest = INFINITY; maxX = maxY = -INFINITY;
+    for (int i = 0; i < 8; ++i) {
+        const float p[3] = { i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z };
+        float c[4]; for (int j = 0; j < 4; ++j) c[j] = p[0] * m.m[0][j] + p[1] * m.m[1][j] + p[2] * m.m[2][j] + m.m[3][j];
+        if (c[3] < kMinTestW || c[2] < 0.0f) return true;
+        const float inv = 1.0f / c[3];
+        minX = std::min(minX, c[0] * inv); maxX = std::max(maxX, c[0] * inv); minY = std::min(minY, c[1] * inv); maxY = std::max(maxY, c[1] * inv); nearest = std::min(nearest, c[2] * inv);
+    }
+#endif
+    // NDC y points up and pixel rows run down, so the top of the box is the smallest row.
+    const float w = float(bufferWidth), h = float(bufferHeight);
+    return testRect((minX * 0.5f + 0.5f) * w, (0.5f - maxY * 0.5f) * h, (maxX * 0.5f + 0.5f) * w, (0.5f - minY * 0.5f) * h, nearest);
+}
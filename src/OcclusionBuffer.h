@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+class JobSystem;
+
+constexpr uint32_t kOcclusionTileWidth = 8;
+constexpr uint32_t kOcclusionTileHeight = 4;
+
+// Object-space triangles a mesh contributes when it is picked as an occluder; the full-detail mesh, since a
+// simplified one may bulge past the real surface and hide things that are visible. A view: whoever hands it out keeps
+// the arrays alive, so a cooked mesh can lend its mapping instead of a copy.
+struct OccluderMesh {
+    const Float3* positions{nullptr};
+    uint32_t vertexCount{0};
+    const uint32_t* indices{nullptr};
+    uint32_t indexCount{0};
+};
+
+struct OcclusionStats {
+    uint32_t occluders{0};
+    uint32_t triangles{0};            // submitted
+    uint32_t rasterizedTriangles{0};  // after clipping and rejecting triangles that cover no pixel centre
+    uint32_t tilesUpdated{0};
+};
+
+// One 8x4 tile. Every pixel is at most farDepth away; the pixels in mask (bit y * 8 + x) are at most workDepth.
+struct OcclusionTile {
+    float farDepth;
+    float workDepth;
+    uint32_t mask;
+};
+
+// Low-resolution masked depth buffer in the style of masked software occlusion culling. Depth follows D3D (0 near,
+// 1 far). Tiles keep no per-pixel depth, only a conservative far depth plus one nearer working layer with a coverage
+// mask, and every update only ever claims occluders are farther than they are, so a box tests hidden only when the
+// occluders cover it at every pixel centre it touches.
+class OcclusionBuffer {
+public:
+    // Rounds up to whole tiles; the buffer maps the full viewport whatever its aspect.
+    void resize(uint32_t width, uint32_t height);
+    void clear();
+    // Transforms, clips and sets up the triangles; nothing is written to the tiles until rasterize().
+    void addOccluder(const Float3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, const Float4x4& worldViewProj);
+    // Bins the set-up triangles by tile row and rasterizes the rows in parallel; each row is owned by one job.
+    void rasterize(JobSystem* jobs = nullptr);
+
+    // False only when the box is hidden. Const and safe to call from several threads after rasterize().
+    bool testAabb(const Aabb& box, const Float4x4& viewProj) const;
+    // Pixel-space rectangle at its nearest depth; every pixel the rectangle touches must be covered nearer to hide it.
+    bool testRect(float minX, float minY, float maxX, float maxY, float nearestDepth) const;
+
+    uint32_t width() const { return bufferWidth; }
+    uint32_t height() const { return bufferHeight; }
+    uint32_t tilesX() const { return bufferWidth / kOcclusionTileWidth; }
+    uint32_t tilesY() const { return bufferHeight / kOcclusionTileHeight; }
+    const OcclusionTile& tile(uint32_t x, uint32_t y) const { return tiles[size_t(y) * tilesX() + x]; }
+    // Conservative depth of one pixel, for debug views and reference checks.
+    float pixelDepth(uint32_t x, uint32_t y) const;
+    const OcclusionStats& stats() const { return frameStats; }
+
+private:
+    // Edge functions are e(x, y) = a * x + b * y + c, non-negative inside; depth is z(x, y) = za * x + zb * y + zc.
+    struct Triangle {
+        float ea[3], eb[3], ec[3];
+        float za, zb, zc, zMax;
+        int32_t minX, minY, maxX, maxY;
+    };
+
+    void setupTriangle(const Float4* clip);
+    uint32_t rasterizeRow(uint32_t tileRow);
+
+    uint32_t bufferWidth{0};
+    uint32_t bufferHeight{0};
+    std::vector<OcclusionTile> tiles;
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<uint32_t>> rowBins;
+    std::vector<Float4> clipScratch;
+    std::vector<uint8_t> outcodeScratch;
+    OcclusionStats frameStats;
+};
@@ -0,0 +1,197 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace {
+void WriteJsonString(std::ofstream& f, const char* s) {
+    f << '"';
+    for (; *s; ++s) {
+        const unsigned char c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') f << '\\' << char(c);
+        else if (c < 0x20) { char esc[8]; snprintf(esc, sizeof(esc), "\\u%04x", c); f << esc; }
+        else f << char(c);
+    }
+    f << '"';
+}
+}
+
+bool ExportChromeTrace(const std::filesystem::path& path, const std::vector<ProfileFrame>& frames, const std::vector<std::string>& threadNames) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    uint64_t origin = ~0ull;
+    for (const ProfileFrame& frame : frames) { origin = std::min(origin, frame.beginNs); for (const ProfileZone& z : frame.zones) origin = std::min(origin, z.beginNs); }
+    const uint32_t gpuTid = uint32_t(threadNames.size()), frameTid = gpuTid + 1;
+    bool first = true;
+    auto separator = [&] { if (!first) f << ",\n"; first = false; };
+    auto threadName = [&](uint32_t tid, const char* name) { separator(); f << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":"; WriteJsonString(f, name); f << "}}"; };
+    auto complete = [&](const char* name, uint64_t beginNs, uint64_t endNs, uint32_t tid) {
+        char times[96]; snprintf(times, sizeof(times), ",\"ts\":%.3f,\"dur\":%.3f", double(beginNs - origin) / 1000.0, double(endNs > beginNs ? endNs - beginNs : 0) / 1000.0);
+        separator(); f << "{\"name\":"; WriteJsonString(f, name); f << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << times << '}';
+    };
+    f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    separator(); f << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ggine\"}}";
+    for (uint32_t t = 0; t < threadNames.size(); ++t) threadName(t, threadNames[t].c_str());
+    threadName(gpuTid, "GPU"); threadName(frameTid, "Frames");
+    for (const ProfileFrame& frame : frames) {
+        char name[32]; snprintf(name, sizeof(name), "Frame %llu", (unsigned long long)frame.index);
+        complete(name, frame.beginNs, frame.endNs, frameTid);
+        for (const ProfileZone& z : frame.zones) complete(z.name, z.beginNs, z.endNs, z.thread == kProfileGpuThread ? gpuTid : z.thread);
+    }
+    f << "\n]}\n";
+    return bool(f);
+}
+
+#if GGINE_ENABLE_PROFILER
+namespace {
+constexpr uint64_t kRingCapacity = 1u << 13;
+
+struct ThreadBuffer {
+    explicit ThreadBuffer(uint32_t id) : id(id), ring(new ProfileZone[kRingCapacity]) {}
+    const uint32_t id;
+    std::string name;
+    uint32_t depth{0};
+    std::unique_ptr<ProfileZone[]> ring;
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+struct ProfilerState {
+    // Buffers are never freed, so a thread may exit while the collector still drains what it wrote.
+    std::mutex threadsMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
+    std::mutex framesMutex;
+    std::vector<ThreadBuffer*> draining;
+    ProfileFrame current;
+    // The last kProfilerHistoryFrames frames, oldest at historyStart. Slots are recycled in place, so a frame reuses the
+    // zone storage of the one it pushes out and a steady frame rate drains into memory that is already there.
+    std::vector<ProfileFrame> history = std::vector<ProfileFrame>(kProfilerHistoryFrames);
+    size_t historyStart{0}, historyCount{0};
+    bool capturing{false};
+    uint64_t captureFirst{0}, captureLast{0};
+};
+
+ProfilerState& State() { static ProfilerState state; return state; }
+
+ProfileFrame& HistoryAt(ProfilerState& s, size_t i) { return s.history[(s.historyStart + i) % kProfilerHistoryFrames]; }
+
+thread_local ThreadBuffer* tlsBuffer = nullptr;
+
+ThreadBuffer& LocalBuffer() {
+    if (!tlsBuffer) {
+        ProfilerState& s = State();
+        std::lock_guard<std::mutex> lock(s.threadsMutex);
+        s.threads.push_back(std::make_unique<ThreadBuffer>(uint32_t(s.threads.size())));
+        tlsBuffer = s.threads.back().get();
+    }
+    return *tlsBuffer;
+}
+
+void Drain(ThreadBuffer& b, std::vector<ProfileZone>& out) {
+    const uint64_t head = b.head.load(std::memory_order_acquire), tail = b.tail.load(std::memory_order_relaxed);
+    for (uint64_t i = tail; i < head; ++i) out.push_back(b.ring[i & (kRingCapacity - 1)]);
+    b.tail.store(head, std::memory_order_release);
+}
+}
+
+uint64_t ProfilerNowNs() { return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()); }
+
+void ProfilerSetThreadName(const std::string& name) {
+    ThreadBuffer& b = LocalBuffer();
+    std::lock_guard<std::mutex> lock(State().threadsMutex);
+    b.name = name;
+}
+
+uint32_t ProfilerEnterZone() { return LocalBuffer().depth++; }
+
+void ProfilerLeaveZone(const char* name, uint64_t beginNs, uint32_t depth) {
+    const uint64_t endNs = ProfilerNowNs();
+    ThreadBuffer& b = LocalBuffer(); b.depth = depth;
+    const uint64_t head = b.head.load(std::memory_order_relaxed);
+    if (head - b.tail.load(std::memory_order_acquire) >= kRingCapacity) { b.dropped.fetch_add(1, std::memory_order_relaxed); return; }
+    b.ring[head & (kRingCapacity - 1)] = { name, beginNs, endNs, b.id, depth };
+    b.head.store(head + 1, std::memory_order_release);
+}
+
+void ProfilerBeginFrame() {
+    ProfilerState& s = State();
+    const uint64_t now = ProfilerNowNs();
+    std::lock_guard<std::mutex> lock(s.framesMutex);
+    { std::lock_guard<std::mutex> threadsLock(s.threadsMutex); s.draining.clear(); for (const auto& t : s.threads) s.draining.push_back(t.get()); }
+    for (ThreadBuffer* b : s.draining) Drain(*b, s.current.zones);
+    if (s.current.index > 0) {
+        s.current.endNs = now;
+        std::swap(s.current, s.history[(s.historyStart + s.historyCount) % kProfilerHistoryFrames]);
+        if (s.historyCount < kProfilerHistoryFrames) ++s.historyCount; else s.historyStart = (s.historyStart + 1) % kProfilerHistoryFrames;
+    }
+    const uint64_t next = s.historyCount == 0 ? 1 : HistoryAt(s, s.historyCount - 1).index + 1;
+    // A recycled slot may come from a lighter frame; headroom over the last one keeps zone recording off the heap.
+    if (s.historyCount > 0) { const size_t last = HistoryAt(s, s.historyCount - 1).zones.size(); if (s.current.zones.capacity() < last) s.current.zones.reserve(last + last / 2); }
+    s.current.zones.clear(); s.current.index = next; s.current.beginNs = now; s.current.endNs = 0;
+}
+
+uint64_t ProfilerFrameIndex() { ProfilerState& s = State(); std::lock_guard<std::mutex> lock(s.framesMutex); return s.current.index; }
+
+void ProfilerSubmitGpuZones(uint64_t frameIndex, const ProfileZone* zones, size_t count) {
+    ProfilerState& s = State();
+    std::lock_guard<std::mutex> lock(s.framesMutex);
+    ProfileFrame* frame = s.current.index == frameIndex ? &s.current : nullptr;
+    for (size_t i = s.historyCount; !frame && i-- > 0;) if (HistoryAt(s, i).index == frameIndex) frame = &HistoryAt(s, i);
+    if (!frame) return;
+    for (size_t i = 0; i < count; ++i) { frame->zones.push_back(zones[i]); frame->zones.back().thread = kProfileGpuThread; }
+}
+
+bool ProfilerCopyFrame(size_t age, ProfileFrame& out) {
+    ProfilerState& s = State();
+    std::lock_guard<std::mutex> lock(s.framesMutex);
+    if (age >= s.historyCount) return false;
+    out = HistoryAt(s, s.historyCount - 1 - age);
+    return true;
+}
+
+void ProfilerFrameTimes(std::vector<float>& outMs) {
+    ProfilerState& s = State();
+    std::lock_guard<std::mutex> lock(s.framesMutex);
+    outMs.clear();
+    for (size_t i = 0; i < s.historyCount; ++i) { const ProfileFrame& f = HistoryAt(s, i); outMs.push_back(float(double(f.endNs - f.beginNs) / 1e6)); }
+}
+
+void ProfilerThreadNames(std::vector<std::string>& outNames) {
+    ProfilerState& s = State();
+    std::lock_guard<std::mutex> lock(s.threadsMutex);
+    outNames.resize(s.threads.size());
+    for (size_t i = 0; i < s.threads.size(); ++i) { const ThreadBuffer& t = *s.threads[i]; if (t.name.empty()) outNames[i] = "Thread " + std::to_string(t.id); else outNames[i] = t.name; }
+}
+
+ProfilerStats ProfilerGetStats() {
+    ProfilerState& s = State();
+    std::lock_guard<std::mutex> lock(s.threadsMutex);
+    ProfilerStats stats; stats.threads = uint32_t(s.threads.size());
+    for (const auto& t : s.threads) stats.droppedZones += t->dropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ProfilerStartCapture(uint32_t frameCount) {
+    ProfilerState& s = State();
+    std::lock_guard<std::mutex> lock(s.framesMutex);
+    frameCount = std::clamp<uint32_t>(frameCount, 1, uint32_t(kProfilerHistoryFrames) - kProfilerGpuLatencyFrames - 1);
+    s.capturing = true; s.captureFirst = s.current.index + 1; s.captureLast = s.captureFirst + frameCount - 1;
+}
+
+bool ProfilerCaptureActive() { ProfilerState& s = State(); std::lock_guard<std::mutex> lock(s.framesMutex); return s.capturing; }
+
+bool ProfilerTakeCapture(std::vector<ProfileFrame>& outFrames) {
+    ProfilerState& s = State();
+    std::lock_guard<std::mutex> lock(s.framesMutex);
+    if (!s.capturing || s.current.index <= s.captureLast + kProfilerGpuLatencyFrames) return false;
+    outFrames.clear();
+    for (size_t i = 0; i < s.historyCount; ++i) { const ProfileFrame& f = HistoryAt(s, i); if (f.index >= s.captureFirst && f.index <= s.captureLast) outFrames.push_back(f); }
+    s.capturing = false;
+    return true;
+}
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifndef GGINE_ENABLE_PROFILER
+#define GGINE_ENABLE_PROFILER 1
+#endif
+
+// Zones from the GPU timeline carry this thread id; their times are already converted to the CPU clock.
+constexpr uint32_t kProfileGpuThread = ~0u;
+constexpr size_t kProfilerHistoryFrames = 300;
+// GPU zones arrive once the frame's fence completes, so a capture is handed out this many frames after it ends.
+constexpr uint32_t kProfilerGpuLatencyFrames = 4;
+
+struct ProfileZone {
+    const char* name;
+    uint64_t beginNs;
+    uint64_t endNs;
+    uint32_t thread;
+    uint32_t depth;
+};
+
+struct ProfileFrame {
+    uint64_t index{0};
+    uint64_t beginNs{0};
+    uint64_t endNs{0};
+    std::vector<ProfileZone> zones;
+};
+
+// Writes frames as Chrome trace-event JSON (chrome://tracing, Perfetto); threadNames is indexed by ProfileZone::thread.
+bool ExportChromeTrace(const std::filesystem::path& path, const std::vector<ProfileFrame>& frames, const std::vector<std::string>& threadNames);
+
+#if GGINE_ENABLE_PROFILER
+struct ProfilerStats {
+    uint32_t threads{0};
+    uint64_t droppedZones{0};
+};
+
+// Each thread records into its own single-producer ring; ProfilerBeginFrame drains every ring into the frame that just ended.
+// Zone names must outlive the profiler (string literals).
+uint64_t ProfilerNowNs();
+void ProfilerSetThreadName(const std::string& name);
+uint32_t ProfilerEnterZone();
+void ProfilerLeaveZone(const char* name, uint64_t beginNs, uint32_t depth);
+void ProfilerBeginFrame();
+uint64_t ProfilerFrameIndex();
+void ProfilerSubmitGpuZones(uint64_t frameIndex, const ProfileZone* zones, size_t count);
+bool ProfilerCopyFrame(size_t age, ProfileFrame& out);
+void ProfilerFrameTimes(std::vector<float>& outMs);
+// Fills outNames in place, indexed by ProfileZone::thread, so a caller polling every frame keeps its strings.
+void ProfilerThreadNames(std::vector<std::string>& outNames);
+ProfilerStats ProfilerGetStats();
+void ProfilerStartCapture(uint32_t frameCount);
+bool ProfilerCaptureActive();
+bool ProfilerTakeCapture(std::vector<ProfileFrame>& outFrames);
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : name(name), depth(ProfilerEnterZone()), beginNs(ProfilerNowNs()) {}
+    ~ProfileScope() { ProfilerLeaveZone(name, beginNs, depth); }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint32_t depth;
+    uint64_t beginNs;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) ProfilerSetThreadName(name)
+#define PROFILE_FRAME() ProfilerBeginFrame()
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
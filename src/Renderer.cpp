@@ -0,0 +1,34 @@
+#include "Renderer.h"
+#include "Profiler.h"
+#include <cstring>
+
+void RenderCommandStream::compile() {
+    PROFILE_ZONE("Compile render commands");
+    RadixSortDrawItems(keys, scratch);
+    compiled.clear(); compiled.reserve(keys.size() * 2); streamStats = {};
+    RenderDraw bound{}; bool first = true;
+    for (const DrawItem& k : keys) {
+        const RenderDraw& d = packets[k.objectIndex];
+        auto state = [&](bool changed, RenderOpType type, uint32_t& counter) { if (changed) { compiled.push_back({ type, k.objectIndex }); ++counter; } else ++streamStats.redundantStateSkipped; };
+        state(first || bound.pipeline != d.pipeline, RenderOpType::SetPipeline, streamStats.pipelineChanges);
+        state(first || !(bound.vertexBuffer == d.vertexBuffer), RenderOpType::SetVertexBuffer, streamStats.vertexBufferChanges);
+        if (d.indexBuffer.address) state(!(bound.indexBuffer == d.indexBuffer), RenderOpType::SetIndexBuffer, streamStats.indexBufferChanges);
+        state(first || memcmp(bound.constants, d.constants, sizeof(d.constants)) != 0, RenderOpType::SetConstants, streamStats.constantChanges);
+        state(first || bound.instanceOffset != d.instanceOffset, RenderOpType::SetInstanceOffset, streamStats.instanceOffsetChanges);
+        compiled.push_back({ d.indexBuffer.address ? RenderOpType::DrawIndexed : RenderOpType::Draw, k.objectIndex });
+        ++streamStats.draws; streamStats.primitives += uint64_t(d.count / 3) * d.instanceCount;
+        // A non-indexed draw leaves the bound index buffer alone, so the next indexed draw compares against the last one set.
+        const RenderBufferView indexBuffer = d.indexBuffer.address ? d.indexBuffer : bound.indexBuffer;
+        bound = d; bound.indexBuffer = indexBuffer; first = false;
+    }
+}
+
+void NullRenderer::execute(const RenderCommandStream& stream) {
+    PROFILE_ZONE("Null renderer");
+    const std::vector<RenderDraw>& draws = stream.draws();
+    for (const RenderOp& op : stream.ops()) {
+        ++counts[size_t(op.type)];
+        if (op.type == RenderOpType::DrawIndexed || op.type == RenderOpType::Draw) primitiveCount += uint64_t(draws[op.draw].count / 3) * draws[op.draw].instanceCount;
+    }
+    if (keepLog) opLog.insert(opLog.end(), stream.ops().begin(), stream.ops().end());
+}
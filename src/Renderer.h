@@ -1,68 +1,94 @@
 #pragma once
-#include <wrl/client.h>
-#include <d3d12.h>
-#include <dxgi1_6.h>
-#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
+#include "DrawBatcher.h"
 
-struct RendererInitParams {
-    HWND hwnd;
-    UINT width;
-    UINT height;
+// Backend-agnostic draw packets. Buffers are GPU addresses plus size and stride, so a packet is plain data that any
+// thread can build and any backend (or no GPU at all) can consume.
+struct RenderBufferView {
+    uint64_t address{0};
+    uint32_t size{0};
+    uint32_t stride{0};
+    bool operator==(const RenderBufferView&) const = default;
 };
 
-struct CameraCBData { DirectX::XMFLOAT4X4 mvp; };
+// Per-geometry root constants (the position dequantization scale and offset); the instance offset travels separately.
+constexpr uint32_t kRenderDrawConstants = 6;
 
-class Renderer {
-public:
-    bool initialize(const RendererInitParams& params);
-    void resize(UINT width, UINT height);
-    void beginFrame();
-    void drawMesh(const D3D12_VERTEX_BUFFER_VIEW& vbv, UINT vertexCount, const CameraCBData& camera);
-    void endFrame(bool vsync, bool allowTearing);
-
-    ID3D12Device* getDevice() const { return device.Get(); }
-    ID3D12GraphicsCommandList* getCmdList() const { return commandList.Get(); }
-    UINT getCurrentFrameIndex() const { return currentFrameIndex; }
-
-private:
-    static constexpr UINT kFrameCount = 2;
+struct RenderDraw {
+    uint32_t pipeline{0};
+    RenderBufferView vertexBuffer{};
+    RenderBufferView indexBuffer{};   // stride 2 or 4; address 0 draws non-indexed
+    uint32_t constants[kRenderDrawConstants]{};
+    uint32_t instanceOffset{0};
+    uint32_t count{0};                // indices, or vertices when non-indexed
+    uint32_t firstIndex{0};
+    uint32_t instanceCount{1};
+};
 
-    Microsoft::WRL::ComPtr<IDXGIFactory6> dxgiFactory;
-    Microsoft::WRL::ComPtr<ID3D12Device> device;
-    Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue;
-    Microsoft::WRL::ComPtr<IDXGISwapChain3> swapChain;
-    HANDLE frameLatencyWaitableObject{};
+enum class RenderOpType : uint8_t { SetPipeline, SetVertexBuffer, SetIndexBuffer, SetConstants, SetInstanceOffset, DrawIndexed, Draw };
 
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> rtvDescriptorHeap;
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> dsvDescriptorHeap;
-    UINT rtvDescriptorSize{};
-    Microsoft::WRL::ComPtr<ID3D12Resource> renderTargets[kFrameCount];
-    Microsoft::WRL::ComPtr<ID3D12Resource> depthStencil;
+// One backend call; draw is an index into RenderCommandStream::draws().
+struct RenderOp {
+    RenderOpType type;
+    uint32_t draw;
+};
 
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocators[kFrameCount];
-    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
+struct RenderStreamStats {
+    uint32_t draws{0};
+    uint32_t pipelineChanges{0};
+    uint32_t vertexBufferChanges{0};
+    uint32_t indexBufferChanges{0};
+    uint32_t constantChanges{0};
+    uint32_t instanceOffsetChanges{0};
+    uint32_t redundantStateSkipped{0};
+    uint64_t primitives{0};
+};
 
-    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+// Draws are submitted in any order with a sort key; compile() orders them by key (stably, so submission order holds
+// within a key) and emits only the state changes each draw needs on top of the previous one.
+class RenderCommandStream {
+public:
+    void clear() { keys.clear(); packets.clear(); compiled.clear(); streamStats = {}; }
+    void reserve(size_t count) { keys.reserve(count); packets.reserve(count); }
+    void submit(uint64_t sortKey, const RenderDraw& draw) { keys.push_back({ sortKey, uint32_t(packets.size()) }); packets.push_back(draw); }
+    void compile();
 
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> imguiSrvHeap;
+    size_t size() const { return packets.size(); }
+    const std::vector<RenderDraw>& draws() const { return packets; }
+    const std::vector<RenderOp>& ops() const { return compiled; }
+    const RenderStreamStats& stats() const { return streamStats; }
 
-    Microsoft::WRL::ComPtr<ID3D12Resource> cameraCBs[kFrameCount];
-    uint8_t* cameraCBMapped[kFrameCount]{};
+private:
+    std::vector<DrawItem> keys;
+    std::vector<DrawItem> scratch;
+    std::vector<RenderDraw> packets;
+    std::vector<RenderOp> compiled;
+    RenderStreamStats streamStats;
+};
 
-    Microsoft::WRL::ComPtr<ID3D12Fence> fence;
-    UINT64 fenceValues[kFrameCount]{};
-    HANDLE fenceEvent{};
+class Renderer {
+public:
+    virtual ~Renderer() = default;
+    // Translates a compiled stream into backend calls; frame setup (targets, per-frame buffers) stays with the caller.
+    virtual void execute(const RenderCommandStream& stream) = 0;
+};
 
-    UINT currentFrameIndex{};
-    D3D12_VIEWPORT viewport{};
-    D3D12_RECT scissorRect{};
+// Records what a GPU backend would have been asked to do, for headless measurement and tests.
+class NullRenderer final : public Renderer {
+public:
+    explicit NullRenderer(bool keepLog = false) : keepLog(keepLog) {}
+    void execute(const RenderCommandStream& stream) override;
 
-    bool tearingSupported{false};
+    uint64_t opCount(RenderOpType type) const { return counts[size_t(type)]; }
+    uint64_t primitives() const { return primitiveCount; }
+    const std::vector<RenderOp>& log() const { return opLog; }
+    void reset() { for (uint64_t& c : counts) c = 0; primitiveCount = 0; opLog.clear(); }
 
-    bool createDeviceAndSwapchain(HWND hwnd, UINT w, UINT h);
-    void createRenderTargets();
-    void createDepthResources(UINT w, UINT h);
-    bool createPipeline();
+private:
+    bool keepLog;
+    uint64_t counts[size_t(RenderOpType::Draw) + 1]{};
+    uint64_t primitiveCount{0};
+    std::vector<RenderOp> opLog;
 };
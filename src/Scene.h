@@ -1,32 +1,89 @@
 #pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 #include <wrl/client.h>
 #include <d3d12.h>
 #include <DirectXMath.h>
+#include "TransformStore.h"
+#include "DynamicAabbTree.h"
+#include "AssetStreamer.h"
+#include "TlsfAllocator.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+#include "VertexCodec.h"
+#include "OcclusionBuffer.h"
+#include "LightClusters.h"
+#include "FramePrep.h"
+#include "MeshBvh.h"
 
-struct Transform {
-    DirectX::XMFLOAT3 position{0,0,0};
-    DirectX::XMFLOAT3 rotationEuler{0,0,0};
-    DirectX::XMFLOAT3 scale{1,1,1};
+struct GeometryRange {
+    uint32_t block{0};
+    TlsfAllocation allocation{};
+};
+
+struct GeometryFormat {
+    MeshVertexFormat vertex{MeshVertexFormat::Float3};
+    bool shortIndices{false};
+    UINT64 vertexBytes(UINT vertexCount) const { return UINT64(vertexCount) * VertexStride(vertex); }
+    UINT64 indexBytes(UINT indexCount) const { return UINT64(indexCount) * (shortIndices ? sizeof(uint16_t) : sizeof(uint32_t)); }
+    UINT64 bytes(UINT vertexCount, UINT indexCount) const { return vertexBytes(vertexCount) + indexBytes(indexCount); }
+};
+
+// Level 0 on the CPU for occlusion culling and picking, one per geometry and shared by its instances. A streamed mesh keeps
+// its cooked mesh open and points into it, so nothing is copied; a procedural mesh owns its arrays.
+struct MeshCpuData {
+    CookedMesh cooked;
+    std::vector<Float3> ownedPositions;
+    std::vector<uint32_t> ownedIndices;
+    MeshBvh ownedBvh;
+    OccluderMesh triangles;
+    const BvhNode* bvhNodes{nullptr};   // over triangles
+    const uint32_t* bvhTriangles{nullptr};
 };
 
 struct MeshObject {
     std::wstring name;
-    Transform transform;
-    Microsoft::WRL::ComPtr<ID3D12Resource> vertexBuffer;
+    TransformHandle transform;
+    std::shared_ptr<GeometryRange> geometry;
+    GeometryFormat format{};
+    PositionDequantize dequantize{ {1,1,1}, {0,0,0} };
     D3D12_VERTEX_BUFFER_VIEW vbv{};
+    D3D12_INDEX_BUFFER_VIEW ibv{};
     UINT vertexCount{0};
+    UINT indexCount{0};
+    std::array<MeshLod, kMaxMeshLods> lods{};
+    uint32_t lodCount{0};
+    uint32_t lod{0};
+    std::shared_ptr<const std::vector<Meshlet>> meshlets;
+    std::shared_ptr<const MeshCpuData> cpu;
+    uint32_t geometryId{0};
+    uint32_t materialId{0};
+    Aabb localBounds{};
+    Sphere localSphere{};
+    int32_t cullProxy{-1};
+    StreamHandle pendingLoad{};
+    std::wstring sourcePath;
+    // What FramePrep sorts and filters by.
+    uint32_t pipeline() const { return uint32_t(format.vertex); }
+    bool drawable() const { return geometry != nullptr; }
+    const OccluderMesh* occluder() const { return cpu ? &cpu->triangles : nullptr; }
 };
 
 struct LightObject {
     std::wstring name;
-    Transform transform;
+    TransformHandle transform;
     DirectX::XMFLOAT3 color{1,1,1};
     float intensity{1.0f};
+    int32_t cullProxy{-1};
 };
 
 struct Scene {
+    TransformStore transforms;
+    DynamicAabbTree meshTree;
+    DynamicAabbTree lightTree;
     std::vector<MeshObject> meshes;
     std::vector<LightObject> lights;
     int selectedMesh{-1};
@@ -0,0 +1,86 @@
+#include "SceneFile.h"
+#include "Hash.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace {
+size_t AlignUp(size_t v, size_t a) { return (v + a - 1) / a * a; }
+}
+
+SceneString SceneFileData::addString(std::string_view text) {
+    const SceneString s{ uint32_t(strings.size()), uint32_t(text.size()) };
+    strings.append(text);
+    return s;
+}
+
+uint32_t SceneFileData::addAsset(std::string_view key) {
+    const uint64_t id = HashMemory(key.data(), key.size());
+    const auto [it, added] = assetSlots.try_emplace(id, uint32_t(assets.size()));
+    if (added) assets.push_back({ id, addString(key) });
+    return it->second;
+}
+
+std::vector<uint8_t> BuildSceneImage(const SceneFileData& data) {
+    GgsceneHeader h{};
+    h.magic = kGgsceneMagic; h.version = kGgsceneVersion;
+    h.nodeCount = uint32_t(data.positions.size()); h.meshCount = uint32_t(data.meshes.size()); h.lightCount = uint32_t(data.lights.size()); h.assetCount = uint32_t(data.assets.size());
+    h.camera = data.camera;
+    const std::pair<const void*, size_t> payloads[] = {
+        { data.positions.data(), data.positions.size() * sizeof(Float3) }, { data.eulerDegrees.data(), data.eulerDegrees.size() * sizeof(Float3) },
+        { data.scales.data(), data.scales.size() * sizeof(Float3) }, { data.parents.data(), data.parents.size() * sizeof(uint32_t) },
+        { data.meshes.data(), data.meshes.size() * sizeof(SceneMeshRecord) }, { data.lights.data(), data.lights.size() * sizeof(SceneLightRecord) },
+        { data.assets.data(), data.assets.size() * sizeof(SceneAssetRecord) }, { data.strings.data(), data.strings.size() },
+    };
+    static_assert(std::size(payloads) == size_t(SceneSection::Count));
+    size_t cursor = AlignUp(sizeof(h), kGgsceneAlignment);
+    for (size_t i = 0; i < std::size(payloads); ++i) { h.sections[i] = { uint64_t(cursor), uint64_t(payloads[i].second) }; cursor = AlignUp(cursor + payloads[i].second, kGgsceneAlignment); }
+    std::vector<uint8_t> image(cursor, 0);
+    memcpy(image.data(), &h, sizeof(h));
+    for (size_t i = 0; i < std::size(payloads); ++i) if (payloads[i].second) memcpy(image.data() + h.sections[i].offset, payloads[i].first, payloads[i].second);
+    return image;
+}
+
+bool WriteSceneFile(const std::filesystem::path& path, const SceneFileData& data) {
+    const std::vector<uint8_t> image = BuildSceneImage(data);
+    std::filesystem::path tmp = path; tmp += ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) return false;
+        f.write(reinterpret_cast<const char*>(image.data()), std::streamsize(image.size()));
+        if (!f) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) { std::filesystem::remove(tmp, ec); return false; }
+    return true;
+}
+
+bool SceneFile::open(const std::filesystem::path& path) {
+    close();
+    if (!file.open(path) || file.size() < sizeof(GgsceneHeader)) { close(); return false; }
+    header = reinterpret_cast<const GgsceneHeader*>(file.data());
+    if (!validate()) { close(); return false; }
+    return true;
+}
+
+bool SceneFile::validate() const {
+    const GgsceneHeader& h = *header;
+    if (h.magic != kGgsceneMagic || h.version != kGgsceneVersion) return false;
+    const uint64_t expected[] = { uint64_t(h.nodeCount) * sizeof(Float3), uint64_t(h.nodeCount) * sizeof(Float3), uint64_t(h.nodeCount) * sizeof(Float3), uint64_t(h.nodeCount) * sizeof(uint32_t),
+        uint64_t(h.meshCount) * sizeof(SceneMeshRecord), uint64_t(h.lightCount) * sizeof(SceneLightRecord), uint64_t(h.assetCount) * sizeof(SceneAssetRecord) };
+    for (size_t i = 0; i < size_t(SceneSection::Count); ++i) {
+        const GgsceneSectionEntry& e = h.sections[i];
+        if (e.offset % kGgsceneAlignment != 0 || e.offset > file.size() || e.byteSize > file.size() - e.offset) return false;
+        if (i < std::size(expected) && e.byteSize != expected[i]) return false;
+    }
+    const uint64_t stringBytes = h.sections[size_t(SceneSection::Strings)].byteSize;
+    auto validString = [&](SceneString s) { return uint64_t(s.offset) + s.length <= stringBytes; };
+    const uint32_t* up = parents();
+    for (uint32_t i = 0; i < h.nodeCount; ++i) if (up[i] != kSceneNoParent && up[i] >= i) return false;
+    for (uint32_t i = 0; i < h.meshCount; ++i) { const SceneMeshRecord& m = meshes()[i]; if (m.node >= h.nodeCount || (m.asset != kSceneBuiltinCube && m.asset >= h.assetCount) || !validString(m.name)) return false; }
+    for (uint32_t i = 0; i < h.lightCount; ++i) { const SceneLightRecord& l = lights()[i]; if (l.node >= h.nodeCount || !validString(l.name)) return false; }
+    for (uint32_t i = 0; i < h.assetCount; ++i) if (!validString(assets()[i].key)) return false;
+    return true;
+}
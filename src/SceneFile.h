@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+#include "MathTypes.h"
+
+constexpr uint32_t kGgsceneMagic = 0x43534747u;
+constexpr uint32_t kGgsceneVersion = 1;
+constexpr size_t kGgsceneAlignment = 64;
+// Asset slot for meshes that use the engine's built-in cube instead of a cooked asset.
+constexpr uint32_t kSceneBuiltinCube = ~0u;
+constexpr uint32_t kSceneNoParent = ~0u;
+
+// Nodes are stored as parallel arrays in TransformStore slot order, so parents always precede their children.
+enum class SceneSection : uint32_t { Positions, EulerDegrees, Scales, Parents, Meshes, Lights, Assets, Strings, Count };
+
+struct GgsceneSectionEntry {
+    uint64_t offset;
+    uint64_t byteSize;
+};
+
+struct SceneCamera {
+    Float3 position{};
+    float yaw{0.0f};
+    float pitch{0.0f};
+};
+
+struct GgsceneHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t meshCount;
+    uint32_t lightCount;
+    uint32_t assetCount;
+    SceneCamera camera;
+    uint32_t reserved;
+    GgsceneSectionEntry sections[size_t(SceneSection::Count)];
+};
+
+// UTF-8 bytes in the string section.
+struct SceneString {
+    uint32_t offset{0};
+    uint32_t length{0};
+};
+
+struct SceneMeshRecord {
+    uint32_t node;
+    uint32_t asset;   // slot in the asset table, or kSceneBuiltinCube
+    uint32_t materialId;
+    SceneString name;
+};
+
+struct SceneLightRecord {
+    uint32_t node;
+    Float3 color;
+    float intensity;
+    SceneString name;
+};
+
+// Cooked mesh assets are referenced by their asset index key (the source path relative to the asset root); id is
+// a hash of that key, so the same asset keeps its id across saves.
+struct SceneAssetRecord {
+    uint64_t id;
+    SceneString key;
+};
+
+static_assert(sizeof(GgsceneHeader) == 176, "ggscene header layout changed");
+static_assert(sizeof(SceneMeshRecord) == 20, "ggscene mesh record layout changed");
+static_assert(sizeof(SceneLightRecord) == 28, "ggscene light record layout changed");
+static_assert(sizeof(SceneAssetRecord) == 16, "ggscene asset record layout changed");
+
+// What a save collects before it is laid out on disk.
+struct SceneFileData {
+    SceneCamera camera;
+    std::vector<Float3> positions, eulerDegrees, scales;
+    std::vector<uint32_t> parents;
+    std::vector<SceneMeshRecord> meshes;
+    std::vector<SceneLightRecord> lights;
+    std::vector<SceneAssetRecord> assets;
+    std::string strings;
+    std::unordered_map<uint64_t, uint32_t> assetSlots;
+
+    void resizeNodes(size_t count) { positions.resize(count); eulerDegrees.resize(count); scales.resize(count); parents.resize(count); }
+    SceneString addString(std::string_view text);
+    // Returns the asset table slot for key, adding it on first use.
+    uint32_t addAsset(std::string_view key);
+};
+
+std::vector<uint8_t> BuildSceneImage(const SceneFileData& data);
+bool WriteSceneFile(const std::filesystem::path& path, const SceneFileData& data);
+
+// Read-only view of a mapped scene file. open() validates every index and string reference, so callers can copy
+// the arrays straight into the scene.
+class SceneFile {
+public:
+    bool open(const std::filesystem::path& path);
+    void close() { header = nullptr; file.close(); }
+    bool isOpen() const { return header != nullptr; }
+    const GgsceneHeader& info() const { return *header; }
+
+    const Float3* positions() const { return section<Float3>(SceneSection::Positions); }
+    const Float3* eulerDegrees() const { return section<Float3>(SceneSection::EulerDegrees); }
+    const Float3* scales() const { return section<Float3>(SceneSection::Scales); }
+    const uint32_t* parents() const { return section<uint32_t>(SceneSection::Parents); }
+    const SceneMeshRecord* meshes() const { return section<SceneMeshRecord>(SceneSection::Meshes); }
+    const SceneLightRecord* lights() const { return section<SceneLightRecord>(SceneSection::Lights); }
+    const SceneAssetRecord* assets() const { return section<SceneAssetRecord>(SceneSection::Assets); }
+    std::string_view string(SceneString s) const { return { section<char>(SceneSection::Strings) + s.offset, s.length }; }
+
+private:
+    template <typename T> const T* section(SceneSection s) const { return reinterpret_cast<const T*>(file.data() + header->sections[size_t(s)].offset); }
+    bool validate() const;
+
+    MappedFile file;
+    const GgsceneHeader* header{nullptr};
+};
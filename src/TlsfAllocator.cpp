@@ -0,0 +1,170 @@
+#include "TlsfAllocator.h"
+#include <algorithm>
+#include <bit>
+
+void TlsfAllocator::mapping(uint64_t units, uint32_t& fl, uint32_t& sl) {
+    if (units < kSlCount) { fl = 0; sl = uint32_t(units); return; }
+    const uint32_t msb = uint32_t(std::bit_width(units) - 1);
+    fl = msb - kSlBits + 1;
+    sl = uint32_t(units >> (msb - kSlBits)) - kSlCount;
+}
+
+void TlsfAllocator::reset(uint64_t capacity) {
+    nodes.clear(); spareNodes.clear(); pendingFrees.clear();
+    flBitmap = 0; slBitmap.fill(0); for (auto& row : heads) row.fill(kNone);
+    totalCapacity = std::min<uint64_t>(capacity / kGranularity, (1ull << (kFlCount + kSlBits - 1)) - 1) * kGranularity;
+    used = peakUsed = pendingBytes = failures = 0; liveAllocations = freeBlocks = 0;
+    if (totalCapacity == 0) return;
+    const uint32_t n = newNode(); nodes[n].size = totalCapacity; insertFree(n);
+}
+
+uint32_t TlsfAllocator::newNode() {
+    if (!spareNodes.empty()) { const uint32_t n = spareNodes.back(); spareNodes.pop_back(); return n; }
+    nodes.emplace_back(); return uint32_t(nodes.size() - 1);
+}
+
+void TlsfAllocator::insertFree(uint32_t n) {
+    uint32_t fl, sl; mapping(nodes[n].size / kGranularity, fl, sl);
+    Node& node = nodes[n]; node.prevFree = kNone; node.nextFree = heads[fl][sl];
+    if (node.nextFree != kNone) nodes[node.nextFree].prevFree = n;
+    heads[fl][sl] = n; slBitmap[fl] |= 1u << sl; flBitmap |= 1ull << fl; ++freeBlocks;
+}
+
+void TlsfAllocator::removeFree(uint32_t n) {
+    Node& node = nodes[n];
+    if (node.prevFree != kNone) nodes[node.prevFree].nextFree = node.nextFree;
+    else {
+        uint32_t fl, sl; mapping(node.size / kGranularity, fl, sl);
+        heads[fl][sl] = node.nextFree;
+        if (node.nextFree == kNone) { slBitmap[fl] &= ~(1u << sl); if (!slBitmap[fl]) flBitmap &= ~(1ull << fl); }
+    }
+    if (node.nextFree != kNone) nodes[node.nextFree].prevFree = node.prevFree;
+    node.prevFree = node.nextFree = kNone; --freeBlocks;
+}
+
+uint32_t TlsfAllocator::findFree(uint64_t size) const {
+    uint64_t units = size / kGranularity;
+    if (units >= kSlCount) units += (1ull << (std::bit_width(units) - 1 - kSlBits)) - 1;
+    uint32_t fl, sl; mapping(units, fl, sl);
+    if (fl < kFlCount) {
+        uint32_t slMap = slBitmap[fl] & (~0u << sl);
+        const uint64_t flMap = flBitmap & (~0ull << (fl + 1));
+        if (!slMap && flMap) { fl = uint32_t(std::countr_zero(flMap)); slMap = slBitmap[fl]; }
+        if (slMap) return heads[fl][std::countr_zero(slMap)];
+    }
+    // Rounding up to the next class skips blocks of the request's own class that may still fit; scan that one list
+    // before failing, so a request near the size of the largest free block (e.g. the whole heap) still succeeds.
+    mapping(size / kGranularity, fl, sl);
+    if (fl >= kFlCount) return kNone;
+    for (uint32_t n = heads[fl][sl]; n != kNone; n = nodes[n].nextFree) if (nodes[n].size >= size) return n;
+    return kNone;
+}
+
+void TlsfAllocator::trimFront(uint32_t n, uint64_t bytes) {
+    const uint32_t f = newNode();
+    Node& node = nodes[n]; Node& front = nodes[f];
+    front.offset = node.offset; front.size = bytes; front.prevPhysical = node.prevPhysical; front.nextPhysical = n;
+    if (node.prevPhysical != kNone) nodes[node.prevPhysical].nextPhysical = f;
+    node.prevPhysical = f; node.offset += bytes; node.size -= bytes;
+    insertFree(f);
+}
+
+void TlsfAllocator::trimBack(uint32_t n, uint64_t size) {
+    if (nodes[n].size - size < kGranularity) return;
+    const uint32_t b = newNode();
+    Node& node = nodes[n]; Node& back = nodes[b];
+    back.offset = node.offset + size; back.size = node.size - size; back.prevPhysical = n; back.nextPhysical = node.nextPhysical;
+    if (node.nextPhysical != kNone) nodes[node.nextPhysical].prevPhysical = b;
+    node.nextPhysical = b; node.size = size;
+    insertFree(b);
+}
+
+TlsfAllocation TlsfAllocator::allocate(uint64_t size, uint64_t alignment) {
+    alignment = std::max(std::bit_ceil(alignment), kGranularity);
+    size = (std::max<uint64_t>(size, 1) + kGranularity - 1) & ~(kGranularity - 1);
+    const uint32_t n = findFree(size + alignment - kGranularity);
+    if (n == kNone) { ++failures; return {}; }
+    removeFree(n);
+    const uint64_t aligned = (nodes[n].offset + alignment - 1) & ~(alignment - 1);
+    if (aligned != nodes[n].offset) trimFront(n, aligned - nodes[n].offset);
+    trimBack(n, size);
+    nodes[n].used = true; used += nodes[n].size; peakUsed = std::max(peakUsed, used); ++liveAllocations;
+    return { nodes[n].offset, n };
+}
+
+void TlsfAllocator::free(TlsfAllocation allocation) {
+    if (!allocation.isValid() || allocation.node >= nodes.size() || !nodes[allocation.node].used) return;
+    uint32_t n = allocation.node;
+    nodes[n].used = false; used -= nodes[n].size; --liveAllocations;
+    const uint32_t p = nodes[n].prevPhysical;
+    if (p != kNone && !nodes[p].used) {
+        removeFree(p);
+        nodes[p].size += nodes[n].size; nodes[p].nextPhysical = nodes[n].nextPhysical;
+        if (nodes[n].nextPhysical != kNone) nodes[nodes[n].nextPhysical].prevPhysical = p;
+        releaseNode(n); n = p;
+    }
+    const uint32_t q = nodes[n].nextPhysical;
+    if (q != kNone && !nodes[q].used) {
+        removeFree(q);
+        nodes[n].size += nodes[q].size; nodes[n].nextPhysical = nodes[q].nextPhysical;
+        if (nodes[q].nextPhysical != kNone) nodes[nodes[q].nextPhysical].prevPhysical = n;
+        releaseNode(q);
+    }
+    insertFree(n);
+}
+
+void TlsfAllocator::freeAfter(TlsfAllocation allocation, uint64_t fenceValue) {
+    if (!allocation.isValid()) return;
+    pendingBytes += nodes[allocation.node].size;
+    pendingFrees.push_back({ allocation, fenceValue });
+}
+
+void TlsfAllocator::retire(uint64_t completedFenceValue) {
+    while (!pendingFrees.empty() && pendingFrees.front().fenceValue <= completedFenceValue) {
+        const TlsfAllocation a = pendingFrees.front().allocation; pendingFrees.pop_front();
+        pendingBytes -= nodes[a.node].size; free(a);
+    }
+}
+
+TlsfStats TlsfAllocator::stats() const {
+    TlsfStats s;
+    s.capacity = totalCapacity; s.usedBytes = used; s.peakUsedBytes = peakUsed; s.pendingFreeBytes = pendingBytes;
+    s.allocationCount = liveAllocations; s.freeBlockCount = freeBlocks; s.failedAllocations = failures;
+    if (flBitmap) {
+        const uint32_t fl = uint32_t(std::bit_width(flBitmap) - 1), sl = uint32_t(std::bit_width(slBitmap[fl]) - 1);
+        for (uint32_t n = heads[fl][sl]; n != kNone; n = nodes[n].nextFree) s.largestFreeBlock = std::max(s.largestFreeBlock, nodes[n].size);
+    }
+    const uint64_t freeBytes = totalCapacity - used;
+    s.fragmentation = freeBytes ? 1.0 - double(s.largestFreeBlock) / double(freeBytes) : 0.0;
+    return s;
+}
+
+bool TlsfAllocator::validate() const {
+    if (totalCapacity == 0) return flBitmap == 0 && liveAllocations == 0 && freeBlocks == 0;
+    uint32_t first = kNone, blocks = 0;
+    for (uint32_t n = 0; n < nodes.size(); ++n) if (nodes[n].size && nodes[n].prevPhysical == kNone) { if (first != kNone) return false; first = n; }
+    if (first == kNone) return false;
+    uint64_t offset = 0, usedBytes = 0; uint32_t usedBlocks = 0, freeCount = 0;
+    for (uint32_t n = first, prev = kNone; n != kNone; prev = n, n = nodes[n].nextPhysical) {
+        const Node& node = nodes[n];
+        if (++blocks > nodes.size() || node.prevPhysical != prev || node.offset != offset || node.size == 0 || node.size % kGranularity) return false;
+        if (!node.used && prev != kNone && !nodes[prev].used) return false;   // neighbours must have been merged
+        if (node.used) { usedBytes += node.size; ++usedBlocks; } else ++freeCount;
+        offset += node.size;
+    }
+    if (offset != totalCapacity || usedBytes != used || usedBlocks != liveAllocations || freeCount != freeBlocks) return false;
+    uint32_t listed = 0;
+    for (uint32_t fl = 0; fl < kFlCount; ++fl) {
+        if (bool(flBitmap & (1ull << fl)) != (slBitmap[fl] != 0)) return false;
+        for (uint32_t sl = 0; sl < kSlCount; ++sl) {
+            if (bool(slBitmap[fl] & (1u << sl)) != (heads[fl][sl] != kNone)) return false;
+            for (uint32_t n = heads[fl][sl], prev = kNone; n != kNone; prev = n, n = nodes[n].nextFree) {
+                uint32_t f, s; mapping(nodes[n].size / kGranularity, f, s);
+                if (++listed > freeBlocks || nodes[n].used || nodes[n].prevFree != prev || f != fl || s != sl) return false;
+            }
+        }
+    }
+    uint64_t pending = 0;
+    for (const PendingFree& p : pendingFrees) { if (p.allocation.node >= nodes.size() || !nodes[p.allocation.node].used) return false; pending += nodes[p.allocation.node].size; }
+    return listed == freeBlocks && pending == pendingBytes;
+}
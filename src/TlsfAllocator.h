@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+struct TlsfAllocation {
+    uint64_t offset{~0ull};
+    uint32_t node{~0u};
+    bool isValid() const { return node != ~0u; }
+};
+
+struct TlsfStats {
+    uint64_t capacity{0};
+    uint64_t usedBytes{0};
+    uint64_t peakUsedBytes{0};
+    uint64_t pendingFreeBytes{0};
+    uint64_t largestFreeBlock{0};
+    uint32_t allocationCount{0};
+    uint32_t freeBlockCount{0};
+    uint64_t failedAllocations{0};
+    // 0 when all free space is one block; approaches 1 as free space splinters.
+    double fragmentation{0.0};
+};
+
+// Two-level segregated fit over an abstract [0, capacity) range; owns no memory, so it can back GPU heaps or be fuzzed on the CPU.
+class TlsfAllocator {
+public:
+    static constexpr uint64_t kGranularity = 256;
+
+    explicit TlsfAllocator(uint64_t capacity = 0) { reset(capacity); }
+    void reset(uint64_t capacity);
+    TlsfAllocation allocate(uint64_t size, uint64_t alignment = kGranularity);
+    void free(TlsfAllocation allocation);
+    void freeAfter(TlsfAllocation allocation, uint64_t fenceValue);
+    void retire(uint64_t completedFenceValue);
+
+    uint64_t capacity() const { return totalCapacity; }
+    uint64_t allocationSize(TlsfAllocation allocation) const { return nodes[allocation.node].size; }
+    TlsfStats stats() const;
+    // Walks the physical block chain and every free list and checks they agree with each other and with the counters;
+    // linear in the block count, for tests and debug checks.
+    bool validate() const;
+
+private:
+    static constexpr uint32_t kNone = ~0u;
+    static constexpr uint32_t kSlBits = 4;
+    static constexpr uint32_t kSlCount = 1u << kSlBits;
+    static constexpr uint32_t kFlCount = 40;
+
+    struct Node {
+        uint64_t offset{0};
+        uint64_t size{0};
+        uint32_t prevPhysical{kNone};
+        uint32_t nextPhysical{kNone};
+        uint32_t prevFree{kNone};
+        uint32_t nextFree{kNone};
+        bool used{false};
+    };
+    struct PendingFree { TlsfAllocation allocation; uint64_t fenceValue; };
+
+    static void mapping(uint64_t units, uint32_t& fl, uint32_t& sl);
+    uint32_t newNode();
+    void insertFree(uint32_t n);
+    void removeFree(uint32_t n);
+    uint32_t findFree(uint64_t size) const;
+    void trimFront(uint32_t n, uint64_t bytes);
+    void trimBack(uint32_t n, uint64_t size);
+    void releaseNode(uint32_t n) { nodes[n] = Node{}; spareNodes.push_back(n); }
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> spareNodes;
+    uint64_t flBitmap{0};
+    std::array<uint32_t, kFlCount> slBitmap{};
+    std::array<std::array<uint32_t, kSlCount>, kFlCount> heads{};
+    std::deque<PendingFree> pendingFrees;
+    uint64_t totalCapacity{0};
+    uint64_t used{0};
+    uint64_t peakUsed{0};
+    uint64_t pendingBytes{0};
+    uint64_t failures{0};
+    uint32_t liveAllocations{0};
+    uint32_t freeBlocks{0};
+};
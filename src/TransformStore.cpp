@@ -0,0 +1,248 @@
+#include "TransformStore.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <bit>
+#include <cmath>
+#include <type_traits>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define GGINE_TRANSFORM_SSE 1
+#endif
+
+Float4 QuaternionFromEulerDegrees(const Float3& e) {
+    const float k = 3.14159265358979f / 360.0f;
+    const float sp = std::sin(e.x * k), cp = std::cos(e.x * k);
+    const float sy = std::sin(e.y * k), cy = std::cos(e.y * k);
+    const float sr = std::sin(e.z * k), cr = std::cos(e.z * k);
+    return { sp * cy * cr + cp * sy * sr, cp * sy * cr - sp * cy * sr, cp * cy * sr - sp * sy * cr, cp * cy * cr + sp * sy * sr };
+}
+
+void ComputeWorldMatrices(const uint32_t* slots, size_t count, const float* px, const float* py, const float* pz, const float* qx, const float* qy, const float* qz, const float* qw, const float* sx, const float* sy, const float* sz, Float4x4* outWorld) {
+    size_t n = 0;
+#if defined(GGINE_TRANSFORM_SSE)
+    const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps();
+    for (; n + 4 <= count; n += 4) {
+        const uint32_t a = slots[n], b = slots[n + 1], c = slots[n + 2], d = slots[n + 3];
+        __m128 x, y, z, w, tx, ty, tz, kx, ky, kz;
+        if (d == a + 3 && c == a + 2 && b == a + 1) {
+            x = _mm_loadu_ps(qx + a); y = _mm_loadu_ps(qy + a); z = _mm_loadu_ps(qz + a); w = _mm_loadu_ps(qw + a);
+            tx = _mm_loadu_ps(px + a); ty = _mm_loadu_ps(py + a); tz = _mm_loadu_ps(pz + a);
+            kx = _mm_loadu_ps(sx + a); ky = _mm_loadu_ps(sy + a); kz = _mm_loadu_ps(sz + a);
+        } else {
+            x = _mm_setr_ps(qx[a], qx[b], qx[c], qx[d]); y = _mm_setr_ps(qy[a], qy[b], qy[c], qy[d]); z = _mm_setr_ps(qz[a], qz[b], qz[c], qz[d]); w = _mm_setr_ps(qw[a], qw[b], qw[c], qw[d]);
+            tx = _mm_setr_ps(px[a], px[b], px[c], px[d]); ty = _mm_setr_ps(py[a], py[b], py[c], py[d]); tz = _mm_setr_ps(pz[a], pz[b], pz[c], pz[d]);
+            kx = _mm_setr_ps(sx[a], sx[b], sx[c], sx[d]); ky = _mm_setr_ps(sy[a], sy[b], sy[c], sy[d]); kz = _mm_setr_ps(sz[a], sz[b], sz[c], sz[d]);
+        }
+        const __m128 x2 = _mm_mul_ps(x, two), y2 = _mm_mul_ps(y, two), z2 = _mm_mul_ps(z, two);
+        const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+        const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+        const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+        __m128 r0x = _mm_mul_ps(kx, _mm_sub_ps(one, _mm_add_ps(yy, zz))), r0y = _mm_mul_ps(kx, _mm_add_ps(xy, wz)), r0z = _mm_mul_ps(kx, _mm_sub_ps(xz, wy)), r0w = zero;
+        __m128 r1x = _mm_mul_ps(ky, _mm_sub_ps(xy, wz)), r1y = _mm_mul_ps(ky, _mm_sub_ps(one, _mm_add_ps(xx, zz))), r1z = _mm_mul_ps(ky, _mm_add_ps(yz, wx)), r1w = zero;
+        __m128 r2x = _mm_mul_ps(kz, _mm_add_ps(xz, wy)), r2y = _mm_mul_ps(kz, _mm_sub_ps(yz, wx)), r2z = _mm_mul_ps(kz, _mm_sub_ps(one, _mm_add_ps(xx, yy))), r2w = zero;
+        __m128 r3w = one;
+        _MM_TRANSPOSE4_PS(r0x, r0y, r0z, r0w);
+        _MM_TRANSPOSE4_PS(r1x, r1y, r1z, r1w);
+        _MM_TRANSPOSE4_PS(r2x, r2y, r2z, r2w);
+        _MM_TRANSPOSE4_PS(tx, ty, tz, r3w);
+        const uint32_t s[4] = { a, b, c, d };
+        const __m128 row0[4] = { r0x, r0y, r0z, r0w }, row1[4] = { r1x, r1y, r1z, r1w }, row2[4] = { r2x, r2y, r2z, r2w }, row3[4] = { tx, ty, tz, r3w };
+        for (int j = 0; j < 4; ++j) {
+            float* m = &outWorld[s[j]].m[0][0];
+            _mm_storeu_ps(m, row0[j]); _mm_storeu_ps(m + 4, row1[j]); _mm_storeu_ps(m + 8, row2[j]); _mm_storeu_ps(m + 12, row3[j]);
+        }
+    }
+#endif
+    for (; n < count; ++n) {
+        const uint32_t i = slots[n];
+        const float x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+        const float xx = 2 * x * x, yy = 2 * y * y, zz = 2 * z * z, xy = 2 * x * y, xz = 2 * x * z, yz = 2 * y * z, wx = 2 * w * x, wy = 2 * w * y, wz = 2 * w * z;
+        Float4x4& m = outWorld[i];
+        m.m[0][0] = sx[i] * (1 - yy - zz); m.m[0][1] = sx[i] * (xy + wz); m.m[0][2] = sx[i] * (xz - wy); m.m[0][3] = 0;
+        m.m[1][0] = sy[i] * (xy - wz); m.m[1][1] = sy[i] * (1 - xx - zz); m.m[1][2] = sy[i] * (yz + wx); m.m[1][3] = 0;
+        m.m[2][0] = sz[i] * (xz + wy); m.m[2][1] = sz[i] * (yz - wx); m.m[2][2] = sz[i] * (1 - xx - yy); m.m[2][3] = 0;
+        m.m[3][0] = px[i]; m.m[3][1] = py[i]; m.m[3][2] = pz[i]; m.m[3][3] = 1;
+    }
+}
+
+Float4x4 MultiplyTransform(const Float4x4& a, const Float4x4& b) {
+    Float4x4 r;
+#if defined(GGINE_TRANSFORM_SSE)
+    const __m128 b0 = _mm_loadu_ps(b.m[0]), b1 = _mm_loadu_ps(b.m[1]), b2 = _mm_loadu_ps(b.m[2]), b3 = _mm_loadu_ps(b.m[3]);
+    for (int i = 0; i < 4; ++i) _mm_storeu_ps(r.m[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a.m[i][0]), b0), _mm_mul_ps(_mm_set1_ps(a.m[i][1]), b1)), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a.m[i][2]), b2), _mm_mul_ps(_mm_set1_ps(a.m[i][3]), b3))));
+#else
+    for (int i = 0; i < 4; ++i) for (int j = 0; j < 4; ++j) r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+#endif
+    return r;
+}
+
+Float3 InverseTransformPoint(const Float4x4& m, const Float3& p) {
+    const float (*a)[4] = m.m;
+    const float det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    const float inv = det != 0.0f ? 1.0f / det : 0.0f;
+    const float i00 = (a[1][1] * a[2][2] - a[1][2] * a[2][1]) * inv, i01 = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * inv, i02 = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * inv;
+    const float i10 = (a[1][2] * a[2][0] - a[1][0] * a[2][2]) * inv, i11 = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * inv, i12 = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * inv;
+    const float i20 = (a[1][0] * a[2][1] - a[1][1] * a[2][0]) * inv, i21 = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * inv, i22 = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * inv;
+    const Float3 d{ p.x - a[3][0], p.y - a[3][1], p.z - a[3][2] };
+    return { d.x * i00 + d.y * i10 + d.z * i20, d.x * i01 + d.y * i11 + d.z * i21, d.x * i02 + d.y * i12 + d.z * i22 };
+}
+
+TransformHandle TransformStore::create(const Float3& position, const Float3& eulerDegrees, const Float3& scale, TransformHandle parent) {
+    uint32_t index;
+    if (!freeList.empty()) { index = freeList.back(); freeList.pop_back(); }
+    else { index = uint32_t(sparse.size()); sparse.push_back({ kNone, 0 }); }
+    const uint32_t i = uint32_t(owner.size());
+    sparse[index].dense = i;
+    owner.push_back(index);
+    const Float4 q = QuaternionFromEulerDegrees(eulerDegrees);
+    px.push_back(position.x); py.push_back(position.y); pz.push_back(position.z);
+    qx.push_back(q.x); qy.push_back(q.y); qz.push_back(q.z); qw.push_back(q.w);
+    sx.push_back(scale.x); sy.push_back(scale.y); sz.push_back(scale.z);
+    euler.push_back(eulerDegrees);
+    worldMatrices.emplace_back();
+    payload.push_back(~0u);
+    links.emplace_back();
+    // Appending keeps the order topological: the parent already has a lower slot.
+    if (isAlive(parent)) link(i, dense(parent));
+    if (dirtyBits.size() * 64 < owner.size()) dirtyBits.push_back(0);
+    markDirty(i);
+    return { index, sparse[index].generation };
+}
+
+void TransformStore::destroy(TransformHandle h) {
+    if (!isAlive(h)) return;
+    const uint32_t i = dense(h), up = links[i].parent;
+    while (links[i].firstChild != kNone) { const uint32_t c = links[i].firstChild; unlink(c); link(c, up); markDirty(c); }
+    unlink(i);
+    if ((dirtyBits[i >> 6] >> (i & 63)) & 1) { dirtyBits[i >> 6] &= ~(1ull << (i & 63)); --dirtyTotal; }
+    sparse[h.index].dense = kNone; ++sparse[h.index].generation;
+    freeList.push_back(h.index);
+    const uint32_t last = uint32_t(owner.size() - 1);
+    // Swapping the last slot in is only allowed when its parent still comes first; otherwise close the gap in order.
+    if (i != last && links[last].parent != kNone && links[last].parent > i) {
+        orderScratch.clear(); for (uint32_t k = 0; k <= last; ++k) if (k != i) orderScratch.push_back(k);
+        reorder(orderScratch);
+        return;
+    }
+    if (i != last) moveSlot(last, i);
+    px.pop_back(); py.pop_back(); pz.pop_back(); qx.pop_back(); qy.pop_back(); qz.pop_back(); qw.pop_back();
+    sx.pop_back(); sy.pop_back(); sz.pop_back(); euler.pop_back(); worldMatrices.pop_back(); payload.pop_back(); owner.pop_back(); links.pop_back();
+}
+
+void TransformStore::reserve(size_t count) {
+    for (std::vector<float>* v : { &px, &py, &pz, &qx, &qy, &qz, &qw, &sx, &sy, &sz }) v->reserve(count);
+    euler.reserve(count); worldMatrices.reserve(count); payload.reserve(count); owner.reserve(count); links.reserve(count); sparse.reserve(count); dirtyBits.reserve((count + 63) / 64);
+}
+
+void TransformStore::append(size_t count, const Float3* positions, const Float3* eulerDegrees, const Float3* scales, const uint32_t* parents, TransformHandle* outHandles) {
+    reserve(owner.size() + count);
+    for (size_t k = 0; k < count; ++k) outHandles[k] = create(positions[k], eulerDegrees[k], scales[k], parents[k] < k ? outHandles[parents[k]] : TransformHandle{});
+}
+
+void TransformStore::exportSlots(Float3* positions, Float3* eulerDegrees, Float3* scales, uint32_t* parents) const {
+    for (uint32_t i = 0; i < owner.size(); ++i) { positions[i] = { px[i], py[i], pz[i] }; eulerDegrees[i] = euler[i]; scales[i] = { sx[i], sy[i], sz[i] }; parents[i] = links[i].parent; }
+}
+
+bool TransformStore::setParent(TransformHandle h, TransformHandle parent) {
+    const bool toRoot = parent == TransformHandle{};
+    if (!isAlive(h) || (!toRoot && (!isAlive(parent) || parent == h || isAncestor(h, parent)))) return false;
+    const uint32_t i = dense(h), p = toRoot ? kNone : dense(parent);
+    if (links[i].parent == p) return true;
+    unlink(i); link(i, p); markDirty(i);
+    if (p == kNone || p < i) return true;
+    // The new parent sits above the subtree: move the subtree, in its current order, behind everything else.
+    const uint32_t count = uint32_t(owner.size());
+    std::vector<uint8_t> inSubtree(count - i, 0); inSubtree[0] = 1;
+    orderScratch.clear(); for (uint32_t k = 0; k < i; ++k) orderScratch.push_back(k);
+    for (uint32_t k = i + 1; k < count; ++k) { const uint32_t up = links[k].parent; if (up != kNone && up >= i && inSubtree[up - i]) inSubtree[k - i] = 1; else orderScratch.push_back(k); }
+    for (uint32_t k = i; k < count; ++k) if (inSubtree[k - i]) orderScratch.push_back(k);
+    reorder(orderScratch);
+    return true;
+}
+
+bool TransformStore::isAncestor(TransformHandle ancestor, TransformHandle h) const {
+    if (!isAlive(ancestor) || !isAlive(h)) return false;
+    const uint32_t a = dense(ancestor);
+    for (uint32_t i = links[dense(h)].parent; i != kNone && i >= a; i = links[i].parent) if (i == a) return true;
+    return false;
+}
+
+void TransformStore::link(uint32_t i, uint32_t parent) {
+    links[i].parent = parent;
+    if (parent == kNone) return;
+    Links& p = links[parent]; links[i].prev = p.lastChild; links[i].next = kNone;
+    if (p.lastChild != kNone) links[p.lastChild].next = i; else p.firstChild = i;
+    p.lastChild = i; ++linkedCount;
+}
+
+void TransformStore::unlink(uint32_t i) {
+    Links& l = links[i];
+    if (l.parent == kNone) return;
+    if (l.prev != kNone) links[l.prev].next = l.next; else links[l.parent].firstChild = l.next;
+    if (l.next != kNone) links[l.next].prev = l.prev; else links[l.parent].lastChild = l.prev;
+    l.parent = l.prev = l.next = kNone; --linkedCount;
+}
+
+void TransformStore::moveSlot(uint32_t from, uint32_t to) {
+    px[to] = px[from]; py[to] = py[from]; pz[to] = pz[from];
+    qx[to] = qx[from]; qy[to] = qy[from]; qz[to] = qz[from]; qw[to] = qw[from];
+    sx[to] = sx[from]; sy[to] = sy[from]; sz[to] = sz[from];
+    euler[to] = euler[from]; worldMatrices[to] = worldMatrices[from]; payload[to] = payload[from];
+    owner[to] = owner[from]; sparse[owner[to]].dense = to;
+    const Links l = links[to] = links[from];
+    if (l.parent != kNone) { (l.prev != kNone ? links[l.prev].next : links[l.parent].firstChild) = to; (l.next != kNone ? links[l.next].prev : links[l.parent].lastChild) = to; }
+    for (uint32_t c = l.firstChild; c != kNone; c = links[c].next) links[c].parent = to;
+    if ((dirtyBits[from >> 6] >> (from & 63)) & 1) { dirtyBits[from >> 6] &= ~(1ull << (from & 63)); --dirtyTotal; markDirty(to); }
+}
+
+// Rebuilds every slot array in the given order of old slots; slots left out are dropped.
+void TransformStore::reorder(const std::vector<uint32_t>& order) {
+    std::vector<uint32_t> remap(owner.size(), kNone);
+    for (uint32_t k = 0; k < order.size(); ++k) remap[order[k]] = k;
+    auto gather = [&](auto& values) { std::remove_reference_t<decltype(values)> out; out.reserve(order.size()); for (uint32_t i : order) out.push_back(values[i]); values.swap(out); };
+    for (std::vector<float>* v : { &px, &py, &pz, &qx, &qy, &qz, &qw, &sx, &sy, &sz }) gather(*v);
+    gather(euler); gather(worldMatrices); gather(payload); gather(owner); gather(links);
+    for (Links& l : links) for (uint32_t* i : { &l.parent, &l.firstChild, &l.lastChild, &l.prev, &l.next }) if (*i != kNone) *i = remap[*i];
+    for (uint32_t k = 0; k < owner.size(); ++k) sparse[owner[k]].dense = k;
+    std::vector<uint64_t> bits((order.size() + 63) / 64, 0); dirtyTotal = 0;
+    for (uint32_t k = 0; k < order.size(); ++k) if ((dirtyBits[order[k] >> 6] >> (order[k] & 63)) & 1) { bits[k >> 6] |= 1ull << (k & 63); ++dirtyTotal; }
+    dirtyBits.swap(bits);
+}
+
+void TransformStore::markDirty(uint32_t i) {
+    uint64_t& word = dirtyBits[i >> 6]; const uint64_t bit = 1ull << (i & 63);
+    if (!(word & bit)) { word |= bit; ++dirtyTotal; }
+}
+
+void TransformStore::setPosition(TransformHandle h, const Float3& v) { const uint32_t i = dense(h); px[i] = v.x; py[i] = v.y; pz[i] = v.z; markDirty(i); }
+
+void TransformStore::setEulerDegrees(TransformHandle h, const Float3& v) {
+    const uint32_t i = dense(h); const Float4 q = QuaternionFromEulerDegrees(v);
+    euler[i] = v; qx[i] = q.x; qy[i] = q.y; qz[i] = q.z; qw[i] = q.w; markDirty(i);
+}
+
+void TransformStore::setScale(TransformHandle h, const Float3& v) { const uint32_t i = dense(h); sx[i] = v.x; sy[i] = v.y; sz[i] = v.z; markDirty(i); }
+
+size_t TransformStore::updateWorldMatrices(JobSystem* jobs) {
+    PROFILE_ZONE("Update transforms");
+    dirtyScratch.clear();
+    if (dirtyTotal == 0) return 0;
+    for (size_t w = 0; w < dirtyBits.size(); ++w) {
+        if (linkedCount == 0) {
+            for (uint64_t bits = dirtyBits[w]; bits; bits &= bits - 1) dirtyScratch.push_back(uint32_t(w * 64 + size_t(std::countr_zero(bits))));
+            dirtyBits[w] = 0; continue;
+        }
+        // Children always sit above their parent, so the ones marked here are picked up later in this same scan.
+        for (uint64_t bits = dirtyBits[w]; bits; bits = dirtyBits[w]) {
+            const uint32_t i = uint32_t(w * 64 + size_t(std::countr_zero(bits)));
+            dirtyBits[w] = bits & (bits - 1); dirtyScratch.push_back(i);
+            for (uint32_t c = links[i].firstChild; c != kNone; c = links[c].next) markDirty(c);
+        }
+    }
+    auto compute = [this](uint32_t begin, uint32_t end) { ComputeWorldMatrices(dirtyScratch.data() + begin, end - begin, px.data(), py.data(), pz.data(), qx.data(), qy.data(), qz.data(), qw.data(), sx.data(), sy.data(), sz.data(), worldMatrices.data()); };
+    if (jobs) jobs->parallelFor(uint32_t(dirtyScratch.size()), kParallelGrain, compute);
+    else compute(0, uint32_t(dirtyScratch.size()));
+    if (linkedCount != 0) { PROFILE_ZONE("Compose hierarchy"); for (uint32_t i : dirtyScratch) if (links[i].parent != kNone) worldMatrices[i] = MultiplyTransform(worldMatrices[i], worldMatrices[links[i].parent]); }
+    dirtyTotal = 0;
+    return dirtyScratch.size();
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+class JobSystem;
+
+struct TransformHandle {
+    uint32_t index{~0u};
+    uint32_t generation{0};
+    bool operator==(const TransformHandle&) const = default;
+};
+
+Float4 QuaternionFromEulerDegrees(const Float3& eulerDegrees);
+void ComputeWorldMatrices(const uint32_t* slots, size_t count, const float* px, const float* py, const float* pz, const float* qx, const float* qy, const float* qz, const float* qw, const float* sx, const float* sy, const float* sz, Float4x4* outWorld);
+// Row-vector product: local * parent, i.e. the child's world matrix.
+Float4x4 MultiplyTransform(const Float4x4& local, const Float4x4& parent);
+// Maps a world-space point into the space of an affine row-vector matrix, e.g. the eye into a mesh's object space.
+Float3 InverseTransformPoint(const Float4x4& m, const Float3& p);
+
+// Transforms form a parent/child forest stored in dense arrays that stay topologically sorted (a parent's slot is
+// always below its children's), so one ascending pass over the dirty slots composes every world matrix after its
+// parent's. Moving a node dirties its whole subtree; untouched branches keep their cached matrices.
+
+class TransformStore {
+public:
+    TransformHandle create(const Float3& position = {0, 0, 0}, const Float3& eulerDegrees = {0, 0, 0}, const Float3& scale = {1, 1, 1}, TransformHandle parent = {});
+    // Children of a destroyed transform move up to its parent and keep their local transforms.
+    void destroy(TransformHandle h);
+    void reserve(size_t count);
+    // Bulk create for loaders. parents index into the same batch and must precede the child (~0u for a root).
+    void append(size_t count, const Float3* positions, const Float3* eulerDegrees, const Float3* scales, const uint32_t* parents, TransformHandle* outHandles);
+    // Writes every slot in order with parents as slot indices (~0u for roots): the input append() expects.
+    void exportSlots(Float3* positions, Float3* eulerDegrees, Float3* scales, uint32_t* parents) const;
+    uint32_t slotOf(TransformHandle h) const { return dense(h); }
+    bool isAlive(TransformHandle h) const { return h.index < sparse.size() && sparse[h.index].generation == h.generation && sparse[h.index].dense != kNone; }
+    size_t size() const { return owner.size(); }
+    // Upper bound on TransformHandle::index, for tables keyed by handle.
+    size_t handleCapacity() const { return sparse.size(); }
+
+    Float3 position(TransformHandle h) const { const uint32_t i = dense(h); return { px[i], py[i], pz[i] }; }
+    Float3 eulerDegrees(TransformHandle h) const { return euler[dense(h)]; }
+    Float3 scale(TransformHandle h) const { const uint32_t i = dense(h); return { sx[i], sy[i], sz[i] }; }
+    Float4 rotation(TransformHandle h) const { const uint32_t i = dense(h); return { qx[i], qy[i], qz[i], qw[i] }; }
+    const Float4x4& world(TransformHandle h) const { return worldMatrices[dense(h)]; }
+    uint32_t userData(TransformHandle h) const { return payload[dense(h)]; }
+    void setUserData(TransformHandle h, uint32_t value) { payload[dense(h)] = value; }
+
+    const std::vector<uint32_t>& lastUpdatedSlots() const { return dirtyScratch; }
+    const Float4x4& worldAt(uint32_t slot) const { return worldMatrices[slot]; }
+    uint32_t userDataAt(uint32_t slot) const { return payload[slot]; }
+    TransformHandle handleAt(uint32_t slot) const { return { owner[slot], sparse[owner[slot]].generation }; }
+
+    // Local values are relative to the parent; reparenting keeps them, so the node moves with its new parent.
+    // Fails (and changes nothing) when parent is dead or inside h's own subtree; an invalid parent makes h a root.
+    bool setParent(TransformHandle h, TransformHandle parent);
+    TransformHandle parent(TransformHandle h) const { return handleOf(links[dense(h)].parent); }
+    TransformHandle firstChild(TransformHandle h) const { return handleOf(links[dense(h)].firstChild); }
+    TransformHandle nextSibling(TransformHandle h) const { return handleOf(links[dense(h)].next); }
+    bool isAncestor(TransformHandle ancestor, TransformHandle h) const;
+
+    void setPosition(TransformHandle h, const Float3& v);
+    void setEulerDegrees(TransformHandle h, const Float3& v);
+    void setScale(TransformHandle h, const Float3& v);
+
+    size_t updateWorldMatrices(JobSystem* jobs = nullptr);
+    // Slots explicitly marked since the last update; their descendants are added when the update runs.
+    size_t dirtyCount() const { return dirtyTotal; }
+
+private:
+    static constexpr uint32_t kNone = ~0u;
+    static constexpr uint32_t kParallelGrain = 4096;
+    struct SparseEntry { uint32_t dense; uint32_t generation; };
+    struct Links { uint32_t parent{kNone}, firstChild{kNone}, lastChild{kNone}, prev{kNone}, next{kNone}; };
+
+    uint32_t dense(TransformHandle h) const { return sparse[h.index].dense; }
+    TransformHandle handleOf(uint32_t i) const { return i == kNone ? TransformHandle{} : handleAt(i); }
+    void markDirty(uint32_t i);
+    void link(uint32_t i, uint32_t parent);
+    void unlink(uint32_t i);
+    void moveSlot(uint32_t from, uint32_t to);
+    void reorder(const std::vector<uint32_t>& order);
+
+    std::vector<SparseEntry> sparse;
+    std::vector<uint32_t> freeList;
+    std::vector<uint32_t> owner;
+    std::vector<float> px, py, pz, qx, qy, qz, qw, sx, sy, sz;
+    std::vector<Float3> euler;
+    std::vector<Float4x4> worldMatrices;
+    std::vector<uint32_t> payload;
+    std::vector<Links> links;
+    std::vector<uint32_t> orderScratch;
+    std::vector<uint64_t> dirtyBits;
+    std::vector<uint32_t> dirtyScratch;
+    size_t dirtyTotal{0};
+    size_t linkedCount{0};
+};
@@ -0,0 +1,38 @@
+#include "UploadRing.h"
+#include <algorithm>
+
+void UploadRing::reset(uint64_t capacity) {
+    ringCapacity = capacity; head = 0; tail = 0; firstFrame = 0; frameCount = 0;
+    ringStats = UploadRingStats{};
+}
+
+void UploadRing::grow(uint64_t capacity) {
+    const UploadRingStats keep = ringStats;
+    reset(capacity);
+    ringStats = keep; ++ringStats.growCount;
+}
+
+uint64_t UploadRing::allocate(uint64_t size, uint64_t alignment) {
+    if (size == 0 || size > ringCapacity || alignment == 0 || (alignment & (alignment - 1)) != 0) return kInvalidOffset;
+    uint64_t physical = head % ringCapacity;
+    uint64_t aligned = (physical + alignment - 1) & ~(alignment - 1);
+    uint64_t newHead = head + (aligned - physical) + size;
+    if (aligned + size > ringCapacity) { aligned = 0; newHead = head + (ringCapacity - physical) + size; }
+    if (newHead - tail > ringCapacity) return kInvalidOffset;
+    ringStats.bytesThisFrame += newHead - head; ++ringStats.allocationsThisFrame;
+    head = newHead;
+    ringStats.highWaterMark = std::max(ringStats.highWaterMark, head - tail);
+    return aligned;
+}
+
+void UploadRing::endFrame(uint64_t fenceValue) {
+    if (frameCount == kMaxFramesInFlight) frames[(firstFrame + frameCount - 1) % kMaxFramesInFlight] = { fenceValue, head };
+    else frames[(firstFrame + frameCount++) % kMaxFramesInFlight] = { fenceValue, head };
+    ringStats.lastFrameBytes = ringStats.bytesThisFrame; ringStats.lastFrameAllocations = ringStats.allocationsThisFrame;
+    ringStats.peakFrameBytes = std::max(ringStats.peakFrameBytes, ringStats.bytesThisFrame);
+    ringStats.bytesThisFrame = 0; ringStats.allocationsThisFrame = 0;
+}
+
+void UploadRing::retire(uint64_t completedFenceValue) {
+    while (frameCount && frames[firstFrame].fenceValue <= completedFenceValue) { tail = frames[firstFrame].end; firstFrame = (firstFrame + 1) % kMaxFramesInFlight; --frameCount; }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+struct UploadRingStats {
+    uint64_t bytesThisFrame{0};
+    uint64_t lastFrameBytes{0};
+    uint64_t peakFrameBytes{0};
+    uint64_t highWaterMark{0};
+    uint32_t allocationsThisFrame{0};
+    uint32_t lastFrameAllocations{0};
+    uint32_t growCount{0};
+};
+
+class UploadRing {
+public:
+    static constexpr uint64_t kInvalidOffset = ~0ull;
+    // Frame marks are kept in a fixed ring sized for a swap chain of kMaxFramesInFlight - 1 buffers plus the frame
+    // being recorded, so ending a frame never allocates. Past that, endFrame folds the new frame into the newest mark,
+    // which then retires with the later fence.
+    static constexpr uint32_t kMaxFramesInFlight = 3;
+
+    explicit UploadRing(uint64_t capacity = 0) { reset(capacity); }
+    void reset(uint64_t capacity);
+    void grow(uint64_t capacity);
+    uint64_t allocate(uint64_t size, uint64_t alignment);
+    void endFrame(uint64_t fenceValue);
+    void retire(uint64_t completedFenceValue);
+
+    uint64_t capacity() const { return ringCapacity; }
+    uint64_t bytesInFlight() const { return head - tail; }
+    const UploadRingStats& stats() const { return ringStats; }
+
+private:
+    struct FrameMark { uint64_t fenceValue; uint64_t end; };
+
+    uint64_t ringCapacity{0};
+    uint64_t head{0};
+    uint64_t tail{0};
+    FrameMark frames[kMaxFramesInFlight]{};
+    uint32_t firstFrame{0};
+    uint32_t frameCount{0};
+    UploadRingStats ringStats;
+};
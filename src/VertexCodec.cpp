@@ -0,0 +1,133 @@
+#include "VertexCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+PositionDequantize PositionDequantizeFor(const Aabb& bounds) {
+    return { { (bounds.max.x - bounds.min.x) / 65535.0f, (bounds.max.y - bounds.min.y) / 65535.0f, (bounds.max.z - bounds.min.z) / 65535.0f }, bounds.min };
+}
+
+void QuantizePositions(const Float3* positions, size_t count, const PositionDequantize& d, QuantizedPosition* out, const uint32_t* normals) {
+    const Float3 inv{ d.scale.x > 0.0f ? 1.0f / d.scale.x : 0.0f, d.scale.y > 0.0f ? 1.0f / d.scale.y : 0.0f, d.scale.z > 0.0f ? 1.0f / d.scale.z : 0.0f };
+    auto quantize = [](float v, float lo, float invScale) { return uint16_t(std::clamp((v - lo) * invScale, 0.0f, 65535.0f) + 0.5f); };
+    for (size_t i = 0; i < count; ++i) {
+        const Float3& p = positions[i];
+        out[i] = { quantize(p.x, d.offset.x, inv.x), quantize(p.y, d.offset.y, inv.y), quantize(p.z, d.offset.z, inv.z), normals ? NarrowOctahedral(normals[i]) : uint16_t(0) };
+    }
+}
+
+Float3 DequantizePosition(const QuantizedPosition& q, const PositionDequantize& d) {
+    return { d.offset.x + float(q.x) * d.scale.x, d.offset.y + float(q.y) * d.scale.y, d.offset.z + float(q.z) * d.scale.z };
+}
+
+void PackFloatVertices(const Float3* positions, const uint32_t* normals, size_t count, FloatVertex* out) {
+    for (size_t i = 0; i < count; ++i) out[i] = { positions[i], normals ? normals[i] : 0u };
+}
+
+uint32_t EncodeOctahedral(const Float3& n) {
+    const float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    float x = l1 > 0.0f ? n.x / l1 : 0.0f, y = l1 > 0.0f ? n.y / l1 : 0.0f;
+    if (n.z < 0.0f) { const float ox = x; x = (1.0f - std::fabs(y)) * (ox >= 0.0f ? 1.0f : -1.0f); y = (1.0f - std::fabs(ox)) * (y >= 0.0f ? 1.0f : -1.0f); }
+    auto snorm = [](float v) { return uint32_t(uint16_t(int16_t(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f)))); };
+    return snorm(x) | (snorm(y) << 16);
+}
+
+Float3 DecodeOctahedral(uint32_t packed) {
+    float x = std::max(float(int16_t(packed & 0xFFFF)) / 32767.0f, -1.0f), y = std::max(float(int16_t(packed >> 16)) / 32767.0f, -1.0f);
+    const float z = 1.0f - std::fabs(x) - std::fabs(y);
+    if (z < 0.0f) { const float ox = x; x = (1.0f - std::fabs(y)) * (ox >= 0.0f ? 1.0f : -1.0f); y = (1.0f - std::fabs(ox)) * (y >= 0.0f ? 1.0f : -1.0f); }
+    const float len = std::sqrt(x * x + y * y + z * z);
+    return { x / len, y / len, z / len };
+}
+
+uint16_t NarrowOctahedral(uint32_t packed) {
+    auto narrow = [](uint32_t v) { return uint32_t(uint8_t(int8_t(std::lround(float(int16_t(v & 0xFFFF)) * (127.0f / 32767.0f))))); };
+    return uint16_t(narrow(packed) | (narrow(packed >> 16) << 8));
+}
+
+uint16_t FloatToHalf(float f) {
+    uint32_t bits; memcpy(&bits, &f, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u, mantissa = bits & 0x7FFFFFu;
+    const int32_t exponent = int32_t((bits >> 23) & 0xFF) - 127 + 15;
+    if (((bits >> 23) & 0xFF) == 0xFF) return uint16_t(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    if (exponent >= 31) return uint16_t(sign | 0x7C00u);
+    if (exponent <= 0) {
+        if (exponent < -10) return uint16_t(sign);
+        const uint32_t m = mantissa | 0x800000u; const uint32_t shift = uint32_t(14 - exponent);
+        uint32_t half = m >> shift; if ((m >> (shift - 1)) & 1u) half += 1;
+        return uint16_t(sign | half);
+    }
+    uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000u) half += 1;
+    return uint16_t(half);
+}
+
+float HalfToFloat(uint16_t h) {
+    const uint32_t sign = uint32_t(h & 0x8000u) << 16; uint32_t exponent = (h >> 10) & 0x1Fu, mantissa = h & 0x3FFu, bits;
+    if (exponent == 0x1F) bits = sign | 0x7F800000u | (mantissa << 13);
+    else if (exponent != 0) bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    else if (mantissa == 0) bits = sign;
+    else { exponent = 113; while (!(mantissa & 0x400u)) { mantissa <<= 1; --exponent; } bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13); }
+    float f; memcpy(&f, &bits, sizeof(f)); return f;
+}
+
+void EncodeIndexStream(const uint32_t* indices, size_t count, std::vector<uint8_t>& out) {
+    out.clear(); out.reserve(count * 2);
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t delta = int32_t(indices[i] - previous); previous = indices[i];
+        uint32_t v = (uint32_t(delta) << 1) ^ uint32_t(delta >> 31);
+        while (v >= 0x80) { out.push_back(uint8_t(v | 0x80)); v >>= 7; }
+        out.push_back(uint8_t(v));
+    }
+}
+
+bool DecodeIndexStream(const uint8_t* data, size_t size, uint32_t* out, size_t count) {
+    size_t pos = 0; uint32_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t v = 0;
+        for (int shift = 0;; shift += 7) {
+            if (pos >= size || shift > 28) return false;
+            const uint8_t b = data[pos++]; v |= uint32_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        previous += uint32_t(int32_t(v >> 1) ^ -int32_t(v & 1)); out[i] = previous;
+    }
+    return pos == size;
+}
+
+void EncodeVertexStream(const void* vertices, size_t count, size_t stride, std::vector<uint8_t>& out) {
+    const uint8_t* src = static_cast<const uint8_t*>(vertices);
+    out.clear(); out.reserve(count * stride / 2);
+    for (size_t b = 0; b < stride; ++b) {
+        uint8_t previous = 0; size_t zeros = 0;
+        auto flushZeros = [&] { if (!zeros) return; out.push_back(0); size_t run = zeros - 1; while (run >= 0x80) { out.push_back(uint8_t(run | 0x80)); run >>= 7; } out.push_back(uint8_t(run)); zeros = 0; };
+        for (size_t v = 0; v < count; ++v) {
+            const uint8_t x = src[v * stride + b]; const uint8_t delta = uint8_t(x - previous); previous = x;
+            if (delta == 0) { if (++zeros == kVertexStreamMaxZeroRun) flushZeros(); continue; }
+            flushZeros(); out.push_back(delta);
+        }
+        flushZeros();
+    }
+}
+
+bool DecodeVertexStream(const uint8_t* data, size_t size, void* out, size_t count, size_t stride) {
+    uint8_t* dst = static_cast<uint8_t*>(out); size_t pos = 0;
+    for (size_t b = 0; b < stride; ++b) {
+        uint8_t previous = 0;
+        for (size_t v = 0; v < count;) {
+            if (pos >= size) return false;
+            const uint8_t delta = data[pos++];
+            if (delta != 0) { previous = uint8_t(previous + delta); dst[v++ * stride + b] = previous; continue; }
+            size_t run = 0;
+            for (int shift = 0;; shift += 7) {
+                if (pos >= size || shift > 56) return false;
+                const uint8_t c = data[pos++]; run |= size_t(c & 0x7F) << shift;
+                if (!(c & 0x80)) break;
+            }
+            if (run >= kVertexStreamMaxZeroRun || run >= count - v) return false;
+            for (size_t k = 0; k <= run; ++k) dst[v++ * stride + b] = previous;
+        }
+    }
+    return pos == size;
+}
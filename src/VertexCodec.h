@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+enum class MeshVertexFormat : uint8_t { Float3, Quantized16 };
+
+// UNORM16 position relative to the mesh bounds; w carries the normal as two octahedral SNORM8 values (x | y << 8) so a
+// vertex stays 8 bytes.
+struct QuantizedPosition { uint16_t x, y, z, w; };
+
+// Full-precision vertex: the position and the octahedral SNORM16 normal.
+struct FloatVertex { Float3 position; uint32_t normal; };
+
+struct PositionDequantize { Float3 scale; Float3 offset; };
+
+inline size_t VertexStride(MeshVertexFormat format) { return format == MeshVertexFormat::Quantized16 ? sizeof(QuantizedPosition) : sizeof(FloatVertex); }
+
+PositionDequantize PositionDequantizeFor(const Aabb& bounds);
+// normals are octahedral SNORM16 as cooked; without them w is left zero.
+void QuantizePositions(const Float3* positions, size_t count, const PositionDequantize& d, QuantizedPosition* out, const uint32_t* normals = nullptr);
+Float3 DequantizePosition(const QuantizedPosition& q, const PositionDequantize& d);
+void PackFloatVertices(const Float3* positions, const uint32_t* normals, size_t count, FloatVertex* out);
+
+// Octahedral unit vector as two SNORM16 values packed x | y << 16.
+uint32_t EncodeOctahedral(const Float3& n);
+Float3 DecodeOctahedral(uint32_t packed);
+// The same vector rounded to two SNORM8 values packed x | y << 8.
+uint16_t NarrowOctahedral(uint32_t packed);
+
+uint16_t FloatToHalf(float f);
+float HalfToFloat(uint16_t h);
+
+// Lossless on-disk encodings. Indices become zigzag deltas in LEB128 varints; vertex bytes are split into
+// per-byte planes, delta coded against the previous vertex and zero runs collapsed, which also leaves the
+// result friendly to a general-purpose entropy coder. Zero runs stop at kVertexStreamMaxZeroRun bytes so neither
+// encoding expands by more than its ratio below, which is what lets a decoder size its output before trusting a count.
+constexpr size_t kVertexStreamMaxZeroRun = 128;
+constexpr size_t kVertexStreamMaxExpansion = kVertexStreamMaxZeroRun / 2;
+constexpr size_t kIndexStreamMaxExpansion = sizeof(uint32_t);
+void EncodeIndexStream(const uint32_t* indices, size_t count, std::vector<uint8_t>& out);
+bool DecodeIndexStream(const uint8_t* data, size_t size, uint32_t* out, size_t count);
+void EncodeVertexStream(const void* vertices, size_t count, size_t stride, std::vector<uint8_t>& out);
+bool DecodeVertexStream(const uint8_t* data, size_t size, void* out, size_t count, size_t stride);
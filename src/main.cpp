@@ -47,8 +47,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPWSTR,
     UpdateWindow(hwnd);
     LARGE_INTEGER freq; QueryPerformanceFrequency(&freq);
     LARGE_INTEGER prev; QueryPerformanceCounter(&prev);
-    double accumulator = 0.0;
-    const double dt = 1.0 / 60.0;
+    FixedStepClock clock(1.0 / 60.0);
     MSG msg{};
     for (;;) {
         while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
@@ -57,14 +56,10 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPWSTR,
             DispatchMessage(&msg);
         }
         LARGE_INTEGER now; QueryPerformanceCounter(&now);
-        double frameDt = double(now.QuadPart - prev.QuadPart) / double(freq.QuadPart);
+        const double frameDt = double(now.QuadPart - prev.QuadPart) / double(freq.QuadPart);
         prev = now;
-        if (frameDt > 0.25) frameDt = 0.25;
-        accumulator += frameDt;
-        while (accumulator >= dt) {
-            app.update(dt);
-            accumulator -= dt;
-        }
-        app.render();
+        // Simulation steps here while the render thread is still submitting the previous frame.
+        for (uint32_t steps = clock.advance(frameDt); steps > 0; --steps) app.update(clock.step());
+        app.render(clock.alpha());
     }
 }
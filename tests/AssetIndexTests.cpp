@@ -0,0 +1,172 @@
+#include "TestMain.h"
+#include "AssetIndex.h"
+#include "FileWatcher.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+void WriteText(const std::filesystem::path& path, const std::string& text) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream f(path, std::ios::binary | std::ios::trunc); f << text;
+}
+
+size_t CountChanges(const std::vector<AssetChange>& changes, AssetChangeKind kind, const std::string& key) {
+    return size_t(std::count_if(changes.begin(), changes.end(), [&](const AssetChange& c) { return c.kind == kind && c.record.path == key; }));
+}
+
+// Waits for the watcher to report something at or below want; paths from earlier writes may arrive first.
+bool WaitForPath(FileWatcher& watcher, const std::filesystem::path& want, std::chrono::milliseconds timeout) {
+    const auto until = std::chrono::steady_clock::now() + timeout;
+    std::vector<std::filesystem::path> paths;
+    while (std::chrono::steady_clock::now() < until) {
+        paths.clear(); watcher.waitForChanges(paths, std::chrono::milliseconds(50));
+        for (const std::filesystem::path& p : paths) { const std::string rel = want.lexically_relative(p).generic_string(); if (!rel.empty() && !rel.starts_with("..")) return true; }
+    }
+    return false;
+}
+}
+
+GGINE_TEST(AssetIndexKeysAreRootRelative) {
+    const std::filesystem::path root = "assets";
+    CHECK(AssetIndex::KeyFor(root, root / "props" / "crate.obj") == "props/crate.obj");
+    CHECK(AssetIndex::KeyFor(root, root).empty());
+    CHECK(AssetIndex::KeyFor(root, "other/crate.obj").starts_with(".."));
+    CHECK(AssetIndex::PathFor(root, "props/crate.obj") == root / "props" / "crate.obj");
+    const AssetIndex index;
+    CHECK(index.accepts("a.obj") && index.accepts("b.OBJ"));
+    CHECK(!index.accepts("c.ggmesh") && !index.accepts("obj"));
+}
+
+GGINE_TEST(AssetIndexRefreshReportsChanges) {
+    const std::filesystem::path root = TestScratchDir();
+    WriteText(root / "a.obj", "v 0 0 0\n");
+    WriteText(root / "sub" / "b.obj", "v 1 0 0\n");
+    WriteText(root / "notes.txt", "ignored");
+    AssetIndex index; std::vector<AssetChange> changes;
+    index.refresh(root, root, changes);
+    CHECK(changes.size() == 2);
+    CHECK(CountChanges(changes, AssetChangeKind::Added, "a.obj") == 1);
+    CHECK(CountChanges(changes, AssetChangeKind::Added, "sub/b.obj") == 1);
+    CHECK(index.records().size() == 2);
+    CHECK(index.filesHashed() == 2);
+
+    // Unchanged size and mtime skip the hash; a touched file with the same bytes is rehashed but not reported.
+    changes.clear(); index.refresh(root, root, changes);
+    CHECK(changes.empty());
+    CHECK(index.filesHashed() == 2);
+    std::filesystem::last_write_time(root / "a.obj", std::filesystem::last_write_time(root / "a.obj") + std::chrono::seconds(5));
+    index.refresh(root, root / "a.obj", changes);
+    CHECK(changes.empty());
+    CHECK(index.filesHashed() == 3);
+
+    WriteText(root / "a.obj", "v 0 0 0\nv 2 0 0\n");
+    index.refresh(root, root / "a.obj", changes);
+    CHECK(changes.size() == 1 && CountChanges(changes, AssetChangeKind::Modified, "a.obj") == 1);
+    CHECK(index.records().at("a.obj").size == 16);
+
+    changes.clear();
+    std::filesystem::remove_all(root / "sub");
+    index.refresh(root, root / "sub", changes);
+    CHECK(changes.size() == 1 && CountChanges(changes, AssetChangeKind::Removed, "sub/b.obj") == 1);
+    CHECK(index.records().size() == 1);
+    changes.clear();
+    index.refresh(root, root / ".." / "outside.obj", changes);
+    CHECK(changes.empty());
+}
+
+GGINE_TEST(AssetIndexSavesAndLoads) {
+    const std::filesystem::path root = TestScratchDir(), file = root / "index.bin";
+    WriteText(root / "a.obj", "v 0 0 0\n");
+    WriteText(root / "deep" / "er" / "b.obj", "v 1 0 0\n");
+    AssetIndex index; std::vector<AssetChange> changes;
+    index.refresh(root, root, changes);
+    REQUIRE(index.save(file));
+    CHECK(!std::filesystem::exists(root / "index.bin.tmp"));
+    AssetIndex loaded;
+    REQUIRE(loaded.load(file));
+    REQUIRE(loaded.records().size() == index.records().size());
+    for (const auto& [key, r] : index.records()) {
+        const AssetRecord& l = loaded.records().at(key);
+        CHECK(l.path == r.path && l.size == r.size && l.mtime == r.mtime && l.hash == r.hash && l.cooked == r.cooked);
+    }
+    // A loaded index that matches the disk needs no hashing to verify.
+    changes.clear(); loaded.refresh(root, root, changes);
+    CHECK(changes.empty());
+    CHECK(loaded.filesHashed() == 0);
+
+    WriteText(file, "not an index");
+    CHECK(!loaded.load(file));
+    CHECK(loaded.records().size() == 2);   // a failed load keeps what was there
+    CHECK(!loaded.load(root / "missing.bin"));
+}
+
+GGINE_TEST(FileWatcherPollingReportsTheRoot) {
+    const std::filesystem::path root = TestScratchDir();
+    FileWatcher watcher;
+    CHECK(!watcher.start(root / "missing"));
+    REQUIRE(watcher.start(root, std::chrono::milliseconds(50), true));
+    CHECK(watcher.backend() == FileWatchBackend::Polling);
+    std::vector<std::filesystem::path> paths;
+    CHECK(watcher.waitForChanges(paths, std::chrono::seconds(5)));
+    CHECK(std::find(paths.begin(), paths.end(), root) != paths.end());
+    watcher.stop();
+    CHECK(watcher.backend() == FileWatchBackend::None);
+}
+
+GGINE_TEST(FileWatcherWakeReturnsWithoutChanges) {
+    const std::filesystem::path root = TestScratchDir();
+    FileWatcher watcher;
+    REQUIRE(watcher.start(root, std::chrono::hours(1), true));
+    std::vector<std::filesystem::path> paths;
+    watcher.waitForChanges(paths, std::chrono::seconds(5));   // the initial full scan
+    paths.clear();
+    std::thread waker([&] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); watcher.wake(); });
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(!watcher.waitForChanges(paths, std::chrono::seconds(30)));
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    CHECK(paths.empty());
+    waker.join();
+}
+
+GGINE_TEST(FileWatcherNativeReportsNewFiles) {
+    const std::filesystem::path root = TestScratchDir();
+    std::filesystem::create_directories(root / "sub");
+    FileWatcher watcher;
+    REQUIRE(watcher.start(root));
+    if (watcher.backend() == FileWatchBackend::Polling) { printf("  native watching unavailable, polling only\n"); return; }
+    WriteText(root / "sub" / "new.obj", "v 0 0 0\n");
+    CHECK(WaitForPath(watcher, root / "sub" / "new.obj", std::chrono::seconds(5)));
+    // Directories created after start are watched too.
+    std::filesystem::create_directories(root / "later");
+    CHECK(WaitForPath(watcher, root / "later", std::chrono::seconds(5)));
+    WriteText(root / "later" / "deeper.obj", "v 0 0 0\n");
+    CHECK(WaitForPath(watcher, root / "later" / "deeper.obj", std::chrono::seconds(5)));
+}
+
+GGINE_TEST(AssetIndexServicePublishesAndPersists) {
+    const std::filesystem::path root = TestScratchDir() / "assets", file = root.parent_path() / "index.bin";
+    WriteText(root / "a.obj", "v 0 0 0\n");
+    {
+        AssetIndexService service;
+        REQUIRE(service.start(root, file));
+        std::vector<AssetChange> changes;
+        const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (CountChanges(changes, AssetChangeKind::Added, "a.obj") == 0 && std::chrono::steady_clock::now() < until) { service.pollChanges(changes); std::this_thread::sleep_for(std::chrono::milliseconds(10)); }
+        CHECK(CountChanges(changes, AssetChangeKind::Added, "a.obj") == 1);
+        WriteText(root / "b.obj", "v 1 0 0\n");
+        while (CountChanges(changes, AssetChangeKind::Added, "b.obj") == 0 && std::chrono::steady_clock::now() < until) { service.pollChanges(changes); std::this_thread::sleep_for(std::chrono::milliseconds(10)); }
+        CHECK(CountChanges(changes, AssetChangeKind::Added, "b.obj") == 1);
+        std::vector<AssetRecord> records; uint64_t version = 0;
+        CHECK(service.snapshot(records, version));
+        CHECK(records.size() == 2);
+        CHECK(!service.snapshot(records, version));
+        CHECK(service.stats().records == 2);
+    }
+    AssetIndex persisted;
+    REQUIRE(persisted.load(file));
+    CHECK(persisted.records().size() == 2);
+}
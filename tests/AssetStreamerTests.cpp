@@ -0,0 +1,156 @@
+#include "TestMain.h"
+#include "AssetStreamer.h"
+#include "JobSystem.h"
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// Holds the I/O thread inside a read so requests pile up in the queue behind it.
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open{false};
+    void wait() { std::unique_lock<std::mutex> lock(mutex); cv.wait(lock, [this] { return open; }); }
+    void release() { { std::lock_guard<std::mutex> lock(mutex); open = true; } cv.notify_all(); }
+};
+
+// Stages that record the order of reads, block on "gate" and fail on "fail"; nothing touches the disk.
+struct FakeStages {
+    Gate gate;
+    std::mutex mutex;
+    std::vector<std::string> reads;
+    AssetStreamStages stages(bool cook) {
+        AssetStreamStages s;
+        s.read = [this](StreamedMesh& m) {
+            const std::string name = m.source.string();
+            { std::lock_guard<std::mutex> lock(mutex); reads.push_back(name); }
+            if (name == "gate") gate.wait();
+            m.sourceBytes.assign(name.begin(), name.end());
+            return name != "fail";
+        };
+        if (cook) s.cook = [](StreamedMesh& m) { return m.sourceBytes != std::vector<char>{ 'b', 'a', 'd' }; };
+        return s;
+    }
+};
+
+void WaitForState(const AssetStreamer& streamer, StreamHandle handle, StreamState state) { while (streamer.state(handle) != state) std::this_thread::yield(); }
+
+StreamState CompletedState(const std::vector<StreamCompletion>& done, StreamHandle handle) {
+    for (const StreamCompletion& c : done) if (c.handle == handle) return c.state;
+    return StreamState::Invalid;
+}
+}
+
+GGINE_TEST(AssetStreamerReadsByPriorityThenRequestOrder) {
+    FakeStages fake;
+    AssetStreamer streamer(nullptr, fake.stages(false));
+    const StreamHandle gate = streamer.request("gate");
+    WaitForState(streamer, gate, StreamState::Reading);
+    const StreamHandle a = streamer.request("a", StreamPriority::Background);
+    const StreamHandle b = streamer.request("b", StreamPriority::Normal);
+    const StreamHandle c = streamer.request("c", StreamPriority::Immediate);
+    const StreamHandle d = streamer.request("d", StreamPriority::Normal);
+    const StreamHandle e = streamer.request("e", StreamPriority::Background);
+    CHECK(streamer.pendingCount() == 6);
+    CHECK(streamer.setPriority(e, StreamPriority::Immediate));
+    CHECK(!streamer.setPriority(gate, StreamPriority::Background));   // already reading
+    CHECK(streamer.cancel(d));
+    CHECK(streamer.state(d) == StreamState::Cancelled);
+    CHECK(streamer.pendingCount() == 5);
+    fake.gate.release();
+    streamer.waitIdle();
+    CHECK((fake.reads == std::vector<std::string>{ "gate", "c", "e", "b", "a" }));
+
+    std::vector<StreamCompletion> done;
+    CHECK(streamer.drainCompleted(done, 2) == 2);
+    CHECK(streamer.drainCompleted(done) == 4);
+    CHECK(CompletedState(done, d) == StreamState::Cancelled);
+    for (StreamHandle h : { gate, a, b, c, e }) CHECK(CompletedState(done, h) == StreamState::Ready);
+    for (const StreamCompletion& c : done) CHECK((c.state == StreamState::Ready) == (c.payload != nullptr));
+    for (const StreamCompletion& c : done) if (c.payload) CHECK(c.payload->sourceBytes.empty());   // freed once the stream finishes
+}
+
+GGINE_TEST(AssetStreamerHandlesGoStaleAfterDrain) {
+    FakeStages fake; fake.gate.release();
+    AssetStreamer streamer(nullptr, fake.stages(false));
+    const StreamHandle first = streamer.request("first");
+    streamer.waitIdle();
+    std::vector<StreamCompletion> done; streamer.drainCompleted(done);
+    REQUIRE(done.size() == 1);
+    CHECK(streamer.state(first) == StreamState::Invalid);
+    CHECK(!streamer.cancel(first));
+    CHECK(!streamer.setPriority(first, StreamPriority::Immediate));
+    // The slot is reused under a new generation, so the old handle never aliases the new stream.
+    const StreamHandle second = streamer.request("second");
+    CHECK(second.index == first.index);
+    CHECK(!(second == first));
+    streamer.waitIdle();
+    CHECK(streamer.state(second) == StreamState::Ready);
+    CHECK(streamer.state(first) == StreamState::Invalid);
+    CHECK(!streamer.cancel(StreamHandle{}));
+}
+
+GGINE_TEST(AssetStreamerCancelsInFlightAndFinishedStreams) {
+    FakeStages fake;
+    AssetStreamer streamer(nullptr, fake.stages(false));
+    const StreamHandle reading = streamer.request("gate");
+    WaitForState(streamer, reading, StreamState::Reading);
+    CHECK(streamer.cancel(reading));
+    CHECK(streamer.state(reading) == StreamState::Reading);   // the read finishes, its result is dropped
+    fake.gate.release();
+    streamer.waitIdle();
+    const StreamHandle failed = streamer.request("fail");
+    const StreamHandle ready = streamer.request("ready");
+    streamer.waitIdle();
+    CHECK(streamer.state(failed) == StreamState::Failed);
+    CHECK(streamer.cancel(ready));
+    std::vector<StreamCompletion> done; streamer.drainCompleted(done);
+    CHECK(done.size() == 3);
+    CHECK(CompletedState(done, reading) == StreamState::Cancelled);
+    CHECK(CompletedState(done, failed) == StreamState::Failed);
+    CHECK(CompletedState(done, ready) == StreamState::Cancelled);
+    for (const StreamCompletion& c : done) CHECK((c.state == StreamState::Cancelled) == (c.payload == nullptr));
+}
+
+GGINE_TEST(AssetStreamerCooksOnJobWorkers) {
+    JobSystem jobs(2);
+    FakeStages fake; fake.gate.release();
+    AssetStreamer streamer(&jobs, fake.stages(true));
+    std::vector<StreamHandle> handles;
+    for (int i = 0; i < 200; ++i) handles.push_back(streamer.request(i % 10 == 3 ? "bad" : "good" + std::to_string(i), StreamPriority(i % 3)));
+    size_t drained = 0, failed = 0; std::vector<StreamCompletion> done;
+    while (drained < handles.size()) { drained += streamer.drainCompleted(done); std::this_thread::yield(); }
+    streamer.waitIdle();
+    for (const StreamCompletion& c : done) failed += c.state == StreamState::Failed;
+    CHECK(failed == 20);
+    CHECK(done.size() == handles.size());
+    CHECK(streamer.pendingCount() == 0);
+}
+
+GGINE_TEST(AssetStreamerCooksAndCachesObjFiles) {
+    const std::filesystem::path dir = TestScratchDir(), source = dir / "quad.obj";
+    { std::ofstream f(source); f << "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3\nf 1 3 4\n"; }
+    AssetStreamer streamer;
+    const StreamHandle cooked = streamer.request(source), missing = streamer.request(dir / "missing.obj");
+    streamer.waitIdle();
+    std::vector<StreamCompletion> done; streamer.drainCompleted(done);
+    REQUIRE(done.size() == 2);
+    CHECK(CompletedState(done, missing) == StreamState::Failed);
+    for (const StreamCompletion& c : done) if (c.handle == cooked) {
+        REQUIRE(c.state == StreamState::Ready);
+        CHECK(!c.payload->stats.fromCache);
+        CHECK(c.payload->mesh.vertexCount() == 4);
+        CHECK(c.payload->mesh.lods()[0].indexCount == 6);
+    }
+    CHECK(std::filesystem::exists(CookedMeshPath(source)));
+    done.clear();
+    const StreamHandle cached = streamer.request(source);
+    streamer.waitIdle(); streamer.drainCompleted(done);
+    REQUIRE(done.size() == 1 && done[0].handle == cached && done[0].state == StreamState::Ready);
+    CHECK(done[0].payload->stats.fromCache);
+    CHECK(done[0].payload->mesh.vertexCount() == 4);
+}
@@ -0,0 +1,264 @@
+#include "TestMain.h"
+#include "AllocationCounter.h"
+#include "FramePrep.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+constexpr float kNear = 0.5f, kFar = 200.0f;
+
+struct TestMesh {
+    TransformHandle transform;
+    Aabb localBounds{ { -1, -1, -1 }, { 1, 1, 1 } };
+    Sphere localSphere{ {}, 1.7320508f };
+    std::array<MeshLod, kMaxMeshLods> lods{};
+    uint32_t lodCount{0};
+    uint32_t lod{0};
+    uint32_t geometryId{1};
+    uint32_t materialId{0};
+    int32_t cullProxy{-1};
+    const OccluderMesh* occluderMesh{nullptr};
+    bool hasGeometry{true};
+    uint32_t pipeline() const { return 0; }
+    bool drawable() const { return hasGeometry; }
+    const OccluderMesh* occluder() const { return occluderMesh; }
+};
+
+struct TestLight {
+    TransformHandle transform;
+    Float3 color{ 1, 1, 1 };
+    float intensity{1.0f};
+};
+
+struct TestScene {
+    TransformStore transforms;
+    DynamicAabbTree meshTree;
+    DynamicAabbTree lightTree;
+    std::vector<TestMesh> meshes;
+    std::vector<TestLight> lights;
+
+    void addMesh(const Float3& position, TestMesh m = {}, const Float3& scale = { 1, 1, 1 }) { m.transform = transforms.create(position, {}, scale); meshes.push_back(m); }
+    void addLight(const Float3& position, float intensity) { lights.push_back({ transforms.create(position), { 1, 0.5f, 0.25f }, intensity }); }
+    void createProxies() {
+        transforms.updateWorldMatrices();
+        for (size_t i = 0; i < meshes.size(); ++i) { TestMesh& m = meshes[i]; m.cullProxy = meshTree.createProxy(TransformAabb(m.localBounds, transforms.world(m.transform)), uint32_t(i)); transforms.setUserData(m.transform, uint32_t(m.cullProxy)); }
+        for (size_t i = 0; i < lights.size(); ++i) transforms.setUserData(lights[i].transform, kLightProxyFlag | uint32_t(lightTree.createProxy(LightBounds(transforms.world(lights[i].transform), lights[i].intensity), uint32_t(i))));
+    }
+};
+
+// Camera at the origin looking down +z with a square viewport; the view is identity so viewProj is the projection.
+FrameView TestView() {
+    FrameView v; v.projX = 1.0f; v.projY = 1.0f; v.nearZ = kNear; v.farZ = kFar; v.width = 256; v.height = 256;
+    v.view.m[0][0] = v.view.m[1][1] = v.view.m[2][2] = v.view.m[3][3] = 1.0f;
+    v.viewProj.m[0][0] = v.projX; v.viewProj.m[1][1] = v.projY; v.viewProj.m[2][2] = kFar / (kFar - kNear); v.viewProj.m[2][3] = 1.0f; v.viewProj.m[3][2] = -kNear * kFar / (kFar - kNear);
+    return v;
+}
+
+// A unit cube, centred on the origin, as occluder triangles.
+OccluderMesh CubeOccluder() {
+    static const Float3 positions[] = { { -1, -1, -1 }, { 1, -1, -1 }, { -1, 1, -1 }, { 1, 1, -1 }, { -1, -1, 1 }, { 1, -1, 1 }, { -1, 1, 1 }, { 1, 1, 1 } };
+    static const uint32_t indices[] = { 0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3 };
+    return { positions, 8, indices, 36 };
+}
+
+// A flat grid of quads in the z = 0 plane, split into meshlets.
+void BuildGridMeshlets(uint32_t cells, std::vector<Meshlet>& meshlets) {
+    std::vector<Float3> positions; std::vector<uint32_t> indices;
+    for (uint32_t y = 0; y <= cells; ++y) for (uint32_t x = 0; x <= cells; ++x) positions.push_back({ float(x) / float(cells) * 2.0f - 1.0f, float(y) / float(cells) * 2.0f - 1.0f, 0.0f });
+    for (uint32_t y = 0; y < cells; ++y) for (uint32_t x = 0; x < cells; ++x) { const uint32_t i = y * (cells + 1) + x; indices.insert(indices.end(), { i, i + cells + 1, i + 1, i + 1, i + cells + 1, i + cells + 2 }); }
+    BuildMeshlets(positions.data(), positions.size(), indices.data(), indices.size(), meshlets);
+}
+}
+
+// Every mesh whose fat bounds touch the frustum is listed once, unless it has no geometry; the batches cover exactly the
+// visible meshes in sort-key order and the instance worlds follow the batches.
+GGINE_TEST(FramePrepCullsAndSortsVisibleMeshes) {
+    JobSystem jobs(3);
+    TestScene scene;
+    for (int z = -10; z < 40; ++z) for (int x = -20; x <= 20; ++x) { TestMesh m; m.materialId = uint32_t(x + 20) % 5; m.geometryId = 1 + uint32_t(z + 10) % 7; m.hasGeometry = (x + z) % 11 != 0; scene.addMesh({ float(x) * 4.0f, 0.0f, float(z) * 4.0f }, m); }
+    scene.createProxies();
+    const FrameView view = TestView(); const FramePrepSettings settings;
+    FramePrep prep;
+    prep.prepareDrawList(scene, view, settings, jobs);
+
+    const Frustum frustum = ExtractFrustum(view.viewProj);
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < scene.meshes.size(); ++i) if (scene.meshes[i].drawable() && TestAabb(frustum, scene.meshTree.fatAabb(scene.meshes[i].cullProxy)) != CullResult::Outside) expected.push_back(i);
+    std::vector<uint32_t> visible = prep.visibleMeshes(); std::sort(visible.begin(), visible.end());
+    CHECK(visible == expected);
+    CHECK(!expected.empty() && expected.size() < scene.meshes.size());
+    CHECK(prep.transformUpdates() == 0);   // createProxies already brought the matrices up to date
+
+    const DrawBatcher& batcher = prep.drawBatcher();
+    REQUIRE(batcher.instanceOrder().size() == visible.size());
+    uint32_t instances = 0; uint64_t lastKey = 0;
+    for (const DrawBatch& b : batcher.batches()) {
+        CHECK(b.firstInstance == instances && b.sortKey >= lastKey);
+        for (uint32_t i = 0; i < b.instanceCount; ++i) { const TestMesh& m = scene.meshes[batcher.instanceOrder()[b.firstInstance + i]]; CHECK(MakeDrawSortKey(0, m.materialId, uint64_t(m.geometryId) << 3) == b.sortKey); }
+        instances += b.instanceCount; lastKey = b.sortKey;
+    }
+    CHECK(instances == visible.size());
+    std::vector<Float4x4> worlds(instances); prep.copyInstanceWorlds(scene, worlds.data(), jobs);
+    bool same = true; for (uint32_t k = 0; k < instances; ++k) same &= memcmp(&worlds[k], &scene.transforms.world(scene.meshes[batcher.instanceOrder()[k]].transform), sizeof(Float4x4)) == 0;
+    CHECK(same);
+
+    // Moving a mesh out of view refits its proxy before the query.
+    const uint32_t moved = visible.front();
+    scene.transforms.setPosition(scene.meshes[moved].transform, { 0.0f, 0.0f, -50.0f });
+    prep.prepareDrawList(scene, view, settings, jobs);
+    CHECK(prep.transformUpdates() == 1);
+    CHECK(std::find(prep.visibleMeshes().begin(), prep.visibleMeshes().end(), moved) == prep.visibleMeshes().end());
+    CHECK(prep.visibleMeshes().size() + 1 == visible.size());
+}
+
+GGINE_TEST(FramePrepSelectsLodsByProjectedError) {
+    JobSystem jobs(2);
+    TestScene scene;
+    TestMesh m; m.lodCount = 3; m.lods[0] = { 0, 300, 0.0f }; m.lods[1] = { 300, 120, 0.01f }; m.lods[2] = { 420, 30, 0.1f };
+    scene.addMesh({ 0, 0, 3 }, m); scene.addMesh({ 0, 0, 150 }, m);
+    scene.createProxies();
+    FramePrep prep; FramePrepSettings settings; settings.occlusionCulling = false;
+    prep.prepareDrawList(scene, TestView(), settings, jobs);
+    CHECK(scene.meshes[0].lod == 0);
+    CHECK(scene.meshes[1].lod == 2);
+    REQUIRE(prep.drawBatcher().batches().size() == 2);
+    CHECK((prep.drawBatcher().batches()[0].sortKey & 7) == 0 && (prep.drawBatcher().batches()[1].sortKey & 7) == 2);
+}
+
+// A wide occluder in front of a row of meshes hides the ones behind it and nothing beside it; the occluder itself and
+// meshes without an occluder mesh still draw.
+GGINE_TEST(FramePrepOccludesMeshesBehindLargeOccluders) {
+    JobSystem jobs(3);
+    const OccluderMesh cube = CubeOccluder();
+    TestScene scene;
+    TestMesh wall; wall.occluderMesh = &cube;
+    scene.addMesh({ 0, 0, 10 }, wall, { 8, 8, 0.5f });
+    for (int x = -6; x <= 6; ++x) scene.addMesh({ float(x) * 0.8f, 0.0f, 40.0f }, TestMesh{}, { 0.2f, 0.2f, 0.2f });
+    scene.addMesh({ 75.0f, 0.0f, 80.0f });   // beside the wall, still in view
+    scene.createProxies();
+    const FrameView view = TestView();
+    FramePrep prep; FramePrepSettings settings;
+    prep.prepareDrawList(scene, view, settings, jobs);
+    const std::vector<uint32_t>& visible = prep.visibleMeshes();
+    CHECK(prep.occludedMeshes() == 13);
+    CHECK(visible.size() == 2);
+    CHECK(std::find(visible.begin(), visible.end(), 0u) != visible.end());
+    CHECK(std::find(visible.begin(), visible.end(), 14u) != visible.end());
+    CHECK(prep.occlusionBuffer().stats().occluders == 1);
+    CHECK(prep.occlusionBuffer().width() == settings.occlusionWidth);
+
+    // Below the size threshold nothing is rasterized and nothing is hidden; with occlusion off the buffer is not consulted.
+    settings.occluderMinPixels = 1e6f;
+    prep.prepareDrawList(scene, view, settings, jobs);
+    CHECK(prep.occludedMeshes() == 0 && prep.visibleMeshes().size() == 15);
+    settings.occluderMinPixels = 48.0f; settings.occlusionCulling = false;
+    prep.prepareDrawList(scene, view, settings, jobs);
+    CHECK(prep.occludedMeshes() == 0 && prep.visibleMeshes().size() == 15);
+    // The triangle budget keeps the occluder out when it does not fit.
+    settings.occlusionCulling = true; settings.occluderTriangleBudget = 11;
+    prep.prepareDrawList(scene, view, settings, jobs);
+    CHECK(prep.occludedMeshes() == 0 && prep.occlusionBuffer().stats().occluders == 0);
+}
+
+// Lights whose range reaches the frustum are binned with their world position and radiance; lights behind the camera
+// are never gathered, and a moved light is refitted in the light tree before the query.
+GGINE_TEST(FramePrepBinsLightsInView) {
+    JobSystem jobs(2);
+    TestScene scene;
+    scene.addLight({ 0, 0, 20 }, 2.0f); scene.addLight({ 5, 1, 60 }, 4.0f); scene.addLight({ 0, 0, -80 }, 2.0f);
+    scene.createProxies();
+    const FrameView view = TestView();
+    FramePrep prep; FramePrepSettings settings;
+    prep.binVisibleLights(scene, view, settings, jobs);
+    REQUIRE(prep.clusterLights().size() == 2);
+    for (const ClusterLight& l : prep.clusterLights()) {
+        CHECK(l.position.z > 0.0f);
+        const float intensity = l.position.z < 40.0f ? 2.0f : 4.0f;
+        CHECK(l.range == LightRange(intensity) && l.radiance.x == intensity && l.radiance.y == 0.5f * intensity);
+    }
+    CHECK(prep.lightGrid().stats().visibleLights == 2);
+
+    scene.transforms.setPosition(scene.lights[2].transform, { 0, 0, 30 });
+    prep.prepareDrawList(scene, view, settings, jobs);   // refits the light tree
+    prep.binVisibleLights(scene, view, settings, jobs);
+    CHECK(prep.clusterLights().size() == 3);
+    settings.clusteredLighting = false;
+    prep.binVisibleLights(scene, view, settings, jobs);
+    CHECK(prep.clusterLights().empty() && prep.lightGrid().stats().visibleLights == 0);
+}
+
+// The pass gives each instance the ranges CullMeshlets gives it in the instance's object space.
+GGINE_TEST(ClusterCullPassMatchesDirectCulling) {
+    JobSystem jobs(3);
+    std::vector<Meshlet> meshlets; BuildGridMeshlets(32, meshlets);
+    REQUIRE(meshlets.size() > 4);
+    const FrameView view = TestView();
+    std::vector<Float4x4> worlds(6);
+    for (size_t i = 0; i < worlds.size(); ++i) { Float4x4& w = worlds[i]; const float s = 4.0f + float(i); w.m[0][0] = s; w.m[1][1] = s; w.m[2][2] = s; w.m[3][0] = float(i) * 3.0f - 8.0f; w.m[3][2] = 6.0f + float(i); w.m[3][3] = 1.0f; }
+    ClusterCullPass pass;
+    pass.begin(worlds.size());
+    for (uint32_t slot = 0; slot < worlds.size(); slot += 2) pass.add(slot, meshlets);
+    pass.cull(worlds.data(), view.viewProj, view.eye, true, jobs);
+    CHECK(pass.instanceCount() == 3);
+    ClusterCullStats total{};
+    for (uint32_t slot = 0; slot < worlds.size(); slot += 2) {
+        std::vector<MeshletRange> expected; ClusterCullStats stats{};
+        CullMeshlets(meshlets.data(), meshlets.size(), ExtractFrustum(MultiplyTransform(worlds[slot], view.viewProj)), InverseTransformPoint(worlds[slot], view.eye), true, expected, &stats);
+        total.add(stats);
+        const std::vector<MeshletRange>& got = pass.ranges(slot);
+        bool same = got.size() == expected.size();
+        for (size_t k = 0; same && k < got.size(); ++k) same = got[k].firstIndex == expected[k].firstIndex && got[k].indexCount == expected[k].indexCount;
+        CHECK(same);
+    }
+    CHECK(pass.stats().clusters == total.clusters && pass.stats().ranges == total.ranges && pass.stats().frustumCulled == total.frustumCulled);
+    CHECK(total.frustumCulled > 0);   // the outer instances hang past the frustum
+}
+
+GGINE_TEST(InverseTransformPointUndoesTheTransform) {
+    Float4x4 scale{}; scale.m[0][0] = 2.0f; scale.m[1][1] = 3.0f; scale.m[2][2] = 0.5f; scale.m[3][3] = 1.0f;
+    Float4x4 rotate{}; rotate.m[0][2] = 1.0f; rotate.m[1][1] = 1.0f; rotate.m[2][0] = -1.0f; rotate.m[3][0] = 4.0f; rotate.m[3][1] = -2.0f; rotate.m[3][2] = 7.0f; rotate.m[3][3] = 1.0f;
+    const Float4x4 m = MultiplyTransform(scale, rotate);
+    const Float3 p{ 1.5f, -2.0f, 3.0f };
+    const Float3 world{ p.x * m.m[0][0] + p.y * m.m[1][0] + p.z * m.m[2][0] + m.m[3][0], p.x * m.m[0][1] + p.y * m.m[1][1] + p.z * m.m[2][1] + m.m[3][1], p.x * m.m[0][2] + p.y * m.m[1][2] + p.z * m.m[2][2] + m.m[3][2] };
+    const Float3 back = InverseTransformPoint(m, world);
+    CHECK(std::fabs(back.x - p.x) < 1e-5f && std::fabs(back.y - p.y) < 1e-5f && std::fabs(back.z - p.z) < 1e-5f);
+}
+
+// Once the scratch lists have grown to the scene, preparing and cluster culling a frame with moving meshes and lights
+// makes no general-heap allocation on any thread.
+GGINE_TEST(FramePrepSteadyFramesDoNotAllocate) {
+    if (!kHeapAllocationCounting) { printf("  allocation counter compiled out, not checked\n"); return; }
+    JobSystem jobs(3);
+    const OccluderMesh cube = CubeOccluder();
+    std::vector<Meshlet> meshlets; BuildGridMeshlets(16, meshlets);
+    TestScene scene;
+    TestMesh wall; wall.occluderMesh = &cube;
+    scene.addMesh({ 0, 0, 30 }, wall, { 20, 20, 1 });
+    for (int z = 0; z < 24; ++z) for (int x = -12; x <= 12; ++x) { TestMesh m; m.occluderMesh = (x + z) % 4 == 0 ? &cube : nullptr; m.materialId = uint32_t(x + 12) % 3; scene.addMesh({ float(x) * 3.0f, float(z % 3) - 1.0f, 4.0f + float(z) * 3.0f }, m); }
+    for (int i = 0; i < 256; ++i) scene.addLight({ float(i % 16) * 4.0f - 32.0f, 0.0f, float(i / 16) * 6.0f - 20.0f }, 1.0f + float(i % 5));
+    scene.createProxies();
+    const FrameView view = TestView(); const FramePrepSettings settings;
+    FramePrep prep; ClusterCullPass clusterCull; std::vector<Float4x4> worlds;
+    uint32_t frame = 0; size_t occluded = 0;
+    auto runFrame = [&] {
+        ++frame; const float offset = (frame & 1) ? 0.5f : -0.5f;
+        for (size_t i = frame % 7; i < scene.meshes.size(); i += 7) { const Float3 p = scene.transforms.position(scene.meshes[i].transform); scene.transforms.setPosition(scene.meshes[i].transform, { p.x + offset, p.y, p.z }); }
+        for (size_t i = frame % 5; i < scene.lights.size(); i += 5) { const Float3 p = scene.transforms.position(scene.lights[i].transform); scene.transforms.setPosition(scene.lights[i].transform, { p.x, p.y + offset, p.z }); }
+        prep.prepareDrawList(scene, view, settings, jobs);
+        prep.binVisibleLights(scene, view, settings, jobs);
+        worlds.resize(prep.drawBatcher().instanceOrder().size()); prep.copyInstanceWorlds(scene, worlds.data(), jobs);
+        clusterCull.begin(worlds.size());
+        for (const DrawBatch& b : prep.drawBatcher().batches()) for (uint32_t i = 0; i < b.instanceCount; ++i) clusterCull.add(b.firstInstance + i, meshlets);
+        clusterCull.cull(worlds.data(), view.viewProj, view.eye, false, jobs);
+        occluded += prep.occludedMeshes();
+    };
+    for (int i = 0; i < 16; ++i) runFrame();
+    CHECK(occluded > 0);
+    CHECK(!prep.clusterLights().empty());
+    HeapAllocationScope heap;
+    for (int i = 0; i < 64; ++i) runFrame();
+    CHECK(heap.elapsed().allocations == 0);
+}
@@ -0,0 +1,89 @@
+#include "TestMain.h"
+#include "HierarchyView.h"
+#include <string>
+#include <vector>
+
+namespace {
+// Each row as its name indented two spaces per level, with a trailing '+' when the node has children.
+std::vector<std::string> Rows(HierarchyView& view, const TransformStore& store) {
+    std::vector<std::string> out;
+    for (const HierarchyRow& row : view.rows(store)) out.push_back(std::string(row.depth * 2, ' ') + std::string(view.name(row.node)) + (row.hasChildren ? "+" : ""));
+    return out;
+}
+
+// Room
+//   Lamp
+//     Lamp Shade
+//     Bulb
+//   Crate
+//     Cube
+// Floor
+// Shelf
+//   Cube
+struct Scene {
+    TransformStore store;
+    HierarchyView view;
+    TransformHandle room, lamp, shade, bulb, crate, crateCube, floor, shelf, shelfCube;
+    Scene() {
+        auto add = [&](const char* name, TransformHandle parent = {}) { const TransformHandle h = store.create({}, {}, { 1, 1, 1 }, parent); view.add(h, name, int32_t(view.nodeCount())); return h; };
+        room = add("Room"); lamp = add("Lamp", room); shade = add("Lamp Shade", lamp); bulb = add("Bulb", lamp); crate = add("Crate", room); crateCube = add("Cube", crate);
+        floor = add("Floor"); shelf = add("Shelf"); shelfCube = add("Cube", shelf);
+    }
+};
+}
+
+GGINE_TEST(HierarchyViewListsTheTreeInPreOrder) {
+    Scene s;
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "  Lamp+", "    Lamp Shade", "    Bulb", "  Crate+", "    Cube", "Floor", "Shelf+", "  Cube" }));
+    CHECK(s.view.nodeCount() == 9 && s.view.distinctNames() == 8);
+    // Nothing changed, so the cached rows are returned as they are.
+    const uint64_t rebuilds = s.view.rebuildCount();
+    s.view.rows(s.store); s.view.rows(s.store);
+    CHECK(s.view.rebuildCount() == rebuilds);
+    // Reparenting shows up after invalidate(); removing a node drops its row and, with no row to hang from, its subtree's.
+    REQUIRE(s.store.setParent(s.crate, s.floor));
+    s.view.invalidate();
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "  Lamp+", "    Lamp Shade", "    Bulb", "Floor+", "  Crate+", "    Cube", "Shelf+", "  Cube" }));
+    s.view.remove(s.lamp);
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "Floor+", "  Crate+", "    Cube", "Shelf+", "  Cube" }));
+    s.view.rename(s.shelfCube, "Box");
+    CHECK(s.view.rebuildCount() == rebuilds + 2);
+    CHECK(s.view.name(s.view.rows(s.store).back().node) == "Box");
+}
+
+GGINE_TEST(HierarchyViewFilterKeepsAncestorsOfMatches) {
+    Scene s;
+    s.view.setFilter("CUBE");
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "  Crate+", "    Cube", "Shelf+", "  Cube" }));
+    s.view.setFilter("lamp");
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "  Lamp+", "    Lamp Shade" }));
+    // Collapsed ancestors still open onto their matches while filtering, and keep their state for afterwards.
+    s.view.setExpanded(s.room, false);
+    s.view.setFilter("bulb");
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "  Lamp+", "    Bulb" }));
+    CHECK(!s.view.expanded(s.room));
+    // A rename that starts matching brings the node and its ancestors in.
+    s.view.rename(s.crateCube, "Bulb Box");
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "  Lamp+", "    Bulb", "  Crate+", "    Bulb Box" }));
+    s.view.setFilter("nothing");
+    CHECK(Rows(s.view, s.store).empty());
+    s.view.setFilter("");
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "Floor", "Shelf+", "  Cube" }));
+}
+
+GGINE_TEST(HierarchyViewCollapseAndExpand) {
+    Scene s;
+    s.view.setExpanded(s.lamp, false);
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "  Lamp+", "  Crate+", "    Cube", "Floor", "Shelf+", "  Cube" }));
+    s.view.setExpanded(s.room, false);
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "Floor", "Shelf+", "  Cube" }));
+    // Reopening a node restores its children as they were left: Lamp stays collapsed.
+    s.view.setExpanded(s.room, true);
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "  Lamp+", "  Crate+", "    Cube", "Floor", "Shelf+", "  Cube" }));
+    const uint64_t rebuilds = s.view.rebuildCount();
+    s.view.setExpanded(s.room, true);
+    s.view.rows(s.store);
+    CHECK(s.view.rebuildCount() == rebuilds);
+    s.view.setExpanded(s.lamp, true);
+    CHECK((Rows(s.view, s.store) == std::vector<std::string>{ "Room+", "  Lamp+", "    Lamp Shade", "    Bulb", "  Crate+", "    Cube", "Floor", "Shelf+", "  Cube" }));
+}
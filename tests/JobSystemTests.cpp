@@ -0,0 +1,122 @@
+#include "TestMain.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// Workers are requested explicitly so the queues, stealing and sleeping are exercised even on a single core.
+
+GGINE_TEST(JobSystemParallelForCoversEveryIndexOnce) {
+    JobSystem jobs(4);
+    for (uint32_t count : { 0u, 1u, 7u, 1000u, 100003u }) {
+        for (uint32_t grain : { 0u, 1u, 13u, 4096u }) {
+            std::vector<std::atomic<uint32_t>> hits(count);
+            jobs.parallelFor(count, grain, [&](uint32_t begin, uint32_t end) { for (uint32_t i = begin; i < end; ++i) hits[i].fetch_add(1, std::memory_order_relaxed); });
+            uint32_t wrong = 0; for (auto& h : hits) wrong += h.load() != 1;
+            CHECK(wrong == 0);
+        }
+    }
+}
+
+GGINE_TEST(JobSystemNestedParallelForUnderContention) {
+    JobSystem jobs(4);
+    constexpr uint32_t kOuter = 64, kInner = 2000;
+    std::vector<std::atomic<uint32_t>> hits(kOuter * kInner);
+    jobs.parallelFor(kOuter, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t o = begin; o < end; ++o) jobs.parallelFor(kInner, 64, [&, o](uint32_t b, uint32_t e) { for (uint32_t i = b; i < e; ++i) hits[o * kInner + i].fetch_add(1, std::memory_order_relaxed); });
+    });
+    uint32_t wrong = 0; for (auto& h : hits) wrong += h.load() != 1;
+    CHECK(wrong == 0);
+}
+
+// Jobs spawn jobs from workers and from several outside threads at once; every counter must drain exactly once.
+GGINE_TEST(JobSystemSpawnsFromManyThreads) {
+    JobSystem jobs(4);
+    jobs.resetStats();
+    constexpr int kProducers = 4, kJobsPerProducer = 2000, kChildren = 3;
+    std::atomic<uint64_t> executed{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) producers.emplace_back([&] {
+        JobCounter counter;
+        for (int i = 0; i < kJobsPerProducer; ++i) jobs.run([&] {
+            executed.fetch_add(1, std::memory_order_relaxed);
+            for (int c = 0; c < kChildren; ++c) jobs.run([&] { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+        }, &counter);
+        jobs.wait(counter);
+        CHECK(counter.value() == 0);
+    });
+    for (std::thread& t : producers) t.join();
+    CHECK(executed.load() == uint64_t(kProducers) * kJobsPerProducer * (1 + kChildren));
+    uint64_t counted = 0; for (const JobWorkerStats& s : jobs.stats()) counted += s.jobsExecuted;
+    CHECK(counted == executed.load());
+}
+
+GGINE_TEST(JobSystemRunAfterOrdersDependencies) {
+    JobSystem jobs(4);
+    for (int round = 0; round < 200; ++round) {
+        JobCounter first, second, done;
+        std::atomic<int> firstDone{0}, secondStarted{0}, violations{0};
+        for (int i = 0; i < 16; ++i) jobs.run([&] { std::this_thread::yield(); firstDone.fetch_add(1); }, &first);
+        for (int i = 0; i < 4; ++i) jobs.runAfter(first, [&] { violations += firstDone.load() != 16; secondStarted.fetch_add(1); }, &second);
+        jobs.runAfter(second, [&] { violations += secondStarted.load() != 4; }, &done);
+        jobs.wait(done);
+        CHECK(violations.load() == 0);
+        CHECK(first.value() == 0 && second.value() == 0);
+    }
+    // A dependency that already finished schedules the continuation immediately.
+    JobCounter finished, after; bool ran = false;
+    jobs.runAfter(finished, [&] { ran = true; }, &after);
+    jobs.wait(after);
+    CHECK(ran);
+}
+
+GGINE_TEST(JobSystemAffinityPicksTheThread) {
+    JobSystem jobs(2);
+    const std::thread::id main = std::this_thread::get_id();
+    JobCounter counter; std::atomic<int> wrongThread{0}, ran{0};
+    for (int i = 0; i < 100; ++i) {
+        jobs.run([&] { wrongThread += std::this_thread::get_id() != main; ++ran; }, &counter, JobAffinity::MainThread);
+        jobs.run([&] { wrongThread += std::this_thread::get_id() == main; ++ran; }, &counter, JobAffinity::Background);
+    }
+    jobs.wait(counter);
+    CHECK(ran.load() == 200);
+    CHECK(wrongThread.load() == 0);
+    JobCounter deferred; bool mainRan = false;
+    jobs.run([&] { mainRan = true; }, &deferred, JobAffinity::MainThread);
+    CHECK(!mainRan);
+    jobs.runMainThreadJobs();
+    CHECK(mainRan);
+}
+
+// A cook on a background job splits its work with a background parallelFor while the main thread keeps waiting on frame
+// work; the main thread must never pick up one of the cook's ranges.
+GGINE_TEST(JobSystemBackgroundRangesStayOffFrameWaits) {
+    JobSystem jobs(2);
+    const std::thread::id main = std::this_thread::get_id();
+    std::atomic<int> onMain{0}, covered{0}; std::atomic<bool> done{false};
+    JobCounter cook;
+    jobs.run([&] {
+        jobs.parallelFor(16, 1, [&](uint32_t begin, uint32_t end) { for (uint32_t i = begin; i < end; ++i) { onMain += std::this_thread::get_id() == main; std::this_thread::sleep_for(std::chrono::milliseconds(2)); ++covered; } }, JobAffinity::Background);
+        done = true;
+    }, &cook, JobAffinity::Background);
+    uint64_t frames = 0;
+    while (!done) { std::atomic<uint32_t> sum{0}; jobs.parallelFor(64, 1, [&](uint32_t begin, uint32_t end) { for (uint32_t i = begin; i < end; ++i) sum += i; }); frames += sum.load() == 63 * 64 / 2; }
+    jobs.wait(cook);
+    CHECK(covered.load() == 16);
+    CHECK(onMain.load() == 0);
+    CHECK(frames > 0);
+}
+
+GGINE_TEST(JobSystemWithoutWorkersRunsInline) {
+    JobSystem jobs(0);
+    CHECK(jobs.workerCount() == 0);
+    std::vector<uint32_t> values(1000);
+    jobs.parallelFor(uint32_t(values.size()), 16, [&](uint32_t begin, uint32_t end) { for (uint32_t i = begin; i < end; ++i) values[i] = i; });
+    CHECK(std::accumulate(values.begin(), values.end(), uint64_t(0)) == 999ull * 1000 / 2);
+    JobCounter counter; int ran = 0;
+    for (int i = 0; i < 10; ++i) jobs.run([&] { ++ran; }, &counter);
+    jobs.wait(counter);
+    CHECK(ran == 10);
+}
@@ -0,0 +1,172 @@
+#include "TestMain.h"
+#include "Hash.h"
+#include "MeshCache.h"
+#include "VertexCodec.h"
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+// A bumpy n x n grid of quads, big enough for several LODs and meshlets.
+std::string GridObj(int n) {
+    std::string text;
+    for (int y = 0; y <= n; ++y) for (int x = 0; x <= n; ++x) text += "v " + std::to_string(x) + " " + std::to_string(y) + " " + std::to_string((x * 7 + y * 3) % 5 * 0.1f) + "\n";
+    for (int y = 0; y < n; ++y) for (int x = 0; x < n; ++x) { const int a = y * (n + 1) + x + 1, b = a + 1, c = a + n + 2, d = a + n + 1; text += "f " + std::to_string(a) + " " + std::to_string(b) + " " + std::to_string(c) + "\nf " + std::to_string(a) + " " + std::to_string(c) + " " + std::to_string(d) + "\n"; }
+    return text;
+}
+
+std::filesystem::path WriteText(const std::filesystem::path& path, const std::string& text) { std::ofstream f(path, std::ios::binary); f << text; return path; }
+
+std::vector<uint8_t> ReadBytes(const std::filesystem::path& path) {
+    std::ifstream f(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() };
+}
+
+const GgmeshStreamEntry* FindStream(const std::vector<uint8_t>& image, MeshStreamType type) {
+    const GgmeshHeader& h = *reinterpret_cast<const GgmeshHeader*>(image.data());
+    const GgmeshStreamEntry* table = reinterpret_cast<const GgmeshStreamEntry*>(image.data() + sizeof(GgmeshHeader));
+    for (uint32_t i = 0; i < h.streamCount; ++i) if (table[i].type == uint32_t(type)) return &table[i];
+    return nullptr;
+}
+
+bool OpensAfter(const std::filesystem::path& path, const std::vector<uint8_t>& image, size_t offset, const void* value, size_t size) {
+    std::vector<uint8_t> corrupt = image; memcpy(corrupt.data() + offset, value, size);
+    { std::ofstream f(path, std::ios::binary | std::ios::trunc); f.write(reinterpret_cast<const char*>(corrupt.data()), std::streamsize(corrupt.size())); }
+    CookedMesh mesh;
+    return mesh.open(path);
+}
+
+bool SameMesh(const CookedMesh& a, const CookedMesh& b) {
+    return a.vertexCount() == b.vertexCount() && a.indexCount() == b.indexCount() && a.lodCount() == b.lodCount() && a.meshletCount() == b.meshletCount()
+        && memcmp(a.positions(), b.positions(), a.vertexCount() * sizeof(Float3)) == 0 && memcmp(a.normals(), b.normals(), a.vertexCount() * sizeof(uint32_t)) == 0
+        && memcmp(a.indices(), b.indices(), a.indexCount() * sizeof(uint32_t)) == 0 && memcmp(a.lods(), b.lods(), a.lodCount() * sizeof(MeshLod)) == 0;
+}
+}
+
+GGINE_TEST(MeshCacheWritesRawCachesByDefault) {
+    const std::filesystem::path source = WriteText(TestScratchDir() / "grid.obj", GridObj(32));
+    CookedMesh cooked; MeshCookStats stats;
+    REQUIRE(LoadOrCookObjMesh(source, cooked, &stats));
+    CHECK(!stats.fromCache && stats.encodedBytes == 0 && stats.lodCount > 1 && stats.meshletCount > 1);
+    const std::vector<uint8_t> image = ReadBytes(CookedMeshPath(source));
+    REQUIRE(image.size() == stats.imageBytes);
+    CHECK((reinterpret_cast<const GgmeshHeader*>(image.data())->flags & kGgmeshFlagEncodedStreams) == 0);   // bound from the mapping as is
+    CookedMesh cached; MeshCookStats cachedStats;
+    REQUIRE(LoadOrCookObjMesh(source, cached, &cachedStats));
+    CHECK(cachedStats.fromCache);
+    CHECK(SameMesh(cooked, cached));
+}
+
+GGINE_TEST(MeshCacheEncodesStreamsOnRequest) {
+    const std::string text = GridObj(32);
+    const std::filesystem::path source = WriteText(TestScratchDir() / "grid.obj", text);
+    SourceFingerprint fp; REQUIRE(ComputeSourceFingerprint(source, fp, false));
+    CookedMesh cooked; MeshCookStats stats; MeshCookOptions options; options.encodeStreams = true;
+    REQUIRE(CookObjMeshFromMemory(source, text.data(), text.size(), fp.mtime, cooked, &stats, options));
+    CHECK(stats.encodedBytes > 0 && stats.encodedBytes < stats.imageBytes);
+    const std::vector<uint8_t> image = ReadBytes(CookedMeshPath(source));
+    REQUIRE(image.size() == stats.encodedBytes);
+    CHECK(reinterpret_cast<const GgmeshHeader*>(image.data())->flags & kGgmeshFlagEncodedStreams);
+    CookedMesh cached;
+    REQUIRE(OpenCookedMeshIfValid(source, cached));
+    CHECK(SameMesh(cooked, cached));
+}
+
+// The cache describes the text that was cooked, not whatever is on disk by the time the cook finishes.
+GGINE_TEST(MeshCacheFingerprintsTheCookedText) {
+    const std::string cookedText = GridObj(4); std::string editedText = cookedText; editedText[2] = '9';
+    REQUIRE(cookedText.size() == editedText.size() && cookedText != editedText);
+    const std::filesystem::path source = WriteText(TestScratchDir() / "grid.obj", cookedText);
+    SourceFingerprint fp; REQUIRE(ComputeSourceFingerprint(source, fp, false));
+    CookedMesh cooked;
+    REQUIRE(CookObjMeshFromMemory(source, cookedText.data(), cookedText.size(), fp.mtime, cooked));
+    GgmeshHeader h; memcpy(&h, ReadBytes(CookedMeshPath(source)).data(), sizeof(h));
+    CHECK(h.sourceSize == cookedText.size() && h.sourceMtime == fp.mtime && h.sourceHash == HashMemory(cookedText.data(), cookedText.size()));
+    CHECK(IsCookedMeshValid(CookedMeshPath(source), source));
+
+    // Edited while it was cooking: same size, but a later mtime and different bytes.
+    REQUIRE(CookObjMeshFromMemory(source, cookedText.data(), cookedText.size(), fp.mtime - 1, cooked));
+    WriteText(source, editedText);
+    CHECK(!IsCookedMeshValid(CookedMeshPath(source), source));
+    CookedMesh recooked; MeshCookStats stats;
+    REQUIRE(LoadOrCookObjMesh(source, recooked, &stats));
+    CHECK(!stats.fromCache);
+    CHECK(IsCookedMeshValid(CookedMeshPath(source), source));
+}
+
+GGINE_TEST(MeshCacheRejectsOutOfRangeReferences) {
+    const std::filesystem::path dir = TestScratchDir(), source = WriteText(dir / "grid.obj", GridObj(16)), corruptPath = dir / "corrupt.ggmesh";
+    CookedMesh cooked;
+    REQUIRE(LoadOrCookObjMesh(source, cooked));
+    const std::vector<uint8_t> image = ReadBytes(CookedMeshPath(source));
+    const GgmeshStreamEntry* indices = FindStream(image, MeshStreamType::Indices); const GgmeshStreamEntry* meshlets = FindStream(image, MeshStreamType::Meshlets);
+    REQUIRE(indices && meshlets && meshlets->byteSize >= sizeof(Meshlet));
+    const uint32_t vertexCount = cooked.vertexCount(), lastIndex = vertexCount - 1, tooManyTriangles = (kMeshletMaxTriangles + 1) * 3, misalignedFirst = 1;
+    const uint32_t lastLevel0Index = cooked.lods()[0].indexCount - 1;
+    CHECK(OpensAfter(corruptPath, image, size_t(indices->offset), &lastIndex, sizeof(lastIndex)));   // still names a vertex
+    CHECK(!OpensAfter(corruptPath, image, size_t(indices->offset), &vertexCount, sizeof(vertexCount)));
+    CHECK(!OpensAfter(corruptPath, image, size_t(indices->offset + indices->byteSize) - sizeof(uint32_t), &vertexCount, sizeof(vertexCount)));   // in a coarser LOD
+    CHECK(!OpensAfter(corruptPath, image, size_t(meshlets->offset) + offsetof(Meshlet, vertexCount), &vertexCount, sizeof(vertexCount)));
+    CHECK(!OpensAfter(corruptPath, image, size_t(meshlets->offset) + offsetof(Meshlet, indexCount), &tooManyTriangles, sizeof(tooManyTriangles)));
+    CHECK(!OpensAfter(corruptPath, image, size_t(meshlets->offset) + offsetof(Meshlet, firstIndex), &misalignedFirst, sizeof(misalignedFirst)));
+    CHECK(!OpensAfter(corruptPath, image, size_t(meshlets->offset) + offsetof(Meshlet, indexCount), &lastLevel0Index, sizeof(lastLevel0Index)));
+    // The same checks guard images that come from the decoder.
+    MeshCookOptions options; options.encodeStreams = true;
+    const std::string text = GridObj(16); SourceFingerprint fp; REQUIRE(ComputeSourceFingerprint(source, fp, false));
+    REQUIRE(CookObjMeshFromMemory(source, text.data(), text.size(), fp.mtime, cooked, nullptr, options));
+    const std::vector<uint8_t> encoded = ReadBytes(CookedMeshPath(source));
+    const GgmeshStreamEntry* encodedMeshlets = FindStream(encoded, MeshStreamType::Meshlets); REQUIRE(encodedMeshlets);
+    CHECK(OpensAfter(corruptPath, encoded, 0, encoded.data(), sizeof(uint32_t)));
+    CHECK(!OpensAfter(corruptPath, encoded, size_t(encodedMeshlets->offset) + offsetof(Meshlet, vertexCount), &vertexCount, sizeof(vertexCount)));
+}
+
+// Header counts in an encoded image are checked against what the codecs could have expanded to before anything is allocated.
+GGINE_TEST(MeshCacheBoundsDecodedSizes) {
+    const std::string text = GridObj(16);
+    const std::filesystem::path dir = TestScratchDir(), source = WriteText(dir / "grid.obj", text), corruptPath = dir / "corrupt.ggmesh";
+    SourceFingerprint fp; REQUIRE(ComputeSourceFingerprint(source, fp, false));
+    CookedMesh cooked; MeshCookOptions options; options.encodeStreams = true;
+    REQUIRE(CookObjMeshFromMemory(source, text.data(), text.size(), fp.mtime, cooked, nullptr, options));
+    const std::vector<uint8_t> encoded = ReadBytes(CookedMeshPath(source));
+    const uint32_t hugeCount = 0x7FFFFFFFu, doubledVertices = cooked.vertexCount() * 2, hugeElement = 0x10000u;
+    CHECK(!OpensAfter(corruptPath, encoded, offsetof(GgmeshHeader, vertexCount), &hugeCount, sizeof(hugeCount)));
+    CHECK(!OpensAfter(corruptPath, encoded, offsetof(GgmeshHeader, indexCount), &hugeCount, sizeof(hugeCount)));
+    CHECK(!OpensAfter(corruptPath, encoded, offsetof(GgmeshHeader, vertexCount), &doubledVertices, sizeof(doubledVertices)));   // plausible, but the streams do not decode to it
+    CHECK(!OpensAfter(corruptPath, encoded, sizeof(GgmeshHeader) + offsetof(GgmeshStreamEntry, elementSize), &hugeElement, sizeof(hugeElement)));
+
+    // A flat plane: every normal is the same, so its byte planes are nothing but zero runs, which still decode.
+    std::vector<uint32_t> normals(100000, EncodeOctahedral({ 0.0f, 0.0f, 1.0f })), decoded(normals.size());
+    std::vector<uint8_t> stream; EncodeVertexStream(normals.data(), normals.size(), sizeof(uint32_t), stream);
+    CHECK(stream.size() * kVertexStreamMaxExpansion >= normals.size() * sizeof(uint32_t));
+    CHECK(DecodeVertexStream(stream.data(), stream.size(), decoded.data(), decoded.size(), sizeof(uint32_t)) && decoded == normals);
+}
+
+// A loaded mesh keeps its cache mapped; recooking and the mtime patch both replace the file underneath it.
+GGINE_TEST(MeshCacheReplacesCachesThatAreStillMapped) {
+    const std::filesystem::path source = WriteText(TestScratchDir() / "grid.obj", GridObj(8)), cookedPath = CookedMeshPath(source);
+    CookedMesh first; REQUIRE(LoadOrCookObjMesh(source, first));
+    CookedMesh loaded; MeshCookStats stats;
+    REQUIRE(LoadOrCookObjMesh(source, loaded, &stats));
+    REQUIRE(stats.fromCache);
+    const std::vector<Float3> before(loaded.positions(), loaded.positions() + loaded.vertexCount());
+
+    // Same bytes, new mtime: the header is patched so the next check needs no rehash.
+    const auto touched = std::filesystem::last_write_time(source) + std::chrono::seconds(5);
+    std::filesystem::last_write_time(source, touched);
+    CHECK(IsCookedMeshValid(cookedPath, source));
+    SourceFingerprint fp; REQUIRE(ComputeSourceFingerprint(source, fp, false));
+    GgmeshHeader h; memcpy(&h, ReadBytes(cookedPath).data(), sizeof(h));
+    CHECK(h.sourceMtime == fp.mtime);
+    CHECK(!std::filesystem::exists(cookedPath.string() + ".tmp"));
+
+    // An edited source is recooked over the mapped cache, which the loaded mesh keeps reading unchanged.
+    WriteText(source, GridObj(9));
+    CookedMesh recooked; REQUIRE(LoadOrCookObjMesh(source, recooked, &stats));
+    CHECK(!stats.fromCache && recooked.vertexCount() == 100);
+    CHECK(IsCookedMeshValid(cookedPath, source));
+    CHECK(loaded.vertexCount() == before.size() && memcmp(loaded.positions(), before.data(), before.size() * sizeof(Float3)) == 0);
+}
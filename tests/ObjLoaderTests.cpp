@@ -0,0 +1,59 @@
+#include "TestMain.h"
+#include "JobSystem.h"
+#include "ObjLoader.h"
+#include <string>
+#include <vector>
+
+namespace {
+// A grid of quads interleaved row by row with its vertices; odd rows use relative indices, so chunks split mid-file have
+// to resolve both kinds.
+std::string GridObj(int n) {
+    std::string text;
+    for (int y = 0; y <= n; ++y) {
+        for (int x = 0; x <= n; ++x) text += "v " + std::to_string(x) + " " + std::to_string(y) + " 0.25\n";
+        if (y == 0) continue;
+        for (int x = 0; x < n; ++x) {
+            const int a = (y - 1) * (n + 1) + x + 1, b = a + 1, c = a + n + 2, d = a + n + 1, last = (y + 1) * (n + 1);
+            if (y % 2) text += "f " + std::to_string(a - last - 1) + " " + std::to_string(b - last - 1) + " " + std::to_string(c - last - 1) + " " + std::to_string(d - last - 1) + "\n";
+            else text += "f " + std::to_string(a) + " " + std::to_string(b) + " " + std::to_string(c) + " " + std::to_string(d) + "\n";
+        }
+    }
+    return text;
+}
+}
+
+GGINE_TEST(ObjLoaderParsesChunksOnJobs) {
+    const int n = 400;
+    const std::string text = GridObj(n);
+    REQUIRE(text.size() > (size_t(4) << 20));   // enough for one chunk per thread below
+    ObjMeshData serial, parallel; ObjLoadStats serialStats, parallelStats;
+    REQUIRE(ParseObjPositionsAndIndices(text.data(), text.size(), serial, &serialStats));
+    JobSystem jobs(3);
+    REQUIRE(ParseObjPositionsAndIndices(text.data(), text.size(), parallel, &parallelStats, &jobs));
+    CHECK(serialStats.chunks == 1 && parallelStats.chunks == 4);
+    CHECK(serial.positions.size() == size_t(n + 1) * (n + 1) && serial.indices.size() == size_t(n) * n * 6);
+    CHECK(serial.indices == parallel.indices);
+    bool samePositions = serial.positions.size() == parallel.positions.size();
+    for (size_t i = 0; samePositions && i < serial.positions.size(); ++i) samePositions = serial.positions[i].x == parallel.positions[i].x && serial.positions[i].y == parallel.positions[i].y && serial.positions[i].z == parallel.positions[i].z;
+    CHECK(samePositions);
+    // The quad at row 1, column 0 (relative indices) and at row 2, column 0 (absolute) both land on the right vertices.
+    CHECK(serial.indices[0] == 0 && serial.indices[1] == 1 && serial.indices[2] == uint32_t(n + 2));
+    CHECK(serial.indices[size_t(n) * 6] == uint32_t(n + 1));
+}
+
+GGINE_TEST(ObjLoaderRejectsOutOfRangeFaces) {
+    const std::string text = "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n";
+    ObjMeshData mesh;
+    CHECK(!ParseObjPositionsAndIndices(text.data(), text.size(), mesh));
+    const std::string before = "v 0 0 0\nf -2 -1 1\n";
+    CHECK(!ParseObjPositionsAndIndices(before.data(), before.size(), mesh));
+    // Indices that would wrap onto a real vertex if narrowed to 32 bits.
+    const std::string triangle = "v 0 0 0\nv 1 0 0\nv 0 1 0\n";
+    for (const char* face : { "f 4294967297 2 3\n", "f 4294967296 2 3\n", "f 4294967295 2 3\n", "f -4294967296 -2 -1\n", "f -4294967299 -2 -1\n", "f -9223372036854775807 -2 -1\n" }) {
+        const std::string text = triangle + face;
+        CHECK(!ParseObjPositionsAndIndices(text.data(), text.size(), mesh));
+    }
+    const std::string valid = triangle + "f 1 -2 3\n";
+    REQUIRE(ParseObjPositionsAndIndices(valid.data(), valid.size(), mesh));
+    CHECK(mesh.indices == std::vector<uint32_t>({ 0, 1, 2 }));
+}
@@ -0,0 +1,132 @@
+#include "TestMain.h"
+#include "JobSystem.h"
+#include "OcclusionBuffer.h"
+#include "TransformStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr float kNear = 0.5f, kFar = 100.0f, kXScale = 1.0f, kYScale = 16.0f / 9.0f;
+
+// Camera at the origin looking down +z, D3D depth; the view is identity so this is also the view-projection.
+Float4x4 Projection() {
+    Float4x4 p{};
+    p.m[0][0] = kXScale; p.m[1][1] = kYScale; p.m[2][2] = kFar / (kFar - kNear); p.m[2][3] = 1.0f; p.m[3][2] = -kNear * kFar / (kFar - kNear);
+    return p;
+}
+
+double DepthAt(double z) { return (double(kFar) - double(kNear) * kFar / z) / (double(kFar) - kNear); }
+
+// A camera-facing rectangle at view depth z, as two triangles.
+struct Wall { float x0, y0, x1, y1, z; };
+
+void AddWall(OcclusionBuffer& buffer, const Wall& w) {
+    const Float3 positions[] = { { w.x0, w.y0, w.z }, { w.x1, w.y0, w.z }, { w.x1, w.y1, w.z }, { w.x0, w.y1, w.z } };
+    const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+    buffer.addOccluder(positions, 4, indices, 6, Projection());
+}
+
+// Exact depth at every pixel centre; centres within a hair of a wall's edge count as covered.
+std::vector<double> ReferenceDepth(const std::vector<Wall>& walls, uint32_t width, uint32_t height) {
+    std::vector<double> depth(size_t(width) * height, 1.0);
+    for (const Wall& w : walls) {
+        const double sx0 = (w.x0 / w.z * kXScale * 0.5 + 0.5) * width, sx1 = (w.x1 / w.z * kXScale * 0.5 + 0.5) * width;
+        const double sy0 = (0.5 - w.y1 / w.z * kYScale * 0.5) * height, sy1 = (0.5 - w.y0 / w.z * kYScale * 0.5) * height;
+        for (uint32_t y = 0; y < height; ++y) for (uint32_t x = 0; x < width; ++x) {
+            const double cx = x + 0.5, cy = y + 0.5;
+            if (cx >= sx0 - 1e-3 && cx <= sx1 + 1e-3 && cy >= sy0 - 1e-3 && cy <= sy1 + 1e-3) depth[size_t(y) * width + x] = std::min(depth[size_t(y) * width + x], DepthAt(w.z));
+        }
+    }
+    return depth;
+}
+
+Aabb Box(const Float3& c, float h) { return { { c.x - h, c.y - h, c.z - h }, { c.x + h, c.y + h, c.z + h } }; }
+}
+
+GGINE_TEST(OcclusionBufferRoundsToTilesAndClears) {
+    OcclusionBuffer buffer;
+    CHECK(buffer.testAabb(Box({ 0, 0, 10 }, 1), Projection()));   // never sized: nothing is hidden
+    buffer.resize(317, 178);
+    CHECK(buffer.width() == 320 && buffer.height() == 180);
+    CHECK(buffer.tilesX() == 40 && buffer.tilesY() == 45);
+    AddWall(buffer, { -100, -100, 100, 100, 10 }); buffer.rasterize();
+    CHECK(buffer.pixelDepth(0, 0) < 1.0f);
+    buffer.clear();
+    for (uint32_t y = 0; y < buffer.height(); y += 7) for (uint32_t x = 0; x < buffer.width(); x += 5) CHECK(buffer.pixelDepth(x, y) == 1.0f);
+    CHECK(buffer.stats().occluders == 0);
+}
+
+GGINE_TEST(OcclusionBufferHidesOnlyWhatIsBehind) {
+    OcclusionBuffer buffer; buffer.resize(320, 180);
+    // A full-screen wall at z = 20 on the left half of the view only.
+    AddWall(buffer, { -100, -100, 0, 100, 20 });
+    buffer.rasterize();
+    CHECK(buffer.stats().occluders == 1 && buffer.stats().triangles == 2);
+    const Float4x4 viewProj = Projection();
+    CHECK(!buffer.testAabb(Box({ -10, 0, 40 }, 1), viewProj));   // behind the wall
+    CHECK(buffer.testAabb(Box({ -10, 0, 10 }, 1), viewProj));    // in front of it
+    CHECK(buffer.testAabb(Box({ -10, 0, 20 }, 1), viewProj));    // straddles it
+    CHECK(buffer.testAabb(Box({ 10, 0, 40 }, 1), viewProj));     // behind, but on the open side
+    CHECK(buffer.testAabb(Box({ 0, 0, 40 }, 1), viewProj));      // half behind the wall's edge
+    CHECK(buffer.testAabb(Box({ -1, 0, 0.2f }, 1), viewProj));   // crosses the near plane
+}
+
+// Random camera-facing walls at random depths; the buffer may only ever be farther than the exact depth, and a box may
+// only be hidden when every pixel centre it touches is covered nearer than the box. Serial and threaded rasterization
+// must agree bit for bit.
+GGINE_TEST(OcclusionBufferIsConservativeAgainstReference) {
+    JobSystem jobs(3);
+    const Float4x4 viewProj = Projection();
+    std::mt19937 rng(77);
+    auto uniform = [&](float lo, float hi) { return lo + (hi - lo) * float(rng() >> 8) / float(1u << 24); };
+    size_t hiddenTotal = 0;
+    for (int scene = 0; scene < 8; ++scene) {
+        std::vector<Wall> walls;
+        for (int i = 0; i < 24; ++i) { const float z = uniform(2.0f, 60.0f), x = uniform(-0.9f, 0.9f) * z, y = uniform(-0.5f, 0.5f) * z, w = uniform(0.05f, 0.6f) * z, h = uniform(0.05f, 0.4f) * z; walls.push_back({ x - w, y - h, x + w, y + h, z }); }
+        OcclusionBuffer serial, threaded; serial.resize(160, 90); threaded.resize(160, 90);
+        for (const Wall& w : walls) { AddWall(serial, w); AddWall(threaded, w); }
+        serial.rasterize(); threaded.rasterize(&jobs);
+        bool same = true;
+        for (uint32_t ty = 0; ty < serial.tilesY(); ++ty) for (uint32_t tx = 0; tx < serial.tilesX(); ++tx) same &= memcmp(&serial.tile(tx, ty), &threaded.tile(tx, ty), sizeof(OcclusionTile)) == 0;
+        CHECK(same);
+
+        const std::vector<double> reference = ReferenceDepth(walls, serial.width(), serial.height());
+        size_t nearer = 0, wronglyHidden = 0;
+        for (uint32_t y = 0; y < serial.height(); ++y) for (uint32_t x = 0; x < serial.width(); ++x) nearer += serial.pixelDepth(x, y) < reference[size_t(y) * serial.width() + x] - 1e-5;
+        CHECK(nearer == 0);
+        for (int i = 0; i < 2000; ++i) {
+            const float z = uniform(3.0f, 80.0f), h = uniform(0.1f, 2.0f);
+            const Aabb box = Box({ uniform(-0.8f, 0.8f) * z, uniform(-0.4f, 0.4f) * z, z }, h);
+            if (serial.testAabb(box, viewProj)) continue;
+            ++hiddenTotal;
+            // The box's screen rectangle and nearest depth, from its near face (the boxes sit wholly in front of the camera).
+            const float zn = box.min.z;
+            const double sx0 = (std::min(box.min.x / zn, box.min.x / box.max.z) * kXScale * 0.5 + 0.5) * serial.width(), sx1 = (std::max(box.max.x / zn, box.max.x / box.max.z) * kXScale * 0.5 + 0.5) * serial.width();
+            const double sy0 = (0.5 - std::max(box.max.y / zn, box.max.y / box.max.z) * kYScale * 0.5) * serial.height(), sy1 = (0.5 - std::min(box.min.y / zn, box.min.y / box.max.z) * kYScale * 0.5) * serial.height();
+            const int x0 = std::max(0, int(std::floor(sx0))), x1 = std::min(int(serial.width()) - 1, int(std::ceil(sx1)) - 1), y0 = std::max(0, int(std::floor(sy0))), y1 = std::min(int(serial.height()) - 1, int(std::ceil(sy1)) - 1);
+            bool clearlyVisible = false;
+            for (int y = y0; y <= y1; ++y) for (int x = x0; x <= x1; ++x) clearlyVisible |= reference[size_t(y) * serial.width() + size_t(x)] > DepthAt(zn) + 1e-5;
+            wronglyHidden += clearlyVisible;
+        }
+        CHECK(wronglyHidden == 0);
+    }
+    CHECK(hiddenTotal > 0);   // the scenes must actually hide something for the check to mean anything
+}
+
+GGINE_TEST(OcclusionBufferTransformsOccluders) {
+    // The same wall as object-space unit quad scaled and moved by the world matrix.
+    OcclusionBuffer direct, transformed; direct.resize(160, 90); transformed.resize(160, 90);
+    AddWall(direct, { -4, -2, 4, 2, 15 }); direct.rasterize();
+    Float4x4 world{}; world.m[0][0] = 8.0f; world.m[1][1] = 4.0f; world.m[2][2] = 1.0f; world.m[3][2] = 15.0f; world.m[3][3] = 1.0f;
+    const Float3 positions[] = { { -0.5f, -0.5f, 0 }, { 0.5f, -0.5f, 0 }, { 0.5f, 0.5f, 0 }, { -0.5f, 0.5f, 0 } };
+    const uint32_t indices[] = { 0, 2, 1, 0, 3, 2 };   // opposite winding: occluders are double sided
+    transformed.addOccluder(positions, 4, indices, 6, MultiplyTransform(world, Projection()));
+    transformed.rasterize();
+    float worst = 0.0f;
+    for (uint32_t y = 0; y < direct.height(); ++y) for (uint32_t x = 0; x < direct.width(); ++x) worst = std::max(worst, std::fabs(direct.pixelDepth(x, y) - transformed.pixelDepth(x, y)));
+    CHECK(worst < 1e-5f);
+    CHECK(!transformed.testAabb(Box({ 0, 0, 30 }, 0.5f), Projection()));
+}
@@ -0,0 +1,127 @@
+#include "TestMain.h"
+#include "SceneFile.h"
+#include "TransformStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+// A small forest with a reparented subtree and a destroyed node, so slot order differs from creation order.
+void BuildHierarchy(TransformStore& store, std::vector<TransformHandle>& handles) {
+    for (uint32_t i = 0; i < 64; ++i) {
+        const TransformHandle parent = i % 4 ? handles[i - i % 4] : TransformHandle{};
+        handles.push_back(store.create({ float(i), float(i % 7), -float(i) }, { float(i * 5 % 360), 30.0f, 0.0f }, { 1.0f, 1.0f + float(i % 3), 1.0f }, parent));
+    }
+    store.setParent(handles[8], handles[3]);
+    store.destroy(handles[20]);
+    store.updateWorldMatrices();
+}
+
+SceneFileData ExportScene(const TransformStore& store, const std::vector<TransformHandle>& handles) {
+    SceneFileData data; data.camera = { { 1.0f, 2.0f, -3.0f }, 0.5f, -0.25f };
+    data.resizeNodes(store.size()); store.exportSlots(data.positions.data(), data.eulerDegrees.data(), data.scales.data(), data.parents.data());
+    for (size_t i = 0; i < handles.size(); ++i) {
+        if (!store.isAlive(handles[i])) continue;
+        const std::string name = "Node \xC3\xA9 " + std::to_string(i);   // names are UTF-8
+        if (i % 5 == 4) data.lights.push_back({ store.slotOf(handles[i]), { 1.0f, 0.5f, 0.25f }, float(i), data.addString(name) });
+        else data.meshes.push_back({ store.slotOf(handles[i]), i % 6 == 0 ? kSceneBuiltinCube : data.addAsset("props/prop" + std::to_string(i % 3) + ".obj"), uint32_t(i % 4), data.addString(name) });
+    }
+    return data;
+}
+
+std::vector<uint8_t> ReadBytes(const std::filesystem::path& path) {
+    std::ifstream f(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() };
+}
+
+bool OpensAfter(const std::filesystem::path& path, const std::vector<uint8_t>& image, size_t offset, const void* value, size_t size) {
+    std::vector<uint8_t> corrupt = image; memcpy(corrupt.data() + offset, value, size);
+    { std::ofstream f(path, std::ios::binary | std::ios::trunc); f.write(reinterpret_cast<const char*>(corrupt.data()), std::streamsize(corrupt.size())); }
+    SceneFile file;
+    return file.open(path);
+}
+}
+
+GGINE_TEST(SceneFileRoundTripsEveryRecord) {
+    TransformStore store; std::vector<TransformHandle> handles;
+    BuildHierarchy(store, handles);
+    const SceneFileData data = ExportScene(store, handles);
+    CHECK(data.assets.size() == 3);   // repeated keys share a slot
+    const std::filesystem::path path = TestScratchDir() / "scene.ggscene";
+    REQUIRE(WriteSceneFile(path, data));
+    CHECK(!std::filesystem::exists(path.string() + ".tmp"));
+
+    SceneFile file;
+    REQUIRE(file.open(path));
+    const GgsceneHeader& h = file.info();
+    REQUIRE(h.nodeCount == data.positions.size() && h.meshCount == data.meshes.size() && h.lightCount == data.lights.size() && h.assetCount == data.assets.size());
+    CHECK(memcmp(&h.camera, &data.camera, sizeof(SceneCamera)) == 0);
+    CHECK(memcmp(file.positions(), data.positions.data(), data.positions.size() * sizeof(Float3)) == 0);
+    CHECK(memcmp(file.eulerDegrees(), data.eulerDegrees.data(), data.eulerDegrees.size() * sizeof(Float3)) == 0);
+    CHECK(memcmp(file.scales(), data.scales.data(), data.scales.size() * sizeof(Float3)) == 0);
+    CHECK(memcmp(file.parents(), data.parents.data(), data.parents.size() * sizeof(uint32_t)) == 0);
+    for (uint32_t i = 0; i < h.meshCount; ++i) {
+        const SceneMeshRecord& m = file.meshes()[i], &e = data.meshes[i];
+        CHECK(m.node == e.node && m.asset == e.asset && m.materialId == e.materialId);
+        CHECK(file.string(m.name) == std::string_view(data.strings).substr(e.name.offset, e.name.length));
+    }
+    for (uint32_t i = 0; i < h.lightCount; ++i) {
+        const SceneLightRecord& l = file.lights()[i], &e = data.lights[i];
+        CHECK(l.node == e.node && l.intensity == e.intensity && memcmp(&l.color, &e.color, sizeof(Float3)) == 0);
+        CHECK(file.string(l.name).starts_with("Node \xC3\xA9 "));
+    }
+    for (uint32_t i = 0; i < h.assetCount; ++i) CHECK(file.assets()[i].id == data.assets[i].id && file.string(file.assets()[i].key) == std::string_view(data.strings).substr(data.assets[i].key.offset, data.assets[i].key.length));
+
+    // Loading through one append rebuilds the same world matrices.
+    TransformStore loaded; std::vector<TransformHandle> loadedHandles(h.nodeCount);
+    loaded.append(h.nodeCount, file.positions(), file.eulerDegrees(), file.scales(), file.parents(), loadedHandles.data());
+    loaded.updateWorldMatrices();
+    float worst = 0.0f;
+    for (uint32_t slot = 0; slot < h.nodeCount; ++slot)
+        for (int r = 0; r < 4; ++r) for (int c = 0; c < 4; ++c) worst = std::max(worst, std::abs(loaded.worldAt(slot).m[r][c] - store.worldAt(slot).m[r][c]));
+    CHECK(worst < 1e-4f);
+}
+
+GGINE_TEST(SceneFileRoundTripsAnEmptyScene) {
+    const std::filesystem::path path = TestScratchDir() / "empty.ggscene";
+    REQUIRE(WriteSceneFile(path, SceneFileData{}));
+    SceneFile file;
+    REQUIRE(file.open(path));
+    CHECK(file.info().nodeCount == 0 && file.info().meshCount == 0 && file.info().lightCount == 0 && file.info().assetCount == 0);
+}
+
+GGINE_TEST(SceneFileRejectsCorruptImages) {
+    TransformStore store; std::vector<TransformHandle> handles;
+    BuildHierarchy(store, handles);
+    const SceneFileData data = ExportScene(store, handles);
+    const std::filesystem::path dir = TestScratchDir(), path = dir / "scene.ggscene", corruptPath = dir / "corrupt.ggscene";
+    REQUIRE(WriteSceneFile(path, data));
+    const std::vector<uint8_t> image = ReadBytes(path);
+    const GgsceneHeader& h = *reinterpret_cast<const GgsceneHeader*>(image.data());
+    const uint32_t one = 1, huge = 0x7FFFFFFFu, version = kGgsceneVersion + 1;
+    const uint64_t misaligned = h.sections[0].offset + 4, pastEnd = image.size();
+    CHECK(OpensAfter(corruptPath, image, 0, &h.magic, sizeof(h.magic)));   // unchanged bytes still open
+    CHECK(!OpensAfter(corruptPath, image, offsetof(GgsceneHeader, magic), &one, sizeof(one)));
+    CHECK(!OpensAfter(corruptPath, image, offsetof(GgsceneHeader, version), &version, sizeof(version)));
+    CHECK(!OpensAfter(corruptPath, image, offsetof(GgsceneHeader, nodeCount), &huge, sizeof(huge)));
+    CHECK(!OpensAfter(corruptPath, image, offsetof(GgsceneHeader, sections), &misaligned, sizeof(misaligned)));
+    CHECK(!OpensAfter(corruptPath, image, offsetof(GgsceneHeader, sections) + sizeof(uint64_t), &pastEnd, sizeof(pastEnd)));
+    // A parent that does not precede its child, a mesh on a missing node, an asset slot past the table, a name past the strings.
+    const size_t parents = size_t(h.sections[size_t(SceneSection::Parents)].offset), meshes = size_t(h.sections[size_t(SceneSection::Meshes)].offset);
+    const uint32_t selfParent = 5, lastNode = h.nodeCount, badAsset = h.assetCount, badLength = huge;
+    CHECK(!OpensAfter(corruptPath, image, parents + 5 * sizeof(uint32_t), &selfParent, sizeof(selfParent)));
+    CHECK(!OpensAfter(corruptPath, image, meshes + offsetof(SceneMeshRecord, node), &lastNode, sizeof(lastNode)));
+    CHECK(!OpensAfter(corruptPath, image, meshes + offsetof(SceneMeshRecord, asset), &badAsset, sizeof(badAsset)));
+    CHECK(!OpensAfter(corruptPath, image, meshes + offsetof(SceneMeshRecord, name) + offsetof(SceneString, length), &badLength, sizeof(badLength)));
+    // Truncated below the header and missing files.
+    { std::ofstream f(corruptPath, std::ios::binary | std::ios::trunc); f.write(reinterpret_cast<const char*>(image.data()), 100); }
+    SceneFile file;
+    CHECK(!file.open(corruptPath));
+    CHECK(!file.open(dir / "missing.ggscene"));
+    CHECK(!file.isOpen());
+}
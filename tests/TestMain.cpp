@@ -0,0 +1,47 @@
+#include "TestMain.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+struct TestCase { const char* name; TestFunction fn; };
+
+std::vector<TestCase>& Tests() { static std::vector<TestCase> tests; return tests; }
+std::atomic<unsigned> failuresInTest{0};   // CHECK may fail on a worker thread
+const char* currentTest = "";
+std::filesystem::path scratchRoot;
+}
+
+std::filesystem::path TestScratchDir() {
+    if (scratchRoot.empty()) scratchRoot = std::filesystem::temp_directory_path() / ("ggine_tests_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    const std::filesystem::path dir = scratchRoot / currentTest;
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+bool RegisterTest(const char* name, TestFunction fn) { Tests().push_back({ name, fn }); return true; }
+
+void ReportFailure(const char* file, int line, const char* expression) {
+    fprintf(stderr, "  %s:%d: CHECK(%s) failed\n", file, line, expression);
+    ++failuresInTest;
+}
+
+// Usage: ggine_tests [substring]; with a substring only the tests whose names contain it run.
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    unsigned run = 0, failed = 0;
+    for (const TestCase& test : Tests()) {
+        if (filter && !strstr(test.name, filter)) continue;
+        failuresInTest = 0; currentTest = test.name;
+        printf("%s\n", test.name); fflush(stdout);
+        test.fn(); ++run;
+        if (!scratchRoot.empty()) { std::error_code ec; std::filesystem::remove_all(scratchRoot / test.name, ec); }
+        if (failuresInTest) { ++failed; fprintf(stderr, "%s: FAILED (%u checks)\n", test.name, failuresInTest.load()); }
+    }
+    if (!scratchRoot.empty()) { std::error_code ec; std::filesystem::remove_all(scratchRoot, ec); }
+    printf("%u tests, %u failed\n", run, failed);
+    return failed || run == 0 ? 1 : 0;
+}
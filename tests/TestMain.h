@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdio>
+#include <filesystem>
+
+// Minimal self-registering harness for ggine_tests. CHECK reports and keeps going; REQUIRE returns from the test, for
+// conditions the rest of it depends on. Any failure makes the run exit with status 1.
+
+using TestFunction = void (*)();
+bool RegisterTest(const char* name, TestFunction fn);
+void ReportFailure(const char* file, int line, const char* expression);
+// An empty directory for the running test; it and everything in it are removed when the test returns.
+std::filesystem::path TestScratchDir();
+
+#define GGINE_TEST(name) \
+    static void name(); \
+    static const bool name##Registered = RegisterTest(#name, name); \
+    static void name()
+
+#define CHECK(expression) do { if (!(expression)) ReportFailure(__FILE__, __LINE__, #expression); } while (0)
+#define REQUIRE(expression) do { if (!(expression)) { ReportFailure(__FILE__, __LINE__, #expression); return; } } while (0)
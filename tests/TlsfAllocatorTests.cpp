@@ -0,0 +1,122 @@
+#include "TestMain.h"
+#include "TlsfAllocator.h"
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+GGINE_TEST(TlsfAllocatesAlignedAndMergesOnFree) {
+    TlsfAllocator tlsf(1000 * 1024 + 100);
+    CHECK(tlsf.capacity() == 1000 * 1024);   // rounded down to the granularity
+    const TlsfAllocation a = tlsf.allocate(1), b = tlsf.allocate(300, 4096), c = tlsf.allocate(5000);
+    REQUIRE(a.isValid() && b.isValid() && c.isValid());
+    CHECK(a.offset == 0);
+    CHECK(b.offset % 4096 == 0);
+    CHECK(tlsf.allocationSize(a) == TlsfAllocator::kGranularity);
+    CHECK(tlsf.allocationSize(b) == 512);
+    CHECK(tlsf.validate());
+    CHECK(!tlsf.allocate(tlsf.capacity()).isValid());
+    CHECK(tlsf.stats().failedAllocations == 1);
+    tlsf.free(b); tlsf.free(b);   // a second free of the same allocation is ignored
+    CHECK(tlsf.validate());
+    tlsf.free(a); tlsf.free(c);
+    CHECK(tlsf.validate());
+    const TlsfStats s = tlsf.stats();
+    CHECK(s.usedBytes == 0 && s.allocationCount == 0 && s.freeBlockCount == 1);
+    CHECK(s.largestFreeBlock == tlsf.capacity());
+    CHECK(s.fragmentation == 0.0);
+    CHECK(tlsf.allocate(tlsf.capacity()).isValid());
+}
+
+GGINE_TEST(TlsfFreeAfterWaitsForTheFence) {
+    TlsfAllocator tlsf(64 * 1024);
+    const TlsfAllocation a = tlsf.allocate(32 * 1024), b = tlsf.allocate(32 * 1024);
+    REQUIRE(a.isValid() && b.isValid());
+    tlsf.freeAfter(a, 1); tlsf.freeAfter(b, 2);
+    CHECK(tlsf.stats().pendingFreeBytes == 64 * 1024);
+    CHECK(!tlsf.allocate(1).isValid());
+    tlsf.retire(1);
+    CHECK(tlsf.stats().pendingFreeBytes == 32 * 1024);
+    CHECK(tlsf.allocate(32 * 1024).offset == a.offset);
+    tlsf.retire(2);
+    CHECK(tlsf.stats().pendingFreeBytes == 0);
+    CHECK(tlsf.stats().allocationCount == 1);
+    CHECK(tlsf.validate());
+}
+
+GGINE_TEST(TlsfEmptyAllocatorFailsCleanly) {
+    TlsfAllocator tlsf;
+    CHECK(!tlsf.allocate(1).isValid());
+    tlsf.free({}); tlsf.freeAfter({}, 1); tlsf.retire(1);
+    CHECK(tlsf.validate());
+    tlsf.reset(100);   // below one granule
+    CHECK(tlsf.capacity() == 0);
+    CHECK(!tlsf.allocate(1).isValid());
+}
+
+// Random allocate/free/freeAfter/retire traffic against a model of the live ranges. Every allocation must be aligned,
+// in bounds and disjoint from everything not yet retired, and the allocator's internal structure is validated after
+// every operation.
+GGINE_TEST(TlsfRandomizedFuzz) {
+    for (uint32_t seed : { 1u, 2u, 3u, 4u }) {
+        std::mt19937 rng(seed);
+        const uint64_t capacity = (uint64_t(1) << 20) + uint64_t(rng() % 64) * TlsfAllocator::kGranularity;
+        TlsfAllocator tlsf(capacity);
+        struct Live { TlsfAllocation allocation; uint64_t size; };
+        std::vector<Live> live;
+        struct Pending { Live live; uint64_t fence; };
+        std::deque<Pending> pending;
+        std::map<uint64_t, uint64_t> ranges;   // offset -> end, for everything allocated and not yet retired
+        uint64_t fence = 0, completed = 0, modelUsed = 0, failures = 0, invalid = 0;
+        auto release = [&](const Live& l) { ranges.erase(l.allocation.offset); modelUsed -= l.size; };
+        for (int op = 0; op < 20000; ++op) {
+            const uint32_t kind = rng() % 16;
+            if (kind < 7) {
+                // Mostly small requests with an occasional large one, so the free lists span many size classes.
+                const uint64_t size = rng() % 8 ? 1 + rng() % 8192 : 1 + rng() % (capacity / 4);
+                const uint64_t alignment = uint64_t(1) << (rng() % 17);
+                const TlsfAllocation a = tlsf.allocate(size, alignment);
+                if (!a.isValid()) { ++failures; continue; }
+                const uint64_t got = tlsf.allocationSize(a), end = a.offset + got;
+                CHECK(got >= size);
+                CHECK(a.offset % std::max<uint64_t>(alignment, TlsfAllocator::kGranularity) == 0);
+                CHECK(end <= tlsf.capacity());
+                auto next = ranges.lower_bound(a.offset);
+                CHECK(next == ranges.end() || next->first >= end);
+                CHECK(next == ranges.begin() || std::prev(next)->second <= a.offset);
+                ranges[a.offset] = end; modelUsed += got;
+                live.push_back({ a, got });
+            } else if (kind < 11 && !live.empty()) {
+                const size_t i = rng() % live.size();
+                tlsf.free(live[i].allocation); release(live[i]);
+                live[i] = live.back(); live.pop_back();
+            } else if (kind < 14 && !live.empty()) {
+                const size_t i = rng() % live.size();
+                tlsf.freeAfter(live[i].allocation, fence + 1);
+                pending.push_back({ live[i], fence + 1 });
+                live[i] = live.back(); live.pop_back();
+            } else if (kind == 14) {
+                ++fence;
+            } else {
+                completed = std::min(fence, completed + rng() % 3);
+                tlsf.retire(completed);
+                while (!pending.empty() && pending.front().fence <= completed) { release(pending.front().live); pending.pop_front(); }
+            }
+            if (!tlsf.validate()) { ++invalid; break; }
+            const TlsfStats s = tlsf.stats();
+            CHECK(s.usedBytes == modelUsed);
+            CHECK(s.allocationCount == live.size() + pending.size());
+            CHECK(s.failedAllocations == failures);
+            CHECK(s.largestFreeBlock <= s.capacity - s.usedBytes);
+        }
+        CHECK(invalid == 0);
+        tlsf.retire(fence + 1);   // freeAfter tags the frame still being recorded
+        for (const Live& l : live) tlsf.free(l.allocation);
+        CHECK(tlsf.validate());
+        const TlsfStats s = tlsf.stats();
+        CHECK(s.usedBytes == 0 && s.pendingFreeBytes == 0 && s.freeBlockCount == 1);
+        CHECK(s.largestFreeBlock == tlsf.capacity());
+    }
+}
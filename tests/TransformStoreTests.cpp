@@ -0,0 +1,103 @@
+#include "TestMain.h"
+#include "TransformStore.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+bool Near(const Float4x4& a, const Float4x4& b) {
+    for (int r = 0; r < 4; ++r) for (int c = 0; c < 4; ++c) if (std::fabs(a.m[r][c] - b.m[r][c]) > 1e-4f) return false;
+    return true;
+}
+
+// Every parent has to sit in a lower slot than its children, or one ascending pass composes a child before its parent.
+bool ParentsPrecedeChildren(const TransformStore& store) {
+    for (uint32_t k = 0; k < store.size(); ++k) {
+        const TransformHandle p = store.parent(store.handleAt(k));
+        if (!(p == TransformHandle{}) && store.slotOf(p) >= k) return false;
+    }
+    return true;
+}
+
+// A store plus an unparented twin of each node, whose world matrix is therefore the node's local matrix.
+struct Forest {
+    TransformStore store, locals;
+    std::vector<TransformHandle> nodes, twins;
+    TransformHandle add(const Float3& position, const Float3& euler, TransformHandle parent = {}) {
+        nodes.push_back(store.create(position, euler, { 1, 1, 1 }, parent)); twins.push_back(locals.create(position, euler));
+        return nodes.back();
+    }
+    size_t twinOf(TransformHandle h) const { size_t i = 0; while (!(nodes[i] == h)) ++i; return i; }
+    void setPosition(TransformHandle h, const Float3& p) { store.setPosition(h, p); locals.setPosition(twins[twinOf(h)], p); }
+    const Float4x4& local(TransformHandle h) { locals.updateWorldMatrices(); return locals.world(twins[twinOf(h)]); }
+};
+}
+
+GGINE_TEST(TransformStoreRejectsReparentingUnderADescendant) {
+    Forest f;
+    const TransformHandle a = f.add({ 1, 0, 0 }, {}), b = f.add({ 0, 2, 0 }, { 0, 30, 0 }, a), c = f.add({ 0, 0, 3 }, {}, b);
+    f.store.updateWorldMatrices();
+    const Float4x4 before = f.store.world(c);
+    CHECK(!f.store.setParent(a, c));
+    CHECK(!f.store.setParent(a, b));
+    CHECK(!f.store.setParent(b, b));
+    CHECK(f.store.parent(a) == TransformHandle{});
+    CHECK(f.store.parent(b) == a && f.store.parent(c) == b);
+    CHECK(f.store.isAncestor(a, c) && !f.store.isAncestor(c, a));
+    CHECK(f.store.dirtyCount() == 0);
+    CHECK(f.store.updateWorldMatrices() == 0);
+    CHECK(Near(f.store.world(c), before));
+    CHECK(ParentsPrecedeChildren(f.store));
+    // Moving a node under its own subtree's sibling is still fine.
+    const TransformHandle d = f.add({ 5, 0, 0 }, {}, a);
+    CHECK(f.store.setParent(c, d));
+    CHECK(f.store.parent(c) == d && ParentsPrecedeChildren(f.store));
+}
+
+GGINE_TEST(TransformStoreRecomposesAMovedSubtree) {
+    Forest f;
+    // The new parent is created after the subtree, so the move has to reorder slots as well as relink.
+    const TransformHandle a = f.add({ 10, 0, 0 }, {}), c = f.add({ 1, 0, 0 }, { 0, 0, 20 }, a), d = f.add({ 0, 0, 2 }, {}, c), e = f.add({ 0, 1, 0 }, {}, d);
+    const TransformHandle stay = f.add({ 0, 0, 1 }, {}, a), b = f.add({ 0, 5, 0 }, { 0, 90, 0 });
+    f.store.updateWorldMatrices();
+    REQUIRE(f.store.slotOf(b) > f.store.slotOf(c));
+    REQUIRE(f.store.setParent(c, b));
+    CHECK(f.store.parent(c) == b && f.store.firstChild(a) == stay && f.store.nextSibling(stay) == TransformHandle{});
+    CHECK(ParentsPrecedeChildren(f.store));
+    CHECK(f.store.position(c).x == 1.0f);   // local values are kept
+    CHECK(f.store.updateWorldMatrices() == 3);   // the moved subtree and nothing else
+    const Float4x4 wc = MultiplyTransform(f.local(c), f.local(b)), wd = MultiplyTransform(f.local(d), wc), we = MultiplyTransform(f.local(e), wd);
+    CHECK(Near(f.store.world(b), f.local(b)));
+    CHECK(Near(f.store.world(c), wc));
+    CHECK(Near(f.store.world(d), wd));
+    CHECK(Near(f.store.world(e), we));
+    CHECK(Near(f.store.world(stay), MultiplyTransform(f.local(stay), f.local(a))));
+    // Moving the new parent afterwards carries the whole subtree with it.
+    f.setPosition(b, { 0, -5, 0 });
+    CHECK(f.store.updateWorldMatrices() == 4);
+    CHECK(Near(f.store.world(e), MultiplyTransform(f.local(e), MultiplyTransform(f.local(d), MultiplyTransform(f.local(c), f.local(b))))));
+}
+
+GGINE_TEST(TransformStoreDestroyingAMiddleNodeKeepsChildrenOrdered) {
+    // Without the trailing grandchild the last slot swaps into the hole; with it the slots have to close up in order.
+    for (const bool grandchild : { false, true }) {
+        Forest f;
+        const TransformHandle r = f.add({ 0, 3, 0 }, { 0, 45, 0 }), s = f.add({ 2, 0, 0 }, {}, r), m = f.add({ 0, 0, 4 }, { 10, 0, 0 }, r);
+        const TransformHandle m1 = f.add({ 1, 0, 0 }, {}, m), m2 = f.add({ 0, 1, 0 }, {}, m), m3 = f.add({ 0, 0, 1 }, { 0, 0, 30 }, m);
+        const TransformHandle x = grandchild ? f.add({ 0, 2, 0 }, {}, m3) : TransformHandle{};
+        f.store.updateWorldMatrices();
+        f.store.destroy(m);
+        CHECK(!f.store.isAlive(m) && f.store.size() == (grandchild ? 6u : 5u));
+        CHECK(ParentsPrecedeChildren(f.store));
+        // Children move up to the destroyed node's parent, after its existing children and in their own order.
+        std::vector<TransformHandle> children;
+        for (TransformHandle h = f.store.firstChild(r); !(h == TransformHandle{}); h = f.store.nextSibling(h)) children.push_back(h);
+        CHECK((children == std::vector<TransformHandle>{ s, m1, m2, m3 }));
+        CHECK(f.store.position(m3).z == 1.0f);
+        f.store.updateWorldMatrices();
+        for (const TransformHandle h : { s, m1, m2, m3 }) CHECK(Near(f.store.world(h), MultiplyTransform(f.local(h), f.local(r))));
+        if (grandchild) {
+            CHECK(f.store.parent(x) == m3);
+            CHECK(Near(f.store.world(x), MultiplyTransform(f.local(x), MultiplyTransform(f.local(m3), f.local(r)))));
+        }
+    }
+}
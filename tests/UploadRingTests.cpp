@@ -0,0 +1,117 @@
+#include "TestMain.h"
+#include "AllocationCounter.h"
+#include "UploadRing.h"
+#include <algorithm>
+#include <deque>
+#include <random>
+
+GGINE_TEST(UploadRingRejectsInvalidRequests) {
+    UploadRing ring(256);
+    CHECK(ring.allocate(0, 16) == UploadRing::kInvalidOffset);
+    CHECK(ring.allocate(257, 16) == UploadRing::kInvalidOffset);
+    CHECK(ring.allocate(16, 0) == UploadRing::kInvalidOffset);
+    CHECK(ring.allocate(16, 24) == UploadRing::kInvalidOffset);
+    CHECK(ring.bytesInFlight() == 0);
+    UploadRing empty;
+    CHECK(empty.allocate(1, 1) == UploadRing::kInvalidOffset);
+}
+
+GGINE_TEST(UploadRingAlignsAndFillsToCapacity) {
+    UploadRing ring(256);
+    CHECK(ring.allocate(10, 1) == 0);
+    CHECK(ring.allocate(16, 64) == 64);
+    CHECK(ring.allocate(128, 128) == 128);
+    CHECK(ring.bytesInFlight() == 256);
+    CHECK(ring.allocate(1, 1) == UploadRing::kInvalidOffset);
+    CHECK(ring.stats().allocationsThisFrame == 3);
+    CHECK(ring.stats().highWaterMark == 256);
+}
+
+GGINE_TEST(UploadRingRetiresByFence) {
+    UploadRing ring(256);
+    CHECK(ring.allocate(100, 4) == 0); ring.endFrame(1);
+    CHECK(ring.allocate(100, 4) == 100); ring.endFrame(2);
+    CHECK(ring.allocate(100, 4) == UploadRing::kInvalidOffset);
+    ring.retire(0);
+    CHECK(ring.bytesInFlight() == 200);
+    ring.retire(1);
+    CHECK(ring.bytesInFlight() == 100);
+    // The tail of the buffer is too short for 100 bytes, so the allocation wraps to 0 and the skipped bytes stay in flight.
+    CHECK(ring.allocate(100, 4) == 0);
+    CHECK(ring.bytesInFlight() == 256);
+    ring.endFrame(3);
+    ring.retire(3);
+    CHECK(ring.bytesInFlight() == 0);
+    CHECK(ring.stats().lastFrameAllocations == 1);
+    CHECK(ring.stats().lastFrameBytes == 156);
+    CHECK(ring.stats().peakFrameBytes == 156);
+}
+
+GGINE_TEST(UploadRingGrowKeepsStats) {
+    UploadRing ring(64);
+    CHECK(ring.allocate(64, 16) == 0); ring.endFrame(1);
+    ring.grow(128);
+    CHECK(ring.capacity() == 128);
+    CHECK(ring.bytesInFlight() == 0);
+    CHECK(ring.stats().growCount == 1);
+    CHECK(ring.stats().peakFrameBytes == 64);
+    ring.retire(1);   // the mark from before the grow must not move the new tail
+    CHECK(ring.allocate(128, 16) == 0);
+}
+
+// Drives the ring like a renderer that keeps a few frames in flight and checks that no live allocation is handed out
+// twice: every byte allocated since the last retired fence must be disjoint from every other.
+GGINE_TEST(UploadRingRandomFramesNeverOverlap) {
+    constexpr uint64_t kCapacity = 4096;
+    UploadRing ring(kCapacity);
+    std::mt19937 rng(1234);
+    struct Live { uint64_t fence, offset, size; };
+    std::deque<Live> live;
+    uint64_t fence = 0, completed = 0;
+    for (int frame = 0; frame < 2000; ++frame) {
+        const int count = int(rng() % 8);
+        for (int i = 0; i < count; ++i) {
+            const uint64_t size = 1 + rng() % 700, alignment = 1ull << (rng() % 9);
+            const uint64_t offset = ring.allocate(size, alignment);
+            if (offset == UploadRing::kInvalidOffset) continue;
+            CHECK(offset % alignment == 0);
+            CHECK(offset + size <= kCapacity);
+            for (const Live& l : live) CHECK(offset + size <= l.offset || l.offset + l.size <= offset);
+            live.push_back({ fence + 1, offset, size });
+        }
+        CHECK(ring.bytesInFlight() <= kCapacity);
+        ring.endFrame(++fence);
+        // The GPU lags by zero to three frames.
+        completed = std::max(completed, fence - std::min<uint64_t>(fence, rng() % 4));
+        ring.retire(completed);
+        while (!live.empty() && live.front().fence <= completed) live.pop_front();
+    }
+    ring.retire(fence);
+    CHECK(ring.bytesInFlight() == 0);
+}
+
+GGINE_TEST(UploadRingFoldsFramesPastTheMarkRing) {
+    UploadRing ring(1024);
+    for (uint64_t fence = 1; fence <= UploadRing::kMaxFramesInFlight + 2; ++fence) { CHECK(ring.allocate(100, 4) != UploadRing::kInvalidOffset); ring.endFrame(fence); }
+    // Frames past the last ring slot share its mark, so they retire together with the newest fence and never early.
+    ring.retire(UploadRing::kMaxFramesInFlight - 1);
+    CHECK(ring.bytesInFlight() == 300);
+    ring.retire(UploadRing::kMaxFramesInFlight + 1);
+    CHECK(ring.bytesInFlight() == 300);
+    ring.retire(UploadRing::kMaxFramesInFlight + 2);
+    CHECK(ring.bytesInFlight() == 0);
+}
+
+GGINE_TEST(UploadRingSteadyFramesDoNotAllocate) {
+    UploadRing ring(1 << 16);
+    uint64_t fence = 0;
+    auto frame = [&] {
+        for (int i = 0; i < 64; ++i) CHECK(ring.allocate(256, 256) != UploadRing::kInvalidOffset);
+        ring.endFrame(++fence);
+        ring.retire(fence - std::min<uint64_t>(fence, UploadRing::kMaxFramesInFlight - 1));
+    };
+    for (int i = 0; i < 8; ++i) frame();
+    HeapAllocationScope heap;
+    for (int i = 0; i < 1000; ++i) frame();
+    CHECK(heap.elapsed().allocations == 0);
+}